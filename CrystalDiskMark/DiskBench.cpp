@@ -13,6 +13,7 @@
 #include "DiskMark.h"
 #include "DiskMarkDlg.h"
 #include "DiskBench.h"
+#include "DiskSpdDriver.h"
 #include "GetFileVersion.h"
 
 #include <winioctl.h>
@@ -23,9 +24,7 @@
 
 static CString TestFilePath;
 static CString TestFileDir;
-static CString DiskSpdExe;
 
-static HANDLE hFile;
 static int DiskTestCount;
 static UINT64 DiskTestSize;
 static void ShowErrorMessage(CString message);
@@ -38,48 +37,7 @@ static UINT Exit(LPVOID dlg);
 static void CALLBACK TimerProc(HWND hwnd, UINT uMsg, UINT_PTR idEvent, DWORD dwTime);
 static volatile BOOL WaitFlag;
 
-#define DISK_SPD_EXE_32 L"CdmResource\\diskspd\\diskspd32.exe"
-#define DISK_SPD_EXE_64 L"CdmResource\\diskspd\\diskspd64.exe"
-
-int ExecAndWait(TCHAR *pszCmd, BOOL bNoWindow)
-{
-	DWORD Code;
-	BOOL bSuccess;
-	STARTUPINFO si;
-	PROCESS_INFORMATION pi;
-
-	memset(&si, 0, sizeof(STARTUPINFO));
-	si.cb = sizeof(STARTUPINFO);
-
-	if (bNoWindow) {
-		si.dwFlags = STARTF_USESHOWWINDOW;
-		si.wShowWindow = SW_HIDE;
-	}
-
-	bSuccess = CreateProcess(
-		NULL,	// lpApplicationName
-		pszCmd,	// lpCommandLine
-		NULL,	// lpProcessAttributes
-		NULL,	// lpThreadAttributes
-		FALSE,	// bInheritHandle
-		0,		// dwCreationFlag
-		NULL,	// lpEnvironment
-		NULL,	// lpCurrentDirectory
-		&si,	// lpStartupInfo
-		&pi		// lpProcessInformation
-		);
-	if (bSuccess != TRUE) return 0;
-
-	WaitForInputIdle(pi.hProcess, INFINITE);
-	WaitForSingleObject(pi.hProcess, INFINITE);
-	GetExitCodeProcess(pi.hProcess, &Code);
-
-	CloseHandle(pi.hThread);
-	CloseHandle(pi.hProcess);
-
-	return Code;
-}
-
+static DISK_SPD_RESULT DiskSpdResult[TEST_RANDOM_WRITE_4KB3 + 1];
 
 void ShowErrorMessage(CString message)
 {
@@ -202,7 +160,6 @@ UINT ExecDiskBenchRandom4KB3(LPVOID dlg)
 BOOL Init(void* dlg)
 {
 	BOOL FlagArc;
-	BOOL result;
 	static CString cstr;
 	TCHAR drive;
 
@@ -210,27 +167,6 @@ BOOL Init(void* dlg)
 	ULARGE_INTEGER totalNumberOfBytes;
 	ULARGE_INTEGER totalNumberOfFreeBytes;
 
-	// Init m_Ini
-	TCHAR *ptrEnd;
-	TCHAR temp[MAX_PATH];
-	::GetModuleFileName(NULL, temp, MAX_PATH);
-	if ((ptrEnd = _tcsrchr(temp, '\\')) != NULL)
-	{
-		*ptrEnd = '\0';
-	}
-
-#ifdef _M_X64
-	DiskSpdExe.Format(L"%s\\%s", temp, DISK_SPD_EXE_64);
-#else
-	DiskSpdExe.Format(L"%s\\%s", temp, DISK_SPD_EXE_32);
-#endif
-
-	if (! IsFileExist(DiskSpdExe))
-	{
-		AfxMessageBox(((CDiskMarkDlg*) dlg)->m_MesDiskSpdNotFound);
-		((CDiskMarkDlg*) dlg)->m_DiskBenchStatus = FALSE;
-		return FALSE;
-	}
 	DiskTestCount = ((CDiskMarkDlg*) dlg)->m_IndexTestCount + 1;
 	DiskTestSize   = (UINT64)_tstoi(((CDiskMarkDlg*)dlg)->m_ValueTestSize);
 
@@ -293,74 +229,9 @@ BOOL Init(void* dlg)
 	}
 
 // Preapare Test File
-	hFile = ::CreateFile(TestFilePath, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
-			FILE_ATTRIBUTE_NORMAL|FILE_FLAG_NO_BUFFERING|FILE_FLAG_SEQUENTIAL_SCAN, NULL);
-
-	if(hFile == INVALID_HANDLE_VALUE)
-	{
-		AfxMessageBox(((CDiskMarkDlg*)dlg)->m_MesDiskCreateFileError);
-		((CDiskMarkDlg*)dlg)->m_DiskBenchStatus = FALSE;
-		return FALSE;
-	}
-
-// COMPRESSION_FORMAT_NONE
-	USHORT lpInBuffer = COMPRESSION_FORMAT_NONE;
-	DWORD lpBytesReturned = 0;
-	DeviceIoControl(hFile, FSCTL_SET_COMPRESSION, (LPVOID) &lpInBuffer,
-				sizeof(USHORT), NULL, 0, (LPDWORD)&lpBytesReturned, NULL);
-
-
-	// Fill Test Data
-	char* buf = NULL;
-	int BufSize;
-	int Loop;
-	int i;
-	DWORD writesize;
-	BufSize = 1024 * 1024;
-	Loop = (int)DiskTestSize;
-
-	buf = (char*) VirtualAlloc(NULL, BufSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
-	if (buf == NULL)
-	{
-		AfxMessageBox(_T("Failed VirtualAlloc()."));
-		((CDiskMarkDlg*) dlg)->m_DiskBenchStatus = FALSE;
-		return FALSE;
-	}
+	DiskSpd(dlg, TEST_CREATE_FILE);
 
-	if (((CDiskMarkDlg*) dlg)->m_TestData == TEST_DATA_ALL0X00)
-	{
-		for (i = 0; i < BufSize; i++)
-		{
-			buf[i] = 0;
-		}
-	}
-	else
-	{
-		// Compatible with DiskSpd
-		for (i = 0; i < BufSize; i++)
-		{
-			buf[i] = (char) (rand() % 256);
-		}
-	}
-
-	for (i = 0; i < Loop; i++)
-	{
-		if (((CDiskMarkDlg*) dlg)->m_DiskBenchStatus)
-		{
-			result = WriteFile(hFile, buf, BufSize, &writesize, NULL);
-		}
-		else
-		{
-			CloseHandle(hFile);
-			VirtualFree(buf, 0, MEM_RELEASE);
-			((CDiskMarkDlg*) dlg)->m_DiskBenchStatus = FALSE;
-			return FALSE;
-		}
-	}
-	VirtualFree(buf, 0, MEM_RELEASE);
-	CloseHandle(hFile);
-
-	return TRUE;
+	return ((CDiskMarkDlg*)dlg)->m_DiskBenchStatus;
 }
 
 void CALLBACK TimerProc(HWND hwnd, UINT uMsg, UINT_PTR idEvent, DWORD dwTime)
@@ -403,11 +274,10 @@ void DiskSpd(void* dlg, DISK_SPD_CMD cmd)
 	static CString cstr;
 	double score;
 	double *maxScore;
-	CString command;
 	CString title;
 	CString qt;
-	CString option;
-	CString bufOption;
+	DISK_SPD_TEST test;
+	DISK_SPD_RESULT result;
 
 	int j;
 
@@ -416,113 +286,137 @@ void DiskSpd(void* dlg, DISK_SPD_CMD cmd)
 		return;
 	}
 
-
-	if (((CDiskMarkDlg*) dlg)->m_TestData == TEST_DATA_ALL0X00)
-	{
-		bufOption += L" -Z";
-	}
-	else
-	{
-		switch (cmd)
-		{
-		case TEST_SEQUENTIAL_WRITE1:
-#ifdef SEQUENTIAL2
-		case TEST_SEQUENTIAL_WRITE2:
-#endif
-			bufOption += L" -Z128K";
-			break;
-		case TEST_RANDOM_WRITE_4KB1:
-		case TEST_RANDOM_WRITE_4KB2:
-		case TEST_RANDOM_WRITE_4KB3:
-			bufOption += L" -Z4K";
-			break;
-		}
-	}
+	ZeroMemory(&test, sizeof(test));
+	test.Duration = 5;
+	test.Warmup = 0;
+	test.ZeroBuffers = (((CDiskMarkDlg*) dlg)->m_TestData == TEST_DATA_ALL0X00);
 
 	switch (cmd)
 	{
 	case TEST_CREATE_FILE:
-		title = L"Preparing...";
-		::PostMessage(((CDiskMarkDlg*) dlg)->GetSafeHwnd(), WM_USER_UPDATE_MESSAGE, (WPARAM) &title, 0);
-
-		option.Format(L"-c%dM", (int)DiskTestSize);
-		option += bufOption;
-		command.Format(_T("\"%s\" %s \"%s\""), DiskSpdExe, option, TestFilePath);
-		ExecAndWait((TCHAR*) (command.GetString()), TRUE);
+		cstr = L"Preparing...";
+		::PostMessage(((CDiskMarkDlg*) dlg)->GetSafeHwnd(), WM_USER_UPDATE_MESSAGE, (WPARAM) &cstr, 0);
 
+		if (! CreateDiskSpdTestFile(TestFilePath, DiskTestSize, ((CDiskMarkDlg*) dlg)->m_TestData == TEST_DATA_ALL0X00, &((CDiskMarkDlg*) dlg)->m_DiskBenchStatus))
+		{
+			if (((CDiskMarkDlg*) dlg)->m_DiskBenchStatus)
+			{
+				AfxMessageBox(((CDiskMarkDlg*)dlg)->m_MesDiskCreateFileError);
+			}
+			((CDiskMarkDlg*)dlg)->m_DiskBenchStatus = FALSE;
+		}
 		return;
 		break;
 	case TEST_SEQUENTIAL_READ1:
 		title.Format(L"Sequential Read");
 		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*) dlg)->m_SequentialMultiQueues1, ((CDiskMarkDlg*) dlg)->m_SequentialMultiThreads1);
-		option.Format(L"-b128k -d5 -o%d -t%d -W0 -S -w0", ((CDiskMarkDlg*) dlg)->m_SequentialMultiQueues1, ((CDiskMarkDlg*) dlg)->m_SequentialMultiThreads1);
+		test.BlockSize = 128 * 1024;
+		test.Queues = ((CDiskMarkDlg*) dlg)->m_SequentialMultiQueues1;
+		test.Threads = ((CDiskMarkDlg*) dlg)->m_SequentialMultiThreads1;
+		test.WriteRatio = 0;
+		test.Random = FALSE;
 		maxScore = &(((CDiskMarkDlg*) dlg)->m_SequentialReadScore1);
 		break;
 	case TEST_SEQUENTIAL_WRITE1:
 		title.Format(L"Sequential Write");
 		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*) dlg)->m_SequentialMultiQueues1, ((CDiskMarkDlg*) dlg)->m_SequentialMultiThreads1);
-		option.Format(L"-b128k -d5 -o%d -t%d -W0 -S -w100", ((CDiskMarkDlg*) dlg)->m_SequentialMultiQueues1, ((CDiskMarkDlg*) dlg)->m_SequentialMultiThreads1);
-		option += bufOption;
+		test.BlockSize = 128 * 1024;
+		test.Queues = ((CDiskMarkDlg*) dlg)->m_SequentialMultiQueues1;
+		test.Threads = ((CDiskMarkDlg*) dlg)->m_SequentialMultiThreads1;
+		test.WriteRatio = 100;
+		test.Random = FALSE;
 		maxScore = &(((CDiskMarkDlg*) dlg)->m_SequentialWriteScore1);
 		break;
 #ifdef SEQUENTIAL2
 	case TEST_SEQUENTIAL_READ2:
 		title.Format(L"Sequential Read");
-		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*)dlg)->m_SequentialMultiQueues2, ((CDiskMarkDlg*)dlg)->m_SequentialMultiThreads2);
-		option.Format(L"-b128k -d5 -o%d -t%d -W0 -S -w0", ((CDiskMarkDlg*)dlg)->m_SequentialMultiQueues2, ((CDiskMarkDlg*)dlg)->m_SequentialMultiThreads2);
-		maxScore = &(((CDiskMarkDlg*)dlg)->m_SequentialReadScore2);
+		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*) dlg)->m_SequentialMultiQueues2, ((CDiskMarkDlg*) dlg)->m_SequentialMultiThreads2);
+		test.BlockSize = 128 * 1024;
+		test.Queues = ((CDiskMarkDlg*) dlg)->m_SequentialMultiQueues2;
+		test.Threads = ((CDiskMarkDlg*) dlg)->m_SequentialMultiThreads2;
+		test.WriteRatio = 0;
+		test.Random = FALSE;
+		maxScore = &(((CDiskMarkDlg*) dlg)->m_SequentialReadScore2);
 		break;
 	case TEST_SEQUENTIAL_WRITE2:
 		title.Format(L"Sequential Write");
-		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*)dlg)->m_SequentialMultiQueues2, ((CDiskMarkDlg*)dlg)->m_SequentialMultiThreads2);
-		option.Format(L"-b128k -d5 -o%d -t%d -W0 -S -w100", ((CDiskMarkDlg*)dlg)->m_SequentialMultiQueues2, ((CDiskMarkDlg*)dlg)->m_SequentialMultiThreads2);
-		option += bufOption;
-		maxScore = &(((CDiskMarkDlg*)dlg)->m_SequentialWriteScore2);
+		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*) dlg)->m_SequentialMultiQueues2, ((CDiskMarkDlg*) dlg)->m_SequentialMultiThreads2);
+		test.BlockSize = 128 * 1024;
+		test.Queues = ((CDiskMarkDlg*) dlg)->m_SequentialMultiQueues2;
+		test.Threads = ((CDiskMarkDlg*) dlg)->m_SequentialMultiThreads2;
+		test.WriteRatio = 100;
+		test.Random = FALSE;
+		maxScore = &(((CDiskMarkDlg*) dlg)->m_SequentialWriteScore2);
 		break;
 #endif
 	case TEST_RANDOM_READ_4KB1:
 		title.Format(L"Random Read 4KiB");
 		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues1, ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads1);
-		option.Format(L"-b4K -d5 -o%d -t%d -W0 -r -S -w0", ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues1, ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads1);
+		test.BlockSize = 4 * 1024;
+		test.Queues = ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues1;
+		test.Threads = ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads1;
+		test.WriteRatio = 0;
+		test.Random = TRUE;
 		maxScore = &(((CDiskMarkDlg*) dlg)->m_RandomRead4KBScore1);
 		break;
 	case TEST_RANDOM_WRITE_4KB1:
 		title.Format(L"Random Write 4KiB");
 		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues1, ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads1);
-		option.Format(L"-b4K -d5 -o%d -t%d -W0 -r -S -w100", ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues1, ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads1);
-		option += bufOption;
+		test.BlockSize = 4 * 1024;
+		test.Queues = ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues1;
+		test.Threads = ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads1;
+		test.WriteRatio = 100;
+		test.Random = TRUE;
 		maxScore = &(((CDiskMarkDlg*) dlg)->m_RandomWrite4KBScore1);
 		break;
 	case TEST_RANDOM_READ_4KB2:
 		title.Format(L"Random Read 4KiB");
-		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*)dlg)->m_RandomMultiQueues2, ((CDiskMarkDlg*)dlg)->m_RandomMultiThreads2);
-		option.Format(L"-b4K -d5 -o%d -t%d -W0 -r -S -w0", ((CDiskMarkDlg*)dlg)->m_RandomMultiQueues2, ((CDiskMarkDlg*)dlg)->m_RandomMultiThreads2);
-		maxScore = &(((CDiskMarkDlg*)dlg)->m_RandomRead4KBScore2);
+		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues2, ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads2);
+		test.BlockSize = 4 * 1024;
+		test.Queues = ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues2;
+		test.Threads = ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads2;
+		test.WriteRatio = 0;
+		test.Random = TRUE;
+		maxScore = &(((CDiskMarkDlg*) dlg)->m_RandomRead4KBScore2);
 		break;
 	case TEST_RANDOM_WRITE_4KB2:
 		title.Format(L"Random Write 4KiB");
-		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*)dlg)->m_RandomMultiQueues2, ((CDiskMarkDlg*)dlg)->m_RandomMultiThreads2);
-		option.Format(L"-b4K -d5 -o%d -t%d -W0 -r -S -w100", ((CDiskMarkDlg*)dlg)->m_RandomMultiQueues2, ((CDiskMarkDlg*)dlg)->m_RandomMultiThreads2);
-		option += bufOption;
-		maxScore = &(((CDiskMarkDlg*)dlg)->m_RandomWrite4KBScore2);
+		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues2, ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads2);
+		test.BlockSize = 4 * 1024;
+		test.Queues = ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues2;
+		test.Threads = ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads2;
+		test.WriteRatio = 100;
+		test.Random = TRUE;
+		maxScore = &(((CDiskMarkDlg*) dlg)->m_RandomWrite4KBScore2);
 		break;
 	case TEST_RANDOM_READ_4KB3:
 		title.Format(L"Random Read 4KiB");
-		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*)dlg)->m_RandomMultiQueues3, ((CDiskMarkDlg*)dlg)->m_RandomMultiThreads3);
-		option.Format(L"-b4K -d5 -o%d -t%d -W0 -r -S -w0", ((CDiskMarkDlg*)dlg)->m_RandomMultiQueues3, ((CDiskMarkDlg*)dlg)->m_RandomMultiThreads3);
-		maxScore = &(((CDiskMarkDlg*)dlg)->m_RandomRead4KBScore3);
+		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues3, ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads3);
+		test.BlockSize = 4 * 1024;
+		test.Queues = ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues3;
+		test.Threads = ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads3;
+		test.WriteRatio = 0;
+		test.Random = TRUE;
+		maxScore = &(((CDiskMarkDlg*) dlg)->m_RandomRead4KBScore3);
 		break;
 	case TEST_RANDOM_WRITE_4KB3:
 		title.Format(L"Random Write 4KiB");
-		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*)dlg)->m_RandomMultiQueues3, ((CDiskMarkDlg*)dlg)->m_RandomMultiThreads3);
-		option.Format(L"-b4K -d5 -o%d -t%d -W0 -r -S -w100", ((CDiskMarkDlg*)dlg)->m_RandomMultiQueues3, ((CDiskMarkDlg*)dlg)->m_RandomMultiThreads3);
-		option += bufOption;
-		maxScore = &(((CDiskMarkDlg*)dlg)->m_RandomWrite4KBScore3);
+		qt.Format(L"[Q=%d/T=%d]", ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues3, ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads3);
+		test.BlockSize = 4 * 1024;
+		test.Queues = ((CDiskMarkDlg*) dlg)->m_RandomMultiQueues3;
+		test.Threads = ((CDiskMarkDlg*) dlg)->m_RandomMultiThreads3;
+		test.WriteRatio = 100;
+		test.Random = TRUE;
+		maxScore = &(((CDiskMarkDlg*) dlg)->m_RandomWrite4KBScore3);
+		break;
+	default:
+		return;
 		break;
 	}
 
 	score = 0.0;
 	*maxScore = 0.0;
+	ZeroMemory(&DiskSpdResult[cmd], sizeof(DISK_SPD_RESULT));
 	for (j = 0; j <= DiskTestCount; j++)
 	{
 		if (j == 0)
@@ -534,14 +428,20 @@ void DiskSpd(void* dlg, DISK_SPD_CMD cmd)
 			cstr.Format(L"%s [%d/%d]", title, j, DiskTestCount);
 		}
 		::PostMessage(((CDiskMarkDlg*) dlg)->GetSafeHwnd(), WM_USER_UPDATE_MESSAGE, (WPARAM) &cstr, 0);
-		
-		command.Format(_T("\"%s\" %s \"%s\""), DiskSpdExe, option, TestFilePath);
 
-		score = ExecAndWait((TCHAR*) (command.GetString()), TRUE) / 10 / 1000.0;
+		if (ExecDiskSpd(TestFilePath, &test, &result, NULL))
+		{
+			score = result.BytesPerSec / 1000 / 1000;
+		}
+		else
+		{
+			score = 0.0;
+		}
 
 		if (j > 0 && score > *maxScore)
 		{
 			*maxScore = score;
+			DiskSpdResult[cmd] = result;
 			::PostMessage(((CDiskMarkDlg*) dlg)->GetSafeHwnd(), WM_USER_UPDATE_SCORE, 0, 0);
 		}
 
@@ -552,3 +452,8 @@ void DiskSpd(void* dlg, DISK_SPD_CMD cmd)
 	}
 	::PostMessage(((CDiskMarkDlg*) dlg)->GetSafeHwnd(), WM_USER_UPDATE_SCORE, 0, 0);
 }
+
+const DISK_SPD_RESULT* GetDiskSpdResult(DISK_SPD_CMD cmd)
+{
+	return &DiskSpdResult[cmd];
+}
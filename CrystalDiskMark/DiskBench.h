@@ -51,3 +51,6 @@ UINT ExecDiskBenchSequential2(void* dlg);
 UINT ExecDiskBenchRandom4KB1(void* dlg);
 UINT ExecDiskBenchRandom4KB2(void* dlg);
 UINT ExecDiskBenchRandom4KB3(void* dlg);
+
+// Best pass of the last run of each test
+const struct DISK_SPD_RESULT* GetDiskSpdResult(DISK_SPD_CMD cmd);
@@ -0,0 +1,627 @@
+/*---------------------------------------------------------------------------*/
+//       Author : hiyohiyo
+//         Mail : hiyohiyo@crystalmark.info
+//          Web : http://crystalmark.info/
+//      License : The MIT License
+//
+//                                             Copyright (c) 2007-2015 hiyohiyo
+/*---------------------------------------------------------------------------*/
+
+// Command line runner of the standard CrystalDiskMark test set.
+// Runs the same tests, passes and intervals as ExecDiskBenchAll() without the dialog.
+// -l runs the tests of a test list file (see LoadDiskSpdTestList()) in file order instead.
+// -N repeats each test until the 95% confidence interval of its passes is within a tolerance
+// and reports the median pass rather than the best one.
+
+#include <windows.h>
+#include <atlstr.h>
+#include <stdio.h>
+#include <mmsystem.h>
+#pragma comment(lib,"winmm.lib")
+
+#include "DiskSpdDriver.h"
+
+#define PRODUCT_NAME			_T("CrystalDiskMark")
+#define PRODUCT_VERSION			_T("6.0.0")
+#define PRODUCT_COPY_YEAR		_T("2007-2017")
+
+#define ALL_0X00_0FILL			_T("<0Fill>")
+
+#define SUITE_PASS_MAX			99
+
+struct SUITE_TEST
+{
+	DISK_SPD_TEST_ENTRY Entry;
+	BOOL BlankLineAfter;	// ResultText grouping
+	double Score;		// MB/s
+	DISK_SPD_RESULT Result;
+	double PassScore[SUITE_PASS_MAX];	// MB/s of every measured pass
+	DISK_SPD_STATISTICS Stats;
+};
+
+// ResultText order of the standard test set
+enum
+{
+	SEQ_READ_1 = 0,
+	SEQ_WRITE_1,
+	RND_READ_1,
+	RND_WRITE_1,
+	RND_READ_2,
+	RND_WRITE_2,
+	RND_READ_3,
+	RND_WRITE_3,
+	STANDARD_TEST_COUNT,
+};
+
+static const struct
+{
+	LPCWSTR Name;
+	DWORD BlockSize;
+	BOOL Random;
+	DWORD WriteRatio;
+	DWORD Queues;
+	DWORD Threads;
+} StandardTests[STANDARD_TEST_COUNT] =
+{
+	{ L"Sequential Read",  128 * 1024, FALSE, 0,   32, 1 },
+	{ L"Sequential Write", 128 * 1024, FALSE, 100, 32, 1 },
+	{ L"Random Read 4KiB", 4 * 1024,   TRUE,  0,    8, 8 },
+	{ L"Random Write 4KiB",4 * 1024,   TRUE,  100,  8, 8 },
+	{ L"Random Read 4KiB", 4 * 1024,   TRUE,  0,   32, 1 },
+	{ L"Random Write 4KiB",4 * 1024,   TRUE,  100, 32, 1 },
+	{ L"Random Read 4KiB", 4 * 1024,   TRUE,  0,    1, 1 },
+	{ L"Random Write 4KiB",4 * 1024,   TRUE,  100,  1, 1 },
+};
+
+// Execution order of ExecDiskBenchAll(): reads first, then writes
+static const int StandardOrder[STANDARD_TEST_COUNT] =
+{
+	SEQ_READ_1, RND_READ_1, RND_READ_2, RND_READ_3,
+	SEQ_WRITE_1, RND_WRITE_1, RND_WRITE_2, RND_WRITE_3,
+};
+
+static SUITE_TEST Suite[DISK_SPD_TEST_LIST_MAX];
+static int SuiteOrder[DISK_SPD_TEST_LIST_MAX];
+static int SuiteCount = 0;
+
+static int TestCount = 5;
+static int TestSize = 1024;		// MiB
+static int IntervalTime = 5;	// sec
+static BOOL TestDataZero = FALSE;
+static BOOL MedianPass = FALSE;		// -N
+static double PassTolerance = 0.0;	// %, 0 = always run TestCount passes
+static int MinPassCount = 3;
+static int SteadyStateWarmup = 0;	// sec, -w
+static CString TargetPath;
+static CString OutputPath;
+static CString TestListPath;
+
+static volatile BOOL Running = TRUE;
+static HANDLE StopEvent = NULL;
+
+static BOOL WINAPI CtrlHandler(DWORD ctrlType)
+{
+	UNREFERENCED_PARAMETER(ctrlType);
+	Running = FALSE;
+	SetEvent(StopEvent);
+	return TRUE;
+}
+
+static void Usage()
+{
+	wprintf(L"Usage: DiskMarkCmd [options] <target directory>\n"
+		L"  -n<count>    passes per test, 1-9 (default 5)\n"
+		L"  -N<max>[:<tolerance>[:<min>]]\n"
+		L"               up to <max> passes per test (1-99), stop once the 95%% confidence\n"
+		L"               interval is within <tolerance> %% after <min> passes (default 3);\n"
+		L"               the median pass is reported instead of the best one\n"
+		L"  -s<MiB>      test file size (default 1024)\n"
+		L"  -i<sec>      interval between tests (default 5)\n"
+		L"  -z           fill the test data with 0x00\n"
+		L"  -w<sec>      warm up each pass until IOPS and latency settle, at most <sec>\n"
+		L"  -q<index>=<queues>,<threads>\n"
+		L"               queues/threads of a test: s1 = Seq, r1/r2/r3 = 4KiB (not with -l)\n"
+		L"  -ini<file>   read the settings of DiskMark.ini\n"
+		L"  -l<file>     run the tests of a test list file instead of the standard set\n"
+		L"  -o<file>     write the results as JSON\n");
+}
+
+static void InitStandardSuite()
+{
+	for (int i = 0; i < STANDARD_TEST_COUNT; i++)
+	{
+		DISK_SPD_TEST_ENTRY* entry = &Suite[i].Entry;
+		wcscpy_s(entry->Name, StandardTests[i].Name);
+		entry->Test.BlockSize = StandardTests[i].BlockSize;
+		entry->Test.Random = StandardTests[i].Random;
+		entry->Test.WriteRatio = StandardTests[i].WriteRatio;
+		entry->Test.Queues = StandardTests[i].Queues;
+		entry->Test.Threads = StandardTests[i].Threads;
+		entry->Test.Duration = 5;
+		entry->Test.Warmup = 0;
+		Suite[i].BlankLineAfter = (i == RND_WRITE_1 || i == RND_WRITE_2);
+		SuiteOrder[i] = StandardOrder[i];
+	}
+	SuiteCount = STANDARD_TEST_COUNT;
+}
+
+static BOOL LoadTestList(LPCWSTR path)
+{
+	DISK_SPD_TEST_ENTRY entries[DISK_SPD_TEST_LIST_MAX];
+	int count = LoadDiskSpdTestList(path, entries, DISK_SPD_TEST_LIST_MAX);
+	if (count == 0)
+	{
+		return FALSE;
+	}
+
+	ZeroMemory(Suite, sizeof(Suite));
+	for (int i = 0; i < count; i++)
+	{
+		Suite[i].Entry = entries[i];
+		SuiteOrder[i] = i;
+	}
+	SuiteCount = count;
+	return TRUE;
+}
+
+static BOOL SetQueuesThreads(int read, int write, int queues, int threads)
+{
+	if (queues < 1 || queues > MAX_QUEUES || threads < 1 || threads > MAX_THREADS)
+	{
+		return FALSE;
+	}
+	Suite[read].Entry.Test.Queues = Suite[write].Entry.Test.Queues = queues;
+	Suite[read].Entry.Test.Threads = Suite[write].Entry.Test.Threads = threads;
+	return TRUE;
+}
+
+// Same keys and ranges as CDiskMarkDlg::OnInitDialog()
+static void LoadIni(LPCWSTR ini)
+{
+	int value = GetPrivateProfileInt(_T("Settings"), _T("TestCount"), 4, ini);
+	TestCount = (value < 0 || value >= 9) ? 5 : value + 1;
+
+	value = GetPrivateProfileInt(_T("Settings"), _T("IntervalTime"), 5, ini);
+	IntervalTime = (value < 0) ? 5 : value;
+
+	TestDataZero = (GetPrivateProfileInt(_T("Settings"), _T("TestData"), 0, ini) == 1);
+
+	SetQueuesThreads(SEQ_READ_1, SEQ_WRITE_1,
+		GetPrivateProfileInt(_T("Settings"), _T("SequentialMultiQueues1"), 32, ini),
+		GetPrivateProfileInt(_T("Settings"), _T("SequentialMultiThreads1"), 1, ini));
+	SetQueuesThreads(RND_READ_1, RND_WRITE_1,
+		GetPrivateProfileInt(_T("Settings"), _T("RandomMultiQueues1"), 8, ini),
+		GetPrivateProfileInt(_T("Settings"), _T("RandomMultiThreads1"), 8, ini));
+	SetQueuesThreads(RND_READ_2, RND_WRITE_2,
+		GetPrivateProfileInt(_T("Settings"), _T("RandomMultiQueues2"), 32, ini),
+		GetPrivateProfileInt(_T("Settings"), _T("RandomMultiThreads2"), 1, ini));
+	SetQueuesThreads(RND_READ_3, RND_WRITE_3,
+		GetPrivateProfileInt(_T("Settings"), _T("RandomMultiQueues3"), 1, ini),
+		GetPrivateProfileInt(_T("Settings"), _T("RandomMultiThreads3"), 1, ini));
+}
+
+static BOOL ParseArgs(int argc, wchar_t* argv[])
+{
+	BOOL queuesThreadsSet = FALSE;
+	for (int i = 1; i < argc; i++)
+	{
+		LPCWSTR arg = argv[i];
+		if (arg[0] != L'-' && arg[0] != L'/')
+		{
+			TargetPath = arg;
+			continue;
+		}
+
+		arg++;
+		if (_wcsnicmp(arg, L"ini", 3) == 0)
+		{
+			LoadIni(arg + 3);
+		}
+		else if (arg[0] == L'n')
+		{
+			TestCount = _wtoi(arg + 1);
+			if (TestCount < 1 || TestCount > 9)
+			{
+				return FALSE;
+			}
+		}
+		else if (arg[0] == L'N')
+		{
+			double tolerance = 0.0;
+			int minCount = 3;
+			if (swscanf_s(arg + 1, L"%d:%lf:%d", &TestCount, &tolerance, &minCount) < 1
+			||  TestCount < 1 || TestCount > SUITE_PASS_MAX || tolerance < 0.0 || minCount < 2)
+			{
+				return FALSE;
+			}
+			MedianPass = TRUE;
+			PassTolerance = tolerance;
+			MinPassCount = minCount;
+		}
+		else if (arg[0] == L's')
+		{
+			TestSize = _wtoi(arg + 1);
+			if (TestSize < 1)
+			{
+				return FALSE;
+			}
+		}
+		else if (arg[0] == L'i')
+		{
+			IntervalTime = _wtoi(arg + 1);
+			if (IntervalTime < 0)
+			{
+				return FALSE;
+			}
+		}
+		else if (arg[0] == L'w')
+		{
+			SteadyStateWarmup = _wtoi(arg + 1);
+			if (SteadyStateWarmup < 1)
+			{
+				return FALSE;
+			}
+		}
+		else if (arg[0] == L'z')
+		{
+			TestDataZero = TRUE;
+		}
+		else if (arg[0] == L'q')
+		{
+			int queues = 0, threads = 0;
+			WCHAR kind = 0;
+			int index = 0;
+			if (swscanf_s(arg + 1, L"%c%d=%d,%d", &kind, 1, &index, &queues, &threads) != 4)
+			{
+				return FALSE;
+			}
+			if (kind == L's' && index == 1)
+			{
+				if (! SetQueuesThreads(SEQ_READ_1, SEQ_WRITE_1, queues, threads)) return FALSE;
+			}
+			else if (kind == L'r' && index >= 1 && index <= 3)
+			{
+				if (! SetQueuesThreads(RND_READ_1 + (index - 1) * 2, RND_WRITE_1 + (index - 1) * 2, queues, threads)) return FALSE;
+			}
+			else
+			{
+				return FALSE;
+			}
+			queuesThreadsSet = TRUE;
+		}
+		else if (arg[0] == L'o')
+		{
+			OutputPath = arg + 1;
+		}
+		else if (arg[0] == L'l')
+		{
+			TestListPath = arg + 1;
+		}
+		else
+		{
+			return FALSE;
+		}
+	}
+	// -q names tests of the standard set; a test list sets its own queues and threads
+	if (! TestListPath.IsEmpty() && queuesThreadsSet)
+	{
+		fwprintf(stderr, L"ERROR: -q cannot be combined with -l; set Queues and Threads in the test list\n");
+		return FALSE;
+	}
+	if (! TestListPath.IsEmpty() && ! LoadTestList(TestListPath))
+	{
+		fwprintf(stderr, L"ERROR: invalid test list %s\n", (LPCWSTR)TestListPath);
+		return FALSE;
+	}
+	return ! TargetPath.IsEmpty();
+}
+
+static void Interval()
+{
+	for (int i = 0; i < IntervalTime && Running; i++)
+	{
+		fwprintf(stderr, L"Interval Time %d/%d sec\r", i, IntervalTime);
+		WaitForSingleObject(StopEvent, 1000);
+	}
+}
+
+// Same pass loop as DiskSpd() in DiskBench.cpp: pass 0 prepares, the best of the rest counts.
+// With -N the median of the rest counts and the loop ends once the passes agree within PassTolerance.
+static void DiskSpd(LPCWSTR testFilePath, SUITE_TEST* suite)
+{
+	DISK_SPD_TEST test = suite->Entry.Test;
+	DISK_SPD_RESULT result;
+	DISK_SPD_RESULT passResult[SUITE_PASS_MAX];
+	int passCount = 0;
+
+	test.ZeroBuffers = TestDataZero;
+	if (SteadyStateWarmup > 0 && ! test.SteadyState)
+	{
+		test.Warmup = SteadyStateWarmup;
+		test.SteadyState = TRUE;
+	}
+
+	suite->Score = 0.0;
+	ZeroMemory(&suite->Result, sizeof(DISK_SPD_RESULT));
+	ZeroMemory(&suite->Stats, sizeof(DISK_SPD_STATISTICS));
+	for (int j = 0; j <= TestCount && Running; j++)
+	{
+		if (j == 0)
+		{
+			fwprintf(stderr, L"Preparing... %s [Q=%d/T=%d]          \r", suite->Entry.Name, test.Queues, test.Threads);
+		}
+		else
+		{
+			fwprintf(stderr, L"%s [Q=%d/T=%d] [%d/%d]          \r", suite->Entry.Name, test.Queues, test.Threads, j, TestCount);
+		}
+
+		if (ExecDiskSpd(testFilePath, &test, &result, StopEvent) && Running)
+		{
+			double score = result.BytesPerSec / 1000 / 1000;
+			if (j > 0)
+			{
+				suite->PassScore[passCount] = score;
+				passResult[passCount] = result;
+				passCount++;
+			}
+			if (j > 0 && score > suite->Score)
+			{
+				suite->Score = score;
+				suite->Result = result;
+			}
+		}
+
+		if (MedianPass && PassTolerance > 0.0 && passCount >= min(MinPassCount, TestCount))
+		{
+			GetDiskSpdStatistics(suite->PassScore, passCount, &suite->Stats);
+			if (suite->Stats.Ci95Percent <= PassTolerance)
+			{
+				break;
+			}
+		}
+	}
+
+	if (passCount == 0)
+	{
+		return;
+	}
+
+	GetDiskSpdStatistics(suite->PassScore, passCount, &suite->Stats);
+	if (MedianPass)
+	{
+		// the lower one of the middle two for an even count
+		int order[SUITE_PASS_MAX];
+		for (int i = 0; i < passCount; i++)
+		{
+			order[i] = i;
+			for (int k = i; k > 0 && suite->PassScore[order[k - 1]] > suite->PassScore[order[k]]; k--)
+			{
+				int t = order[k]; order[k] = order[k - 1]; order[k - 1] = t;
+			}
+		}
+		int median = order[(passCount - 1) / 2];
+		suite->Score = suite->PassScore[median];
+		suite->Result = passResult[median];
+	}
+}
+
+static void GetOsName(CString& osName)
+{
+	WCHAR productName[256] = L"Windows";
+	WCHAR build[32] = L"";
+	DWORD size;
+	HKEY hKey;
+
+	if (RegOpenKeyEx(HKEY_LOCAL_MACHINE, L"SOFTWARE\\Microsoft\\Windows NT\\CurrentVersion", 0, KEY_READ, &hKey) == ERROR_SUCCESS)
+	{
+		size = sizeof(productName);
+		RegQueryValueEx(hKey, L"ProductName", NULL, NULL, (LPBYTE)productName, &size);
+		size = sizeof(build);
+		RegQueryValueEx(hKey, L"CurrentBuild", NULL, NULL, (LPBYTE)build, &size);
+		RegCloseKey(hKey);
+	}
+	osName.Format(L"%s [Build %s]", productName, build);
+}
+
+static CString ResultText(const CString& driveInfo)
+{
+	CString clip, cstr;
+
+	clip.Format(L"\
+-----------------------------------------------------------------------\r\n\
+%s %s (C) %s hiyohiyo\r\n\
+                          Crystal Dew World : https://crystalmark.info/\r\n\
+-----------------------------------------------------------------------\r\n\
+* MB/s = 1,000,000 bytes/s [SATA/600 = 600,000,000 bytes/s]\r\n\
+* KB = 1000 bytes, KiB = 1024 bytes\r\n\
+\r\n", PRODUCT_NAME, PRODUCT_VERSION, PRODUCT_COPY_YEAR);
+
+	for (int i = 0; i < SuiteCount; i++)
+	{
+		const DISK_SPD_TEST_ENTRY& entry = Suite[i].Entry;
+		if (entry.Test.Random)
+		{
+			cstr.Format(L"%18s (Q=%3d,T=%2d) : %9.3f MB/s [%9.1f IOPS] <%8.2f us>", entry.Name, entry.Test.Queues, entry.Test.Threads,
+				Suite[i].Score, Suite[i].Result.IoPerSec, Suite[i].Result.LatencyAverage);
+		}
+		else
+		{
+			cstr.Format(L"%18s (Q=%3d,T=%2d) : %9.3f MB/s", entry.Name, entry.Test.Queues, entry.Test.Threads, Suite[i].Score);
+		}
+		clip += cstr;
+		if (MedianPass)
+		{
+			cstr.Format(L" (+/-%5.2f%%, x%d)", Suite[i].Stats.Ci95Percent, Suite[i].Stats.Count);
+			clip += cstr;
+		}
+		clip += L"\r\n";
+		if (Suite[i].BlankLineAfter)
+		{
+			clip += L"\r\n";
+		}
+	}
+
+	cstr.Format(L"\r\n  Test : %d MiB [%s] (x%d) %s [Interval=%d sec]\r\n", TestSize, (LPCWSTR)driveInfo, TestCount,
+		TestDataZero ? ALL_0X00_0FILL : L"", IntervalTime);
+	clip += cstr;
+	if (MedianPass)
+	{
+		cstr.Format(L"Passes : median of up to %d, 95%% CI <= %.2f%% after %d\r\n", TestCount, PassTolerance, min(MinPassCount, TestCount));
+		clip += cstr;
+	}
+	if (SteadyStateWarmup > 0)
+	{
+		cstr.Format(L"Warmup : until steady state, at most %d sec\r\n", SteadyStateWarmup);
+		clip += cstr;
+	}
+
+	SYSTEMTIME st;
+	GetLocalTime(&st);
+	cstr.Format(_T("  Date : %04d/%02d/%02d %d:%02d:%02d\r\n"), st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond);
+	clip += cstr;
+
+	CString osName;
+	GetOsName(osName);
+	clip += L"    OS : " + osName + L"\r\n";
+
+	return clip;
+}
+
+static BOOL WriteJson(LPCWSTR path)
+{
+	FILE* pFile;
+	if (_wfopen_s(&pFile, path, L"w,ccs=UTF-8") != 0)
+	{
+		return FALSE;
+	}
+
+	CString target(TargetPath);
+	target.Replace(L"\\", L"\\\\");
+	target.Replace(L"\"", L"\\\"");
+
+	fwprintf(pFile, L"{\n");
+	fwprintf(pFile, L"  \"product\": \"%s %s\",\n", PRODUCT_NAME, PRODUCT_VERSION);
+	fwprintf(pFile, L"  \"target\": \"%s\",\n", (LPCWSTR)target);
+	fwprintf(pFile, L"  \"testSizeMiB\": %d,\n", TestSize);
+	fwprintf(pFile, L"  \"testCount\": %d,\n", TestCount);
+	fwprintf(pFile, L"  \"intervalSeconds\": %d,\n", IntervalTime);
+	fwprintf(pFile, L"  \"testData\": \"%s\",\n", TestDataZero ? L"0x00" : L"random");
+	fwprintf(pFile, L"  \"reportedPass\": \"%s\",\n", MedianPass ? L"median" : L"best");
+	fwprintf(pFile, L"  \"passTolerancePercent\": %.2f,\n", PassTolerance);
+	fwprintf(pFile, L"  \"tests\": [\n");
+	for (int i = 0; i < SuiteCount; i++)
+	{
+		const SUITE_TEST& t = Suite[i];
+		CString name(t.Entry.Name);
+		name.Replace(L"\\", L"\\\\");
+		name.Replace(L"\"", L"\\\"");
+		fwprintf(pFile, L"    { \"name\": \"%s\", \"blockSize\": %u, \"random\": %s, \"writeRatio\": %u, \"queues\": %u, \"threads\": %u, \"durationSeconds\": %u,"
+			L" \"mbps\": %.3f, \"iops\": %.1f, \"latencyAverageUs\": %.2f, \"latency50Us\": %.2f, \"latency99Us\": %.2f, \"latency999Us\": %.2f, \"cpuPercent\": %.2f, \"cpuUsPerIo\": %.3f,"
+			L" \"warmupSeconds\": %.2f, \"steadyState\": %s,",
+			(LPCWSTR)name, t.Entry.Test.BlockSize, t.Entry.Test.Random ? L"true" : L"false", t.Entry.Test.WriteRatio,
+			t.Entry.Test.Queues, t.Entry.Test.Threads, t.Entry.Test.Duration,
+			t.Score, t.Result.IoPerSec, t.Result.LatencyAverage, t.Result.Latency50, t.Result.Latency99, t.Result.Latency999, t.Result.CpuUsage, t.Result.CpuPerIo,
+			t.Result.WarmupTime, t.Result.SteadyStateReached ? L"true" : L"false");
+		fwprintf(pFile, L" \"passesMbps\": [");
+		for (int j = 0; j < t.Stats.Count; j++)
+		{
+			fwprintf(pFile, L"%s%.3f", (j > 0) ? L", " : L"", t.PassScore[j]);
+		}
+		fwprintf(pFile, L"], \"medianMbps\": %.3f, \"meanMbps\": %.3f, \"stdDevMbps\": %.3f, \"ci95Mbps\": %.3f, \"ci95Percent\": %.2f }%s\n",
+			t.Stats.Median, t.Stats.Mean, t.Stats.StdDev, t.Stats.Ci95, t.Stats.Ci95Percent,
+			(i + 1 < SuiteCount) ? L"," : L"");
+	}
+	fwprintf(pFile, L"  ]\n");
+	fwprintf(pFile, L"}\n");
+	fclose(pFile);
+	return TRUE;
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	InitStandardSuite();
+	if (! ParseArgs(argc, argv))
+	{
+		Usage();
+		return 1;
+	}
+
+	StopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	SetConsoleCtrlHandler(CtrlHandler, TRUE);
+
+	CString rootPath = TargetPath;
+	if (rootPath.Right(1) != L"\\")
+	{
+		rootPath += L"\\";
+	}
+
+	ULARGE_INTEGER freeBytesAvailableToCaller, totalNumberOfBytes, totalNumberOfFreeBytes;
+	if (! GetDiskFreeSpaceEx(rootPath, &freeBytesAvailableToCaller, &totalNumberOfBytes, &totalNumberOfFreeBytes))
+	{
+		fwprintf(stderr, L"ERROR: cannot access %s (error code: %u)\n", (LPCWSTR)rootPath, GetLastError());
+		return 1;
+	}
+	if ((UINT64)TestSize > totalNumberOfFreeBytes.QuadPart / 1024 / 1024)
+	{
+		fwprintf(stderr, L"ERROR: not enough free space for a %d MiB test file\n", TestSize);
+		return 1;
+	}
+
+	CString driveInfo;
+	driveInfo.Format(_T("%s %.1f%% (%.1f/%.1f GiB)"), (LPCWSTR)TargetPath,
+		(double)(totalNumberOfBytes.QuadPart - totalNumberOfFreeBytes.QuadPart) / (double)totalNumberOfBytes.QuadPart * 100,
+		(totalNumberOfBytes.QuadPart - totalNumberOfFreeBytes.QuadPart) / 1024 / 1024 / 1024.0,
+		totalNumberOfBytes.QuadPart / 1024 / 1024 / 1024.0);
+
+	CString testFileDir, testFilePath;
+	testFileDir.Format(_T("%sCrystalDiskMark%08X"), (LPCWSTR)rootPath, timeGetTime());
+	CreateDirectory(testFileDir, NULL);
+	testFilePath.Format(_T("%s\\CrystalDiskMark%08X.tmp"), (LPCWSTR)testFileDir, timeGetTime());
+
+	int exitCode = 0;
+	fwprintf(stderr, L"Preparing...\r");
+	if (! CreateDiskSpdTestFile(testFilePath, TestSize, TestDataZero, &Running))
+	{
+		fwprintf(stderr, L"ERROR: cannot create the test file %s (error code: %u)\n", (LPCWSTR)testFilePath, GetLastError());
+		exitCode = 1;
+	}
+	else
+	{
+		for (int i = 0; i < SuiteCount && Running; i++)
+		{
+			if (i > 0)
+			{
+				Interval();
+			}
+			DiskSpd(testFilePath, &Suite[SuiteOrder[i]]);
+		}
+	}
+
+	DeleteFile(testFilePath);
+	RemoveDirectory(testFileDir);
+	fwprintf(stderr, L"%60s\r", L"");
+
+	if (exitCode == 0)
+	{
+		if (! Running)
+		{
+			fwprintf(stderr, L"Aborted.\n");
+			exitCode = 1;
+		}
+		else
+		{
+			// stdout is in text mode
+			CString text = ResultText(driveInfo);
+			text.Replace(L"\r\n", L"\n");
+			wprintf(L"%s", (LPCWSTR)text);
+			if (! OutputPath.IsEmpty() && ! WriteJson(OutputPath))
+			{
+				fwprintf(stderr, L"ERROR: cannot write %s\n", (LPCWSTR)OutputPath);
+				exitCode = 1;
+			}
+		}
+	}
+
+	CloseHandle(StopEvent);
+	return exitCode;
+}
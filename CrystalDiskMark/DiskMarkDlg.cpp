@@ -11,6 +11,7 @@
 #include "DiskMark.h"
 #include "DiskMarkDlg.h"
 #include "DiskBench.h"
+#include "DiskSpdDriver.h"
 #include "AboutDlg.h"
 #include "GetFileVersion.h"
 #include "GetOsInfo.h"
@@ -507,17 +508,17 @@ void CDiskMarkDlg::UpdateScore()
 
 	// Set IOPS value as title
 	CString cstr;
-	cstr.Format(_T("%8.1f IOPS"), m_RandomRead4KBScore1 * 1000 * 1000 / 4096);
+	cstr.Format(_T("%8.1f IOPS"), GetDiskSpdResult(TEST_RANDOM_READ_4KB1)->IoPerSec);
 	SetElementPropertyEx(_T("RandomRead4KB1"), DISPID_IHTMLELEMENT_TITLE, cstr);
-	cstr.Format(_T("%8.1f IOPS"), m_RandomWrite4KBScore1 * 1000 * 1000 / 4096);
+	cstr.Format(_T("%8.1f IOPS"), GetDiskSpdResult(TEST_RANDOM_WRITE_4KB1)->IoPerSec);
 	SetElementPropertyEx(_T("RandomWrite4KB1"), DISPID_IHTMLELEMENT_TITLE, cstr);
-	cstr.Format(_T("%8.1f IOPS"), m_RandomRead4KBScore2 * 1000 * 1000 / 4096);
+	cstr.Format(_T("%8.1f IOPS"), GetDiskSpdResult(TEST_RANDOM_READ_4KB2)->IoPerSec);
 	SetElementPropertyEx(_T("RandomRead4KB2"), DISPID_IHTMLELEMENT_TITLE, cstr);
-	cstr.Format(_T("%8.1f IOPS"), m_RandomWrite4KBScore2 * 1000 * 1000 / 4096);
+	cstr.Format(_T("%8.1f IOPS"), GetDiskSpdResult(TEST_RANDOM_WRITE_4KB2)->IoPerSec);
 	SetElementPropertyEx(_T("RandomWrite4KB2"), DISPID_IHTMLELEMENT_TITLE, cstr);
-	cstr.Format(_T("%8.1f IOPS"), m_RandomRead4KBScore3 * 1000 * 1000 / 4096);
+	cstr.Format(_T("%8.1f IOPS"), GetDiskSpdResult(TEST_RANDOM_READ_4KB3)->IoPerSec);
 	SetElementPropertyEx(_T("RandomRead4KB3"), DISPID_IHTMLELEMENT_TITLE, cstr);
-	cstr.Format(_T("%8.1f IOPS"), m_RandomWrite4KBScore3 * 1000 * 1000 / 4096);
+	cstr.Format(_T("%8.1f IOPS"), GetDiskSpdResult(TEST_RANDOM_WRITE_4KB3)->IoPerSec);
 	SetElementPropertyEx(_T("RandomWrite4KB3"), DISPID_IHTMLELEMENT_TITLE, cstr);
 }
 
@@ -1177,12 +1178,6 @@ void CDiskMarkDlg::ChangeLang(CString LangName)
 	m_MesDiskWriteError = i18n(_T("Message"), _T("DISK_WRITE_ERROR"));
 	m_MesDiskReadError = i18n(_T("Message"), _T("DISK_READ_ERROR"));
 
-#ifdef _M_X64
-	m_MesDiskSpdNotFound = L"Not found diskspd64.exe";//i18n(_T("Message"), _T("DISK_SPD_NOT_FOUND"));
-#else
-	m_MesDiskSpdNotFound = L"Not found diskspd32.exe";//i18n(_T("Message"), _T("DISK_SPD_NOT_FOUND"));
-#endif
-
 	InitDrive(_T("TestDrive"));
 
 	m_TitleTestDrive = i18n(_T("Title"), _T("TEST_DRIVE"));
@@ -1323,19 +1318,19 @@ void CDiskMarkDlg::ResultText(RESULT_TEXT type)
 	cstr.Format(_T("  Sequential Write (Q=%3d,T=%2d) : %9.3f MB/s"), m_SequentialMultiQueues2, m_SequentialMultiThreads2, m_SequentialWriteScore2);
 	clip.Replace(_T("%SequentialWrite2%"), cstr);
 #endif
-	cstr.Format(_T("  Random Read 4KiB (Q=%3d,T=%2d) : %9.3f MB/s [%9.1f IOPS]"), m_RandomMultiQueues1, m_RandomMultiThreads1, m_RandomRead4KBScore1, m_RandomRead4KBScore1 * 1000 * 1000 / 4096);
+	cstr.Format(_T("  Random Read 4KiB (Q=%3d,T=%2d) : %9.3f MB/s [%9.1f IOPS] <%8.2f us>"), m_RandomMultiQueues1, m_RandomMultiThreads1, m_RandomRead4KBScore1, GetDiskSpdResult(TEST_RANDOM_READ_4KB1)->IoPerSec, GetDiskSpdResult(TEST_RANDOM_READ_4KB1)->LatencyAverage);
 	clip.Replace(_T("%RandomRead4KB1%"), cstr);
-	cstr.Format(_T(" Random Write 4KiB (Q=%3d,T=%2d) : %9.3f MB/s [%9.1f IOPS]"), m_RandomMultiQueues1, m_RandomMultiThreads1, m_RandomWrite4KBScore1, m_RandomWrite4KBScore1 * 1000 * 1000 / 4096);
+	cstr.Format(_T(" Random Write 4KiB (Q=%3d,T=%2d) : %9.3f MB/s [%9.1f IOPS] <%8.2f us>"), m_RandomMultiQueues1, m_RandomMultiThreads1, m_RandomWrite4KBScore1, GetDiskSpdResult(TEST_RANDOM_WRITE_4KB1)->IoPerSec, GetDiskSpdResult(TEST_RANDOM_WRITE_4KB1)->LatencyAverage);
 	clip.Replace(_T("%RandomWrite4KB1%"), cstr);
 
-	cstr.Format(_T("  Random Read 4KiB (Q=%3d,T=%2d) : %9.3f MB/s [%9.1f IOPS]"), m_RandomMultiQueues2, m_RandomMultiThreads2, m_RandomRead4KBScore2, m_RandomRead4KBScore2 * 1000 * 1000 / 4096);
+	cstr.Format(_T("  Random Read 4KiB (Q=%3d,T=%2d) : %9.3f MB/s [%9.1f IOPS] <%8.2f us>"), m_RandomMultiQueues2, m_RandomMultiThreads2, m_RandomRead4KBScore2, GetDiskSpdResult(TEST_RANDOM_READ_4KB2)->IoPerSec, GetDiskSpdResult(TEST_RANDOM_READ_4KB2)->LatencyAverage);
 	clip.Replace(_T("%RandomRead4KB2%"), cstr);
-	cstr.Format(_T(" Random Write 4KiB (Q=%3d,T=%2d) : %9.3f MB/s [%9.1f IOPS]"), m_RandomMultiQueues2, m_RandomMultiThreads2, m_RandomWrite4KBScore2, m_RandomWrite4KBScore2 * 1000 * 1000 / 4096);
+	cstr.Format(_T(" Random Write 4KiB (Q=%3d,T=%2d) : %9.3f MB/s [%9.1f IOPS] <%8.2f us>"), m_RandomMultiQueues2, m_RandomMultiThreads2, m_RandomWrite4KBScore2, GetDiskSpdResult(TEST_RANDOM_WRITE_4KB2)->IoPerSec, GetDiskSpdResult(TEST_RANDOM_WRITE_4KB2)->LatencyAverage);
 	clip.Replace(_T("%RandomWrite4KB2%"), cstr);
 
-	cstr.Format(_T("  Random Read 4KiB (Q=%3d,T=%2d) : %9.3f MB/s [%9.1f IOPS]"), m_RandomMultiQueues3, m_RandomMultiThreads3, m_RandomRead4KBScore3, m_RandomRead4KBScore3 * 1000 * 1000 / 4096);
+	cstr.Format(_T("  Random Read 4KiB (Q=%3d,T=%2d) : %9.3f MB/s [%9.1f IOPS] <%8.2f us>"), m_RandomMultiQueues3, m_RandomMultiThreads3, m_RandomRead4KBScore3, GetDiskSpdResult(TEST_RANDOM_READ_4KB3)->IoPerSec, GetDiskSpdResult(TEST_RANDOM_READ_4KB3)->LatencyAverage);
 	clip.Replace(_T("%RandomRead4KB3%"), cstr);
-	cstr.Format(_T(" Random Write 4KiB (Q=%3d,T=%2d) : %9.3f MB/s [%9.1f IOPS]"), m_RandomMultiQueues3, m_RandomMultiThreads3, m_RandomWrite4KBScore3, m_RandomWrite4KBScore3 * 1000 * 1000 / 4096);
+	cstr.Format(_T(" Random Write 4KiB (Q=%3d,T=%2d) : %9.3f MB/s [%9.1f IOPS] <%8.2f us>"), m_RandomMultiQueues3, m_RandomMultiThreads3, m_RandomWrite4KBScore3, GetDiskSpdResult(TEST_RANDOM_WRITE_4KB3)->IoPerSec, GetDiskSpdResult(TEST_RANDOM_WRITE_4KB3)->LatencyAverage);
 	clip.Replace(_T("%RandomWrite4KB3%"), cstr);
 
 	cstr.Format(_T("%d MiB [%s]"), _tstoi(m_ValueTestSize), m_TestDriveInfo);
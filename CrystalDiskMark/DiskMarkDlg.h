@@ -84,7 +84,6 @@ public:
 	CString m_MesDiskReadError;
 	CString m_MesStopBenchmark;
 	CString m_MesDiskCreateFileError;
-	CString m_MesDiskSpdNotFound;
 
 protected:
 	virtual void DoDataExchange(CDataExchange* pDX);	// DDX/DDV support
@@ -0,0 +1,315 @@
+/*---------------------------------------------------------------------------*/
+//       Author : hiyohiyo
+//         Mail : hiyohiyo@crystalmark.info
+//          Web : http://crystalmark.info/
+//      License : The MIT License
+//
+//                                             Copyright (c) 2007-2015 hiyohiyo
+/*---------------------------------------------------------------------------*/
+
+// No MFC here; the driver is shared by the dialog and the console runner.
+
+#include "DiskSpdDriver.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <winioctl.h>
+#include <wctype.h>
+
+#include "..\diskspd\Common\Common.h"
+#include "..\diskspd\IORequestGenerator\IORequestGenerator.h"
+
+static void WINAPI PrintNothing(const char* format, va_list args)
+{
+	UNREFERENCED_PARAMETER(format);
+	UNREFERENCED_PARAMETER(args);
+}
+
+static void WINAPI PrintDebug(const char* format, va_list args)
+{
+	char message[1024];
+	_vsnprintf_s(message, sizeof(message), _TRUNCATE, format, args);
+	OutputDebugStringA(message);
+}
+
+static void Summarize(const Results& results, DISK_SPD_RESULT* result)
+{
+	Histogram<float> latencyHistogram;
+	UINT64 totalIoCount = 0;
+
+	for (size_t i = 0; i < results.vThreadResults.size(); i++)
+	{
+		double time = results.GetThreadTimeInSeconds(i);
+		for (const auto& targetResults : results.vThreadResults[i].vTargetResults)
+		{
+			if (time > 0)
+			{
+				result->BytesPerSec += targetResults.ullBytesCount / time;
+				result->IoPerSec += targetResults.ullIOCount / time;
+			}
+			totalIoCount += targetResults.ullIOCount;
+			latencyHistogram.Merge(targetResults.readLatencyHistogram);
+			latencyHistogram.Merge(targetResults.writeLatencyHistogram);
+		}
+	}
+
+	if (latencyHistogram.GetSampleSize() > 0)
+	{
+		result->LatencyAverage = latencyHistogram.GetAvg();
+		result->Latency50 = latencyHistogram.GetPercentile(0.5);
+		result->Latency99 = latencyHistogram.GetPercentile(0.99);
+		result->Latency999 = latencyHistogram.GetPercentile(0.999);
+	}
+
+	double time = PerfTimer::PerfTimeToSeconds(results.ullTimeCount);
+	size_t procCount = results.vSystemProcessorPerfInfo.size();
+	if (time > 0 && procCount > 0)
+	{
+		double busy = 0.0;
+		for (const auto& info : results.vSystemProcessorPerfInfo)
+		{
+			busy += (double)(info.KernelTime.QuadPart + info.UserTime.QuadPart - info.IdleTime.QuadPart) / 10000000 / time;
+		}
+		result->CpuUsage = 100.0 * busy / procCount;
+		if (totalIoCount > 0)
+		{
+			result->CpuPerIo = busy * time * 1000000 / totalIoCount;
+		}
+	}
+
+	result->WarmupTime = PerfTimer::PerfTimeToSeconds(results.ullWarmupTime);
+	result->SteadyStateReached = results.fSteadyStateReached;
+}
+
+void GetDiskSpdStatistics(const double* values, int count, DISK_SPD_STATISTICS* stats)
+{
+	PassStatistics passStatistics(vector<double>(values, values + count));
+
+	stats->Count = count;
+	stats->Median = passStatistics.fMedian;
+	stats->Mean = passStatistics.fMean;
+	stats->StdDev = passStatistics.fStandardDeviation;
+	stats->Ci95 = passStatistics.fConfidenceInterval;
+	stats->Ci95Percent = passStatistics.GetRelativeConfidenceInterval();
+}
+
+BOOL CreateDiskSpdTestFile(LPCWSTR path, UINT64 sizeMiB, BOOL zero, const volatile BOOL* running)
+{
+	HANDLE hFile = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL|FILE_FLAG_NO_BUFFERING|FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		return FALSE;
+	}
+
+// COMPRESSION_FORMAT_NONE
+	USHORT lpInBuffer = COMPRESSION_FORMAT_NONE;
+	DWORD lpBytesReturned = 0;
+	DeviceIoControl(hFile, FSCTL_SET_COMPRESSION, (LPVOID) &lpInBuffer,
+				sizeof(USHORT), NULL, 0, (LPDWORD)&lpBytesReturned, NULL);
+
+	// Fill Test Data
+	const DWORD BufSize = 1024 * 1024;
+	char* buf = (char*) VirtualAlloc(NULL, BufSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	if (buf == NULL)
+	{
+		CloseHandle(hFile);
+		return FALSE;
+	}
+
+	if (! zero)
+	{
+		// Compatible with DiskSpd
+		for (DWORD i = 0; i < BufSize; i++)
+		{
+			buf[i] = (char) (rand() % 256);
+		}
+	}
+
+	BOOL result = TRUE;
+	DWORD writesize;
+	for (UINT64 i = 0; i < sizeMiB; i++)
+	{
+		if (running != NULL && ! *running)
+		{
+			result = FALSE;
+			break;
+		}
+		WriteFile(hFile, buf, BufSize, &writesize, NULL);
+	}
+
+	VirtualFree(buf, 0, MEM_RELEASE);
+	CloseHandle(hFile);
+	return result;
+}
+
+BOOL ExecDiskSpd(LPCWSTR path, const DISK_SPD_TEST* test, DISK_SPD_RESULT* result, HANDLE stopEvent)
+{
+	ZeroMemory(result, sizeof(DISK_SPD_RESULT));
+
+	char pathA[MAX_PATH];
+	if (WideCharToMultiByte(CP_ACP, 0, path, -1, pathA, MAX_PATH, NULL, NULL) == 0)
+	{
+		return FALSE;
+	}
+
+	// same settings as "-b -o -t -w -S [-r] [-Z]" on the command line
+	Target target;
+	target.SetPath(pathA);
+	target.SetBlockSizeInBytes(test->BlockSize);
+	target.SetRequestCount(test->Queues);
+	target.SetThreadsPerFile(test->Threads);
+	target.SetWriteRatio(test->WriteRatio);
+	target.SetDisableOSCache(true);
+	if (test->Random)
+	{
+		target.SetUseRandomAccessPattern(true);
+		target.SetBlockAlignmentInBytes(test->BlockSize);
+	}
+	if (test->ZeroBuffers)
+	{
+		target.SetZeroWriteBuffers(true);
+	}
+	else if (test->WriteRatio > 0)
+	{
+		target.SetRandomDataWriteBufferSize(test->RandomDataSize > 0 ? test->RandomDataSize : test->BlockSize);
+	}
+
+	TimeSpan timeSpan;
+	timeSpan.SetDuration(test->Duration);
+	timeSpan.SetWarmup(test->Warmup);
+	timeSpan.SetSteadyStateWarmup(test->SteadyState ? true : false);
+	timeSpan.SetMeasureLatency(true);
+	timeSpan.AddTarget(target);
+
+	Profile profile;
+	profile.AddTimeSpan(timeSpan);
+	if (!profile.Validate(true))
+	{
+		return FALSE;
+	}
+
+	struct Synchronization synch = {};
+	synch.ulStructSize = sizeof(synch);
+	synch.hStopEvent = stopEvent;
+
+	vector<Results> vResults;
+	IORequestGenerator generator;
+	if (!generator.GenerateRequests(profile, vResults, PrintNothing, PrintDebug, PrintNothing, &synch) || vResults.empty())
+	{
+		return FALSE;
+	}
+
+	Summarize(vResults[0], result);
+	return TRUE;
+}
+
+// "4K", "4KB", "4KiB", "1M", "512", "512B" -> bytes; anything after the suffix or a size that does not fit a DWORD is rejected
+static BOOL ParseSize(LPCWSTR str, DWORD* size)
+{
+	if (! iswdigit(*str))
+	{
+		return FALSE;
+	}
+
+	WCHAR* end;
+	errno = 0;
+	unsigned long value = wcstoul(str, &end, 10);
+	if (errno == ERANGE || value > MAXDWORD)
+	{
+		return FALSE;
+	}
+
+	DWORD multiplier = 1;
+	switch (towupper(*end))
+	{
+	case L'K': multiplier = 1024; end++; break;
+	case L'M': multiplier = 1024 * 1024; end++; break;
+	}
+	if (multiplier > 1 && towupper(end[0]) == L'I' && towupper(end[1]) == L'B')
+	{
+		end += 2;
+	}
+	else if (towupper(end[0]) == L'B')
+	{
+		end++;
+	}
+	if (*end != L'\0' || value > MAXDWORD / multiplier)
+	{
+		return FALSE;
+	}
+
+	*size = (DWORD)value * multiplier;
+	return *size > 0;
+}
+
+/*
+[RND8K Q8T4 70/30]
+BlockSize=8K
+Queues=8
+Threads=4
+Pattern=Random
+WriteRatio=30
+Duration=5
+Warmup=0
+*/
+int LoadDiskSpdTestList(LPCWSTR path, DISK_SPD_TEST_ENTRY* entries, int maxEntries)
+{
+	WCHAR sections[8192];
+	WCHAR value[64];
+	int count = 0;
+
+	DWORD length = GetPrivateProfileSectionNamesW(sections, _countof(sections), path);
+	if (length == 0 || length >= _countof(sections) - 2)
+	{
+		return 0;
+	}
+
+	for (LPCWSTR section = sections; *section != L'\0'; section += wcslen(section) + 1)
+	{
+		if (count >= maxEntries)
+		{
+			return 0;
+		}
+
+		DISK_SPD_TEST_ENTRY* entry = &entries[count];
+		ZeroMemory(entry, sizeof(DISK_SPD_TEST_ENTRY));
+		wcsncpy_s(entry->Name, section, _TRUNCATE);
+
+		GetPrivateProfileStringW(section, L"BlockSize", L"4K", value, _countof(value), path);
+		if (! ParseSize(value, &entry->Test.BlockSize))
+		{
+			return 0;
+		}
+
+		GetPrivateProfileStringW(section, L"Pattern", L"Random", value, _countof(value), path);
+		if (_wcsicmp(value, L"Random") == 0)
+		{
+			entry->Test.Random = TRUE;
+		}
+		else if (_wcsicmp(value, L"Sequential") != 0)
+		{
+			return 0;
+		}
+
+		entry->Test.Queues = GetPrivateProfileIntW(section, L"Queues", 1, path);
+		entry->Test.Threads = GetPrivateProfileIntW(section, L"Threads", 1, path);
+		entry->Test.WriteRatio = GetPrivateProfileIntW(section, L"WriteRatio", 0, path);
+		entry->Test.Duration = GetPrivateProfileIntW(section, L"Duration", 5, path);
+		entry->Test.Warmup = GetPrivateProfileIntW(section, L"Warmup", 0, path);
+		entry->Test.SteadyState = GetPrivateProfileIntW(section, L"SteadyState", 0, path) != 0;
+
+		// same limits as the settings dialog
+		if (entry->Test.Queues < 1 || entry->Test.Queues > MAX_QUEUES
+		||  entry->Test.Threads < 1 || entry->Test.Threads > MAX_THREADS
+		||  entry->Test.WriteRatio > 100
+		||  entry->Test.Duration < 1
+		||  (entry->Test.SteadyState && entry->Test.Warmup < 1))
+		{
+			return 0;
+		}
+		count++;
+	}
+	return count;
+}
@@ -0,0 +1,77 @@
+/*---------------------------------------------------------------------------*/
+//       Author : hiyohiyo
+//         Mail : hiyohiyo@crystalmark.info
+//          Web : http://crystalmark.info/
+//      License : The MIT License
+//
+//                                             Copyright (c) 2007-2015 hiyohiyo
+/*---------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <windows.h>
+
+// limits of the queues and threads of a test, shared by the settings dialog and the test lists
+#define MAX_THREADS 64
+#define MAX_QUEUES 512
+
+// One diskspd run against an existing test file
+struct DISK_SPD_TEST
+{
+	DWORD BlockSize;		// bytes
+	DWORD Queues;			// outstanding I/Os per thread
+	DWORD Threads;
+	DWORD WriteRatio;		// 0 = read only, 100 = write only
+	BOOL Random;
+	DWORD Duration;			// sec
+	DWORD Warmup;			// sec
+	BOOL SteadyState;		// end the warm up once IOPS and latency settle, Warmup is the limit
+	BOOL ZeroBuffers;		// write 0x00 instead of random data
+	UINT64 RandomDataSize;	// size of the random write source buffer, 0 = block size
+};
+
+// One entry of a test list file
+struct DISK_SPD_TEST_ENTRY
+{
+	WCHAR Name[64];
+	DISK_SPD_TEST Test;
+};
+
+#define DISK_SPD_TEST_LIST_MAX	64
+
+struct DISK_SPD_RESULT
+{
+	double BytesPerSec;
+	double IoPerSec;
+	double LatencyAverage;	// us
+	double Latency50;		// us
+	double Latency99;		// us
+	double Latency999;		// us
+	double CpuUsage;		// %
+	double CpuPerIo;		// us of CPU busy in the whole system per I/O
+	double WarmupTime;		// sec
+	BOOL SteadyStateReached;
+};
+
+// Spread of the scores of repeated passes
+struct DISK_SPD_STATISTICS
+{
+	int Count;
+	double Median;
+	double Mean;
+	double StdDev;			// sample standard deviation
+	double Ci95;			// half-width of the 95% confidence interval of the mean
+	double Ci95Percent;		// Ci95 in percent of the mean
+};
+
+// Writes a sizeMiB MiB test file; running (optional) is polled to abort early
+BOOL CreateDiskSpdTestFile(LPCWSTR path, UINT64 sizeMiB, BOOL zero, const volatile BOOL* running);
+
+// Runs the test in-process; stopEvent (optional) ends the run early
+BOOL ExecDiskSpd(LPCWSTR path, const DISK_SPD_TEST* test, DISK_SPD_RESULT* result, HANDLE stopEvent);
+
+// Median, mean, standard deviation and 95% confidence interval of count values
+void GetDiskSpdStatistics(const double* values, int count, DISK_SPD_STATISTICS* stats);
+
+// Reads a test list file (one [section] per test, in file order); returns the number of tests, 0 on error
+int LoadDiskSpdTestList(LPCWSTR path, DISK_SPD_TEST_ENTRY* entries, int maxEntries);
@@ -4,6 +4,7 @@
 #include "stdafx.h"
 #include "DiskMark.h"
 #include "SettingsDlg.h"
+#include "DiskSpdDriver.h"
 
 
 // CSettingsDlg _CAO
@@ -114,7 +114,4 @@
 #define URL_HTML_HELP_JA			_T("https://crystalmark.info/software/CrystalDiskMark/manual-ja/")
 #define URL_HTML_HELP_EN 			_T("https://crystalmark.info/software/CrystalDiskMark/manual-en/")
 
-#define MAX_THREADS 64
-#define MAX_QUEUES 512
-
 static const int RE_EXEC = 5963;
@@ -147,6 +147,10 @@ void CmdLineParser::_DisplayUsageInfo(const char *pszFilename) const
     printf("                             use -n to disable default affinity]\n"); 
     printf("  -ag                   group affinity - affinitize threads in a round-robin manner across Processor\n");
     printf("                          Groups, starting at group 0\n");
+    printf("  -A<iops>[p]           open-loop load: issue I/Os at their intended arrival times at <iops> per second\n");
+    printf("                          per target (split evenly among its threads) instead of as soon as a request\n");
+    printf("                          completes; latency is measured from the intended time. Add p for Poisson\n");
+    printf("                          inter-arrival times [default: constant]. Conflicts with -g, -i/-j and -x\n");
     printf("  -b<size>[K|M|G]       block size in bytes or KiB/MiB/GiB [default=64K]\n");
     printf("  -B<offs>[K|M|G|b]     base target offset in bytes or KiB/MiB/GiB/blocks [default=0]\n");
     printf("                          (offset from the beginning of the file)\n");
@@ -163,6 +167,8 @@ void CmdLineParser::_DisplayUsageInfo(const char *pszFilename) const
     printf("  -fs                   open file with the FILE_FLAG_SEQUENTIAL_SCAN hint\n");
     printf("  -F<count>             total number of threads (conflicts with -t)\n");
     printf("  -g<bytes per ms>      throughput per-thread per-target throttled to given bytes per millisecond\n");
+    printf("  -G<bytes per ms>      throughput per-target throttled to given bytes per millisecond in total across\n");
+    printf("                          all threads of the target; may be combined with -g\n");
     printf("                          note that this can not be specified when using completion routines\n");
     printf("                          [default inactive]\n"); 
     printf("  -h                    disable both software caching and hardware write caching. Equivalent to\n");
@@ -171,18 +177,54 @@ void CmdLineParser::_DisplayUsageInfo(const char *pszFilename) const
     printf("  -i<count>             number of IOs per burst; see -j [default: inactive]\n");
     printf("  -j<milliseconds>      interval in <milliseconds> between issuing IO bursts; see -i [default: inactive]\n");
     printf("  -I<priority>          Set IO priority to <priority>. Available values are: 1-very low, 2-low, 3-normal (default)\n");
+    printf("  -k<count>             under -si, each thread claims <count> consecutive strides from the shared offset\n");
+    printf("                          with one interlocked operation and issues them before claiming more; the\n");
+    printf("                          pattern stays sequential in chunks while the shared offset is touched less often\n");
+    printf("                          [default=1]\n");
     printf("  -l                    Use large pages for IO buffers\n");
     printf("  -L                    measure latency statistics\n");
+    printf("  -Ld                   measure latency statistics and split each latency into submit time (inside\n");
+    printf("                          ReadFile/WriteFile), in-flight time and reap delay (completion waiting to be\n");
+    printf("                          dequeued by the worker); reap delay is an upper bound [I/O completion ports only]\n");
+    printf("  -mf<files>[:<per dir>]  small-file workload: the target is a directory which is populated with <files>\n");
+    printf("                          files in subdirectories of <per dir> files each [default=1000] (existing files are\n");
+    printf("                          kept); each thread then works on its share of the files one operation at a time.\n");
+    printf("                          Operations per second and the latency of each kind of operation are reported;\n");
+    printf("                          needs -o1, conflicts with -c, -F, -h, -r, -S and -x (-Sw is allowed)\n");
+    printf("  -ms<min>[K|M|G][:<max>[K|M|G]]  sizes of the files, log-uniform between <min> and <max>\n");
+    printf("                          [default: the block size]; reads and writes go in blocks of -b\n");
+    printf("  -mo<open>:<create>:<stat>:<delete>  percentages of the operations: open, read to the end and close;\n");
+    printf("                          create, write, flush and close (written through under -Sw); query the\n");
+    printf("                          attributes; delete [default=100:0:0:0]\n");
+    printf("  -M<clients>[:<rate>[p]]  group-commit log writer: <clients> commit at <rate> commits per second in total\n");
+    printf("                          (back to back if omitted; p = Poisson times between commits) and each waits until\n");
+    printf("                          its commit is durable; the thread writes the waiting commits as one sequential\n");
+    printf("                          write and flushes it (no flush under -Sw/-h). The stride (-s) is the size of a\n");
+    printf("                          commit record, the block size the largest batch; needs -w100 -t1 -o1.\n");
+    printf("                          Commit latency, batch sizes and commits per second are reported\n");
     printf("  -n                    disable default affinity (-a)\n");
+    printf("  -N<count>[:<tol>[:<min>]]  run the test up to <count> times, reusing the threads and files, and report\n");
+    printf("                          the median pass with the median, mean, stddev and 95%% confidence interval of\n");
+    printf("                          all the passes; with <tol>, stop once the confidence interval is within <tol>\n");
+    printf("                          percent of the mean after at least <min> passes [default min=3]\n");
     printf("  -o<count>             number of outstanding I/O requests per target per thread\n");
     printf("                          (1=synchronous I/O, unless more than 1 thread is specified with -F)\n");
     printf("                          [default=2]\n");
+    printf("  -Of<count>            flush the target (FlushFileBuffers) after every <count> writes of a thread and\n");
+    printf("                          report the flush latency and the durable latency of every write, from its issue\n");
+    printf("                          to the end of the first flush after it completed (-L); the flush runs on the\n");
+    printf("                          worker while its other I/Os stay in flight\n");
+    printf("  -Op<percentage>       flush the target ahead of <percentage> of the I/Os issued; durable latency as -Of\n");
     printf("  -p                    start parallel sequential I/O operations with the same offset\n");
     printf("                          (ignored if -r is specified, makes sense only with -o2 or greater)\n");
     printf("  -P<count>             enable printing a progress dot after each <count> [default=65536]\n");
     printf("                          completed I/O operations, counted separately by each thread \n");
+    printf("  -Q                    sample the IOCTL_DISK_PERFORMANCE counters of the disk or volume behind each\n");
+    printf("                          target every -D interval and report device-side IOPS, queue depth and\n");
+    printf("                          utilization next to the application-side numbers\n");
     printf("  -r<align>[K|M|G|b]    random I/O aligned to <align> in bytes/KiB/MiB/GiB/blocks (overrides -s)\n");
-    printf("  -R<text|xml>          output format. Default is text.\n");
+    printf("  -R<text|xml|json|csv> output format. Default is text. json and csv are streamed to the output as the\n");
+    printf("                          results are walked and carry the latency histograms and IOPS time series\n");
     printf("  -s[i]<size>[K|M|G|b]  sequential stride size, offset between subsequent I/O operations\n");
     printf("                          [default access=non-interlocked sequential, default stride=block size]\n");
     printf("                          In non-interlocked mode, threads do not coordinate, so the pattern of offsets\n");
@@ -192,16 +234,45 @@ void CmdLineParser::_DisplayUsageInfo(const char *pszFilename) const
     printf("                          (ignored if -r specified, -si conflicts with -T and -p)\n");
     printf("  -S                    disable software caching, equivalent to FILE_FLAG_NO_BUFFERING\n");
     printf("                          [default: caching is enabled, also see -h]\n");
+    printf("  -Sw                   write-through: every write reaches stable media before it completes, equivalent\n");
+    printf("                          to FILE_FLAG_WRITE_THROUGH; software caching stays enabled unless -S is also given.\n");
+    printf("                          With -L the write latency is also reported as durable write latency\n");
     printf("  -t<count>             number of threads per target (conflicts with -F)\n");
     printf("  -T<offs>[K|M|G|b]     starting stride between I/O operations performed on the same target by different threads\n");
     printf("                          [default=0] (starting offset = base file offset + (thread number * <offs>)\n");
     printf("                          makes sense only with #threads > 1\n");
+    printf("  -U<percentage>        discard (trim) one block in place of <percentage> of the I/Os: FSCTL_FILE_LEVEL_TRIM on\n");
+    printf("                          files, a DSM trim on disks and partitions; needs write access to the target\n");
+    printf("  -Ub<size>[K|M|G|b]:<ms>  bulk discard <size> bytes at a random offset every <ms> milliseconds, issued by\n");
+    printf("                          the first thread of the target. Discard latency is reported; with -L and -D the\n");
+    printf("                          read/write latency of the intervals after the bursts is shown as well\n");
+    printf("                          [I/O completion ports and synchronous I/O only]\n");
     printf("  -v                    verbose mode\n");
+    printf("  -vt<file>[:<records>] write a binary record of every measured I/O (offset, size, type, submit and\n");
+    printf("                          completion time, thread, target) to <file> through a memory-mapped ring of\n");
+    printf("                          <records> per thread, keeping the latest ones [default=1048576]; decode the\n");
+    printf("                          file to CSV with TraceDecoder\n");
+    printf("  -V                    verify mode: every block written carries a header (target, offset, generation,\n");
+    printf("                          seed, block size) and a CRC32C of its payload, and every block read is checked\n");
+    printf("                          against them; stale, misplaced and corrupt blocks are reported with the cost of\n");
+    printf("                          verification. Blocks stamped with another block size count as unwritten.\n");
+    printf("                          Needs -r/-s/-B/-T in multiples of the block size\n");
     printf("  -w<percentage>        percentage of write requests (-w and -w0 are equivalent and result in a read-only workload).\n");
     printf("                        absence of this switch indicates 100%% reads\n");
     printf("                          IMPORTANT: a write test will destroy existing data without a warning\n");
     printf("  -W<seconds>           warm up time - duration of the test before measurements start [default=5s]\n");
+    printf("  -Ws[<window>[:<interval>[:<range>[:<slope>]]]]  end the warm up once IOPS (and latency with -L) reach\n");
+    printf("                          steady state: over the last <window> rounds of <interval> ms, max - min stays\n");
+    printf("                          within <range> percent and the change of the linear fit within <slope> percent\n");
+    printf("                          of the average (SNIA PTS); -W limits the warm up [default=5:1000:20:10]\n");
     printf("  -x                    use completion routines instead of I/O Completion Ports\n");
+    printf("  -Y<file>[:<speed>]    replay the I/Os of a trace instead of the access pattern: a -vt binary trace or a\n");
+    printf("                          CSV of stream,target,type,offset,bytes,submit_us[,complete_us] lines; stream s runs\n");
+    printf("                          on thread s modulo the thread count. Each I/O is issued at its recorded time\n");
+    printf("                          divided by <speed>, or with a <speed> of 0 as fast as possible while waiting for\n");
+    printf("                          the I/Os of its stream it originally waited for [default=1]. The replay starts\n");
+    printf("                          with the measurement and ends it early once the whole trace is issued; -w must\n");
+    printf("                          allow the reads and writes of the trace (1-99 for a mix)\n");
     printf("  -X<filepath>          use an XML file for configuring the workload. Cannot be used with other parameters.\n");
     printf("  -z[seed]              set random seed [with no -z, seed=0; with plain -z, seed is based on system run time]\n");
     printf("\n");
@@ -453,6 +524,31 @@ bool CmdLineParser::_ReadParametersFromCmdLine(const int argc, const char *argv[
             }
             break;
 
+        case 'A':    //open-loop arrival rate
+            {
+                char *pszEnd;
+                DWORD dwArrivalRate = strtoul(arg + 1, &pszEnd, 10);
+                bool fPoisson = ('p' == *pszEnd);
+                if (fPoisson)
+                {
+                    pszEnd++;
+                }
+
+                if (dwArrivalRate > 0 && *pszEnd == '\0')
+                {
+                    for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+                    {
+                        i->SetArrivalRate(dwArrivalRate);
+                        i->SetPoissonArrivals(fPoisson);
+                    }
+                }
+                else
+                {
+                    fError = true;
+                }
+            }
+            break;
+
         case 'b':    //block size
             // nop - block size has been taken care of before the loop
             break;
@@ -622,6 +718,23 @@ bool CmdLineParser::_ReadParametersFromCmdLine(const int argc, const char *argv[
             }
             break;
 
+        case 'G':    //throughput in bytes per millisecond shared by all threads of a target
+            {
+                int c = atoi(arg + 1);
+                if (c > 0)
+                {
+                    for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+                    {
+                        i->SetTotalThroughput(c);
+                    }
+                }
+                else
+                {
+                    fError = true;
+                }
+            }
+            break;
+
         case 'h':    //disable both software and hardware caching
             for (auto i = vTargets.begin(); i != vTargets.end(); i++)
             {
@@ -665,6 +778,23 @@ bool CmdLineParser::_ReadParametersFromCmdLine(const int argc, const char *argv[
             }
             break;
 
+        case 'k':    //number of blocks claimed at once in interlocked sequential mode
+            {
+                int c = atoi(arg + 1);
+                if (c > 0)
+                {
+                    for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+                    {
+                        i->SetInterlockedSequentialChunk(c);
+                    }
+                }
+                else
+                {
+                    fError = true;
+                }
+            }
+            break;
+
         case 'I':   //io priority
             {
                 int x = atoi(arg + 1);
@@ -692,6 +822,166 @@ bool CmdLineParser::_ReadParametersFromCmdLine(const int argc, const char *argv[
         
         case 'L':    //measure latency
             timeSpan.SetMeasureLatency(true);
+            if ('d' == *(arg + 1))
+            {
+                timeSpan.SetMeasureLatencyDecomposition(true);
+            }
+            else if (*(arg + 1) != '\0')
+            {
+                fError = true;
+            }
+            break;
+
+        case 'm':    //small-file workload: -mf<files>[:<per dir>], -ms<min>[:<max>] or -mo<open>:<create>:<stat>:<delete>
+            if ('f' == *(arg + 1))
+            {
+                char *pszEnd;
+                DWORD dwFileCount = strtoul(arg + 2, &pszEnd, 10);
+                DWORD dwFilesPerDirectory = 1000;
+                if (':' == *pszEnd)
+                {
+                    dwFilesPerDirectory = strtoul(pszEnd + 1, &pszEnd, 10);
+                }
+
+                if ((dwFileCount > 0) && (dwFilesPerDirectory > 0) && ('\0' == *pszEnd))
+                {
+                    for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+                    {
+                        i->SetFileCount(dwFileCount);
+                        i->SetFilesPerDirectory(dwFilesPerDirectory);
+                    }
+                }
+                else
+                {
+                    fprintf(stderr, "Invalid file population passed to -mf; use -mf<files>[:<files per directory>]\n");
+                    fError = true;
+                }
+            }
+            else if ('s' == *(arg + 1))
+            {
+                char szSize[32];
+                const char *pszMax = strchr(arg + 2, ':');
+                size_t cchMin = (nullptr != pszMax) ? (pszMax - (arg + 2)) : strlen(arg + 2);
+                UINT64 cbMin = 0;
+                UINT64 cbMax = 0;
+                bool fOk = (cchMin < _countof(szSize)) &&
+                    (strncpy_s(szSize, _countof(szSize), arg + 2, cchMin) == 0) &&
+                    _GetSizeInBytes(szSize, cbMin) && (cbMin > 0);
+                if (fOk)
+                {
+                    cbMax = cbMin;
+                    fOk = (nullptr == pszMax) || (_GetSizeInBytes(pszMax + 1, cbMax) && (cbMax > 0));
+                }
+
+                if (fOk)
+                {
+                    for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+                    {
+                        i->SetMinPopulationFileSize(cbMin);
+                        i->SetMaxPopulationFileSize(cbMax);
+                    }
+                }
+                else
+                {
+                    fprintf(stderr, "Invalid file sizes passed to -ms; use -ms<min>[K|M|G][:<max>[K|M|G]]\n");
+                    fError = true;
+                }
+            }
+            else if ('o' == *(arg + 1))
+            {
+                UINT32 vulPercentages[FILE_OPERATION_COUNT];
+                const char *psz = arg + 2;
+                bool fOk = true;
+                for (size_t iOperation = 0; fOk && (iOperation < FILE_OPERATION_COUNT); iOperation++)
+                {
+                    char *pszEnd;
+                    vulPercentages[iOperation] = strtoul(psz, &pszEnd, 10);
+                    fOk = (pszEnd != psz) && (*pszEnd == ((iOperation + 1 < FILE_OPERATION_COUNT) ? ':' : '\0'));
+                    psz = pszEnd + 1;
+                }
+
+                if (fOk)
+                {
+                    for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+                    {
+                        for (size_t iOperation = 0; iOperation < FILE_OPERATION_COUNT; iOperation++)
+                        {
+                            i->SetFileOperationPercentage(static_cast<FileOperation>(iOperation), vulPercentages[iOperation]);
+                        }
+                    }
+                }
+                else
+                {
+                    fprintf(stderr, "Invalid operation mix passed to -mo; use -mo<open>:<create>:<stat>:<delete>\n");
+                    fError = true;
+                }
+            }
+            else
+            {
+                fprintf(stderr, "Invalid small-file workload option -m%s; use -mf, -ms or -mo\n", arg + 1);
+                fError = true;
+            }
+            break;
+
+        case 'M':    //group-commit log writer: -M<clients>[:<rate>[p]]
+            {
+                char *pszEnd;
+                DWORD dwLogClients = strtoul(arg + 1, &pszEnd, 10);
+                DWORD dwCommitRate = 0;
+                bool fPoisson = false;
+                if (':' == *pszEnd)
+                {
+                    dwCommitRate = strtoul(pszEnd + 1, &pszEnd, 10);
+                    fPoisson = ('p' == *pszEnd);
+                    if (fPoisson)
+                    {
+                        pszEnd++;
+                    }
+                }
+
+                if (dwLogClients > 0 && *pszEnd == '\0')
+                {
+                    for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+                    {
+                        i->SetLogClients(dwLogClients);
+                        i->SetCommitRate(dwCommitRate);
+                        i->SetPoissonCommits(fPoisson);
+                    }
+                }
+                else
+                {
+                    fprintf(stderr, "Invalid log writer specification passed to -M; use -M<clients>[:<rate>[p]]\n");
+                    fError = true;
+                }
+            }
+            break;
+
+        case 'N':    //repeated passes: -N<count>[:<tolerance>[:<min count>]]
+            {
+                char *pszEnd;
+                UINT32 ulPassCount = strtoul(arg + 1, &pszEnd, 10);
+                double fTolerance = 0;
+                UINT32 ulMinPassCount = timeSpan.GetMinPassCount();
+                if (':' == *pszEnd)
+                {
+                    fTolerance = strtod(pszEnd + 1, &pszEnd);
+                    if (':' == *pszEnd)
+                    {
+                        ulMinPassCount = strtoul(pszEnd + 1, &pszEnd, 10);
+                    }
+                }
+
+                if (ulPassCount > 0 && fTolerance >= 0 && ulMinPassCount > 1 && *pszEnd == '\0')
+                {
+                    timeSpan.SetPassCount(ulPassCount);
+                    timeSpan.SetPassTolerance(fTolerance);
+                    timeSpan.SetMinPassCount(ulMinPassCount);
+                }
+                else
+                {
+                    fError = true;
+                }
+            }
             break;
 
         case 'n':    //disable affinity (by default simple affinity is turned on)
@@ -715,6 +1005,33 @@ bool CmdLineParser::_ReadParametersFromCmdLine(const int argc, const char *argv[
             }
             break;
 
+        case 'O':    //flushes: -Of<count> or -Op<percentage>
+            {
+                char chMode = *(arg + 1);
+                const char *pszCount = arg + 2;
+                if ((('f' == chMode) || ('p' == chMode)) && (*pszCount >= '0') && (*pszCount <= '9'))
+                {
+                    UINT32 ulValue = static_cast<UINT32>(atoi(pszCount));
+                    for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+                    {
+                        if ('f' == chMode)
+                        {
+                            i->SetFlushInterval(ulValue);
+                        }
+                        else
+                        {
+                            i->SetFlushPercentage(ulValue);
+                        }
+                    }
+                }
+                else
+                {
+                    fprintf(stderr, "Invalid flush specification passed to -O; use -Of<count> or -Op<percentage>\n");
+                    fError = true;
+                }
+            }
+            break;
+
         case 'p':    //start async IO operations with the same offset
             //makes sense only for -o2 and greater
             for (auto i = vTargets.begin(); i != vTargets.end(); i++)
@@ -734,6 +1051,17 @@ bool CmdLineParser::_ReadParametersFromCmdLine(const int argc, const char *argv[
             }
             break;
 
+        case 'Q':    //device statistics
+            if (*(arg + 1) != '\0')
+            {
+                fError = true;
+            }
+            else
+            {
+                timeSpan.SetDeviceStatistics(true);
+            }
+            break;
+
         case 'r':    //random access
             {
                 UINT64 cb = _dwBlockSize;
@@ -764,6 +1092,14 @@ bool CmdLineParser::_ReadParametersFromCmdLine(const int argc, const char *argv[
                 {
                     pProfile->SetResultsFormat(ResultsFormat::Xml);
                 }
+                else if (strcmp(pszArg, "json") == 0)
+                {
+                    pProfile->SetResultsFormat(ResultsFormat::Json);
+                }
+                else if (strcmp(pszArg, "csv") == 0)
+                {
+                    pProfile->SetResultsFormat(ResultsFormat::Csv);
+                }
                 else if (strcmp(pszArg, "text") != 0)
                 {
                     fError = true;
@@ -819,9 +1155,24 @@ bool CmdLineParser::_ReadParametersFromCmdLine(const int argc, const char *argv[
             // size is 512 bytes, an application can request reads and writes of 512, 1024, or 2048 bytes, but not of 335, 981, or 7171 bytes. 
             // Buffer addresses for read and write operations should be sector aligned (aligned on addresses in memory that are integer
             // multiples of the volume's sector size). Depending on the disk, this requirement may not be enforced. 
-            for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+            //-Sw asks for write-through alone and leaves the software cache on
+            if ('w' == *(arg + 1) && '\0' == *(arg + 2))
+            {
+                for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+                {
+                    i->SetWriteThrough(true);
+                }
+            }
+            else if ('\0' == *(arg + 1))
+            {
+                for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+                {
+                    i->SetDisableOSCache(true);
+                }
+            }
+            else
             {
-                i->SetDisableOSCache(true);
+                fError = true;
             }
             break;
 
@@ -860,8 +1211,88 @@ bool CmdLineParser::_ReadParametersFromCmdLine(const int argc, const char *argv[
             }
             break;
 
+        case 'U':    //discards: -U<percentage> or -Ub<size>:<milliseconds>
+            if ('b' == *(arg + 1))
+            {
+                char szSize[32];
+                const char *pszInterval = strchr(arg + 2, ':');
+                UINT64 cb = 0;
+                bool fOk = (nullptr != pszInterval) &&
+                    (pszInterval - (arg + 2) < _countof(szSize)) &&
+                    (strncpy_s(szSize, _countof(szSize), arg + 2, pszInterval - (arg + 2)) == 0) &&
+                    _GetSizeInBytes(szSize, cb) && (cb > 0);
+                DWORD dwInterval = fOk ? strtoul(pszInterval + 1, nullptr, 10) : 0;
+                if (dwInterval > 0)
+                {
+                    for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+                    {
+                        i->SetDiscardBurstSize(cb);
+                        i->SetDiscardBurstInterval(dwInterval);
+                    }
+                }
+                else
+                {
+                    fprintf(stderr, "Invalid bulk discard passed to -Ub; use -Ub<size>:<milliseconds>\n");
+                    fError = true;
+                }
+            }
+            else
+            {
+                char *pszEnd;
+                UINT32 ulPercentage = strtoul(arg + 1, &pszEnd, 10);
+                if ((pszEnd != arg + 1) && ('\0' == *pszEnd))
+                {
+                    for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+                    {
+                        i->SetDiscardPercentage(ulPercentage);
+                    }
+                }
+                else
+                {
+                    fprintf(stderr, "Invalid discard percentage passed to -U\n");
+                    fError = true;
+                }
+            }
+            break;
+
         case 'v':    //verbose mode
-            pProfile->SetVerbose(true);
+            if ('t' == *(arg + 1))    //binary I/O trace: -vt<file>[:<records per thread>]
+            {
+                string sTraceFile(arg + 2);
+                size_t iColon = sTraceFile.rfind(':');
+                // a colon followed by digits only is the ring size, not a drive letter
+                if ((iColon != string::npos) && (iColon + 1 < sTraceFile.length()) &&
+                    (sTraceFile.find_first_not_of("0123456789", iColon + 1) == string::npos))
+                {
+                    UINT32 ulRecords = strtoul(sTraceFile.c_str() + iColon + 1, nullptr, 10);
+                    if (ulRecords == 0)
+                    {
+                        fError = true;
+                    }
+                    pProfile->SetTraceRecordsPerThread(ulRecords);
+                    sTraceFile.erase(iColon);
+                }
+                if (sTraceFile.empty())
+                {
+                    fError = true;
+                }
+                pProfile->SetTraceFile(sTraceFile);
+            }
+            else
+            {
+                pProfile->SetVerbose(true);
+            }
+            break;
+
+        case 'V':    //verify mode
+            if (*(arg + 1) != '\0')
+            {
+                fError = true;
+            }
+            for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+            {
+                i->SetVerify(true);
+            }
             break;
 
         case 'w':    //write test [default=read]
@@ -891,6 +1322,44 @@ bool CmdLineParser::_ReadParametersFromCmdLine(const int argc, const char *argv[
             break;
 
         case 'W':    //warm up time
+            if ('s' == *(arg + 1))    //steady state warm up: -Ws[<window>[:<interval>[:<range>[:<slope>]]]]
+            {
+                char *pszEnd = const_cast<char *>(arg + 2);
+                UINT32 ulWindow = timeSpan.GetSteadyStateWindow();
+                UINT32 ulInterval = timeSpan.GetSteadyStateIntervalInMilliseconds();
+                double fRange = timeSpan.GetSteadyStateRange();
+                double fSlope = timeSpan.GetSteadyStateSlope();
+                if ('\0' != *pszEnd)
+                {
+                    ulWindow = strtoul(pszEnd, &pszEnd, 10);
+                    if (':' == *pszEnd)
+                    {
+                        ulInterval = strtoul(pszEnd + 1, &pszEnd, 10);
+                        if (':' == *pszEnd)
+                        {
+                            fRange = strtod(pszEnd + 1, &pszEnd);
+                            if (':' == *pszEnd)
+                            {
+                                fSlope = strtod(pszEnd + 1, &pszEnd);
+                            }
+                        }
+                    }
+                }
+
+                if (ulWindow > 1 && ulInterval > 0 && fRange >= 0 && fSlope >= 0 && *pszEnd == '\0')
+                {
+                    timeSpan.SetSteadyStateWarmup(true);
+                    timeSpan.SetSteadyStateWindow(ulWindow);
+                    timeSpan.SetSteadyStateIntervalInMilliseconds(ulInterval);
+                    timeSpan.SetSteadyStateRange(fRange);
+                    timeSpan.SetSteadyStateSlope(fSlope);
+                }
+                else
+                {
+                    fError = true;
+                }
+            }
+            else
             {
                 int c = atoi(arg + 1);
                 if (c >= 0)
@@ -908,6 +1377,33 @@ bool CmdLineParser::_ReadParametersFromCmdLine(const int argc, const char *argv[
             timeSpan.SetCompletionRoutines(true);
             break;
 
+        case 'Y':    //trace replay: -Y<file>[:<speed>]
+            {
+                string sReplayFile(arg + 1);
+                double fSpeed = 1;
+                size_t iColon = sReplayFile.rfind(':');
+                // a colon followed by a number is the speed, not a drive letter
+                if ((iColon != string::npos) && (iColon + 1 < sReplayFile.length()) &&
+                    (sReplayFile.find_first_not_of("0123456789.", iColon + 1) == string::npos))
+                {
+                    fSpeed = strtod(sReplayFile.c_str() + iColon + 1, nullptr);
+                    sReplayFile.erase(iColon);
+                }
+
+                if (sReplayFile.empty())
+                {
+                    fError = true;
+                }
+                else
+                {
+                    // the report compares the latency of the replay with the original one
+                    timeSpan.SetReplayFile(sReplayFile);
+                    timeSpan.SetReplaySpeed(fSpeed);
+                    timeSpan.SetMeasureLatency(true);
+                }
+            }
+            break;
+
         case 'y':    //external synchronization
             switch (*(arg + 1))
             {
@@ -41,6 +41,7 @@ SOFTWARE.
 #include "..\IORequestGenerator\IORequestGenerator.h"
 #include "..\ResultParser\ResultParser.h"
 #include "..\XmlResultParser\XmlResultParser.h"
+#include "..\ResultParser\ResultWriter.h"
 
 /*****************************************************************************/
 // global variables
@@ -160,18 +161,38 @@ int __cdecl main(int argc, const char* argv[])
     //
     ResultParser resultParser;
     XmlResultParser xmlResultParser;
+    JsonResultWriter jsonResultWriter;
+    CsvResultWriter csvResultWriter;
     IResultParser *pResultParser = nullptr;
+    IResultWriter *pResultWriter = nullptr;
     if (profile.GetResultsFormat() == ResultsFormat::Xml)
     {
         pResultParser = &xmlResultParser;
     }
+    else if (profile.GetResultsFormat() == ResultsFormat::Json)
+    {
+        pResultWriter = &jsonResultWriter;
+    }
+    else if (profile.GetResultsFormat() == ResultsFormat::Csv)
+    {
+        pResultWriter = &csvResultWriter;
+    }
     else
     {
         pResultParser = &resultParser;
     }
 
     IORequestGenerator ioGenerator;
-    if (!ioGenerator.GenerateRequests(profile, *pResultParser, (PRINTF)PrintOut, (PRINTF)PrintError, (PRINTF)PrintOut, &synch, &totalScore))
+    bool fOk;
+    if (nullptr != pResultWriter)
+    {
+        fOk = ioGenerator.GenerateRequests(profile, *pResultWriter, stdout, (PRINTF)PrintOut, (PRINTF)PrintError, (PRINTF)PrintOut, &synch, &totalScore);
+    }
+    else
+    {
+        fOk = ioGenerator.GenerateRequests(profile, *pResultParser, (PRINTF)PrintOut, (PRINTF)PrintError, (PRINTF)PrintOut, &synch, &totalScore);
+    }
+    if (!fOk)
     {
         fprintf(stderr, "Error generating I/O requests\n");
         return 1;
@@ -193,7 +214,11 @@ int __cdecl main(int argc, const char* argv[])
     {
         CloseHandle(g_hEventFinished);
     }
-	printf("Score: %d", totalScore);
+	// the streamed formats are meant for tools; keep them free of anything else
+	if (nullptr == pResultWriter)
+	{
+		printf("Score: %d", totalScore);
+	}
 
 	return totalScore;
 }
\ No newline at end of file
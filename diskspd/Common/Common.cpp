@@ -28,23 +28,125 @@ SOFTWARE.
 */
 
 #include "Common.h"
+#include <intrin.h>
+#include <algorithm>
 
 UINT64 PerfTimer::GetTime()
 {
+#if defined(_M_IX86) || defined(_M_X64)
+    if (USE_TSC)
+    {
+        return __rdtsc();
+    }
+#endif
     LARGE_INTEGER li;
     QueryPerformanceCounter(&li);
     return li.QuadPart;
 }
 
+bool PerfTimer::_IsInvariantTscAvailable()
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    int cpuInfo[4];
+
+    // leaf 0x80000007 (advanced power management) must be present
+    __cpuid(cpuInfo, 0x80000000);
+    if (static_cast<unsigned int>(cpuInfo[0]) < 0x80000007)
+    {
+        return false;
+    }
+
+    // EDX bit 8: the TSC ticks at a constant rate across P-, C- and T-states
+    __cpuid(cpuInfo, 0x80000007);
+    return (cpuInfo[3] & (1 << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+UINT64 PerfTimer::_CalibrateTsc()
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    LARGE_INTEGER liFreq;
+    LARGE_INTEGER liStart;
+    LARGE_INTEGER liEnd;
+    unsigned int uAux;
+
+    QueryPerformanceFrequency(&liFreq);
+
+    // spin for ~50ms against QPC; rdtscp waits for the preceding QPC read to retire
+    QueryPerformanceCounter(&liStart);
+    UINT64 ullTscStart = __rdtscp(&uAux);
+    do
+    {
+        QueryPerformanceCounter(&liEnd);
+    } while (liEnd.QuadPart - liStart.QuadPart < liFreq.QuadPart / 20);
+    UINT64 ullTscEnd = __rdtscp(&uAux);
+
+    return static_cast<UINT64>(static_cast<double>(ullTscEnd - ullTscStart) * liFreq.QuadPart / (liEnd.QuadPart - liStart.QuadPart));
+#else
+    return 0;
+#endif
+}
+
 UINT64 PerfTimer::_GetPerfTimerFreq()
 {
+    if (USE_TSC)
+    {
+        UINT64 ullTscFreq = _CalibrateTsc();
+        if (ullTscFreq != 0)
+        {
+            return ullTscFreq;
+        }
+    }
+
     LARGE_INTEGER li;
     QueryPerformanceFrequency(&li);
     return li.QuadPart;
 }
 
+// USE_TSC must be initialized before TIMER_FREQ since calibration depends on it
+const bool PerfTimer::USE_TSC = _IsInvariantTscAvailable();
 const UINT64 PerfTimer::TIMER_FREQ = _GetPerfTimerFreq();
 
+PerfTimerSource PerfTimer::GetSource()
+{
+    return USE_TSC ? PerfTimerSource::InvariantTsc : PerfTimerSource::QueryPerformanceCounter;
+}
+
+UINT64 PerfTimer::GetFrequency()
+{
+    return TIMER_FREQ;
+}
+
+void PerfTimer::MeasureOverhead(double *pfOverheadNs, double *pfResolutionNs)
+{
+    const UINT32 cIterations = 100000;
+
+    // cost of a single call: back-to-back reads amortized over the loop
+    UINT64 ullStart = GetTime();
+    for (UINT32 i = 0; i < cIterations; i++)
+    {
+        GetTime();
+    }
+    UINT64 ullEnd = GetTime();
+    *pfOverheadNs = PerfTimeToMicroseconds(ullEnd - ullStart) * 1000 / cIterations;
+
+    // resolution: smallest non-zero difference between two consecutive reads
+    UINT64 ullMinDelta = MAXUINT64;
+    UINT64 ullPrev = GetTime();
+    for (UINT32 i = 0; i < cIterations; i++)
+    {
+        UINT64 ullNow = GetTime();
+        if ((ullNow > ullPrev) && (ullNow - ullPrev < ullMinDelta))
+        {
+            ullMinDelta = ullNow - ullPrev;
+        }
+        ullPrev = ullNow;
+    }
+    *pfResolutionNs = (ullMinDelta == MAXUINT64) ? 0 : PerfTimeToMicroseconds(ullMinDelta) * 1000;
+}
+
 double PerfTimer::PerfTimeToMicroseconds(const double perfTime)
 {
     return perfTime / (TIMER_FREQ / 1000000.0);
@@ -119,6 +221,22 @@ string Target::GetXml() const
     if (!_fDisableAllCache)
     {
         sXml += _fDisableOSCache ? "<DisableOSCache>true</DisableOSCache>\n" : "<DisableOSCache>false</DisableOSCache>\n";
+        if (_fWriteThrough)
+        {
+            sXml += "<WriteThrough>true</WriteThrough>\n";
+        }
+    }
+
+    if (_dwFlushInterval > 0)
+    {
+        sprintf_s(buffer, _countof(buffer), "<FlushInterval>%u</FlushInterval>\n", _dwFlushInterval);
+        sXml += buffer;
+    }
+
+    if (_ulFlushPercentage > 0)
+    {
+        sprintf_s(buffer, _countof(buffer), "<FlushPercentage>%u</FlushPercentage>\n", _ulFlushPercentage);
+        sXml += buffer;
     }
     
     sXml += "<WriteBufferContent>\n";
@@ -178,6 +296,12 @@ string Target::GetXml() const
         sXml += _fInterlockedSequential ?
             "<InterlockedSequential>true</InterlockedSequential>\n" :
             "<InterlockedSequential>false</InterlockedSequential>\n";
+
+        if (_dwInterlockedSequentialChunk > 1)
+        {
+            sprintf_s(buffer, _countof(buffer), "<InterlockedSequentialChunk>%u</InterlockedSequentialChunk>\n", _dwInterlockedSequentialChunk);
+            sXml += buffer;
+        }
     }
 
     sprintf_s(buffer, _countof(buffer), "<ThreadStride>%I64u</ThreadStride>\n", _ullThreadStride);
@@ -195,6 +319,73 @@ string Target::GetXml() const
     sprintf_s(buffer, _countof(buffer), "<Throughput>%u</Throughput>\n", _dwThroughputBytesPerMillisecond);
     sXml += buffer;
 
+    if (_dwTotalThroughputBytesPerMillisecond > 0)
+    {
+        sprintf_s(buffer, _countof(buffer), "<TotalThroughput>%u</TotalThroughput>\n", _dwTotalThroughputBytesPerMillisecond);
+        sXml += buffer;
+    }
+
+    if (_dwArrivalRate > 0)
+    {
+        sprintf_s(buffer, _countof(buffer), "<ArrivalRate>%u</ArrivalRate>\n", _dwArrivalRate);
+        sXml += buffer;
+        sXml += _fPoissonArrivals ? "<PoissonArrivals>true</PoissonArrivals>\n" : "<PoissonArrivals>false</PoissonArrivals>\n";
+    }
+
+    if (_fVerify)
+    {
+        sXml += "<Verify>true</Verify>\n";
+    }
+
+    if (_dwLogClients > 0)
+    {
+        sprintf_s(buffer, _countof(buffer), "<LogClients>%u</LogClients>\n", _dwLogClients);
+        sXml += buffer;
+        sprintf_s(buffer, _countof(buffer), "<CommitRate>%u</CommitRate>\n", _dwCommitRate);
+        sXml += buffer;
+        sXml += _fPoissonCommits ? "<PoissonCommits>true</PoissonCommits>\n" : "<PoissonCommits>false</PoissonCommits>\n";
+    }
+
+    if (_ulDiscardPercentage > 0)
+    {
+        sprintf_s(buffer, _countof(buffer), "<DiscardPercentage>%u</DiscardPercentage>\n", _ulDiscardPercentage);
+        sXml += buffer;
+    }
+
+    if (_dwDiscardBurstInterval > 0)
+    {
+        sprintf_s(buffer, _countof(buffer), "<DiscardBurstSize>%I64u</DiscardBurstSize>\n", _ullDiscardBurstSize);
+        sXml += buffer;
+        sprintf_s(buffer, _countof(buffer), "<DiscardBurstInterval>%u</DiscardBurstInterval>\n", _dwDiscardBurstInterval);
+        sXml += buffer;
+    }
+
+    if (_dwFileCount > 0)
+    {
+        sprintf_s(buffer, _countof(buffer), "<FileCount>%u</FileCount>\n", _dwFileCount);
+        sXml += buffer;
+        sprintf_s(buffer, _countof(buffer), "<FilesPerDirectory>%u</FilesPerDirectory>\n", _dwFilesPerDirectory);
+        sXml += buffer;
+        if (_ullMinPopulationFileSize > 0)
+        {
+            sprintf_s(buffer, _countof(buffer), "<MinPopulationFileSize>%I64u</MinPopulationFileSize>\n", _ullMinPopulationFileSize);
+            sXml += buffer;
+        }
+        if (_ullMaxPopulationFileSize > 0)
+        {
+            sprintf_s(buffer, _countof(buffer), "<MaxPopulationFileSize>%I64u</MaxPopulationFileSize>\n", _ullMaxPopulationFileSize);
+            sXml += buffer;
+        }
+        sprintf_s(buffer, _countof(buffer), "<OpenReadPercentage>%u</OpenReadPercentage>\n", GetFileOperationPercentage(FileOperation::OpenRead));
+        sXml += buffer;
+        sprintf_s(buffer, _countof(buffer), "<CreatePercentage>%u</CreatePercentage>\n", GetFileOperationPercentage(FileOperation::Create));
+        sXml += buffer;
+        sprintf_s(buffer, _countof(buffer), "<StatPercentage>%u</StatPercentage>\n", GetFileOperationPercentage(FileOperation::Stat));
+        sXml += buffer;
+        sprintf_s(buffer, _countof(buffer), "<DeletePercentage>%u</DeletePercentage>\n", GetFileOperationPercentage(FileOperation::Delete));
+        sXml += buffer;
+    }
+
     sprintf_s(buffer, _countof(buffer), "<ThreadsPerFile>%u</ThreadsPerFile>\n", _dwThreadsPerFile);
     sXml += buffer;
 
@@ -340,6 +531,7 @@ string TimeSpan::GetXml() const
 
     sXml += _fCompletionRoutines ? "<CompletionRoutines>true</CompletionRoutines>\n" : "<CompletionRoutines>false</CompletionRoutines>\n";
     sXml += _fMeasureLatency ? "<MeasureLatency>true</MeasureLatency>\n" : "<MeasureLatency>false</MeasureLatency>\n";
+    sXml += _fMeasureLatencyDecomposition ? "<MeasureLatencyDecomposition>true</MeasureLatencyDecomposition>\n" : "<MeasureLatencyDecomposition>false</MeasureLatencyDecomposition>\n";
     sXml += _fCalculateIopsStdDev ? "<CalculateIopsStdDev>true</CalculateIopsStdDev>\n" : "<CalculateIopsStdDev>false</CalculateIopsStdDev>\n";
     sXml += _fDisableAffinity ? "<DisableAffinity>true</DisableAffinity>\n" : "<DisableAffinity>false</DisableAffinity>\n";
     sXml += _fGroupAffinity ? "<GroupAffinity>true</GroupAffinity>\n" : "<GroupAffinity>false</GroupAffinity>\n";
@@ -362,6 +554,33 @@ string TimeSpan::GetXml() const
     sprintf_s(buffer, _countof(buffer), "<RandSeed>%u</RandSeed>\n", _ulRandSeed);
     sXml += buffer;
 
+    if (_ulPassCount > 1)
+    {
+        sprintf_s(buffer, _countof(buffer), "<Passes>\n<Count>%u</Count>\n<MinCount>%u</MinCount>\n<Tolerance>%.2f</Tolerance>\n</Passes>\n",
+            _ulPassCount, _ulMinPassCount, _fPassTolerance);
+        sXml += buffer;
+    }
+
+    if (_fDeviceStatistics)
+    {
+        sXml += "<DeviceStatistics>true</DeviceStatistics>\n";
+    }
+
+    if (!_sReplayFile.empty())
+    {
+        sXml += "<Replay>\n<Path>" + _sReplayFile + "</Path>\n";
+        sprintf_s(buffer, _countof(buffer), "<Speed>%.3f</Speed>\n", _fReplaySpeed);
+        sXml += buffer;
+        sXml += "</Replay>\n";
+    }
+
+    if (_fSteadyStateWarmup)
+    {
+        sprintf_s(buffer, _countof(buffer), "<SteadyState>\n<Window>%u</Window>\n<Interval>%u</Interval>\n<Range>%.2f</Range>\n<Slope>%.2f</Slope>\n</SteadyState>\n",
+            _ulSteadyStateWindow, _ulSteadyStateInterval, _fSteadyStateRange, _fSteadyStateSlope);
+        sXml += buffer;
+    }
+
     if (_vAffinity.size() > 0)
     {
         sXml += "<Affinity>\n";
@@ -413,12 +632,27 @@ string Profile::GetXml() const
     {
         sXml += "<ResultFormat>xml</ResultFormat>\n";
     }
+    else if (_resultsFormat == ResultsFormat::Json)
+    {
+        sXml += "<ResultFormat>json</ResultFormat>\n";
+    }
+    else if (_resultsFormat == ResultsFormat::Csv)
+    {
+        sXml += "<ResultFormat>csv</ResultFormat>\n";
+    }
     else
     {
         sXml += "<ResultFormat>* UNSUPPORTED *</ResultFormat>\n";
     }
 
     sXml += _fVerbose ? "<Verbose>true</Verbose>\n" : "<Verbose>false</Verbose>\n";
+    if (!_sTraceFile.empty())
+    {
+        sXml += "<Trace>\n<Path>" + _sTraceFile + "</Path>\n";
+        sprintf_s(buffer, _countof(buffer), "<RecordsPerThread>%u</RecordsPerThread>\n", _ulTraceRecordsPerThread);
+        sXml += buffer;
+        sXml += "</Trace>\n";
+    }
     if (_precreateFiles == PrecreateFiles::UseMaxSize)
     {
         sXml += "<PrecreateFiles>UseMaxSize</PrecreateFiles>\n";
@@ -477,6 +711,48 @@ bool Profile::Validate(bool fSingleSpec) const
             fOk = false;
         }
 
+        if (!timeSpan.GetReplayFile().empty())
+        {
+            if (timeSpan.GetCompletionRoutines())
+            {
+                fprintf(stderr, "ERROR: -Y trace replay uses I/O completion ports and cannot be used with -x\n");
+                fOk = false;
+            }
+
+            if (timeSpan.GetReplaySpeed() < 0)
+            {
+                fprintf(stderr, "ERROR: the -Y replay speed cannot be negative\n");
+                fOk = false;
+            }
+        }
+
+        if (timeSpan.GetMeasureLatencyDecomposition() && timeSpan.GetCompletionRoutines())
+        {
+            fprintf(stderr, "WARNING: -Ld latency decomposition is only available with I/O completion ports and is ignored with -x\n");
+        }
+
+        if ((timeSpan.GetPassCount() < 1) || (timeSpan.GetMinPassCount() < 2) || (timeSpan.GetPassTolerance() < 0))
+        {
+            fprintf(stderr, "ERROR: -N needs at least 1 pass, a minimum of at least 2 passes and a non-negative tolerance\n");
+            fOk = false;
+        }
+
+        if (timeSpan.GetSteadyStateWarmup())
+        {
+            if (timeSpan.GetWarmup() == 0)
+            {
+                fprintf(stderr, "ERROR: -Ws needs a warm up time (-W) to limit the warm up to\n");
+                fOk = false;
+            }
+
+            if ((timeSpan.GetSteadyStateWindow() < 2) || (timeSpan.GetSteadyStateIntervalInMilliseconds() == 0) ||
+                (timeSpan.GetSteadyStateRange() < 0) || (timeSpan.GetSteadyStateSlope() < 0))
+            {
+                fprintf(stderr, "ERROR: -Ws needs a window of at least 2 rounds, a non-zero interval and non-negative tolerances\n");
+                fOk = false;
+            }
+        }
+
         for (const auto& target : timeSpan.GetTargets())
         {
             const bool targetHasMultipleThreads = (timeSpan.GetThreadCount() > 1) || (target.GetThreadsPerFile() > 1);
@@ -498,6 +774,201 @@ bool Profile::Validate(bool fSingleSpec) const
                 fOk = false;
             }
 
+            if (target.GetTotalThroughputInBytesPerMillisecond() > 0 && timeSpan.GetCompletionRoutines())
+            {
+                fprintf(stderr, "ERROR: -G throughput control cannot be used with -x completion routines\n");
+                fOk = false;
+            }
+
+            if (target.GetArrivalRate() > 0)
+            {
+                if (timeSpan.GetCompletionRoutines())
+                {
+                    fprintf(stderr, "ERROR: -A open-loop arrivals cannot be used with -x completion routines\n");
+                    fOk = false;
+                }
+
+                if (target.GetThroughputInBytesPerMillisecond() > 0 || target.GetTotalThroughputInBytesPerMillisecond() > 0 || target.GetThinkTime() > 0)
+                {
+                    fprintf(stderr, "ERROR: -A open-loop arrivals cannot be used with -g, -G or -i/-j throttling\n");
+                    fOk = false;
+                }
+            }
+
+            if ((target.GetFlushInterval() > 0) || (target.GetFlushPercentage() > 0))
+            {
+                if (target.GetWriteRatio() == 0)
+                {
+                    fprintf(stderr, "ERROR: -Of and -Op flush written data and need writes (-w)\n");
+                    fOk = false;
+                }
+
+                if (target.GetFlushPercentage() > 100)
+                {
+                    fprintf(stderr, "ERROR: -Op takes a percentage of I/Os between 0 and 100\n");
+                    fOk = false;
+                }
+            }
+
+            if (target.GetWriteThrough() && target.GetDisableAllCache())
+            {
+                fprintf(stderr, "WARNING: -Sw is included in the effect of -h, specifying both is not required\n");
+            }
+
+            if (target.GetLogClients() > 0)
+            {
+                // a log has a single writer issuing one batch at a time at sequential offsets; the
+                // stride is the size of a commit record and the block size that of the largest batch
+                if ((target.GetWriteRatio() != 100) ||
+                    target.GetUseRandomAccessPattern() ||
+                    target.GetUseInterlockedSequential() ||
+                    target.GetUseParallelAsyncIO())
+                {
+                    fprintf(stderr, "ERROR: -M log writer needs sequential writes only (-w100, no -r, -si or -p)\n");
+                    fOk = false;
+                }
+
+                if ((target.GetThreadsPerFile() != 1) || (timeSpan.GetThreadCount() > 0) || (target.GetRequestCount() != 1))
+                {
+                    fprintf(stderr, "ERROR: -M log writer has one writer per target with one write in flight (-t1 -o1, no -F)\n");
+                    fOk = false;
+                }
+
+                if (target.GetBlockSizeInBytes() % target.GetBlockAlignmentInBytes() != 0)
+                {
+                    fprintf(stderr, "ERROR: -M log writer needs a block size (largest batch) in multiples of the stride (commit record size)\n");
+                    fOk = false;
+                }
+
+                if ((target.GetArrivalRate() > 0) ||
+                    (target.GetThroughputInBytesPerMillisecond() > 0) ||
+                    (target.GetTotalThroughputInBytesPerMillisecond() > 0) ||
+                    (target.GetThinkTime() > 0) ||
+                    (target.GetFlushInterval() > 0) ||
+                    (target.GetFlushPercentage() > 0) ||
+                    target.GetVerify() ||
+                    !timeSpan.GetReplayFile().empty())
+                {
+                    fprintf(stderr, "ERROR: -M log writer paces and flushes its own writes and cannot be used with -A, -g, -G, -i/-j, -Of, -Op, -V or -Y\n");
+                    fOk = false;
+                }
+            }
+
+            if (target.GetUseDiscards())
+            {
+                if (target.GetDiscardPercentage() > 100)
+                {
+                    fprintf(stderr, "ERROR: -U takes a percentage of I/Os between 0 and 100\n");
+                    fOk = false;
+                }
+
+                if ((target.GetDiscardBurstInterval() > 0) && (target.GetDiscardBurstSize() == 0))
+                {
+                    fprintf(stderr, "ERROR: -Ub needs the size of the bulk discards\n");
+                    fOk = false;
+                }
+
+                // DeviceIoControl has no completion routine form
+                if (timeSpan.GetCompletionRoutines())
+                {
+                    fprintf(stderr, "ERROR: -U discards cannot be used with -x completion routines\n");
+                    fOk = false;
+                }
+
+                if (target.GetVerify() || (target.GetLogClients() > 0) || !timeSpan.GetReplayFile().empty())
+                {
+                    fprintf(stderr, "ERROR: -U discards cannot be used with -V, -M or -Y\n");
+                    fOk = false;
+                }
+            }
+
+            if (target.GetFileCount() > 0)
+            {
+                UINT32 ulTotalPercentage = 0;
+                for (size_t i = 0; i < FILE_OPERATION_COUNT; i++)
+                {
+                    ulTotalPercentage += target.GetFileOperationPercentage(static_cast<FileOperation>(i));
+                }
+
+                if (ulTotalPercentage != 100)
+                {
+                    fprintf(stderr, "ERROR: -mo percentages of open/read, create, stat and delete must add up to 100\n");
+                    fOk = false;
+                }
+
+                if (target.GetFilesPerDirectory() == 0)
+                {
+                    fprintf(stderr, "ERROR: -mf needs at least one file per directory\n");
+                    fOk = false;
+                }
+
+                if (target.GetMinPopulationFileSize() > target.GetMaxPopulationFileSize())
+                {
+                    fprintf(stderr, "ERROR: -ms smallest file size is larger than the largest\n");
+                    fOk = false;
+                }
+
+                if (target.GetFileCount() < target.GetThreadsPerFile())
+                {
+                    fprintf(stderr, "ERROR: -mf needs at least one file per thread\n");
+                    fOk = false;
+                }
+
+                // each thread works through its own files one operation at a time
+                if ((target.GetRequestCount() != 1) || (timeSpan.GetThreadCount() > 0) || timeSpan.GetCompletionRoutines())
+                {
+                    fprintf(stderr, "ERROR: -m small-file workload runs one operation at a time per thread (-o1, no -F or -x)\n");
+                    fOk = false;
+                }
+
+                // the path names the directory of the population, which is built before the run
+                if ((target.GetFileSize() > 0) ||
+                    target.GetUseRandomAccessPattern() ||
+                    target.GetUseInterlockedSequential() ||
+                    (target.GetBaseFileOffsetInBytes() > 0) ||
+                    (target.GetThreadStrideInBytes() > 0) ||
+                    target.GetDisableOSCache() ||
+                    target.GetDisableAllCache() ||
+                    (target.GetArrivalRate() > 0) ||
+                    (target.GetThroughputInBytesPerMillisecond() > 0) ||
+                    (target.GetTotalThroughputInBytesPerMillisecond() > 0) ||
+                    (target.GetFlushInterval() > 0) ||
+                    (target.GetFlushPercentage() > 0) ||
+                    target.GetVerify() ||
+                    (target.GetLogClients() > 0) ||
+                    target.GetUseDiscards() ||
+                    !timeSpan.GetReplayFile().empty())
+                {
+                    fprintf(stderr, "ERROR: -m small-file workload cannot be used with -c, -r, -si, -B, -T, -h, -S (but not -Sw), -A, -g, -G, -Of, -Op, -V, -M, -U or -Y\n");
+                    fOk = false;
+                }
+            }
+
+            if (target.GetVerify())
+            {
+                // blocks are tracked by their index, so every I/O must cover exactly one of them
+                if ((target.GetBlockSizeInBytes() < 512) ||
+                    (target.GetBlockAlignmentInBytes() % target.GetBlockSizeInBytes() != 0) ||
+                    (target.GetBaseFileOffsetInBytes() % target.GetBlockSizeInBytes() != 0) ||
+                    (target.GetThreadStrideInBytes() % target.GetBlockSizeInBytes() != 0))
+                {
+                    fprintf(stderr, "ERROR: -V needs a block size of at least 512 bytes and -r, -s, -B and -T in multiples of the block size\n");
+                    fOk = false;
+                }
+
+                if (target.GetRandomDataWriteBufferSize() > 0)
+                {
+                    fprintf(stderr, "ERROR: -V stamps each write buffer and cannot be used with a custom write buffer (-Z)\n");
+                    fOk = false;
+                }
+
+                if (!timeSpan.GetReplayFile().empty())
+                {
+                    fprintf(stderr, "ERROR: -V cannot be used with -Y trace replay\n");
+                    fOk = false;
+                }
+            }
+
             //  If burst size is specified think time must be specified and If think time is specified burst size should be non zero
             if ((target.GetThinkTime() == 0 && target.GetBurstSize() > 0) || (target.GetThinkTime() > 0 && target.GetBurstSize() == 0))
             {
@@ -569,6 +1040,11 @@ bool Profile::Validate(bool fSingleSpec) const
                 }
                 else
                 {
+                    if (target.GetInterlockedSequentialChunk() > 1)
+                    {
+                        fprintf(stderr, "WARNING: -k has no effect without -si\n");
+                    }
+
                     if (targetHasMultipleThreads && !target.GetThreadStrideInBytes())
                     {
                         fprintf(stderr, "WARNING: target access pattern will not be sequential, consider -si\n");
@@ -672,6 +1148,32 @@ BYTE* ThreadParameters::GetWriteBuffer(size_t iTarget, size_t iRequest)
     return pBuffer;
 }
 
+bool ThreadParameters::AllocateIORequests(UINT32 cRequests)
+{
+    assert(nullptr == pIORequests);
+
+    // VirtualAlloc returns page aligned memory, so each request starts on its own cache line
+    size_t cbRequests = static_cast<size_t>(cRequests) * sizeof(IORequest);
+    pIORequests = (IORequest *)VirtualAlloc(nullptr, cbRequests, MEM_COMMIT, PAGE_READWRITE);
+    if (nullptr == pIORequests)
+    {
+        return false;
+    }
+
+    cIORequests = cRequests;
+    return true;
+}
+
+void ThreadParameters::FreeIORequests()
+{
+    if (nullptr != pIORequests)
+    {
+        VirtualFree(pIORequests, 0, MEM_RELEASE);
+        pIORequests = nullptr;
+        cIORequests = 0;
+    }
+}
+
 DWORD ThreadParameters::GetTotalRequestCount() const
 {
     DWORD cRequests = 0;
@@ -683,3 +1185,153 @@ DWORD ThreadParameters::GetTotalRequestCount() const
 
     return cRequests;
 }
+
+DeviceSample DeviceResults::GetDelta(size_t iFirst, size_t iLast) const
+{
+    DeviceSample delta = {};
+
+    if (iLast < vSamples.size() && iFirst < iLast)
+    {
+        const DeviceSample& first = vSamples[iFirst];
+        const DeviceSample& last = vSamples[iLast];
+
+        delta.ullTime = last.ullTime - first.ullTime;
+        delta.ullBytesRead = last.ullBytesRead - first.ullBytesRead;
+        delta.ullBytesWritten = last.ullBytesWritten - first.ullBytesWritten;
+        delta.ullReadTime = last.ullReadTime - first.ullReadTime;
+        delta.ullWriteTime = last.ullWriteTime - first.ullWriteTime;
+        delta.ullIdleTime = last.ullIdleTime - first.ullIdleTime;
+        delta.ullQueryTime = last.ullQueryTime - first.ullQueryTime;
+        // the counts are 32 bit and may wrap; unsigned arithmetic takes care of a single wrap
+        delta.dwReadCount = last.dwReadCount - first.dwReadCount;
+        delta.dwWriteCount = last.dwWriteCount - first.dwWriteCount;
+        delta.dwSplitCount = last.dwSplitCount - first.dwSplitCount;
+        delta.dwQueueDepth = last.dwQueueDepth;
+    }
+
+    return delta;
+}
+
+double DeviceResults::GetIops(const DeviceSample& delta) const
+{
+    double fTime = PerfTimer::PerfTimeToSeconds(delta.ullTime);
+    return (fTime > 0) ? (static_cast<double>(delta.dwReadCount) + delta.dwWriteCount) / fTime : 0;
+}
+
+// Little's law: the time all the I/Os spent in the device over the length of the interval
+double DeviceResults::GetAverageQueueDepth(const DeviceSample& delta) const
+{
+    return (delta.ullQueryTime > 0) ? static_cast<double>(delta.ullReadTime + delta.ullWriteTime) / delta.ullQueryTime : 0;
+}
+
+double DeviceResults::GetUtilization(const DeviceSample& delta) const
+{
+    if ((delta.ullQueryTime == 0) || (delta.ullIdleTime >= delta.ullQueryTime))
+    {
+        return 0;
+    }
+    return 100.0 * (delta.ullQueryTime - delta.ullIdleTime) / delta.ullQueryTime;
+}
+
+double DeviceResults::GetAverageInFlight() const
+{
+    if (vSamples.empty())
+    {
+        return 0;
+    }
+
+    double fSum = 0;
+    for (const auto& sample : vSamples)
+    {
+        fSum += sample.dwQueueDepth;
+    }
+    return fSum / vSamples.size();
+}
+
+void DeviceResults::GetApplicationIo(const vector<ThreadResults>& vThreadResults, UINT64 *pullReadBytes, UINT64 *pullWriteBytes, UINT64 *pullReadCount, UINT64 *pullWriteCount) const
+{
+    *pullReadBytes = 0;
+    *pullWriteBytes = 0;
+    *pullReadCount = 0;
+    *pullWriteCount = 0;
+
+    for (const auto& threadResults : vThreadResults)
+    {
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            if (find(vTargetPaths.begin(), vTargetPaths.end(), targetResults.sPath) != vTargetPaths.end())
+            {
+                *pullReadBytes += targetResults.ullReadBytesCount;
+                *pullWriteBytes += targetResults.ullWriteBytesCount;
+                *pullReadCount += targetResults.ullReadIOCount;
+                *pullWriteCount += targetResults.ullWriteIOCount;
+            }
+        }
+    }
+}
+
+const char *DeviceResults::GetDiscrepancy(UINT64 ullApplicationBytes, UINT64 ullDeviceBytes, bool fWrite)
+{
+    if (ullDeviceBytes * 10 < ullApplicationBytes * 9)
+    {
+        return fWrite ? "writes absorbed by the cache; they may reach the device after the measurement" :
+                        "reads served from the cache without reaching the device";
+    }
+    if (ullDeviceBytes * 10 > ullApplicationBytes * 11)
+    {
+        return fWrite ? "more writes on the device than issued: other activity, metadata or cache flushes" :
+                        "more reads on the device than issued: other activity, metadata or read-ahead";
+    }
+    return NULL;
+}
+
+PassStatistics::PassStatistics(const vector<double>& vValues) :
+    cValues(vValues.size()),
+    fMedian(0),
+    fMean(0),
+    fStandardDeviation(0),
+    fConfidenceInterval(0)
+{
+    if (cValues == 0)
+    {
+        return;
+    }
+
+    vector<double> vSorted(vValues);
+    sort(vSorted.begin(), vSorted.end());
+    fMedian = (cValues % 2 == 1) ? vSorted[cValues / 2] : (vSorted[cValues / 2 - 1] + vSorted[cValues / 2]) / 2;
+
+    double fSum = 0;
+    for (auto f : vValues)
+    {
+        fSum += f;
+    }
+    fMean = fSum / cValues;
+
+    if (cValues > 1)
+    {
+        double fSumSq = 0;
+        for (auto f : vValues)
+        {
+            fSumSq += (f - fMean) * (f - fMean);
+        }
+        fStandardDeviation = sqrt(fSumSq / (cValues - 1));
+        fConfidenceInterval = GetStudentT95(cValues - 1) * fStandardDeviation / sqrt(static_cast<double>(cValues));
+    }
+}
+
+// two-sided 95% critical values of Student's t distribution
+double PassStatistics::GetStudentT95(size_t cDegreesOfFreedom)
+{
+    static const double afT95[] = {
+        0,      12.706, 4.303,  3.182,  2.776,  2.571,  2.447,  2.365,  2.306,  2.262,
+        2.228,  2.201,  2.179,  2.160,  2.145,  2.131,  2.120,  2.110,  2.101,  2.093,
+        2.086,  2.080,  2.074,  2.069,  2.064,  2.060,  2.056,  2.052,  2.048,  2.045,
+        2.042 };
+
+    if (cDegreesOfFreedom < _countof(afT95))
+    {
+        return afT95[cDegreesOfFreedom];
+    }
+    return (cDegreesOfFreedom < 60) ? 2.000 : ((cDegreesOfFreedom < 120) ? 1.980 : 1.960);
+}
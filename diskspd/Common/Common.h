@@ -110,6 +110,38 @@ struct ETWSessionInfo
     ULONG ulRealTimeBuffersLost;
 };
 
+// counters of the worker threads and the process over the measurement window; unlike the ETW
+// counters they are always collected, since they need neither a trace session nor elevation.
+// The only hardware counter is the cycle count of each thread (QueryThreadCycleTime, in
+// ThreadResults). Retired instructions and cache misses are out of scope: Windows exposes them
+// only as PMC samples attached to the context switch events of the system-wide kernel logger,
+// which needs elevation and a per-CPU attribution of the samples to the worker threads
+struct WorkerCounters
+{
+    UINT64 ullContextSwitches;          // summed over the worker threads
+    UINT64 ullPageFaults;               // whole process (GetProcessMemoryInfo)
+    UINT64 ullReadOperations;           // whole process (GetProcessIoCounters)
+    UINT64 ullWriteOperations;
+    UINT64 ullOtherOperations;
+};
+
+// one snapshot of the IOCTL_DISK_PERFORMANCE counters of a disk or volume;
+// the times are in 100ns units, as reported by the storage stack
+struct DeviceSample
+{
+    UINT64 ullTime;                     // PerfTimer ticks when the sample was taken
+    UINT64 ullBytesRead;
+    UINT64 ullBytesWritten;
+    UINT64 ullReadTime;                 // summed over all the reads, so it grows with the queue depth
+    UINT64 ullWriteTime;
+    UINT64 ullIdleTime;
+    UINT64 ullQueryTime;
+    DWORD dwReadCount;
+    DWORD dwWriteCount;
+    DWORD dwQueueDepth;                 // I/Os in flight at the time of the sample
+    DWORD dwSplitCount;                 // I/Os split into several requests by the storage stack
+};
+
 // structure containing parameters concerning ETW session provided by user
 struct ETWMask
 {
@@ -134,6 +166,13 @@ namespace UnitTests
     class TargetUnitTests;
 }
 
+// source of the timestamps returned by PerfTimer::GetTime
+enum class PerfTimerSource
+{
+    QueryPerformanceCounter = 1,
+    InvariantTsc
+};
+
 class PerfTimer
 {
 public:
@@ -151,10 +190,20 @@ public:
     static UINT64 MillisecondsToPerfTime(const double);
     static UINT64 SecondsToPerfTime(const double);
 
+    static PerfTimerSource GetSource();
+    static UINT64 GetFrequency();
+
+    // measures the cost of a single GetTime call and the smallest observable
+    // difference between two consecutive calls (both in nanoseconds)
+    static void MeasureOverhead(double *pfOverheadNs, double *pfResolutionNs);
+
 private:
 
+    static const bool USE_TSC;
     static const UINT64 TIMER_FREQ;
+    static bool _IsInvariantTscAvailable();
     static UINT64 _GetPerfTimerFreq();
+    static UINT64 _CalibrateTsc();
 
     friend class UnitTests::PerfTimerUnitTests;
 };
@@ -179,9 +228,48 @@ public:
 enum class IOOperation
 {
     ReadIO = 1,
-    WriteIO
+    WriteIO,
+    DiscardIO       // -U; not accounted by TargetResults::Add
+};
+
+// outcome of checking a block read in verify mode (-V)
+enum class BlockCheck
+{
+    Verified = 0,
+    Unwritten,      // no header, or one of another block size: the block was not written by a verify run with this -b
+    Raced,          // a write to the block was in flight, the read cannot be checked
+    Stale,          // an older generation than the last one written
+    Misplaced,      // the header names another offset or target
+    Corrupt,        // the checksum does not match
+    Count           // number of outcomes, not an outcome
 };
 
+struct VerifyError
+{
+    BlockCheck check;
+    UINT64 ullOffset;
+    UINT64 ullReadTime;             // completion of the read, in PerfTimer ticks from the start of the TimeSpan
+    UINT64 ullExpectedGeneration;   // 0 if unknown
+    UINT64 ullFoundGeneration;
+    UINT64 ullFoundOffset;
+    UINT64 ullWriteTime;            // issue of the write found in the block, likewise; 0 if written before the TimeSpan
+    UINT32 ulFoundTarget;
+    UINT32 ulFirstBadByte;          // first byte of the payload that differs (corrupt blocks)
+};
+
+#define MAX_VERIFY_ERRORS_PER_TARGET 16
+
+// operations of the small-file workload (-m), each on a whole file of the population
+enum class FileOperation
+{
+    OpenRead = 0,   // open, read to the end, close
+    Create,         // create, write, flush, close
+    Stat,           // query the attributes
+    Delete
+};
+
+#define FILE_OPERATION_COUNT 4
+
 class TargetResults
 {
 public:
@@ -192,9 +280,38 @@ public:
         ullReadBytesCount(0),
         ullReadIOCount(0),
         ullWriteBytesCount(0),
-        ullWriteIOCount(0)
+        ullWriteIOCount(0),
+        ullLateIOCount(0),
+        ullMaxBacklog(0),
+        ullIssueLag(0),
+        ullSequentialClaimCount(0),
+        dwThroughputBytesPerMillisecond(0),
+        dwTotalThroughputBytesPerMillisecond(0),
+        ullIssueIntervalCount(0),
+        fIssueIntervalSum(0),
+        fIssueIntervalSumSq(0),
+        ullFlushCount(0),
+        ullCommitCount(0),
+        ullLateCommitCount(0),
+        ullLogBatchCount(0),
+        ullDiscardCount(0),
+        ullDiscardBytesCount(0),
+        ullDiscardBurstCount(0),
+        ullFileReadBytesCount(0),
+        ullFileWriteBytesCount(0),
+        ullVerifyWriteCount(0),
+        ullVerifyReadCount(0),
+        ullVerifyErrorCount(0),
+        ullVerifyTime(0)
     {
-
+        for (size_t i = 0; i < static_cast<size_t>(BlockCheck::Count); i++)
+        {
+            vullVerifyChecks[i] = 0;
+        }
+        for (size_t i = 0; i < _countof(vullFileOperationCounts); i++)
+        {
+            vullFileOperationCounts[i] = 0;
+        }
     }
 
     void Add(DWORD dwBytesTransferred,
@@ -233,13 +350,15 @@ public:
         {
             ullRelativeCompletionTime = ullEndTime - *pullSpanStartTime;
 
-            if (type == IOOperation::ReadIO)
+            // with latency, the time series also carries the latency of each interval
+            IoBucketizer& bucketizer = (type == IOOperation::ReadIO) ? readBucketizer : writeBucketizer;
+            if (fMeasureLatency)
             {
-                readBucketizer.Add(ullRelativeCompletionTime);
+                bucketizer.Add(ullRelativeCompletionTime, fDurationMsec);
             }
             else
             {
-                writeBucketizer.Add(ullRelativeCompletionTime);
+                bucketizer.Add(ullRelativeCompletionTime);
             }
         }
 
@@ -258,6 +377,172 @@ public:
         ullIOCount++;                                   // update completed I/O operations counter
     }
 
+    // accounts for one open-loop arrival issued at ullIssueTime instead of its intended time
+    void AddArrival(UINT64 ullIntendedTime, UINT64 ullIssueTime, UINT64 ullBacklog)
+    {
+        if (ullBacklog > 0)
+        {
+            ullLateIOCount++;
+        }
+        if (ullBacklog > ullMaxBacklog)
+        {
+            ullMaxBacklog = ullBacklog;
+        }
+        if (ullIssueTime > ullIntendedTime)
+        {
+            ullIssueLag += ullIssueTime - ullIntendedTime;
+        }
+    }
+
+    // accounts for the time between two consecutive throttled (-g) issues
+    void AddIssueInterval(UINT64 ullInterval)
+    {
+        double fInterval = PerfTimer::PerfTimeToMicroseconds(ullInterval);
+        ullIssueIntervalCount++;
+        fIssueIntervalSum += fInterval;
+        fIssueIntervalSumSq += fInterval * fInterval;
+    }
+
+    double GetIssueIntervalAvg(void) const
+    {
+        return (ullIssueIntervalCount > 0) ? fIssueIntervalSum / ullIssueIntervalCount : 0;
+    }
+
+    double GetIssueIntervalJitter(void) const
+    {
+        if (ullIssueIntervalCount < 2)
+        {
+            return 0;
+        }
+        double fAvg = GetIssueIntervalAvg();
+        double fVariance = fIssueIntervalSumSq / ullIssueIntervalCount - fAvg * fAvg;
+        return (fVariance > 0) ? sqrt(fVariance) : 0;
+    }
+
+    // accounts for one flush
+    void AddFlush(UINT64 ullFlushStartTime, UINT64 ullFlushEndTime, bool fMeasureLatency)
+    {
+        ullFlushCount++;
+        if (fMeasureLatency)
+        {
+            flushLatencyHistogram.Add(static_cast<float>(PerfTimer::PerfTimeToMicroseconds(ullFlushEndTime - ullFlushStartTime)));
+        }
+    }
+
+    // accounts for one write made durable at ullDurableTime: the end of the flush after it, or its completion under -Sw
+    void AddDurableWrite(UINT64 ullWriteStartTime, UINT64 ullDurableTime)
+    {
+        durableWriteLatencyHistogram.Add(static_cast<float>(PerfTimer::PerfTimeToMicroseconds(ullDurableTime - ullWriteStartTime)));
+    }
+
+    // accounts for one discard, a single block of the mix or a bulk discard
+    void AddDiscard(UINT64 cbDiscarded, UINT64 ullStartTime, UINT64 ullSpanStartTime, bool fBurst, bool fMeasureLatency, bool fCalculateIopsStdDev)
+    {
+        UINT64 ullEndTime = PerfTimer::GetTime();
+
+        ullDiscardCount++;
+        ullDiscardBytesCount += cbDiscarded;
+        if (fBurst)
+        {
+            ullDiscardBurstCount++;
+            vullDiscardBurstTimes.push_back(ullStartTime - ullSpanStartTime);
+        }
+
+        if (fMeasureLatency)
+        {
+            Histogram<float>& histogram = fBurst ? discardBurstLatencyHistogram : discardLatencyHistogram;
+            histogram.Add(static_cast<float>(PerfTimer::PerfTimeToMicroseconds(ullEndTime - ullStartTime)));
+        }
+
+        if (fCalculateIopsStdDev)
+        {
+            discardBucketizer.Add(ullEndTime - ullSpanStartTime);
+        }
+    }
+
+    // accounts for one batch of the group-commit log writer; the write itself is accounted by Add
+    void AddLogBatch(UINT32 cCommits, UINT32 cLateCommits)
+    {
+        ullLogBatchCount++;
+        ullCommitCount += cCommits;
+        ullLateCommitCount += cLateCommits;
+        if (vullLogBatchSizes.size() <= cCommits)
+        {
+            vullLogBatchSizes.resize(cCommits + 1);
+        }
+        vullLogBatchSizes[cCommits]++;
+    }
+
+    // accounts for one operation of the small-file workload (-m) and the bytes it read or wrote
+    void AddFileOperation(FileOperation operation, UINT64 cbTransferred, UINT64 ullStartTime, bool fMeasureLatency)
+    {
+        UINT64 ullEndTime = PerfTimer::GetTime();
+        size_t iOperation = static_cast<size_t>(operation);
+
+        vullFileOperationCounts[iOperation]++;
+        if (operation == FileOperation::OpenRead)
+        {
+            ullFileReadBytesCount += cbTransferred;
+        }
+        else if (operation == FileOperation::Create)
+        {
+            ullFileWriteBytesCount += cbTransferred;
+        }
+
+        if (fMeasureLatency)
+        {
+            vFileOperationLatencyHistograms[iOperation].Add(static_cast<float>(PerfTimer::PerfTimeToMicroseconds(ullEndTime - ullStartTime)));
+        }
+    }
+
+    UINT64 GetFileOperationCount() const
+    {
+        UINT64 ullCount = 0;
+        for (size_t i = 0; i < FILE_OPERATION_COUNT; i++)
+        {
+            ullCount += vullFileOperationCounts[i];
+        }
+        return ullCount;
+    }
+
+    // accounts for one block checked in verify mode (-V); the first errors are kept for the report
+    void AddVerifyCheck(BlockCheck check, const VerifyError& error)
+    {
+        ullVerifyReadCount++;
+        vullVerifyChecks[static_cast<size_t>(check)]++;
+        if (check >= BlockCheck::Stale)
+        {
+            ullVerifyErrorCount++;
+            if (vVerifyErrors.size() < MAX_VERIFY_ERRORS_PER_TARGET)
+            {
+                vVerifyErrors.push_back(error);
+            }
+        }
+    }
+
+    // splits the latency of a single I/O into the time spent in ReadFile/WriteFile,
+    // the time the I/O was in flight and the time its completion waited to be reaped
+    void AddLatencyDecomposition(UINT64 ullSubmitStartTime,
+                                 UINT64 ullSubmitEndTime,
+                                 UINT64 ullCompletionTime,
+                                 UINT64 ullReapTime)
+    {
+        // the completion time is an estimate and may precede the end of the submit call
+        // if the I/O completed before ReadFile/WriteFile returned
+        if (ullCompletionTime < ullSubmitEndTime)
+        {
+            ullCompletionTime = ullSubmitEndTime;
+        }
+        if (ullReapTime < ullCompletionTime)
+        {
+            ullReapTime = ullCompletionTime;
+        }
+
+        submitLatencyHistogram.Add(static_cast<float>(PerfTimer::PerfTimeToMicroseconds(ullSubmitEndTime - ullSubmitStartTime)));
+        inFlightLatencyHistogram.Add(static_cast<float>(PerfTimer::PerfTimeToMicroseconds(ullCompletionTime - ullSubmitEndTime)));
+        reapLatencyHistogram.Add(static_cast<float>(PerfTimer::PerfTimeToMicroseconds(ullReapTime - ullCompletionTime)));
+    }
+
     string sPath;
     UINT64 ullFileSize;         //size of the file
     UINT64 ullBytesCount;       //number of accessed bytes
@@ -267,17 +552,159 @@ public:
     UINT64 ullWriteBytesCount;  //number of bytes written
     UINT64 ullWriteIOCount;     //number of performed Write I/O operations
 
+    // open-loop arrivals (-A)
+    UINT64 ullLateIOCount;      //number of I/Os issued after the next arrival was already due
+    UINT64 ullMaxBacklog;       //largest number of due arrivals waiting for a free request slot
+    UINT64 ullIssueLag;         //sum of (actual - intended) issue times, in PerfTimer ticks
+
+    // interlocked sequential (-si)
+    UINT64 ullSequentialClaimCount;     //number of interlocked operations on the shared offset
+
+    // throttling (-g)
+    DWORD dwThroughputBytesPerMillisecond;  //configured throttle, 0 = not throttled
+    DWORD dwTotalThroughputBytesPerMillisecond; //configured throttle shared by all threads (-G), 0 = not throttled
+    UINT64 ullIssueIntervalCount;           //number of measured intervals between throttled issues
+    double fIssueIntervalSum;               //sum of the intervals, in microseconds
+    double fIssueIntervalSumSq;             //sum of the squared intervals
+
     Histogram<float> readLatencyHistogram;
     Histogram<float> writeLatencyHistogram;
 
+    // latency decomposition (-Ld)
+    Histogram<float> submitLatencyHistogram;    //time spent inside ReadFile/WriteFile
+    Histogram<float> inFlightLatencyHistogram;  //from the return of ReadFile/WriteFile to the (estimated) completion
+    Histogram<float> reapLatencyHistogram;      //from the (estimated) completion to the dequeue by the worker
+
+    // trace replay (-Y): latency the replayed I/Os had when the trace was recorded
+    Histogram<float> originalLatencyHistogram;
+
+    // flushes (-Of, -Op)
+    UINT64 ullFlushCount;                       //number of flushes
+    Histogram<float> flushLatencyHistogram;     //time spent in FlushFileBuffers
+    Histogram<float> durableWriteLatencyHistogram;  //from the issue of a write to the end of the flush after it, or to its completion with -Sw
+
+    // group-commit log writer (-M); each batch is also accounted as one write
+    UINT64 ullCommitCount;                      //number of commits made durable
+    UINT64 ullLateCommitCount;                  //commits held back by the client's previous commit
+    UINT64 ullLogBatchCount;                    //number of batches written
+    vector<UINT64> vullLogBatchSizes;           //number of batches by the number of commits in them
+    Histogram<float> commitLatencyHistogram;    //from the commit to the end of the write and flush of its batch
+
+    // discards (-U, -Ub); not included in the read and write counts
+    UINT64 ullDiscardCount;                     //number of discards, bursts included
+    UINT64 ullDiscardBytesCount;                //bytes discarded
+    UINT64 ullDiscardBurstCount;                //number of bulk discards
+    vector<UINT64> vullDiscardBurstTimes;       //issue times of the bulk discards, relative to the start of the TimeSpan
+    Histogram<float> discardLatencyHistogram;   //discards of the mix
+    Histogram<float> discardBurstLatencyHistogram;  //bulk discards
+
+    // small-file workload (-m); not included in the read and write counts
+    UINT64 vullFileOperationCounts[FILE_OPERATION_COUNT];   //operations by FileOperation
+    Histogram<float> vFileOperationLatencyHistograms[FILE_OPERATION_COUNT];
+    UINT64 ullFileReadBytesCount;               //bytes read by open/read/close
+    UINT64 ullFileWriteBytesCount;              //bytes written by create/write/flush
+
+    // verify mode (-V); counted from the start of the TimeSpan, warm up included
+    UINT64 ullVerifyWriteCount;     //number of blocks stamped
+    UINT64 ullVerifyReadCount;      //number of blocks read back
+    UINT64 vullVerifyChecks[static_cast<size_t>(BlockCheck::Count)];   //reads by BlockCheck
+    UINT64 ullVerifyErrorCount;     //stale, misplaced and corrupt blocks
+    UINT64 ullVerifyTime;           //time spent stamping and checking, in PerfTimer ticks
+    vector<VerifyError> vVerifyErrors;
+
     IoBucketizer readBucketizer;
     IoBucketizer writeBucketizer;
+    IoBucketizer discardBucketizer;
 };
 
 class ThreadResults
 {
 public:
+    ThreadResults() :
+        ullAccountingStartTime(0),
+        ullAccountingEndTime(0),
+        ullKernelTime(0),
+        ullUserTime(0),
+        ullCycleCount(0),
+        ullContextSwitches(0)
+    {
+    }
+
     vector<TargetResults> vTargetResults;
+
+    // the thread's own measurement window: the first and last moment the thread saw accounting on
+    UINT64 ullAccountingStartTime;
+    UINT64 ullAccountingEndTime;
+
+    // CPU used by the thread in its window (GetThreadTimes, in 100ns units, and QueryThreadCycleTime);
+    // they hold the sample taken at the start of the window until the window ends
+    UINT64 ullKernelTime;
+    UINT64 ullUserTime;
+    UINT64 ullCycleCount;
+
+    UINT64 ullContextSwitches;  // over the measurement of the TimeSpan, sampled by the main thread
+
+    // samples the CPU used by the thread so far
+    static bool GetThreadCpu(HANDLE hThread, UINT64 *pullKernelTime, UINT64 *pullUserTime, UINT64 *pullCycleCount)
+    {
+        FILETIME ftCreation, ftExit, ftKernel, ftUser;
+        if (!GetThreadTimes(hThread, &ftCreation, &ftExit, &ftKernel, &ftUser) ||
+            !QueryThreadCycleTime(hThread, pullCycleCount))
+        {
+            return false;
+        }
+        *pullKernelTime = (static_cast<UINT64>(ftKernel.dwHighDateTime) << 32) | ftKernel.dwLowDateTime;
+        *pullUserTime = (static_cast<UINT64>(ftUser.dwHighDateTime) << 32) | ftUser.dwLowDateTime;
+        return true;
+    }
+
+    void StartCpuWindow(HANDLE hThread)
+    {
+        if (!GetThreadCpu(hThread, &ullKernelTime, &ullUserTime, &ullCycleCount))
+        {
+            ullKernelTime = ullUserTime = ullCycleCount = 0;
+        }
+    }
+
+    void EndCpuWindow(HANDLE hThread)
+    {
+        UINT64 ullKernel, ullUser, ullCycles;
+        if (GetThreadCpu(hThread, &ullKernel, &ullUser, &ullCycles))
+        {
+            ullKernelTime = ullKernel - ullKernelTime;
+            ullUserTime = ullUser - ullUserTime;
+            ullCycleCount = ullCycles - ullCycleCount;
+        }
+        else
+        {
+            ullKernelTime = ullUserTime = ullCycleCount = 0;
+        }
+    }
+};
+
+// the device's own view of the I/O issued to one disk or volume during the measurement,
+// sampled at the start, at the end and every IoBucketDuration in between
+class DeviceResults
+{
+public:
+    string sDevice;                 // \\.\PhysicalDrive<n>, \\.\<letter>: or the volume GUID path
+    vector<string> vTargetPaths;    // targets residing on the device
+    vector<DeviceSample> vSamples;
+
+    DeviceSample GetDelta(size_t iFirst, size_t iLast) const;
+    DeviceSample GetTotal() const { return GetDelta(0, vSamples.size() - 1); }
+
+    double GetIops(const DeviceSample& delta) const;
+    double GetAverageQueueDepth(const DeviceSample& delta) const;
+    double GetUtilization(const DeviceSample& delta) const;
+    double GetAverageInFlight() const;
+
+    // what the application issued to the targets residing on the device
+    void GetApplicationIo(const vector<ThreadResults>& vThreadResults, UINT64 *pullReadBytes, UINT64 *pullWriteBytes, UINT64 *pullReadCount, UINT64 *pullWriteCount) const;
+
+    // explanation of a mismatch of more than 10% between the bytes the application issued and the
+    // bytes the device saw, or NULL if the two agree
+    static const char *GetDiscrepancy(UINT64 ullApplicationBytes, UINT64 ullDeviceBytes, bool fWrite);
 };
 
 class Results
@@ -287,9 +714,76 @@ public:
     struct ETWEventCounters EtwEventCounters;
     struct ETWMask EtwMask;
     struct ETWSessionInfo EtwSessionInfo;
+    struct WorkerCounters WorkerCounters;
+    bool fWorkerCounters;       // false if the counters could not be read
     vector<ThreadResults> vThreadResults;
     UINT64 ullTimeCount;
+    UINT64 ullSetupTime;        // from the start of the TimeSpan until all threads were ready to start
+    bool fWorkersReused;        // the threads were re-armed from the previous TimeSpan rather than created
     vector<SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION> vSystemProcessorPerfInfo;
+
+    // device statistics (-Q): one entry per disk or volume behind the targets
+    vector<DeviceResults> vDeviceResults;
+
+    // repeated passes (-N): throughput of every pass; the rest of the results belong to the reported (median) pass
+    vector<double> vPassBytesPerSecond;
+    vector<double> vPassIops;
+    size_t iReportedPass;
+
+    // steady state warm up (-Ws): one value per round of the warm up
+    bool fSteadyStateReached;
+    UINT64 ullWarmupTime;           // actual length of the warm up, in PerfTimer ticks
+    vector<double> vWarmupIops;
+    vector<double> vWarmupLatency;  // average latency in microseconds; only with -L
+
+    // binary I/O trace (-vt)
+    bool fTrace;
+    string sTraceFile;
+    UINT64 ullTraceRecords;             // records kept in the file
+    UINT64 ullTraceOverwrittenRecords;  // older records lost to ring wrap-around
+    double fTraceRecordNs;              // cost of writing one record, measured before the run
+    double fTraceFlushMilliseconds;     // time to flush the mapped view to the file at the end
+
+    // trace replay (-Y)
+    bool fReplay;
+    string sReplayFile;
+    double fReplaySpeed;
+    UINT64 ullReplayOperations;         // I/Os in the trace
+    UINT64 ullReplayIssuedOperations;   // I/Os issued before the replay ended or ran out of time
+    size_t cReplayStreams;
+
+    // length of the window measured by the thread, in seconds; falls back to
+    // the length of the whole measurement if the thread did not record one
+    double GetThreadTimeInSeconds(size_t iThread) const
+    {
+        const ThreadResults& threadResults = vThreadResults[iThread];
+        if ((threadResults.ullAccountingStartTime != 0) && (threadResults.ullAccountingEndTime > threadResults.ullAccountingStartTime))
+        {
+            return PerfTimer::PerfTimeToSeconds(threadResults.ullAccountingEndTime - threadResults.ullAccountingStartTime);
+        }
+        return PerfTimer::PerfTimeToSeconds(ullTimeCount);
+    }
+};
+
+// median, mean, standard deviation and 95% confidence interval of a set of per-pass values
+class PassStatistics
+{
+public:
+    PassStatistics(const vector<double>& vValues);
+
+    size_t cValues;
+    double fMedian;
+    double fMean;
+    double fStandardDeviation;      // sample standard deviation
+    double fConfidenceInterval;     // half-width of the 95% confidence interval of the mean
+
+    // half-width of the confidence interval in percent of the mean
+    double GetRelativeConfidenceInterval() const
+    {
+        return (fMean > 0) ? 100.0 * fConfidenceInterval / fMean : 0;
+    }
+
+    static double GetStudentT95(size_t cDegreesOfFreedom);
 };
 
 typedef void (*CALLBACK_TEST_STARTED)();    //callback function to notify that the measured test is about to start
@@ -300,12 +794,23 @@ class SystemInformation
 public:
     string sComputerName;
 
-    SystemInformation()
+    PerfTimerSource timerSource;    // timer used for latency and bucket timestamps
+    UINT64 ullTimerFrequency;       // ticks per second
+    double fTimerOverheadNs;        // cost of a single timer read
+    double fTimerResolutionNs;      // smallest observable difference between two timer reads
+
+    SystemInformation() :
+        timerSource(PerfTimer::GetSource()),
+        ullTimerFrequency(PerfTimer::GetFrequency()),
+        fTimerOverheadNs(0),
+        fTimerResolutionNs(0)
     {
         char buffer[64];
         DWORD cb = _countof(buffer);
         BOOL fResult;
 
+        PerfTimer::MeasureOverhead(&fTimerOverheadNs, &fTimerResolutionNs);
+
 #pragma prefast(suppress:38020, "Yes, we're aware this is an ANSI API in a UNICODE project")
         fResult = GetComputerNameExA(ComputerNamePhysicalDnsHostname, buffer, &cb);
         if (fResult)
@@ -329,6 +834,18 @@ public:
         sXml += "<VersionDate>" DISKSPD_DATE_VERSION_STRING "</VersionDate>\n";
         sXml += "</Tool>\n";
 
+        // identify the timer used for measurements, so that short latencies can be interpreted
+        char szBuffer[256];
+        sXml += "<Timer>\n";
+        sXml += (timerSource == PerfTimerSource::InvariantTsc) ? "<Source>InvariantTsc</Source>\n" : "<Source>QueryPerformanceCounter</Source>\n";
+        sprintf_s(szBuffer, _countof(szBuffer), "<Frequency>%I64u</Frequency>\n", ullTimerFrequency);
+        sXml += szBuffer;
+        sprintf_s(szBuffer, _countof(szBuffer), "<OverheadNanoseconds>%.3f</OverheadNanoseconds>\n", fTimerOverheadNs);
+        sXml += szBuffer;
+        sprintf_s(szBuffer, _countof(szBuffer), "<ResolutionNanoseconds>%.3f</ResolutionNanoseconds>\n", fTimerResolutionNs);
+        sXml += szBuffer;
+        sXml += "</Timer>\n";
+
         sXml += "</System>\n";
 
         return sXml;
@@ -362,6 +879,7 @@ public:
         _ullBaseFileOffset(0),
         _fParallelAsyncIO(false),
         _fInterlockedSequential(false),
+        _dwInterlockedSequentialChunk(1),
         _fDisableOSCache(false),
         _fDisableAllCache(false),
         _fZeroWriteBuffers(false),
@@ -381,10 +899,32 @@ public:
         _fUseLargePages(false),
         _ioPriorityHint(IoPriorityHintNormal),
         _dwThroughputBytesPerMillisecond(0),
+        _dwTotalThroughputBytesPerMillisecond(0),
+        _dwArrivalRate(0),
+        _fPoissonArrivals(false),
+        _fVerify(false),
+        _fWriteThrough(false),
+        _dwFlushInterval(0),
+        _ulFlushPercentage(0),
+        _dwLogClients(0),
+        _dwCommitRate(0),
+        _fPoissonCommits(false),
+        _ulDiscardPercentage(0),
+        _ullDiscardBurstSize(0),
+        _dwDiscardBurstInterval(0),
+        _dwFileCount(0),
+        _dwFilesPerDirectory(1000),
+        _ullMinPopulationFileSize(0),
+        _ullMaxPopulationFileSize(0),
         _cbRandomDataWriteBuffer(0),
         _sRandomDataWriteBufferSourcePath(),
         _pRandomDataWriteBuffer(nullptr)
     {
+        for (size_t i = 0; i < _countof(_vulFileOperationPercentages); i++)
+        {
+            _vulFileOperationPercentages[i] = 0;
+        }
+        _vulFileOperationPercentages[static_cast<size_t>(FileOperation::OpenRead)] = 100;
     }
 
     void SetPath(string sPath) { _sPath = sPath; }
@@ -428,6 +968,57 @@ public:
     void SetDisableAllCache(bool fDisableAllCache) { _fDisableAllCache = fDisableAllCache; }
     bool GetDisableAllCache() const { return _fDisableAllCache; }
 
+    // FILE_FLAG_WRITE_THROUGH alone, keeping the software cache unless -S is given too
+    void SetWriteThrough(bool fWriteThrough) { _fWriteThrough = fWriteThrough; }
+    bool GetWriteThrough() const { return _fWriteThrough; }
+
+    // flush the target after every n-th write of a thread (0 = never)
+    void SetFlushInterval(DWORD dwFlushInterval) { _dwFlushInterval = dwFlushInterval; }
+    DWORD GetFlushInterval() const { return _dwFlushInterval; }
+
+    // flush the target before the given percentage of the I/Os issued (0 = never)
+    void SetFlushPercentage(UINT32 ulFlushPercentage) { _ulFlushPercentage = ulFlushPercentage; }
+    UINT32 GetFlushPercentage() const { return _ulFlushPercentage; }
+
+    // group-commit log writer (-M): number of clients committing to the target (0 = off)
+    void SetLogClients(DWORD dwLogClients) { _dwLogClients = dwLogClients; }
+    DWORD GetLogClients() const { return _dwLogClients; }
+
+    void SetCommitRate(DWORD dwCommitRate) { _dwCommitRate = dwCommitRate; }
+    DWORD GetCommitRate() const { return _dwCommitRate; }
+
+    void SetPoissonCommits(bool fPoissonCommits) { _fPoissonCommits = fPoissonCommits; }
+    bool GetPoissonCommits() const { return _fPoissonCommits; }
+
+    // discards (-U): FSCTL_FILE_LEVEL_TRIM on files, a DSM trim on disks and partitions
+    void SetDiscardPercentage(UINT32 ulDiscardPercentage) { _ulDiscardPercentage = ulDiscardPercentage; }
+    UINT32 GetDiscardPercentage() const { return _ulDiscardPercentage; }
+
+    void SetDiscardBurstSize(UINT64 ullDiscardBurstSize) { _ullDiscardBurstSize = ullDiscardBurstSize; }
+    UINT64 GetDiscardBurstSize() const { return _ullDiscardBurstSize; }
+
+    void SetDiscardBurstInterval(DWORD dwDiscardBurstInterval) { _dwDiscardBurstInterval = dwDiscardBurstInterval; }
+    DWORD GetDiscardBurstInterval() const { return _dwDiscardBurstInterval; }
+
+    bool GetUseDiscards() const { return (_ulDiscardPercentage > 0) || (_dwDiscardBurstInterval > 0); }
+
+    // small-file workload (-m): the path is a directory populated with this many files (0 = off)
+    void SetFileCount(DWORD dwFileCount) { _dwFileCount = dwFileCount; }
+    DWORD GetFileCount() const { return _dwFileCount; }
+
+    void SetFilesPerDirectory(DWORD dwFilesPerDirectory) { _dwFilesPerDirectory = dwFilesPerDirectory; }
+    DWORD GetFilesPerDirectory() const { return _dwFilesPerDirectory; }
+
+    // sizes of the files, log-uniform between the two (0 = the block size)
+    void SetMinPopulationFileSize(UINT64 ullSize) { _ullMinPopulationFileSize = ullSize; }
+    UINT64 GetMinPopulationFileSize() const { return (_ullMinPopulationFileSize > 0) ? _ullMinPopulationFileSize : _dwBlockSize; }
+
+    void SetMaxPopulationFileSize(UINT64 ullSize) { _ullMaxPopulationFileSize = ullSize; }
+    UINT64 GetMaxPopulationFileSize() const { return (_ullMaxPopulationFileSize > 0) ? _ullMaxPopulationFileSize : GetMinPopulationFileSize(); }
+
+    void SetFileOperationPercentage(FileOperation operation, UINT32 ulPercentage) { _vulFileOperationPercentages[static_cast<size_t>(operation)] = ulPercentage; }
+    UINT32 GetFileOperationPercentage(FileOperation operation) const { return _vulFileOperationPercentages[static_cast<size_t>(operation)]; }
+
     void SetZeroWriteBuffers(bool fZeroWriteBuffers) { _fZeroWriteBuffers = fZeroWriteBuffers; }
     bool GetZeroWriteBuffers() const { return _fZeroWriteBuffers; }
 
@@ -470,6 +1061,9 @@ public:
     void SetUseInterlockedSequential(bool fInterlockedSequential) { _fInterlockedSequential = fInterlockedSequential; }
     bool GetUseInterlockedSequential() const { return _fInterlockedSequential; }
 
+    void SetInterlockedSequentialChunk(DWORD dwChunk) { _dwInterlockedSequentialChunk = dwChunk; }
+    DWORD GetInterlockedSequentialChunk() const { return _dwInterlockedSequentialChunk; }
+
     void SetThreadStrideInBytes(UINT64 ullThreadStride) { _ullThreadStride = ullThreadStride; }
     UINT64 GetThreadStrideInBytes() const { return _ullThreadStride; }
 
@@ -486,6 +1080,19 @@ public:
     void SetThroughput(DWORD dwThroughputBytesPerMillisecond) { _dwThroughputBytesPerMillisecond = dwThroughputBytesPerMillisecond; }
     DWORD GetThroughputInBytesPerMillisecond() const { return _dwThroughputBytesPerMillisecond; }
 
+    void SetTotalThroughput(DWORD dwTotalThroughputBytesPerMillisecond) { _dwTotalThroughputBytesPerMillisecond = dwTotalThroughputBytesPerMillisecond; }
+    DWORD GetTotalThroughputInBytesPerMillisecond() const { return _dwTotalThroughputBytesPerMillisecond; }
+
+    void SetArrivalRate(DWORD dwArrivalRate) { _dwArrivalRate = dwArrivalRate; }
+    DWORD GetArrivalRate() const { return _dwArrivalRate; }
+
+    void SetPoissonArrivals(bool fPoissonArrivals) { _fPoissonArrivals = fPoissonArrivals; }
+    bool GetPoissonArrivals() const { return _fPoissonArrivals; }
+
+    // verify mode: writes carry a header and a checksum which reads check
+    void SetVerify(bool fVerify) { _fVerify = fVerify; }
+    bool GetVerify() const { return _fVerify; }
+
     string GetXml() const;
 
     bool AllocateAndFillRandomDataWriteBuffer();
@@ -504,6 +1111,7 @@ private:
     UINT64 _ullBaseFileOffset;
     bool _fParallelAsyncIO;
     bool _fInterlockedSequential;
+    DWORD _dwInterlockedSequentialChunk;    // number of consecutive blocks a thread claims at once under -si
     bool _fDisableOSCache;
     bool _fDisableAllCache;
     bool _fZeroWriteBuffers;
@@ -521,6 +1129,24 @@ private:
     // TODO: could this be removed by using _dwThinkTime==0?
     bool _fThinkTime;       //variable to decide whether to think between IOs (default is false)
     DWORD _dwThroughputBytesPerMillisecond; // set to 0 to disable throttling
+    DWORD _dwTotalThroughputBytesPerMillisecond;    // throttle shared by all threads of the target; 0 = disabled
+    DWORD _dwArrivalRate;   // open-loop arrivals per second across all threads of the target; 0 = closed loop
+    bool _fPoissonArrivals; // exponential instead of constant inter-arrival times
+    bool _fVerify;          // stamp written blocks and check the blocks read
+    bool _fWriteThrough;    // open with FILE_FLAG_WRITE_THROUGH
+    DWORD _dwFlushInterval;     // writes between flushes, 0 = no flushes
+    UINT32 _ulFlushPercentage;  // flushes per 100 I/Os issued, 0 = no flushes
+    DWORD _dwLogClients;        // clients of the group-commit log writer, 0 = not a log
+    DWORD _dwCommitRate;        // commits per second across all clients, 0 = back to back
+    bool _fPoissonCommits;      // exponential instead of constant times between commits
+    UINT32 _ulDiscardPercentage;    // discards per 100 I/Os, one block each
+    UINT64 _ullDiscardBurstSize;    // bytes of each bulk discard
+    DWORD _dwDiscardBurstInterval;  // milliseconds between bulk discards, 0 = none
+    DWORD _dwFileCount;             // files of the small-file population, 0 = not a population
+    DWORD _dwFilesPerDirectory;     // files in each subdirectory of the population
+    UINT64 _ullMinPopulationFileSize;   // smallest file of the population, 0 = block size
+    UINT64 _ullMaxPopulationFileSize;   // largest file of the population, 0 = smallest
+    UINT32 _vulFileOperationPercentages[FILE_OPERATION_COUNT];  // mix of the operations, by FileOperation
 
     bool _fSequentialScanHint;          // open file with the FILE_FLAG_SEQUENTIAL_SCAN hint
     bool _fRandomAccessHint;            // open file with the FILE_FLAG_RANDOM_ACCESS hint
@@ -551,8 +1177,19 @@ public:
         _fDisableAffinity(false),
         _fCompletionRoutines(false),
         _fMeasureLatency(false),
+        _fMeasureLatencyDecomposition(false),
         _fCalculateIopsStdDev(false),
-        _ulIoBucketDurationInMilliseconds(1000)
+        _ulIoBucketDurationInMilliseconds(1000),
+        _ulPassCount(1),
+        _ulMinPassCount(3),
+        _fPassTolerance(0),
+        _fSteadyStateWarmup(false),
+        _ulSteadyStateWindow(5),
+        _ulSteadyStateInterval(1000),
+        _fSteadyStateRange(20),
+        _fSteadyStateSlope(10),
+        _fDeviceStatistics(false),
+        _fReplaySpeed(1)
     {
     }
 
@@ -595,11 +1232,55 @@ public:
     void SetMeasureLatency(bool fMeasureLatency) { _fMeasureLatency = fMeasureLatency; }
     bool GetMeasureLatency() const { return _fMeasureLatency; }
 
+    void SetMeasureLatencyDecomposition(bool fMeasureLatencyDecomposition) { _fMeasureLatencyDecomposition = fMeasureLatencyDecomposition; }
+    bool GetMeasureLatencyDecomposition() const { return _fMeasureLatencyDecomposition; }
+
     void SetCalculateIopsStdDev(bool fCalculateStdDev) { _fCalculateIopsStdDev = fCalculateStdDev; }
     bool GetCalculateIopsStdDev() const { return _fCalculateIopsStdDev; }
 
     void SetIoBucketDurationInMilliseconds(UINT32 ulIoBucketDurationInMilliseconds) { _ulIoBucketDurationInMilliseconds = ulIoBucketDurationInMilliseconds; }
     UINT32 GetIoBucketDurationInMilliseconds() const { return _ulIoBucketDurationInMilliseconds; }
+
+    // repeated passes (-N): the TimeSpan is run up to PassCount times and stops early once the
+    // confidence interval of the throughput is within PassTolerance percent of the mean
+    void SetPassCount(UINT32 ulPassCount) { _ulPassCount = ulPassCount; }
+    UINT32 GetPassCount() const { return _ulPassCount; }
+
+    void SetMinPassCount(UINT32 ulMinPassCount) { _ulMinPassCount = ulMinPassCount; }
+    UINT32 GetMinPassCount() const { return _ulMinPassCount; }
+
+    void SetPassTolerance(double fPassTolerance) { _fPassTolerance = fPassTolerance; }
+    double GetPassTolerance() const { return _fPassTolerance; }
+
+    // steady state warm up (-Ws): the warm up ends as soon as IOPS (and latency with -L) settle
+    // over a window of rounds, the way SNIA PTS defines it; the warm up time becomes the limit
+    void SetSteadyStateWarmup(bool fSteadyStateWarmup) { _fSteadyStateWarmup = fSteadyStateWarmup; }
+    bool GetSteadyStateWarmup() const { return _fSteadyStateWarmup; }
+
+    void SetSteadyStateWindow(UINT32 ulSteadyStateWindow) { _ulSteadyStateWindow = ulSteadyStateWindow; }
+    UINT32 GetSteadyStateWindow() const { return _ulSteadyStateWindow; }
+
+    void SetSteadyStateIntervalInMilliseconds(UINT32 ulSteadyStateInterval) { _ulSteadyStateInterval = ulSteadyStateInterval; }
+    UINT32 GetSteadyStateIntervalInMilliseconds() const { return _ulSteadyStateInterval; }
+
+    void SetSteadyStateRange(double fSteadyStateRange) { _fSteadyStateRange = fSteadyStateRange; }
+    double GetSteadyStateRange() const { return _fSteadyStateRange; }
+
+    void SetSteadyStateSlope(double fSteadyStateSlope) { _fSteadyStateSlope = fSteadyStateSlope; }
+    double GetSteadyStateSlope() const { return _fSteadyStateSlope; }
+
+    // device statistics (-Q): sample the counters of the disk or volume behind each target
+    // every IoBucketDuration of the measurement
+    void SetDeviceStatistics(bool fDeviceStatistics) { _fDeviceStatistics = fDeviceStatistics; }
+    bool GetDeviceStatistics() const { return _fDeviceStatistics; }
+
+    // trace replay (-Y): the I/Os of a trace are issued instead of the access pattern of the targets,
+    // at their recorded times divided by the speed, or as fast as their dependencies allow with a speed of 0
+    void SetReplayFile(string sReplayFile) { _sReplayFile = sReplayFile; }
+    string GetReplayFile() const { return _sReplayFile; }
+
+    void SetReplaySpeed(double fReplaySpeed) { _fReplaySpeed = fReplaySpeed; }
+    double GetReplaySpeed() const { return _fReplaySpeed; }
     
     string GetXml() const;
     void MarkFilesAsPrecreated(const vector<string> vFiles);
@@ -616,8 +1297,20 @@ private:
     vector<UINT32> _vAffinity;
     bool _fCompletionRoutines;
     bool _fMeasureLatency;
+    bool _fMeasureLatencyDecomposition;
     bool _fCalculateIopsStdDev;
     UINT32 _ulIoBucketDurationInMilliseconds;
+    UINT32 _ulPassCount;        //maximum number of passes (-N)
+    UINT32 _ulMinPassCount;     //passes run before the tolerance is checked
+    double _fPassTolerance;     //in percent of the mean; 0 = always run all the passes
+    bool _fSteadyStateWarmup;
+    UINT32 _ulSteadyStateWindow;    //number of rounds the criteria are checked over
+    UINT32 _ulSteadyStateInterval;  //length of a round, in milliseconds
+    double _fSteadyStateRange;      //allowed max - min within the window, in percent of its average
+    double _fSteadyStateSlope;      //allowed change of the line fit across the window, in percent of its average
+    bool _fDeviceStatistics;
+    string _sReplayFile;
+    double _fReplaySpeed;           //0 = as fast as possible
 
     friend class UnitTests::ProfileUnitTests;
 };
@@ -625,7 +1318,9 @@ private:
 enum class ResultsFormat
 {
     Text,
-    Xml
+    Xml,
+    Json,
+    Csv
 };
 
 enum class PrecreateFiles
@@ -656,7 +1351,8 @@ public:
         _fEtwUseSystemTimer(false),
         _fEtwUseCyclesCounter(false),
         _resultsFormat(ResultsFormat::Text),
-        _precreateFiles(PrecreateFiles::None)
+        _precreateFiles(PrecreateFiles::None),
+        _ulTraceRecordsPerThread(1 << 20)
     {
     }
 
@@ -682,6 +1378,14 @@ public:
     void SetPrecreateFiles(PrecreateFiles c) { _precreateFiles = c; }
     PrecreateFiles GetPrecreateFiles() const { return _precreateFiles; }
 
+    // binary per-I/O trace (-vt): every measured I/O is recorded in a memory-mapped ring per thread;
+    // with several TimeSpans, the trace of the n-th one goes to <file>.<n>
+    void SetTraceFile(string sTraceFile) { _sTraceFile = sTraceFile; }
+    string GetTraceFile() const { return _sTraceFile; }
+
+    void SetTraceRecordsPerThread(UINT32 ulTraceRecordsPerThread) { _ulTraceRecordsPerThread = ulTraceRecordsPerThread; }
+    UINT32 GetTraceRecordsPerThread() const { return _ulTraceRecordsPerThread; }
+
     //ETW
     void SetEtwEnabled(bool fEtwEnabled)                    { _fEtwEnabled = fEtwEnabled; }
     void SetEtwProcess(bool fEtwProcess)                    { _fEtwProcess = fEtwProcess; }
@@ -724,6 +1428,8 @@ private:
     string _sCmdLine;
     ResultsFormat _resultsFormat;
     PrecreateFiles _precreateFiles;
+    string _sTraceFile;
+    UINT32 _ulTraceRecordsPerThread;   //capacity of each thread's ring, rounded up to a power of two
 
     //ETW
     bool _fEtwEnabled;
@@ -743,6 +1449,33 @@ private:
     friend class UnitTests::ProfileUnitTests;
 };
 
+class SharedThroughputMeter;
+class IOTraceRing;
+class IOReplay;
+class BlockVerifier;
+
+#define IO_REQUEST_ALIGNMENT 64
+
+// IORequest holds the state of one outstanding request that is touched on every
+// issue and completion. It embeds the OVERLAPPED passed to the OS, so a completed
+// OVERLAPPED leads straight to its request, and it fits in a single cache line.
+struct DECLSPEC_ALIGN(IO_REQUEST_ALIGNMENT) IORequest
+{
+    OVERLAPPED overlapped;
+    BYTE *pReadBuffer;          // data buffer of the request
+    BYTE *pWriteBuffer;         // same as pReadBuffer unless the target uses a random data write buffer
+    UINT64 ullStartTime;        // IO start time (or the intended arrival time in open-loop mode)
+    UINT32 iTarget;             // index of the target in ThreadParameters::vTargets
+    IOOperation ioType;         // type of the IO in flight
+
+    static IORequest *FromOverlapped(OVERLAPPED *pOverlapped)
+    {
+        return CONTAINING_RECORD(pOverlapped, IORequest, overlapped);
+    }
+};
+
+static_assert(sizeof(IORequest) == IO_REQUEST_ALIGNMENT, "IORequest should fill exactly one cache line");
+
 class ThreadParameters
 {
 public:
@@ -750,9 +1483,20 @@ public:
         pProfile(nullptr),
         pTimeSpan(nullptr),
         pullSharedSequentialOffsets(nullptr),
+        pSharedThroughputMeters(nullptr),
+        pIORequests(nullptr),
+        cIORequests(0),
+        cIORequestsInFlight(0),
         ulRandSeed(0),
         ulThreadNo(0),
-        ulRelativeThreadNo(0)
+        ulRelativeThreadNo(0),
+        llWarmupIOCount(0),
+        llWarmupLatency(0),
+        hRearmEvent(nullptr),
+        fRetire(false),
+        pTrace(nullptr),
+        pReplay(nullptr),
+        pBlockVerifiers(nullptr)
     {
     }
 
@@ -763,20 +1507,30 @@ public:
     vector<HANDLE> vhTargets;
     vector<UINT64> vullFileSizes;
     vector<BYTE *> vpDataBuffers;
-    vector<OVERLAPPED> vOverlapped;             // each target has RequestCount OVERLAPPED structures
-    vector<size_t> vOverlappedIdToTargetId;
-    vector<size_t> vFirstOverlappedIdForTargetId;   //id of the first overlapped structure in the vOverlapped vector by target
-    vector<IOOperation> vdwIoType;                        //as many as vOverlapped; used by the completion routines
-    vector<UINT64> vIoStartTimes;
+    IORequest *pIORequests;                     // each target has RequestCount requests, one per cache line
+    UINT32 cIORequests;
+    UINT32 cIORequestsInFlight;                 //used only in case of completion routines
+    vector<UINT64> vIoSubmitEndTimes;           //as many as requests; used only for latency decomposition
+    vector<UINT64> vullVerifySnapshots;         //as many as requests; block state at issue, used only in verify mode
+    vector<DWORD> vdwWritesSinceFlush;          //per target; used only with -Of
+    vector<vector<UINT64>> vvullUnflushedWriteStartTimes;  //per target; writes completed since the last flush, kept only with -L
   
     // For vanilla sequential access (-s):
     // Private per-thread offsets, incremented directly, indexed to number of targets
     vector<UINT64> vullPrivateSequentialOffsets; 
 
+    // For chunked interlocked sequential access (-si with -k):
+    // Blocks left in the chunk last claimed from the shared offset, indexed to number of targets;
+    // the next offset of the chunk is kept in vullPrivateSequentialOffsets
+    vector<DWORD> vdwSequentialChunkRemaining;
+
     // For interlocked sequential access (-si):
     // Pointers to offsets shared between threads, incremented with an interlocked op
     UINT64* pullSharedSequentialOffsets;
 
+    // For -G: throttles shared between threads, indexed to number of targets
+    SharedThroughputMeter* pSharedThroughputMeters;
+
     UINT32 ulRandSeed;
     UINT32 ulThreadNo;
     UINT32 ulRelativeThreadNo;
@@ -784,6 +1538,10 @@ public:
     // accounting
     volatile bool *pfAccountingOn;
     PUINT64 pullStartTime;
+
+    // steady state warm up (-Ws): completions before accounting is turned on, sampled by the main thread
+    volatile LONG64 llWarmupIOCount;
+    volatile LONG64 llWarmupLatency;   //sum of the latencies, in PerfTimer ticks; only with -L
     ThreadResults *pResults;
 
     //group affinity
@@ -795,8 +1553,24 @@ public:
 
     // TODO: check how it's used
     HANDLE hEndEvent;        //used only in case of completion routines (not for IO Completion Ports)
+
+    // worker pool: a parked thread waits on hRearmEvent for the next TimeSpan, or exits if fRetire is set
+    HANDLE hRearmEvent;
+    volatile bool fRetire;
+
+    // binary I/O trace (-vt): the thread's ring in the trace file, or NULL
+    IOTraceRing *pTrace;
+
+    // trace replay (-Y): the replay of the TimeSpan, or NULL
+    IOReplay *pReplay;
+
+    // verify mode (-V): block verifiers shared by all threads, indexed like vTargets
+    BlockVerifier *pBlockVerifiers;
     
     bool AllocateAndFillBufferForTarget(const Target& target);
+    bool AllocateIORequests(UINT32 cRequests);
+    void FreeIORequests();
+    UINT32 GetIORequestIndex(const IORequest *pIORequest) const { return static_cast<UINT32>(pIORequest - pIORequests); }
     BYTE* GetReadBuffer(size_t iTarget, size_t iRequest);
     BYTE* GetWriteBuffer(size_t iTarget, size_t iRequest);
     DWORD GetTotalRequestCount() const;
@@ -808,6 +1582,14 @@ private:
 class IResultParser
 {
 public:
-    virtual string ParseResults(Profile& profile, const SystemInformation& system, vector<Results> vResults) = 0;
+    virtual string ParseResults(Profile& profile, const SystemInformation& system, const vector<Results>& vResults) = 0;
 	virtual int GetTotalScore() = 0;
 };
+
+// writes the results to a file as it walks them, without building the report in memory
+class IResultWriter
+{
+public:
+    virtual bool WriteResults(const Profile& profile, const SystemInformation& system, const vector<Results>& vResults, FILE *pFile) = 0;
+    virtual int GetTotalScore() = 0;
+};
@@ -34,6 +34,8 @@ SOFTWARE.
 #include <string>
 #include <sstream>
 #include <limits>
+#include <vector>
+#include <algorithm>
 #include <cmath>
 
 #pragma push_macro("min")
@@ -151,6 +153,48 @@ class Histogram
         throw std::runtime_error("Percentile is undefined");
     }
     
+    // several percentiles (ascending, each >= 0 and <= 1) from a single sort of the data
+    void GetPercentiles(const double *pPercentiles, size_t cPercentiles, T *pValues) const
+    {
+        std::map<T,unsigned> sortedData = _GetSortedData();
+        auto pos = sortedData.begin();
+        unsigned cur = 0;
+        T value = T();
+
+        for (size_t i = 0; i < cPercentiles; i++)
+        {
+            const double target = GetSampleSize() * pPercentiles[i];
+
+            while (pos != sortedData.end() && (cur == 0 || cur < target))
+            {
+                cur += pos->second;
+                value = pos->first;
+                ++pos;
+            }
+
+            if (cur == 0 || cur < target)
+            {
+                throw std::runtime_error("Percentile is undefined");
+            }
+            pValues[i] = value;
+        }
+    }
+
+    // number of samples at or below each of the ascending upper limits, bin by bin; the extra
+    // last bin holds the samples above the last limit. Walks the data once without sorting it
+    std::vector<unsigned> GetBinCounts(const std::vector<T>& vLimits) const
+    {
+        std::vector<unsigned> vCounts(vLimits.size() + 1, 0);
+
+        for (auto i : _data)
+        {
+            size_t bin = std::lower_bound(vLimits.begin(), vLimits.end(), i.first) - vLimits.begin();
+            vCounts[bin] += i.second;
+        }
+
+        return vCounts;
+    }
+
     T GetPercentile(int p) const 
     {
         return GetPercentile(static_cast<double>(p)/100);
@@ -73,6 +73,28 @@ void IoBucketizer::Add(unsigned __int64 ioCompletionTime)
     _vBuckets[bucketNumber]++;
 }
 
+void IoBucketizer::Add(unsigned __int64 ioCompletionTime, double latency)
+{
+    Add(ioCompletionTime);
+
+    size_t bucketNumber = static_cast<size_t>(ioCompletionTime / _bucketDuration);
+    if (_vLatencySums.size() < bucketNumber + 1)
+    {
+        _vLatencySums.resize(bucketNumber + 1, 0);
+    }
+    _vLatencySums[bucketNumber] += latency;
+}
+
+bool IoBucketizer::HasLatency() const
+{
+    return !_vLatencySums.empty();
+}
+
+double IoBucketizer::GetLatencySum(size_t bucketNumber) const
+{
+    return (bucketNumber < _vLatencySums.size()) ? _vLatencySums[bucketNumber] : 0;
+}
+
 size_t IoBucketizer::GetNumberOfValidBuckets() const 
 {
     // Buckets beyond this may exist since Add is willing to extend the vector
@@ -140,4 +162,13 @@ void IoBucketizer::Merge(const IoBucketizer& other)
     {
         _vBuckets[i] += other.GetIoBucket(i);
     }
+
+    if (other._vLatencySums.size() > _vLatencySums.size())
+    {
+        _vLatencySums.resize(other._vLatencySums.size(), 0);
+    }
+    for (size_t i = 0; i < other._vLatencySums.size(); i++)
+    {
+        _vLatencySums[i] += other._vLatencySums[i];
+    }
 }
\ No newline at end of file
@@ -41,6 +41,9 @@ public:
     size_t GetNumberOfBuckets() const;
     unsigned int GetIoBucket(size_t bucketNumber) const;
     void Add(unsigned __int64 ioCompletionTime);
+    void Add(unsigned __int64 ioCompletionTime, double latency);
+    bool HasLatency() const;
+    double GetLatencySum(size_t bucketNumber) const;
     double GetStandardDeviation() const;
     void Merge(const IoBucketizer& other);
 private:
@@ -49,4 +52,5 @@ private:
     unsigned __int64 _bucketDuration;
     size_t _validBuckets;
     std::vector<unsigned int> _vBuckets;
+    std::vector<double> _vLatencySums;      // sum of the latencies of the IOs of each bucket, if given
 };
\ No newline at end of file
@@ -0,0 +1,102 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "ArrivalScheduler.h"
+#include <math.h>
+
+ArrivalScheduler::ArrivalScheduler(void) :
+    _fRunning(false),
+    _fPoisson(false),
+    _fMeanInterArrival(0),
+    _ullNextArrival(0),
+    _ullRandState(0)
+{
+}
+
+bool ArrivalScheduler::IsRunning(void) const
+{
+    return _fRunning;
+}
+
+void ArrivalScheduler::Start(double fArrivalsPerSecond, bool fPoisson, UINT32 ulSeed)
+{
+    _fRunning = false;
+
+    if (fArrivalsPerSecond > 0)
+    {
+        _fPoisson = fPoisson;
+        _fMeanInterArrival = PerfTimer::SecondsToPerfTime(1.0) / fArrivalsPerSecond;
+        // xorshift must not be seeded with zero
+        _ullRandState = 0x9E3779B97F4A7C15ULL ^ ulSeed;
+        _ullNextArrival = PerfTimer::GetTime() + _GetInterArrivalTime();
+        _fRunning = true;
+    }
+}
+
+UINT64 ArrivalScheduler::GetNextArrivalTime(void) const
+{
+    return _ullNextArrival;
+}
+
+UINT64 ArrivalScheduler::GetDelay(UINT64 ullNow) const
+{
+    return (ullNow < _ullNextArrival) ? (_ullNextArrival - ullNow) : 0;
+}
+
+UINT64 ArrivalScheduler::TakeArrival(UINT64 ullNow, UINT64 *pullBacklog)
+{
+    UINT64 ullIntended = _ullNextArrival;
+    _ullNextArrival += _GetInterArrivalTime();
+
+    // arrivals which are already due but still wait for a free request slot
+    *pullBacklog = 0;
+    if (ullNow >= _ullNextArrival)
+    {
+        *pullBacklog = 1 + static_cast<UINT64>((ullNow - _ullNextArrival) / _fMeanInterArrival);
+    }
+
+    return ullIntended;
+}
+
+UINT64 ArrivalScheduler::_GetInterArrivalTime(void)
+{
+    if (!_fPoisson)
+    {
+        return static_cast<UINT64>(_fMeanInterArrival);
+    }
+
+    _ullRandState ^= _ullRandState << 13;
+    _ullRandState ^= _ullRandState >> 7;
+    _ullRandState ^= _ullRandState << 17;
+
+    // uniform in (0, 1], then inverse transform to an exponential distribution
+    double u = static_cast<double>((_ullRandState >> 11) + 1) / 9007199254740992.0;
+    return static_cast<UINT64>(-log(u) * _fMeanInterArrival);
+}
@@ -0,0 +1,59 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+#include <Windows.h>
+#include "Common.h"
+
+// ArrivalScheduler generates the intended issue times of an open-loop
+// workload: I/Os arrive at a fixed rate (constant or Poisson inter-arrival
+// times) regardless of how fast earlier I/Os complete. The worker issues an
+// I/O once GetNextArrivalTime() has passed and calls TakeArrival() to get
+// its intended issue time, from which latency is then measured.
+class ArrivalScheduler
+{
+public:
+    ArrivalScheduler(void);
+
+    bool IsRunning(void) const;
+    void Start(double fArrivalsPerSecond, bool fPoisson, UINT32 ulSeed);
+    UINT64 GetNextArrivalTime(void) const;
+    UINT64 GetDelay(UINT64 ullNow) const;
+    UINT64 TakeArrival(UINT64 ullNow, UINT64 *pullBacklog);
+
+private:
+    UINT64 _GetInterArrivalTime(void);
+
+    bool _fRunning;                 // true = open-loop scheduling is on
+    bool _fPoisson;                 // true = exponential inter-arrival times, false = constant
+    double _fMeanInterArrival;      // mean time between arrivals, in PerfTimer ticks
+    UINT64 _ullNextArrival;         // intended issue time of the next I/O, in PerfTimer ticks
+    UINT64 _ullRandState;           // xorshift state for Poisson arrivals
+};
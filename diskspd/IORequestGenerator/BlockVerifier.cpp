@@ -0,0 +1,324 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "BlockVerifier.h"
+#include <intrin.h>
+#include <stddef.h>
+#include <string.h>
+
+#define STATE_GENERATION_MASK   0x0000FFFFFFFFFFFFULL
+#define STATE_WRITER            0x0001000000000000ULL
+#define STATE_WRITERS_MASK      0x7FFF000000000000ULL
+#define STATE_OVERLAPPED        0x8000000000000000ULL
+
+// software CRC32C (Castagnoli, reflected) for CPUs without the CRC instructions
+struct Crc32cTable
+{
+    Crc32cTable()
+    {
+        for (UINT32 i = 0; i < 256; i++)
+        {
+            UINT32 ulCrc = i;
+            for (int iBit = 0; iBit < 8; iBit++)
+            {
+                ulCrc = (ulCrc & 1) ? (ulCrc >> 1) ^ 0x82F63B78 : (ulCrc >> 1);
+            }
+            vulCrc[i] = ulCrc;
+        }
+    }
+
+    UINT32 vulCrc[256];
+};
+
+#if defined(_M_X64) || defined(_M_IX86)
+static bool hasCrcInstruction(void)
+{
+    int vInfo[4];
+    __cpuid(vInfo, 1);
+    return (vInfo[2] & (1 << 20)) != 0;    // SSE4.2
+}
+#endif
+
+BlockVerifier::BlockVerifier(void) :
+    _fRunning(false),
+    _ulTarget(0),
+    _dwBlockSize(0),
+    _ullStartTime(0),
+    _llGeneration(0),
+    _pllStates(nullptr),
+    _cBlocks(0)
+{
+}
+
+BlockVerifier::~BlockVerifier(void)
+{
+    if (nullptr != _pllStates)
+    {
+        VirtualFree(const_cast<LONG64 *>(_pllStates), 0, MEM_RELEASE);
+    }
+}
+
+void BlockVerifier::Start(UINT32 ulTarget, DWORD dwBlockSize)
+{
+    assert(dwBlockSize >= sizeof(BlockHeader));
+
+    _ulTarget = ulTarget;
+    _dwBlockSize = dwBlockSize;
+    _ullStartTime = PerfTimer::GetTime();
+    _fRunning = true;
+}
+
+bool BlockVerifier::Track(UINT64 ullFileSize)
+{
+    if (nullptr != _pllStates)
+    {
+        return true;
+    }
+
+    // the threads of a target all see the same size; the first one to publish its map wins
+    UINT64 cBlocks = ullFileSize / _dwBlockSize;
+    LONG64 *pllStates = static_cast<LONG64 *>(VirtualAlloc(nullptr, static_cast<SIZE_T>(cBlocks * sizeof(LONG64)), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+    if (nullptr == pllStates)
+    {
+        return false;
+    }
+
+    _cBlocks = cBlocks;
+    if (nullptr != InterlockedCompareExchangePointer((PVOID volatile *)&_pllStates, pllStates, nullptr))
+    {
+        VirtualFree(pllStates, 0, MEM_RELEASE);
+    }
+    return true;
+}
+
+volatile LONG64 *BlockVerifier::_GetState(UINT64 ullOffset) const
+{
+    UINT64 iBlock = ullOffset / _dwBlockSize;
+    return (iBlock < _cBlocks) ? &_pllStates[iBlock] : nullptr;
+}
+
+void BlockVerifier::BeginWrite(BYTE *pBuffer, UINT64 ullOffset, UINT32 ulSeed)
+{
+    UINT64 ullGeneration = static_cast<UINT64>(InterlockedIncrement64(&_llGeneration)) & STATE_GENERATION_MASK;
+
+    // a write issued while another one is in flight makes the content of the block ambiguous
+    // until a write is issued to the idle block again
+    volatile LONG64 *pllState = _GetState(ullOffset);
+    if (nullptr != pllState)
+    {
+        LONG64 llOld;
+        LONG64 llNew;
+        do
+        {
+            llOld = *pllState;
+            UINT64 ullWriters = static_cast<UINT64>(llOld) & STATE_WRITERS_MASK;
+            llNew = static_cast<LONG64>(ullGeneration | (ullWriters + STATE_WRITER) | ((ullWriters != 0) ? STATE_OVERLAPPED : 0));
+        } while (InterlockedCompareExchange64(pllState, llNew, llOld) != llOld);
+    }
+
+    BlockHeader *pHeader = reinterpret_cast<BlockHeader *>(pBuffer);
+    _FillPayload(pBuffer + sizeof(BlockHeader), _dwBlockSize - sizeof(BlockHeader), ulSeed);
+    pHeader->ulMagic = BLOCK_HEADER_MAGIC;
+    pHeader->ullOffset = ullOffset;
+    pHeader->ullGeneration = ullGeneration;
+    pHeader->ullWriteTime = PerfTimer::GetTime();
+    pHeader->ulTarget = _ulTarget;
+    pHeader->ulSeed = ulSeed;
+    pHeader->ulBlockSize = _dwBlockSize;
+    pHeader->ulReserved = 0;
+    pHeader->ulCrc = Crc32c(&pHeader->ullOffset, _dwBlockSize - offsetof(BlockHeader, ullOffset));
+}
+
+void BlockVerifier::EndWrite(UINT64 ullOffset)
+{
+    volatile LONG64 *pllState = _GetState(ullOffset);
+    if (nullptr != pllState)
+    {
+        LONG64 llOld;
+        do
+        {
+            llOld = *pllState;
+            assert((static_cast<UINT64>(llOld) & STATE_WRITERS_MASK) != 0);
+        } while (InterlockedCompareExchange64(pllState, static_cast<LONG64>(static_cast<UINT64>(llOld) - STATE_WRITER), llOld) != llOld);
+    }
+}
+
+UINT64 BlockVerifier::BeginRead(UINT64 ullOffset) const
+{
+    volatile LONG64 *pllState = _GetState(ullOffset);
+    return (nullptr != pllState) ? static_cast<UINT64>(*pllState) : 0;
+}
+
+BlockCheck BlockVerifier::CheckRead(const BYTE *pBuffer, UINT64 ullOffset, UINT64 ullSnapshot, VerifyError *pError) const
+{
+    assert(nullptr != pError);
+
+    memset(pError, 0, sizeof(*pError));
+    pError->ullOffset = ullOffset;
+    pError->ullReadTime = PerfTimer::GetTime() - _ullStartTime;
+
+    // the block can only be checked if no write to it was in flight while it was read
+    if ((BeginRead(ullOffset) != ullSnapshot) || ((ullSnapshot & STATE_WRITERS_MASK) != 0))
+    {
+        pError->check = BlockCheck::Raced;
+        return pError->check;
+    }
+
+    UINT64 ullExpected = ullSnapshot & STATE_GENERATION_MASK;
+    bool fExact = (ullExpected != 0) && ((ullSnapshot & STATE_OVERLAPPED) == 0);
+    pError->ullExpectedGeneration = ullExpected;
+
+    const BlockHeader *pHeader = reinterpret_cast<const BlockHeader *>(pBuffer);
+    if ((pHeader->ulMagic != BLOCK_HEADER_MAGIC) || (pHeader->ulBlockSize != _dwBlockSize))
+    {
+        // a block written in this TimeSpan must come back with its header; one stamped with
+        // another block size (an earlier run or TimeSpan) has a checksum over another length
+        pError->check = (ullExpected == 0) ? BlockCheck::Unwritten : BlockCheck::Stale;
+        return pError->check;
+    }
+
+    pError->ullFoundGeneration = pHeader->ullGeneration;
+    pError->ullFoundOffset = pHeader->ullOffset;
+    pError->ulFoundTarget = pHeader->ulTarget;
+    pError->ullWriteTime = (pHeader->ullWriteTime >= _ullStartTime) ? pHeader->ullWriteTime - _ullStartTime : 0;
+
+    if (Crc32c(&pHeader->ullOffset, _dwBlockSize - offsetof(BlockHeader, ullOffset)) != pHeader->ulCrc)
+    {
+        pError->ulFirstBadByte = static_cast<UINT32>(sizeof(BlockHeader) +
+            _FindFirstDifference(pBuffer + sizeof(BlockHeader), _dwBlockSize - sizeof(BlockHeader), pHeader->ulSeed));
+        pError->check = BlockCheck::Corrupt;
+    }
+    else if ((pHeader->ullOffset != ullOffset) || (pHeader->ulTarget != _ulTarget))
+    {
+        pError->check = BlockCheck::Misplaced;
+    }
+    else if (ullExpected == 0)
+    {
+        // written before the TimeSpan: the block is consistent, its generation cannot be checked
+        pError->check = BlockCheck::Verified;
+    }
+    else if ((pHeader->ullWriteTime < _ullStartTime) ||
+             (fExact && (pHeader->ullGeneration != ullExpected)) ||
+             (!fExact && (pHeader->ullGeneration > ullExpected)))
+    {
+        pError->check = BlockCheck::Stale;
+    }
+    else
+    {
+        pError->check = BlockCheck::Verified;
+    }
+
+    return pError->check;
+}
+
+// xorshift64* sequence seeded from the header, so that a corrupt payload can be
+// regenerated and compared
+void BlockVerifier::_FillPayload(BYTE *pPayload, size_t cb, UINT32 ulSeed)
+{
+    UINT64 ullState = (static_cast<UINT64>(ulSeed) << 32) | 0x9E3779B9;
+    size_t i = 0;
+    for (; i + sizeof(UINT64) <= cb; i += sizeof(UINT64))
+    {
+        ullState ^= ullState >> 12;
+        ullState ^= ullState << 25;
+        ullState ^= ullState >> 27;
+        *reinterpret_cast<UINT64 *>(pPayload + i) = ullState * 0x2545F4914F6CDD1DULL;
+    }
+    if (i < cb)
+    {
+        ullState ^= ullState >> 12;
+        ullState ^= ullState << 25;
+        ullState ^= ullState >> 27;
+        UINT64 ullLast = ullState * 0x2545F4914F6CDD1DULL;
+        memcpy(pPayload + i, &ullLast, cb - i);
+    }
+}
+
+size_t BlockVerifier::_FindFirstDifference(const BYTE *pPayload, size_t cb, UINT32 ulSeed)
+{
+    std::vector<BYTE> vExpected(cb);
+    _FillPayload(&vExpected[0], cb, ulSeed);
+    for (size_t i = 0; i < cb; i++)
+    {
+        if (pPayload[i] != vExpected[i])
+        {
+            return i;
+        }
+    }
+    return cb;  // the payload is intact, the header was damaged
+}
+
+UINT32 BlockVerifier::Crc32c(const void *pData, size_t cb)
+{
+    const BYTE *pb = static_cast<const BYTE *>(pData);
+    UINT32 ulCrc = 0xFFFFFFFF;
+
+#if defined(_M_X64) || defined(_M_IX86)
+    static const bool fHardware = hasCrcInstruction();
+    if (fHardware)
+    {
+#if defined(_M_X64)
+        UINT64 ullCrc = ulCrc;
+        for (; cb >= sizeof(UINT64); cb -= sizeof(UINT64), pb += sizeof(UINT64))
+        {
+            ullCrc = _mm_crc32_u64(ullCrc, *reinterpret_cast<const UINT64 *>(pb));
+        }
+        ulCrc = static_cast<UINT32>(ullCrc);
+#else
+        for (; cb >= sizeof(UINT32); cb -= sizeof(UINT32), pb += sizeof(UINT32))
+        {
+            ulCrc = _mm_crc32_u32(ulCrc, *reinterpret_cast<const UINT32 *>(pb));
+        }
+#endif
+        for (; cb > 0; cb--, pb++)
+        {
+            ulCrc = _mm_crc32_u8(ulCrc, *pb);
+        }
+        return ~ulCrc;
+    }
+#elif defined(_M_ARM64)
+    // the CRC32 instructions are part of every ARMv8 CPU Windows runs on
+    for (; cb >= sizeof(UINT64); cb -= sizeof(UINT64), pb += sizeof(UINT64))
+    {
+        ulCrc = __crc32cd(ulCrc, *reinterpret_cast<const UINT64 *>(pb));
+    }
+    for (; cb > 0; cb--, pb++)
+    {
+        ulCrc = __crc32cb(ulCrc, *pb);
+    }
+    return ~ulCrc;
+#endif
+
+    static const Crc32cTable table;
+    for (; cb > 0; cb--, pb++)
+    {
+        ulCrc = table.vulCrc[(ulCrc ^ *pb) & 0xFF] ^ (ulCrc >> 8);
+    }
+    return ~ulCrc;
+}
@@ -0,0 +1,108 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+#include <Windows.h>
+#include <vector>
+#include "Common.h"
+
+// Verify mode (-V): every block written carries a header naming the target, the
+// offset, the generation of the write and the block size, followed by a payload
+// generated from the seed in the header. The CRC32C in the header covers the
+// rest of the block, so a block stamped with another block size cannot be checked.
+// A read checks the header and the checksum of the block it got back, so that
+// data that is stale (an older generation), misplaced (another offset or target)
+// or corrupt is caught under load.
+//
+#define BLOCK_HEADER_MAGIC 0x42565344   // "DSVB"
+
+struct BlockHeader
+{
+    UINT32 ulMagic;
+    UINT32 ulCrc;           // CRC32C of the block from ullOffset to its end
+    UINT64 ullOffset;
+    UINT64 ullGeneration;   // 1 for the first block written to the target in the TimeSpan
+    UINT64 ullWriteTime;    // PerfTimer time the write was issued
+    UINT32 ulTarget;
+    UINT32 ulSeed;          // seed of the payload
+    UINT32 ulBlockSize;     // bytes covered by the header, i.e. the block size of the write
+    UINT32 ulReserved;
+};
+
+// BlockVerifier tracks the last generation written to each block of a target;
+// it is shared by all the threads working on the target. The state of a block
+// is a single 64-bit word updated with compare-exchange:
+//
+//   bits 0-47    generation of the last write issued
+//   bits 48-62   writes in flight
+//   bit 63       writes overlapped since the last write issued to an idle block,
+//                so any of their generations may be on the media
+//
+// A read can only be checked against a generation if no write to the block was
+// in flight while it was, i.e. the state did not change from issue to completion.
+class BlockVerifier
+{
+public:
+    BlockVerifier(void);
+    ~BlockVerifier(void);
+
+    // called by the main thread before the TimeSpan starts
+    void Start(UINT32 ulTarget, DWORD dwBlockSize);
+    bool IsRunning(void) const { return _fRunning; }
+
+    // called by each thread with the size of the target once it is open; the first
+    // call allocates the block map
+    bool Track(UINT64 ullFileSize);
+
+    // stamps the buffer of a write and marks the block as being written
+    void BeginWrite(BYTE *pBuffer, UINT64 ullOffset, UINT32 ulSeed);
+    void EndWrite(UINT64 ullOffset);
+
+    // snapshots the state of a block about to be read; the snapshot is passed to CheckRead
+    UINT64 BeginRead(UINT64 ullOffset) const;
+    BlockCheck CheckRead(const BYTE *pBuffer, UINT64 ullOffset, UINT64 ullSnapshot, VerifyError *pError) const;
+
+    static UINT32 Crc32c(const void *pData, size_t cb);
+
+private:
+    BlockVerifier(const BlockVerifier&);
+    BlockVerifier& operator=(const BlockVerifier&);
+
+    static void _FillPayload(BYTE *pPayload, size_t cb, UINT32 ulSeed);
+    static size_t _FindFirstDifference(const BYTE *pPayload, size_t cb, UINT32 ulSeed);
+    volatile LONG64 *_GetState(UINT64 ullOffset) const;
+
+    bool _fRunning;
+    UINT32 _ulTarget;
+    DWORD _dwBlockSize;
+    UINT64 _ullStartTime;           // blocks written before are not expected to match the block map
+    volatile LONG64 _llGeneration;  // last generation handed out
+    volatile LONG64 * volatile _pllStates;  // one word per block, published by the first Track()
+    UINT64 _cBlocks;
+};
@@ -0,0 +1,138 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "GroupCommitLog.h"
+#include <algorithm>
+
+GroupCommitLog::GroupCommitLog(void) :
+    _cMaxBatch(0)
+{
+}
+
+void GroupCommitLog::Start(UINT32 cClients, double fCommitsPerSecond, bool fPoisson, UINT32 cMaxBatch, UINT32 ulSeed)
+{
+    UINT64 ullNow = PerfTimer::GetTime();
+
+    _cMaxBatch = max(cMaxBatch, 1U);
+    _vBatch.clear();
+    _vBatch.reserve(cClients);
+    _vClients.clear();
+    _vClients.resize(cClients);
+    for (UINT32 i = 0; i < cClients; i++)
+    {
+        Client& client = _vClients[i];
+        // clients share the rate; seeded apart so Poisson clients do not commit in lockstep
+        client.arrivals.Start(fCommitsPerSecond / cClients, fPoisson, ulSeed + i);
+        client.ullReleaseTime = ullNow;
+        client.ullCommitTime = 0;
+        client.fLate = false;
+    }
+}
+
+UINT64 GroupCommitLog::GetDelay(UINT64 ullNow) const
+{
+    UINT64 ullDelay = MAXUINT64;
+    for (const auto& client : _vClients)
+    {
+        if ((client.ullCommitTime != 0) || !client.arrivals.IsRunning())
+        {
+            return 0;
+        }
+        ullDelay = min(ullDelay, client.arrivals.GetDelay(ullNow));
+    }
+    return (ullDelay == MAXUINT64) ? 0 : ullDelay;
+}
+
+UINT32 GroupCommitLog::FormBatch(UINT64 ullNow)
+{
+    _vBatch.clear();
+    for (UINT32 i = 0; i < _vClients.size(); i++)
+    {
+        Client& client = _vClients[i];
+        if (client.ullCommitTime == 0)
+        {
+            if (!client.arrivals.IsRunning())
+            {
+                client.ullCommitTime = client.ullReleaseTime;
+            }
+            else if (ullNow >= client.arrivals.GetNextArrivalTime())
+            {
+                // a client which is still waiting for its previous commit at the intended
+                // time commits as soon as it is released, as a database session would
+                UINT64 ullBacklog;
+                UINT64 ullIntended = client.arrivals.TakeArrival(ullNow, &ullBacklog);
+                client.fLate = (ullIntended < client.ullReleaseTime);
+                client.ullCommitTime = max(ullIntended, client.ullReleaseTime);
+            }
+        }
+
+        if (client.ullCommitTime != 0)
+        {
+            _vBatch.push_back(i);
+        }
+    }
+
+    // more commits than fit in one write: the oldest go first, the rest wait for the next batch
+    if (_vBatch.size() > _cMaxBatch)
+    {
+        std::nth_element(_vBatch.begin(), _vBatch.begin() + _cMaxBatch, _vBatch.end(),
+            [this](UINT32 a, UINT32 b) { return _vClients[a].ullCommitTime < _vClients[b].ullCommitTime; });
+        _vBatch.resize(_cMaxBatch);
+    }
+
+    return static_cast<UINT32>(_vBatch.size());
+}
+
+UINT64 GroupCommitLog::GetCommitTime(UINT32 iCommit) const
+{
+    return _vClients[_vBatch[iCommit]].ullCommitTime;
+}
+
+UINT32 GroupCommitLog::GetLateCommitCount(void) const
+{
+    UINT32 cLate = 0;
+    for (UINT32 iClient : _vBatch)
+    {
+        cLate += _vClients[iClient].fLate ? 1 : 0;
+    }
+    return cLate;
+}
+
+void GroupCommitLog::CompleteBatch(UINT64 ullDurableTime)
+{
+    for (UINT32 iClient : _vBatch)
+    {
+        Client& client = _vClients[iClient];
+        client.ullReleaseTime = ullDurableTime;
+        client.ullCommitTime = 0;
+        client.fLate = false;
+    }
+    _vBatch.clear();
+}
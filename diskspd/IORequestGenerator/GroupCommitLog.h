@@ -0,0 +1,67 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+#include <Windows.h>
+#include <vector>
+#include "Common.h"
+#include "ArrivalScheduler.h"
+
+// GroupCommitLog models the clients of a database log (-M). Each client
+// commits at its own rate (or back to back when no rate is given) and then
+// waits until its commit record is durable, so at most one commit per client
+// is outstanding. The log writer calls FormBatch() to gather the commits which
+// have arrived into one write, and CompleteBatch() once the write and its
+// flush are done, which releases the clients of the batch.
+class GroupCommitLog
+{
+public:
+    GroupCommitLog(void);
+
+    void Start(UINT32 cClients, double fCommitsPerSecond, bool fPoisson, UINT32 cMaxBatch, UINT32 ulSeed);
+    UINT64 GetDelay(UINT64 ullNow) const;
+    UINT32 FormBatch(UINT64 ullNow);
+    UINT64 GetCommitTime(UINT32 iCommit) const;
+    UINT32 GetLateCommitCount(void) const;
+    void CompleteBatch(UINT64 ullDurableTime);
+
+private:
+    struct Client
+    {
+        ArrivalScheduler arrivals;  // intended commit times; not running when clients commit back to back
+        UINT64 ullReleaseTime;      // end of the client's previous commit
+        UINT64 ullCommitTime;       // arrival of the waiting commit, 0 = none
+        bool fLate;                 // the commit was held back by the client's previous one
+    };
+
+    std::vector<Client> _vClients;
+    std::vector<UINT32> _vBatch;    // clients whose commits are in the batch being written
+    UINT32 _cMaxBatch;              // commit records which fit in one write
+};
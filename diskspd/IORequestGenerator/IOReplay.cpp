@@ -0,0 +1,388 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "IOReplay.h"
+#include "IOTrace.h"
+#include "Common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <limits.h>
+#include <map>
+#include <algorithm>
+
+IOReplay::IOReplay() :
+    _cThreads(0),
+    _fSpeed(1),
+    _ullOperationCount(0),
+    _ulMaxBytes(0),
+    _ulMaxInFlight(0),
+    _fReads(false),
+    _fWrites(false),
+    _lThreadsReplaying(0),
+    _hDoneEvent(nullptr)
+{
+}
+
+IOReplay::~IOReplay()
+{
+    if (nullptr != _hDoneEvent)
+    {
+        CloseHandle(_hDoneEvent);
+    }
+}
+
+bool IOReplay::Load(const char *pszPath, double fSpeed, UINT32 cThreads)
+{
+    FILE *pFile = nullptr;
+    if ((fopen_s(&pFile, pszPath, "rb") != 0) || (nullptr == pFile))
+    {
+        _sError = "could not open the file";
+        return false;
+    }
+
+    // the binary trace starts with its magic; anything else is read as CSV
+    UINT32 ulMagic = 0;
+    bool fBinary = (fread(&ulMagic, sizeof(ulMagic), 1, pFile) == 1) && (ulMagic == IO_TRACE_MAGIC);
+    rewind(pFile);
+
+    std::vector<std::vector<RawOp>> vRawStreams;
+    std::vector<UINT32> vIds;
+    UINT64 ullFrequency = 1000000000;   // the CSV loader keeps nanoseconds
+    bool fOk = fBinary ? _LoadBinary(pFile, vRawStreams, vIds, &ullFrequency) : _LoadCsv(pFile, vRawStreams, vIds);
+    fclose(pFile);
+    if (!fOk)
+    {
+        return false;
+    }
+
+    _cThreads = cThreads;
+    _fSpeed = fSpeed;
+    _Prepare(vRawStreams, vIds, ullFrequency);
+    if (0 == _ullOperationCount)
+    {
+        _sError = "the trace does not have any I/O";
+        return false;
+    }
+
+    _lThreadsReplaying = static_cast<LONG>(cThreads);
+    _hDoneEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (nullptr == _hDoneEvent)
+    {
+        _sError = "could not create the replay event";
+        return false;
+    }
+    return true;
+}
+
+/*****************************************************************************/
+// reads the rings of a -vt trace, oldest record first; every ring is a stream
+//
+bool IOReplay::_LoadBinary(FILE *pFile, std::vector<std::vector<RawOp>>& vRawStreams, std::vector<UINT32>& vIds, UINT64 *pullFrequency)
+{
+    IOTraceFileHeader header;
+    if ((fread(&header, sizeof(header), 1, pFile) != 1) ||
+        (header.ulVersion != IO_TRACE_VERSION) ||
+        (header.cbRecord != sizeof(IOTraceRecord)) ||
+        (header.cRecordsPerThread == 0) ||
+        (header.ullTimerFrequency == 0))
+    {
+        _sError = "unsupported version of the binary trace";
+        return false;
+    }
+    *pullFrequency = header.ullTimerFrequency;
+
+    std::vector<IOTraceRecord> vRecords;
+    for (UINT32 iThread = 0; iThread < header.cThreads; iThread++)
+    {
+        IOTraceSegmentHeader segment;
+        UINT64 ullSegmentOffset = header.cbHeader + header.cbSegment * iThread;
+        if ((_fseeki64(pFile, ullSegmentOffset, SEEK_SET) != 0) || (fread(&segment, sizeof(segment), 1, pFile) != 1))
+        {
+            _sError = "the binary trace is truncated";
+            return false;
+        }
+
+        UINT64 cRecords = segment.ullRecordCount;
+        UINT64 iFirst = 0;
+        if (cRecords > header.cRecordsPerThread)
+        {
+            iFirst = cRecords % header.cRecordsPerThread;
+            cRecords = header.cRecordsPerThread;
+        }
+        if (0 == cRecords)
+        {
+            continue;
+        }
+
+        vRecords.resize(static_cast<size_t>(cRecords));
+        if (fread(&vRecords[0], sizeof(IOTraceRecord), vRecords.size(), pFile) != vRecords.size())
+        {
+            _sError = "the binary trace is truncated";
+            return false;
+        }
+
+        vIds.push_back(segment.ulThread);
+        vRawStreams.resize(vRawStreams.size() + 1);
+        std::vector<RawOp>& vOps = vRawStreams.back();
+        vOps.reserve(vRecords.size());
+        for (UINT64 i = 0; i < cRecords; i++)
+        {
+            const IOTraceRecord& record = vRecords[static_cast<size_t>((iFirst + i) % header.cRecordsPerThread)];
+            // discards (-U) are not replayed
+            if (3 == record.bType)
+            {
+                continue;
+            }
+            RawOp op;
+            op.ullOffset = record.ullOffset;
+            op.llSubmitTime = static_cast<INT64>(record.ullSubmitTime);
+            op.llCompleteTime = static_cast<INT64>(record.ullCompleteTime);
+            op.ulBytes = record.ulBytes;
+            op.bTarget = record.bTarget;
+            op.bType = record.bType;
+            vOps.push_back(op);
+        }
+    }
+
+    return true;
+}
+
+/*****************************************************************************/
+// reads stream,target,type,offset,bytes,submit_us[,complete_us] lines
+//
+bool IOReplay::_LoadCsv(FILE *pFile, std::vector<std::vector<RawOp>>& vRawStreams, std::vector<UINT32>& vIds)
+{
+    std::map<UINT32, size_t> mStreams;
+    char szLine[1024];
+    UINT64 ullLine = 0;
+    while (nullptr != fgets(szLine, sizeof(szLine), pFile))
+    {
+        ullLine++;
+        if (!isdigit(static_cast<unsigned char>(szLine[0])))
+        {
+            continue;   // header, comment or empty line
+        }
+
+        char *pszNext;
+        RawOp op;
+        UINT32 ulStream = strtoul(szLine, &pszNext, 10);
+        bool fOk = (',' == *pszNext);
+        if (fOk)
+        {
+            op.bTarget = static_cast<BYTE>(strtoul(pszNext + 1, &pszNext, 10));
+            fOk = (',' == *pszNext);
+        }
+        if (fOk)
+        {
+            char chType = static_cast<char>(tolower(static_cast<unsigned char>(*(pszNext + 1))));
+            op.bType = ('r' == chType) ? 1 : 2;
+            fOk = ('r' == chType) || ('w' == chType);
+            pszNext = strchr(pszNext + 1, ',');
+            fOk = fOk && (nullptr != pszNext);
+        }
+        if (fOk)
+        {
+            op.ullOffset = _strtoui64(pszNext + 1, &pszNext, 10);
+            fOk = (',' == *pszNext);
+        }
+        if (fOk)
+        {
+            op.ulBytes = strtoul(pszNext + 1, &pszNext, 10);
+            fOk = (',' == *pszNext) && (op.ulBytes > 0);
+        }
+        if (fOk)
+        {
+            // microseconds with up to three decimals are kept as nanoseconds
+            double fSubmit = strtod(pszNext + 1, &pszNext);
+            op.llSubmitTime = static_cast<INT64>(fSubmit * 1000);
+            op.llCompleteTime = LLONG_MIN;
+            if (',' == *pszNext)
+            {
+                char *pszStart = pszNext + 1;
+                double fComplete = strtod(pszStart, &pszNext);
+                if (pszNext != pszStart)
+                {
+                    op.llCompleteTime = static_cast<INT64>(fComplete * 1000);
+                }
+            }
+        }
+        if (!fOk)
+        {
+            char szError[128];
+            sprintf_s(szError, _countof(szError), "line %I64u is not stream,target,type,offset,bytes,submit_us[,complete_us]", ullLine);
+            _sError = szError;
+            return false;
+        }
+
+        auto i = mStreams.find(ulStream);
+        if (i == mStreams.end())
+        {
+            i = mStreams.insert(std::make_pair(ulStream, vRawStreams.size())).first;
+            vRawStreams.resize(vRawStreams.size() + 1);
+            vIds.push_back(ulStream);
+        }
+        vRawStreams[i->second].push_back(op);
+    }
+
+    return true;
+}
+
+/*****************************************************************************/
+// orders every stream by issue time, works out the dependencies and converts the
+// times to scaled PerfTimer ticks
+//
+void IOReplay::_Prepare(std::vector<std::vector<RawOp>>& vRawStreams, const std::vector<UINT32>& vIds, UINT64 ullFrequency)
+{
+    INT64 llOrigin = LLONG_MAX;
+    for (const auto& vOps : vRawStreams)
+    {
+        for (const auto& op : vOps)
+        {
+            llOrigin = min(llOrigin, op.llSubmitTime);
+        }
+    }
+
+    const double fTicksPerTick = static_cast<double>(PerfTimer::GetFrequency()) / ullFrequency;
+    const double fMicrosecondsPerTick = 1000000.0 / ullFrequency;
+
+    // concurrency of the whole trace: +1 at every issue, -1 at every completion
+    std::vector<std::pair<INT64, int>> vEvents;
+    bool fCompletionsKnown = true;
+
+    _vStreams.clear();
+    _vStreams.resize(vRawStreams.size());
+    _ullOperationCount = 0;
+    _ulMaxBytes = 0;
+    _fReads = _fWrites = false;
+    for (size_t iStream = 0; iStream < vRawStreams.size(); iStream++)
+    {
+        std::vector<RawOp>& vOps = vRawStreams[iStream];
+        std::stable_sort(vOps.begin(), vOps.end(), [](const RawOp& a, const RawOp& b) { return a.llSubmitTime < b.llSubmitTime; });
+
+        // an I/O depends on the I/Os of its stream that completed before it was issued; without
+        // completion times every I/O depends on the one before it
+        bool fStreamCompletionsKnown = true;
+        std::vector<INT64> vCompleteTimes;
+        vCompleteTimes.reserve(vOps.size());
+        for (const auto& op : vOps)
+        {
+            fStreamCompletionsKnown = fStreamCompletionsKnown && (op.llCompleteTime != LLONG_MIN);
+            vCompleteTimes.push_back(op.llCompleteTime);
+        }
+        std::sort(vCompleteTimes.begin(), vCompleteTimes.end());
+        fCompletionsKnown = fCompletionsKnown && fStreamCompletionsKnown;
+
+        ReplayStream& stream = _vStreams[iStream];
+        stream.ulId = vIds[iStream];
+        stream.vOps.resize(vOps.size());
+        size_t cCompleted = 0;
+        for (size_t i = 0; i < vOps.size(); i++)
+        {
+            const RawOp& raw = vOps[i];
+            ReplayOp& op = stream.vOps[i];
+
+            if (fStreamCompletionsKnown)
+            {
+                while ((cCompleted < vCompleteTimes.size()) && (vCompleteTimes[cCompleted] <= raw.llSubmitTime))
+                {
+                    cCompleted++;
+                }
+                op.ulDependency = static_cast<UINT32>(min(cCompleted, i));
+                op.fLatency = static_cast<float>((raw.llCompleteTime - raw.llSubmitTime) * fMicrosecondsPerTick);
+                vEvents.push_back(std::make_pair(raw.llSubmitTime, 1));
+                vEvents.push_back(std::make_pair(raw.llCompleteTime, -1));
+            }
+            else
+            {
+                op.ulDependency = static_cast<UINT32>(i);
+                op.fLatency = -1;
+            }
+
+            op.ullOffset = raw.ullOffset;
+            op.ullTime = (_fSpeed > 0) ? static_cast<UINT64>((raw.llSubmitTime - llOrigin) * fTicksPerTick / _fSpeed) : 0;
+            op.ulBytes = raw.ulBytes;
+            op.bTarget = raw.bTarget;
+            op.bType = raw.bType;
+
+            _ulMaxBytes = max(_ulMaxBytes, raw.ulBytes);
+            _fReads = _fReads || (1 == raw.bType);
+            _fWrites = _fWrites || (2 == raw.bType);
+        }
+        _ullOperationCount += vOps.size();
+
+        // the raw I/Os are not needed any more
+        std::vector<RawOp>().swap(vOps);
+    }
+
+    // a completion at the same time as an issue is counted first
+    _ulMaxInFlight = 0;
+    if (fCompletionsKnown)
+    {
+        std::sort(vEvents.begin(), vEvents.end());
+        int cInFlight = 0;
+        for (const auto& event : vEvents)
+        {
+            cInFlight += event.second;
+            _ulMaxInFlight = max(_ulMaxInFlight, static_cast<UINT32>(max(cInFlight, 0)));
+        }
+    }
+    else
+    {
+        _ulMaxInFlight = static_cast<UINT32>(_vStreams.size());
+    }
+}
+
+UINT64 IOReplay::GetIssuedCount() const
+{
+    UINT64 ullIssued = 0;
+    for (const auto& stream : _vStreams)
+    {
+        ullIssued += stream.iNext;
+    }
+    return ullIssued;
+}
+
+void IOReplay::GetThreadStreams(UINT32 iThread, std::vector<ReplayStream *>& vStreams)
+{
+    vStreams.clear();
+    for (size_t iStream = iThread; iStream < _vStreams.size(); iStream += _cThreads)
+    {
+        vStreams.push_back(&_vStreams[iStream]);
+    }
+}
+
+void IOReplay::ThreadDone()
+{
+    if (0 == InterlockedDecrement(&_lThreadsReplaying))
+    {
+        SetEvent(_hDoneEvent);
+    }
+}
@@ -0,0 +1,135 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+#include <Windows.h>
+#include <vector>
+#include <string>
+
+//
+// Trace replay (-Y). A trace is read either from the binary file written by -vt or from a CSV
+// with one I/O per line:
+//
+//     stream,target,type,offset,bytes,submit_us[,complete_us[,...]]
+//
+// where type is read or write (or R/W), times are in microseconds from any origin and columns
+// past complete_us are ignored, so the output of TraceDecoder can be replayed as it is. Lines
+// that do not start with a number (a header) and lines starting with # are skipped. A stream is
+// a sequence of I/Os issued by one thread or process of the original workload; stream s is
+// replayed by worker thread s modulo the thread count and trace target t goes to the thread's
+// target t modulo its target count.
+//
+// With a speed factor, each I/O is issued at its recorded time divided by the factor. With a
+// speed factor of 0, I/Os are issued as fast as possible while each one still waits for as many
+// I/Os of its stream to complete as had completed when it was originally issued; this keeps the
+// dependencies and the concurrency of every stream.
+//
+struct ReplayOp
+{
+    UINT64 ullOffset;
+    UINT64 ullTime;         // issue time, in PerfTimer ticks from the first I/O of the trace, already scaled
+    UINT32 ulBytes;
+    UINT32 ulDependency;    // I/Os of the stream completed when this one was originally issued
+    float fLatency;         // original latency in microseconds; negative if the trace does not have it
+    BYTE bTarget;
+    BYTE bType;             // 1 = read, 2 = write (IOOperation)
+};
+
+class ReplayStream
+{
+public:
+    ReplayStream() :
+        ulId(0),
+        iNext(0),
+        iDue(0),
+        cCompleted(0)
+    {
+    }
+
+    UINT32 ulId;                // stream id in the trace
+    std::vector<ReplayOp> vOps; // in the order of their original issue
+    size_t iNext;               // next I/O to issue
+    size_t iDue;                // first I/O not due yet (timed replay)
+    UINT32 cCompleted;          // I/Os of the stream completed in the replay
+};
+
+class IOReplay
+{
+public:
+    IOReplay();
+    ~IOReplay();
+
+    // reads the trace; a speed of 0 replays as fast as the dependencies allow
+    bool Load(const char *pszPath, double fSpeed, UINT32 cThreads);
+    bool IsLoaded() const { return nullptr != _hDoneEvent; }
+    const char *GetError() const { return _sError.c_str(); }
+
+    double GetSpeed() const { return _fSpeed; }
+    size_t GetStreamCount() const { return _vStreams.size(); }
+    UINT64 GetOperationCount() const { return _ullOperationCount; }
+    UINT64 GetIssuedCount() const;
+    UINT32 GetMaxBytes() const { return _ulMaxBytes; }
+    UINT32 GetMaxInFlight() const { return _ulMaxInFlight; }
+    bool HasReads() const { return _fReads; }
+    bool HasWrites() const { return _fWrites; }
+
+    // the streams replayed by a worker thread; they are only touched by that thread
+    void GetThreadStreams(UINT32 iThread, std::vector<ReplayStream *>& vStreams);
+
+    // called by every worker thread once it has replayed all its streams; the last one sets the done event
+    void ThreadDone();
+    HANDLE GetDoneEvent() const { return _hDoneEvent; }
+
+private:
+    struct RawOp
+    {
+        UINT64 ullOffset;
+        INT64 llSubmitTime;     // in ticks of the trace clock
+        INT64 llCompleteTime;   // LLONG_MIN if unknown
+        UINT32 ulBytes;
+        BYTE bTarget;
+        BYTE bType;
+    };
+
+    bool _LoadBinary(FILE *pFile, std::vector<std::vector<RawOp>>& vRawStreams, std::vector<UINT32>& vIds, UINT64 *pullFrequency);
+    bool _LoadCsv(FILE *pFile, std::vector<std::vector<RawOp>>& vRawStreams, std::vector<UINT32>& vIds);
+    void _Prepare(std::vector<std::vector<RawOp>>& vRawStreams, const std::vector<UINT32>& vIds, UINT64 ullFrequency);
+
+    std::vector<ReplayStream> _vStreams;
+    UINT32 _cThreads;
+    double _fSpeed;
+    UINT64 _ullOperationCount;
+    UINT32 _ulMaxBytes;
+    UINT32 _ulMaxInFlight;  // largest number of I/Os the whole trace had in flight
+    bool _fReads;
+    bool _fWrites;
+    volatile LONG _lThreadsReplaying;
+    HANDLE _hDoneEvent;
+    std::string _sError;
+};
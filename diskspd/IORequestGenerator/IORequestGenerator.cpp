@@ -45,17 +45,26 @@ SOFTWARE.
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <Winioctl.h>   //DISK_GEOMETRY
 #include <windows.h>
 #include <stddef.h>
 
 #include <Wmistr.h>     //WNODE_HEADER
+#include <Psapi.h>      //GetProcessMemoryInfo
 
 #include "etw.h"
 #include <assert.h>
 #include <list>
+#include <algorithm>
 #include "ThroughputMeter.h"
-#include "OverlappedQueue.h"
+#include "ArrivalScheduler.h"
+#include "IORequestRing.h"
+#include "SteadyStateDetector.h"
+#include "IOTrace.h"
+#include "IOReplay.h"
+#include "BlockVerifier.h"
+#include "GroupCommitLog.h"
 
 /*****************************************************************************/
 // gets partition size, return zero on failure
@@ -236,6 +245,7 @@ struct ETWEventCounters g_EtwEventCounters;
 
 __declspec(align(4)) static LONG volatile g_lRunningThreadsCount = 0;   //must be aligned on a 32-bit boundary, otherwise InterlockedIncrement
                                                                         //and InterlockedDecrement will fail on 64-bit systems
+__declspec(align(4)) static LONG volatile g_lReadyThreadsCount = 0;     //number of threads which finished initialization and wait for the start signal
 
 static ULONG volatile g_ulProcCount = 0;        //number of CPUs present in the system
 static BOOL volatile g_bRun;                    //used for letting threads know that they should stop working
@@ -582,6 +592,295 @@ bool IORequestGenerator::_GetSystemPerfInfo(SYSTEM_PROCESSOR_PERFORMANCE_INFORMA
     return NT_SUCCESS(Status);
 }
 
+#ifndef STATUS_INFO_LENGTH_MISMATCH
+#define STATUS_INFO_LENGTH_MISMATCH ((NTSTATUS)0xC0000004L)
+#endif
+
+/*****************************************************************************/
+// layout of the thread entries which follow each process entry returned by
+// NtQuerySystemInformation(SystemProcessInformation) (SYSTEM_THREAD_INFORMATION)
+//
+struct NtThreadInformation
+{
+    LARGE_INTEGER KernelTime;
+    LARGE_INTEGER UserTime;
+    LARGE_INTEGER CreateTime;
+    ULONG WaitTime;
+    PVOID StartAddress;
+    HANDLE UniqueProcess;
+    HANDLE UniqueThread;
+    LONG Priority;
+    LONG BasePriority;
+    ULONG ContextSwitches;
+    ULONG ThreadState;
+    ULONG WaitReason;
+};
+
+/*****************************************************************************/
+// reads the process-wide counters and the context switches of every worker thread
+//
+bool IORequestGenerator::_GetWorkerCounters(struct WorkerCounters *pCounters, vector<UINT64>& vullContextSwitches) const
+{
+    assert(nullptr != pCounters);
+
+    memset(pCounters, 0, sizeof(*pCounters));
+    vullContextSwitches.assign(_vhWorkers.size(), 0);
+
+    PROCESS_MEMORY_COUNTERS memoryCounters;
+    IO_COUNTERS ioCounters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)) ||
+        !GetProcessIoCounters(GetCurrentProcess(), &ioCounters))
+    {
+        return false;
+    }
+    pCounters->ullPageFaults = memoryCounters.PageFaultCount;
+    pCounters->ullReadOperations = ioCounters.ReadOperationCount;
+    pCounters->ullWriteOperations = ioCounters.WriteOperationCount;
+    pCounters->ullOtherOperations = ioCounters.OtherOperationCount;
+
+    // the snapshot covers every process in the system, so it has to grow until it fits
+    vector<BYTE> vBuffer(256 * 1024);
+    NTSTATUS Status;
+    for (;;)
+    {
+        ULONG cbNeeded = 0;
+        Status = g_pfnNtQuerySysInfo(SystemProcessInformation, &vBuffer[0], static_cast<ULONG>(vBuffer.size()), &cbNeeded);
+        if (STATUS_INFO_LENGTH_MISMATCH != Status)
+        {
+            break;
+        }
+        vBuffer.resize(max(vBuffer.size() * 2, static_cast<size_t>(cbNeeded) + 64 * 1024));
+    }
+
+    if (!NT_SUCCESS(Status))
+    {
+        return false;
+    }
+
+    vector<DWORD> vdwThreadIds(_vhWorkers.size());
+    for (size_t i = 0; i < _vhWorkers.size(); i++)
+    {
+        vdwThreadIds[i] = GetThreadId(_vhWorkers[i]);
+    }
+
+    const DWORD dwProcessId = GetCurrentProcessId();
+    BYTE *pEntry = &vBuffer[0];
+    for (;;)
+    {
+        const SYSTEM_PROCESS_INFORMATION *pProcess = reinterpret_cast<const SYSTEM_PROCESS_INFORMATION *>(pEntry);
+        if (HandleToUlong(pProcess->UniqueProcessId) == dwProcessId)
+        {
+            const NtThreadInformation *pThreads = reinterpret_cast<const NtThreadInformation *>(pProcess + 1);
+            for (ULONG iThread = 0; iThread < pProcess->NumberOfThreads; iThread++)
+            {
+                DWORD dwThreadId = HandleToUlong(pThreads[iThread].UniqueThread);
+                for (size_t i = 0; i < vdwThreadIds.size(); i++)
+                {
+                    if (vdwThreadIds[i] == dwThreadId)
+                    {
+                        vullContextSwitches[i] = pThreads[iThread].ContextSwitches;
+                        pCounters->ullContextSwitches += pThreads[iThread].ContextSwitches;
+                    }
+                }
+            }
+            return true;
+        }
+
+        if (0 == pProcess->NextEntryOffset)
+        {
+            break;
+        }
+        pEntry += pProcess->NextEntryOffset;
+    }
+
+    return false;
+}
+
+/*****************************************************************************/
+// opens the disk or volume behind every target of the TimeSpan for IOCTL_DISK_PERFORMANCE;
+// targets sharing a device share its entry. Devices that cannot be opened or do not report
+// the counters (e.g. network shares) are skipped
+//
+void IORequestGenerator::_OpenDevices(const TimeSpan& timeSpan, vector<HANDLE>& vhDevices, vector<DeviceResults>& vDeviceResults, bool fVerbose) const
+{
+    vhDevices.clear();
+    vDeviceResults.clear();
+
+    vector<Target> vTargets(timeSpan.GetTargets());
+    for (const auto& target : vTargets)
+    {
+        string sPath(target.GetPath());
+        string sDevice;
+        char szDevice[MAX_PATH];
+
+        if ('#' == sPath[0] && '\0' != sPath[1])
+        {
+            sprintf_s(szDevice, _countof(szDevice), "\\\\.\\PhysicalDrive%u", (UINT32)atoi(sPath.c_str() + 1));
+            sDevice = szDevice;
+        }
+        else if (2 == sPath.length() && isalpha((unsigned char)sPath[0]) && ':' == sPath[1])
+        {
+            sprintf_s(szDevice, _countof(szDevice), "\\\\.\\%c:", sPath[0]);
+            sDevice = szDevice;
+        }
+        else
+        {
+            char szVolumePath[MAX_PATH];
+            if (!GetVolumePathNameA(sPath.c_str(), szVolumePath, _countof(szVolumePath)))
+            {
+                printfv(fVerbose, "device statistics: unable to find the volume of '%s' (error code: %u)\n", sPath.c_str(), GetLastError());
+                continue;
+            }
+
+            // drive letters read better than volume GUID paths
+            if (isalpha((unsigned char)szVolumePath[0]) && ':' == szVolumePath[1] && '\\' == szVolumePath[2] && '\0' == szVolumePath[3])
+            {
+                sprintf_s(szDevice, _countof(szDevice), "\\\\.\\%c:", szVolumePath[0]);
+            }
+            else if (GetVolumeNameForVolumeMountPointA(szVolumePath, szDevice, _countof(szDevice)))
+            {
+                // the volume has to be opened without the trailing backslash
+                size_t cch = strlen(szDevice);
+                if (cch > 0 && '\\' == szDevice[cch - 1])
+                {
+                    szDevice[cch - 1] = '\0';
+                }
+            }
+            else
+            {
+                printfv(fVerbose, "device statistics: '%s' is not on a local volume\n", sPath.c_str());
+                continue;
+            }
+            sDevice = szDevice;
+        }
+
+        bool fFound = false;
+        for (auto& deviceResults : vDeviceResults)
+        {
+            if (_stricmp(deviceResults.sDevice.c_str(), sDevice.c_str()) == 0)
+            {
+                deviceResults.vTargetPaths.push_back(sPath);
+                fFound = true;
+                break;
+            }
+        }
+        if (fFound)
+        {
+            continue;
+        }
+
+        // no access rights are needed for IOCTL_DISK_PERFORMANCE, so this works without elevation
+        HANDLE hDevice = CreateFileA(sDevice.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, NULL);
+        if (INVALID_HANDLE_VALUE == hDevice)
+        {
+            printfv(fVerbose, "device statistics: unable to open '%s' (error code: %u)\n", sDevice.c_str(), GetLastError());
+            continue;
+        }
+
+        DISK_PERFORMANCE diskPerformance;
+        DWORD cbReturned;
+        if (!DeviceIoControl(hDevice, IOCTL_DISK_PERFORMANCE, NULL, 0, &diskPerformance, sizeof(diskPerformance), &cbReturned, NULL))
+        {
+            printfv(fVerbose, "device statistics: '%s' does not report performance counters (error code: %u)\n", sDevice.c_str(), GetLastError());
+            CloseHandle(hDevice);
+            continue;
+        }
+
+        DeviceResults deviceResults;
+        deviceResults.sDevice = sDevice;
+        deviceResults.vTargetPaths.push_back(sPath);
+        vDeviceResults.push_back(deviceResults);
+        vhDevices.push_back(hDevice);
+    }
+}
+
+/*****************************************************************************/
+// appends one sample to every device; a device failing to answer keeps its previous
+// sample so that the deltas stay meaningful
+//
+void IORequestGenerator::_SampleDevices(const vector<HANDLE>& vhDevices, vector<DeviceResults>& vDeviceResults) const
+{
+    assert(vhDevices.size() == vDeviceResults.size());
+
+    for (size_t iDevice = 0; iDevice < vhDevices.size(); iDevice++)
+    {
+        DeviceResults& deviceResults = vDeviceResults[iDevice];
+        DISK_PERFORMANCE diskPerformance;
+        DWORD cbReturned;
+        DeviceSample sample;
+
+        if (DeviceIoControl(vhDevices[iDevice], IOCTL_DISK_PERFORMANCE, NULL, 0, &diskPerformance, sizeof(diskPerformance), &cbReturned, NULL))
+        {
+            sample.ullBytesRead = diskPerformance.BytesRead.QuadPart;
+            sample.ullBytesWritten = diskPerformance.BytesWritten.QuadPart;
+            sample.ullReadTime = diskPerformance.ReadTime.QuadPart;
+            sample.ullWriteTime = diskPerformance.WriteTime.QuadPart;
+            sample.ullIdleTime = diskPerformance.IdleTime.QuadPart;
+            sample.ullQueryTime = diskPerformance.QueryTime.QuadPart;
+            sample.dwReadCount = diskPerformance.ReadCount;
+            sample.dwWriteCount = diskPerformance.WriteCount;
+            sample.dwQueueDepth = diskPerformance.QueueDepth;
+            sample.dwSplitCount = diskPerformance.SplitCount;
+        }
+        else if (!deviceResults.vSamples.empty())
+        {
+            sample = deviceResults.vSamples.back();
+        }
+        else
+        {
+            memset(&sample, 0, sizeof(sample));
+        }
+
+        sample.ullTime = PerfTimer::GetTime();
+        deviceResults.vSamples.push_back(sample);
+    }
+}
+
+/*****************************************************************************/
+// waits for the duration of the measurement, sampling the devices every IoBucketDuration;
+// returns WAIT_TIMEOUT when the duration elapsed, WAIT_OBJECT_0 when the stop event was signaled
+//
+DWORD IORequestGenerator::_WaitAndSampleDevices(const TimeSpan& timeSpan, const vector<HANDLE>& vhDevices, vector<DeviceResults>& vDeviceResults, HANDLE hStopEvent) const
+{
+    const DWORD dwInterval = timeSpan.GetIoBucketDurationInMilliseconds();
+    UINT64 ullEnd = PerfTimer::GetTime() + PerfTimer::SecondsToPerfTime(timeSpan.GetDuration());
+
+    DWORD dwWaitStatus = WAIT_TIMEOUT;
+    UINT64 ullNow = PerfTimer::GetTime();
+    while ((WAIT_TIMEOUT == dwWaitStatus) && (ullNow < ullEnd))
+    {
+        DWORD dwWait = static_cast<DWORD>(min(static_cast<double>(dwInterval), PerfTimer::PerfTimeToMilliseconds(ullEnd - ullNow)));
+        if (NULL != hStopEvent)
+        {
+            dwWaitStatus = WaitForSingleObject(hStopEvent, dwWait);
+        }
+        else
+        {
+            Sleep(dwWait);
+        }
+
+        ullNow = PerfTimer::GetTime();
+
+        // the closing sample is taken by the caller once accounting is off
+        if ((WAIT_TIMEOUT == dwWaitStatus) && (ullNow < ullEnd))
+        {
+            _SampleDevices(vhDevices, vDeviceResults);
+        }
+    }
+
+    return dwWaitStatus;
+}
+
+/*****************************************************************************/
+void IORequestGenerator::_CloseDevices(vector<HANDLE>& vhDevices) const
+{
+    for (auto hDevice : vhDevices)
+    {
+        CloseHandle(hDevice);
+    }
+    vhDevices.clear();
+}
+
 /*****************************************************************************/
 // calculate the offset of the next I/O operation
 //
@@ -607,7 +906,35 @@ __inline UINT64 IORequestGenerator::GetNextFileOffset(ThreadParameters& tp, size
     }
     else if (target.GetUseInterlockedSequential())
     {
-        nextBlockOffset = InterlockedAdd64((PLONGLONG) &tp.pullSharedSequentialOffsets[targetNum], blockAlignment) - blockAlignment;
+        DWORD cChunkBlocks = target.GetInterlockedSequentialChunk();
+        bool fClaimed = true;
+        if (cChunkBlocks <= 1)
+        {
+            nextBlockOffset = InterlockedAdd64((PLONGLONG) &tp.pullSharedSequentialOffsets[targetNum], blockAlignment) - blockAlignment;
+        }
+        else
+        {
+            // claim a run of consecutive blocks with a single interlocked operation and
+            // hand them out locally, so threads contend for the shared offset once per chunk
+            if (tp.vdwSequentialChunkRemaining[targetNum] == 0)
+            {
+                UINT64 cbChunk = blockAlignment * cChunkBlocks;
+                tp.vullPrivateSequentialOffsets[targetNum] = InterlockedAdd64((PLONGLONG) &tp.pullSharedSequentialOffsets[targetNum], cbChunk) - cbChunk;
+                tp.vdwSequentialChunkRemaining[targetNum] = cChunkBlocks;
+            }
+            else
+            {
+                fClaimed = false;
+            }
+            nextBlockOffset = tp.vullPrivateSequentialOffsets[targetNum];
+            tp.vullPrivateSequentialOffsets[targetNum] += blockAlignment;
+            tp.vdwSequentialChunkRemaining[targetNum]--;
+        }
+
+        if (fClaimed && *tp.pfAccountingOn)
+        {
+            tp.pResults->vTargetResults[targetNum].ullSequentialClaimCount++;
+        }
     }
     else // normal sequential access pattern
     {
@@ -715,170 +1042,1117 @@ __inline static IOOperation DecideIo(UINT32 ulWriteRatio)
  }
 
 /*****************************************************************************/
-// function called from worker thread
-// performs asynch I/O using IO Completion Ports
-//
-__inline static bool doWorkUsingIOCompletionPorts(ThreadParameters *p, HANDLE hCompletionPort)
+// Decide whether an operation given as a percentage of the IOs goes next
+// (a flush ahead of the IO with -Op, a discard in place of it with -U)
+__inline static bool DecideByPercentage(UINT32 ulPercentage)
 {
-    assert(nullptr!= p);
-    assert(nullptr != hCompletionPort);
-
-    bool fOk = true;
+    return (ulPercentage > 0) && (((UINT32)(rand() % 100)) < ulPercentage);
+}
 
-    LARGE_INTEGER li;
-    BOOL rslt = FALSE;
-    OVERLAPPED * pCompletedOvrp;
-    ULONG_PTR ulCompletionKey;
-    DWORD dwBytesTransferred;
-    DWORD dwIOCnt = 0;
-    OverlappedQueue overlappedQueue;
-    size_t cOverlapped = p->vOverlapped.size();
+/*****************************************************************************/
+// name of the kind of IO for error messages
+__inline static const char *getIoName(IOOperation ioType)
+{
+    return (ioType == IOOperation::ReadIO) ? "read" : ((ioType == IOOperation::WriteIO) ? "write" : "discard");
+}
 
-    bool fMeasureLatency = p->pTimeSpan->GetMeasureLatency();
+/*****************************************************************************/
+// returns the number of threads sharing the target; rates given per target
+// (burst size, open-loop arrivals) are split evenly among them
+__inline static DWORD getTargetThreadCount(const ThreadParameters *p, const Target *pTarget)
+{
+    return (p->pTimeSpan->GetThreadCount() > 0) ? p->pTimeSpan->GetThreadCount() : pTarget->GetThreadsPerFile();
+}
 
-    size_t cTargets = p->vTargets.size();
-    vector<ThroughputMeter> vThroughputMeters(cTargets);
-    bool fUseThrougputMeter = false;
-    // TODO: move to a separate function
-    for (size_t i = 0; i < cTargets; i++)
+/*****************************************************************************/
+// returns true if a completed I/O should be accounted; also records the first and
+// last moment the thread saw accounting on, which is the window it actually measured
+//
+__inline static bool isAccountingOn(ThreadParameters *p)
+{
+    if (*p->pfAccountingOn)
     {
-        Target *pTarget = &p->vTargets[i];
-        DWORD dwBurstSize = pTarget->GetBurstSize();
-        if (p->pTimeSpan->GetThreadCount() > 0)
-        {
-            dwBurstSize /= p->pTimeSpan->GetThreadCount();
-        }
-        else
-        {
-            dwBurstSize /= pTarget->GetThreadsPerFile();
-        }
-
-        if (pTarget->GetThroughputInBytesPerMillisecond() > 0 || pTarget->GetThinkTime() > 0)
+        if (p->pResults->ullAccountingStartTime == 0)
         {
-            fUseThrougputMeter = true;
-            vThroughputMeters[i].Start(pTarget->GetThroughputInBytesPerMillisecond(), pTarget->GetBlockSizeInBytes(), pTarget->GetThinkTime(), dwBurstSize);
+            p->pResults->ullAccountingStartTime = PerfTimer::GetTime();
+            p->pResults->StartCpuWindow(GetCurrentThread());
         }
+        return true;
     }
 
-    //start IO operations
-    for (size_t i = 0; i < cOverlapped; i++)
+    if ((p->pResults->ullAccountingStartTime != 0) && (p->pResults->ullAccountingEndTime == 0))
     {
-        overlappedQueue.Add(&p->vOverlapped[i]);
+        p->pResults->ullAccountingEndTime = PerfTimer::GetTime();
+        p->pResults->EndCpuWindow(GetCurrentThread());
     }
+    return false;
+}
 
-    //
-    // perform work
-    //
-    while(g_bRun && !g_bThreadError)
+/*****************************************************************************/
+// counts an I/O completed before accounting was turned on, for the main thread to
+// tell when the warm up reached steady state (-Ws)
+//
+__inline static void countWarmupIo(ThreadParameters *p, UINT64 ullStartTime, bool fMeasureLatency)
+{
+    if (p->pTimeSpan->GetSteadyStateWarmup() && (p->pResults->ullAccountingStartTime == 0))
     {
-        DWORD dwMinSleepTime = ~((DWORD)0);
-        for (size_t i = 0; i < overlappedQueue.GetCount(); i++)
+        InterlockedIncrement64(&p->llWarmupIOCount);
+        if (fMeasureLatency)
         {
-            OVERLAPPED *pReadyOverlapped = overlappedQueue.Remove();
-            DWORD iOverlapped = (DWORD)(pReadyOverlapped - &p->vOverlapped[0]);
-            size_t iTarget = p->vOverlappedIdToTargetId[iOverlapped];
-            size_t iRequest = iOverlapped - p->vFirstOverlappedIdForTargetId[iTarget];
-            Target *pTarget = &p->vTargets[iTarget];
-            ThroughputMeter *pThroughputMeter = &vThroughputMeters[iTarget];
+            InterlockedExchangeAdd64(&p->llWarmupLatency, PerfTimer::GetTime() - ullStartTime);
+        }
+    }
+}
 
-            DWORD dwSleepTime = pThroughputMeter->GetSleepTime();
-            if (pThroughputMeter->IsRunning() && dwSleepTime > 0)
-            {
-                dwMinSleepTime = min(dwMinSleepTime, dwSleepTime);
-                overlappedQueue.Add(pReadyOverlapped);
-                continue;
-            }
+/*****************************************************************************/
+// verify mode (-V): stamps the buffer of a write, or snapshots the state of the
+// block about to be read; the time it takes is the cost of verification
+//
+__inline static void verifyBeforeIo(ThreadParameters *p, size_t iTarget, IOOperation ioType, UINT64 ullOffset, BYTE *pBuffer, UINT64 *pullSnapshot)
+{
+    BlockVerifier *pVerifier = &p->pBlockVerifiers[iTarget];
+    TargetResults& targetResults = p->pResults->vTargetResults[iTarget];
+    UINT64 ullStartTime = PerfTimer::GetTime();
 
-            if (fMeasureLatency)
-            {
-                p->vIoStartTimes[iOverlapped] = PerfTimer::GetTime(); // record IO start time 
-            }
+    if (ioType == IOOperation::WriteIO)
+    {
+        pVerifier->BeginWrite(pBuffer, ullOffset, p->ulRandSeed ^ static_cast<UINT32>(ullStartTime));
+        targetResults.ullVerifyWriteCount++;
+    }
+    else
+    {
+        *pullSnapshot = pVerifier->BeginRead(ullOffset);
+    }
 
-            IOOperation readOrWrite;
-            readOrWrite = p->vdwIoType[iOverlapped] = DecideIo(pTarget->GetWriteRatio());
-            if (readOrWrite == IOOperation::ReadIO)
-            {
-                rslt = ReadFile(p->vhTargets[iTarget], p->GetReadBuffer(iTarget, iRequest), pTarget->GetBlockSizeInBytes(), nullptr, pReadyOverlapped);
-            }
-            else
-            {
-                rslt = WriteFile(p->vhTargets[iTarget], p->GetWriteBuffer(iTarget, iRequest), pTarget->GetBlockSizeInBytes(), nullptr, pReadyOverlapped);
-            }
+    targetResults.ullVerifyTime += PerfTimer::GetTime() - ullStartTime;
+}
 
-            if (!rslt && GetLastError() != ERROR_IO_PENDING)
-            {
-                PrintError("t[%u] error during %s error code: %u)\n", iOverlapped, (readOrWrite == IOOperation::ReadIO ? "read" : "write"), GetLastError());
-                fOk = false;
-                goto cleanup;
-            }
+/*****************************************************************************/
+// verify mode (-V): releases the block of a completed write, or checks the block
+// of a completed read against its header and checksum
+//
+__inline static void verifyAfterIo(ThreadParameters *p, size_t iTarget, IOOperation ioType, UINT64 ullOffset, const BYTE *pBuffer, UINT64 ullSnapshot)
+{
+    BlockVerifier *pVerifier = &p->pBlockVerifiers[iTarget];
+    TargetResults& targetResults = p->pResults->vTargetResults[iTarget];
+    UINT64 ullStartTime = PerfTimer::GetTime();
 
-            if (pThroughputMeter->IsRunning())
-            {
-                pThroughputMeter->Adjust(pTarget->GetBlockSizeInBytes());
-            }
-        }
+    if (ioType == IOOperation::WriteIO)
+    {
+        pVerifier->EndWrite(ullOffset);
+    }
+    else
+    {
+        VerifyError error;
+        BlockCheck check = pVerifier->CheckRead(pBuffer, ullOffset, ullSnapshot, &error);
+        targetResults.AddVerifyCheck(check, error);
 
-        // if no IOs are in flight, wait for the next scheduling time
-        if (fUseThrougputMeter && (overlappedQueue.GetCount() == p->vOverlapped.size()) && dwMinSleepTime != ~((DWORD)0))
+        if ((check >= BlockCheck::Stale) && (targetResults.ullVerifyErrorCount <= MAX_VERIFY_ERRORS_PER_TARGET))
         {
-            Sleep(dwMinSleepTime);
+            PrintError("thread %u: %s block read from %s at offset %I64u (generation %I64u, expected %I64u)\n",
+                p->ulThreadNo,
+                (check == BlockCheck::Stale) ? "stale" : ((check == BlockCheck::Misplaced) ? "misplaced" : "corrupt"),
+                p->vTargets[iTarget].GetPath().c_str(),
+                ullOffset,
+                error.ullFoundGeneration,
+                error.ullExpectedGeneration);
         }
+    }
 
-        // wait till one of the IO operations finishes
-        if (GetQueuedCompletionStatus(hCompletionPort, &dwBytesTransferred, &ulCompletionKey, &pCompletedOvrp, 1) != 0)
-        {
-            //find which I/O operation it was (so we know to which buffer should we use)
-            DWORD iOverlapped = (DWORD)(pCompletedOvrp - &p->vOverlapped[0]);
-            size_t iTarget = p->vOverlappedIdToTargetId[iOverlapped];
+    targetResults.ullVerifyTime += PerfTimer::GetTime() - ullStartTime;
+}
 
-            //check if I/O transferred all of the requested bytes
-            Target *pTarget = &p->vTargets[iTarget];
-            if (dwBytesTransferred != pTarget->GetBlockSizeInBytes())
-            {
-                PrintError("Warning: thread %u transferred %u bytes instead of %u bytes\n",
-                    p->ulThreadNo,
-                    dwBytesTransferred,
-                    pTarget->GetBlockSizeInBytes());
-            }
+/*****************************************************************************/
+// flushes the target and accounts the flush, and the durable latency of every write of
+// the thread it covers: those completed since the previous flush, timed from their issue
+// to the end of this one. FlushFileBuffers has no overlapped form, so the flush blocks
+// the worker while the rest of its IOs stay in flight
+//
+__inline static bool flushTarget(ThreadParameters *p, size_t iTarget, bool fMeasureLatency)
+{
+    UINT64 ullStartTime = PerfTimer::GetTime();
+
+    if (!FlushFileBuffers(p->vhTargets[iTarget]))
+    {
+        PrintError("t[%u:%u] error during flush error code: %u)\n", p->ulThreadNo, iTarget, GetLastError());
+        return false;
+    }
+
+    UINT64 ullEndTime = PerfTimer::GetTime();
+    vector<UINT64>& vullWriteStartTimes = p->vvullUnflushedWriteStartTimes[iTarget];
+    if (*p->pfAccountingOn)
+    {
+        TargetResults& targetResults = p->pResults->vTargetResults[iTarget];
+        targetResults.AddFlush(ullStartTime, ullEndTime, fMeasureLatency);
+        for (auto ullWriteStartTime : vullWriteStartTimes)
+        {
+            targetResults.AddDurableWrite(ullWriteStartTime, ullEndTime);
+        }
+    }
+    vullWriteStartTimes.clear();
+    return true;
+}
+
+/*****************************************************************************/
+// follows a completed write until it is durable: a write-through write (-Sw) is
+// durable when it completes, any other one at the end of the next flush of the
+// target (-Of, -Op). Flushes the target after every n-th write (-Of)
+//
+__inline static bool completeWrite(ThreadParameters *p, size_t iTarget, UINT64 ullWriteStartTime, bool fMeasureLatency)
+{
+    Target *pTarget = &p->vTargets[iTarget];
+
+    if (fMeasureLatency)
+    {
+        if (pTarget->GetWriteThrough())
+        {
+            if (*p->pfAccountingOn)
+            {
+                p->pResults->vTargetResults[iTarget].AddDurableWrite(ullWriteStartTime, PerfTimer::GetTime());
+            }
+        }
+        else if ((pTarget->GetFlushInterval() > 0) || (pTarget->GetFlushPercentage() > 0))
+        {
+            p->vvullUnflushedWriteStartTimes[iTarget].push_back(ullWriteStartTime);
+        }
+    }
+
+    if ((pTarget->GetFlushInterval() == 0) || (++p->vdwWritesSinceFlush[iTarget] < pTarget->GetFlushInterval()))
+    {
+        return true;
+    }
+
+    p->vdwWritesSinceFlush[iTarget] = 0;
+    return flushTarget(p, iTarget, fMeasureLatency);
+}
+
+// winioctl.h declares the file-level trim only for Windows 8 and later (_WIN32_WINNT >= 0x0602);
+// the tool targets older systems, where the FSCTL fails at run time and the run stops with its error
+#ifndef FSCTL_FILE_LEVEL_TRIM
+#define FSCTL_FILE_LEVEL_TRIM CTL_CODE(FILE_DEVICE_FILE_SYSTEM, 130, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+typedef struct _FILE_LEVEL_TRIM_RANGE {
+    DWORDLONG Offset;
+    DWORDLONG Length;
+} FILE_LEVEL_TRIM_RANGE, *PFILE_LEVEL_TRIM_RANGE;
+
+typedef struct _FILE_LEVEL_TRIM {
+    DWORD Key;
+    DWORD NumRanges;
+    FILE_LEVEL_TRIM_RANGE Ranges[1];
+} FILE_LEVEL_TRIM, *PFILE_LEVEL_TRIM;
+#endif
+
+/*****************************************************************************/
+// discards (trims) a range of the target: FSCTL_FILE_LEVEL_TRIM for a file, a DSM
+// trim for a disk or partition. Both are METHOD_BUFFERED, so the range need not
+// outlive the call when it completes asynchronously
+//
+__inline static BOOL issueDiscard(ThreadParameters *p, size_t iTarget, UINT64 ullOffset, UINT64 cbLength, OVERLAPPED *pOverlapped)
+{
+    const string& sPath = p->vTargets[iTarget].GetPath();
+    bool fRaw = ('#' == sPath[0]) || ((sPath.length() == 2) && (':' == sPath[1]));
+    DWORD cbReturned;
+
+    if (fRaw)
+    {
+        struct
+        {
+            DEVICE_MANAGE_DATA_SET_ATTRIBUTES attributes;
+            DEVICE_DATA_SET_RANGE range;
+        } dsm = {};
+
+        dsm.attributes.Size = sizeof(dsm.attributes);
+        dsm.attributes.Action = DeviceDsmAction_Trim;
+        dsm.attributes.DataSetRangesOffset = static_cast<DWORD>(reinterpret_cast<BYTE *>(&dsm.range) - reinterpret_cast<BYTE *>(&dsm));
+        dsm.attributes.DataSetRangesLength = sizeof(dsm.range);
+        dsm.range.StartingOffset = ullOffset;
+        dsm.range.LengthInBytes = cbLength;
+
+        return DeviceIoControl(p->vhTargets[iTarget], IOCTL_STORAGE_MANAGE_DATA_SET_ATTRIBUTES, &dsm, sizeof(dsm), nullptr, 0, &cbReturned, pOverlapped);
+    }
+
+    FILE_LEVEL_TRIM trim = {};
+    trim.NumRanges = 1;
+    trim.Ranges[0].Offset = ullOffset;
+    trim.Ranges[0].Length = cbLength;
+
+    return DeviceIoControl(p->vhTargets[iTarget], FSCTL_FILE_LEVEL_TRIM, &trim, sizeof(trim), nullptr, 0, &cbReturned, pOverlapped);
+}
+
+/*****************************************************************************/
+// bulk discards (-Ub): the first thread of each target discards a random range
+// every interval and waits for it, as a delete which trims its extents would;
+// the completion is kept off the completion port
+//
+__inline static bool doDiscardBursts(ThreadParameters *p, vector<UINT64>& vullNextBurstTimes)
+{
+    UINT64 ullNow = PerfTimer::GetTime();
+
+    for (size_t iTarget = 0; iTarget < vullNextBurstTimes.size(); iTarget++)
+    {
+        if ((vullNextBurstTimes[iTarget] == 0) || (ullNow < vullNextBurstTimes[iTarget]))
+        {
+            continue;
+        }
+
+        Target *pTarget = &p->vTargets[iTarget];
+        UINT64 ullBaseOffset = pTarget->GetBaseFileOffsetInBytes();
+        UINT64 cbTarget = p->vullFileSizes[iTarget] - ullBaseOffset;
+        UINT64 cbBurst = min(pTarget->GetDiscardBurstSize(), cbTarget);
+        UINT64 ullOffset = ullBaseOffset + ((cbTarget > cbBurst) ? rand64() % (cbTarget - cbBurst) : 0);
+        ullOffset -= (ullOffset - ullBaseOffset) % pTarget->GetBlockSizeInBytes();
+
+        OVERLAPPED overlapped = {};
+        bool fOverlappedHandle = (pTarget->GetRequestCount() > 1) || (p->vTargets.size() > 1);
+        if (fOverlappedHandle)
+        {
+            overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+            if (nullptr == overlapped.hEvent)
+            {
+                PrintError("t[%u:%u] could not create the event of a bulk discard (error code: %u)\n", p->ulThreadNo, iTarget, GetLastError());
+                return false;
+            }
+            // the low-order bit keeps the completion off the completion port
+            overlapped.hEvent = (HANDLE)((ULONG_PTR)overlapped.hEvent | 1);
+            overlapped.Offset = static_cast<DWORD>(ullOffset);
+            overlapped.OffsetHigh = static_cast<DWORD>(ullOffset >> 32);
+        }
+
+        UINT64 ullStartTime = PerfTimer::GetTime();
+        DWORD cbReturned;
+        BOOL fDone = issueDiscard(p, iTarget, ullOffset, cbBurst, fOverlappedHandle ? &overlapped : nullptr);
+        if (!fDone && fOverlappedHandle && (GetLastError() == ERROR_IO_PENDING))
+        {
+            fDone = GetOverlappedResult(p->vhTargets[iTarget], &overlapped, &cbReturned, TRUE);
+        }
+
+        DWORD dwError = GetLastError();
+        if (fOverlappedHandle)
+        {
+            CloseHandle((HANDLE)((ULONG_PTR)overlapped.hEvent & ~(ULONG_PTR)1));
+        }
+
+        if (!fDone)
+        {
+            PrintError("t[%u:%u] error during bulk discard of %I64u bytes at offset %I64u (error code: %u)\n", p->ulThreadNo, iTarget, cbBurst, ullOffset, dwError);
+            return false;
+        }
+
+        if (isAccountingOn(p))
+        {
+            p->pResults->vTargetResults[iTarget].AddDiscard(cbBurst,
+                ullStartTime,
+                *p->pullStartTime,
+                true,
+                p->pTimeSpan->GetMeasureLatency(),
+                p->pTimeSpan->GetCalculateIopsStdDev());
+        }
+
+        vullNextBurstTimes[iTarget] += PerfTimer::MillisecondsToPerfTime(pTarget->GetDiscardBurstInterval());
+    }
+
+    return true;
+}
+
+/*****************************************************************************/
+// the first bulk discard (-Ub) of each target one interval from now, 0 if none
+//
+__inline static void startDiscardBursts(ThreadParameters *p, vector<UINT64>& vullNextBurstTimes)
+{
+    UINT64 ullNow = PerfTimer::GetTime();
+
+    vullNextBurstTimes.assign(p->vTargets.size(), 0);
+    for (size_t iTarget = 0; iTarget < p->vTargets.size(); iTarget++)
+    {
+        DWORD dwInterval = p->vTargets[iTarget].GetDiscardBurstInterval();
+        if ((dwInterval > 0) && (p->ulRelativeThreadNo == 0))
+        {
+            vullNextBurstTimes[iTarget] = ullNow + PerfTimer::MillisecondsToPerfTime(dwInterval);
+        }
+    }
+}
+
+/*****************************************************************************/
+// function called from worker thread
+// performs asynch I/O using IO Completion Ports
+//
+__inline static bool doWorkUsingIOCompletionPorts(ThreadParameters *p, HANDLE hCompletionPort)
+{
+    assert(nullptr!= p);
+    assert(nullptr != hCompletionPort);
+
+    bool fOk = true;
+
+    LARGE_INTEGER li;
+    BOOL rslt = FALSE;
+    OVERLAPPED * pCompletedOvrp;
+    ULONG_PTR ulCompletionKey;
+    DWORD dwBytesTransferred;
+    DWORD dwIOCnt = 0;
+    UINT32 cIORequests = p->cIORequests;
+    IORequestRing readyRequests(cIORequests);
+
+    bool fMeasureLatency = p->pTimeSpan->GetMeasureLatency();
+    bool fMeasureLatencyDecomposition = fMeasureLatency && p->pTimeSpan->GetMeasureLatencyDecomposition();
+    bool fRecordStartTime = fMeasureLatency || (nullptr != p->pTrace);
+    BOOL fDequeued;
+    bool fWaited;
+    UINT64 ullReapTime;
+    UINT64 ullPortEmptyTime = 0;   // last time the completion port was seen empty
+
+    size_t cTargets = p->vTargets.size();
+    vector<ThroughputMeter> vThroughputMeters(cTargets);
+    bool fUseThrougputMeter = false;
+    vector<ArrivalScheduler> vArrivalSchedulers(cTargets);
+    bool fUseArrivalScheduler = false;
+    PreciseSleeper sleeper;
+    DWORD dwWaitTimeout;
+    // TODO: move to a separate function
+    for (size_t i = 0; i < cTargets; i++)
+    {
+        Target *pTarget = &p->vTargets[i];
+        DWORD dwBurstSize = pTarget->GetBurstSize();
+        if (p->pTimeSpan->GetThreadCount() > 0)
+        {
+            dwBurstSize /= p->pTimeSpan->GetThreadCount();
+        }
+        else
+        {
+            dwBurstSize /= pTarget->GetThreadsPerFile();
+        }
+
+        if (pTarget->GetThroughputInBytesPerMillisecond() > 0 || pTarget->GetThinkTime() > 0)
+        {
+            fUseThrougputMeter = true;
+            vThroughputMeters[i].Start(pTarget->GetThroughputInBytesPerMillisecond(), pTarget->GetBlockSizeInBytes(), pTarget->GetThinkTime(), dwBurstSize);
+        }
+
+        if (p->pSharedThroughputMeters[i].IsRunning())
+        {
+            fUseThrougputMeter = true;
+        }
+
+        if (pTarget->GetArrivalRate() > 0)
+        {
+            fUseArrivalScheduler = true;
+            vArrivalSchedulers[i].Start(static_cast<double>(pTarget->GetArrivalRate()) / getTargetThreadCount(p, pTarget),
+                pTarget->GetPoissonArrivals(),
+                p->ulRandSeed + static_cast<UINT32>(i));
+        }
+    }
+
+    vector<UINT64> vullNextBurstTimes;
+    startDiscardBursts(p, vullNextBurstTimes);
+
+    //start IO operations
+    for (UINT32 i = 0; i < cIORequests; i++)
+    {
+        readyRequests.Add(i);
+    }
+
+    //
+    // perform work
+    //
+    while(g_bRun && !g_bThreadError)
+    {
+        if (!doDiscardBursts(p, vullNextBurstTimes))
+        {
+            fOk = false;
+            goto cleanup;
+        }
+
+        UINT64 ullMinDelay = MAXUINT64;
+        for (size_t i = 0; i < readyRequests.GetCount(); i++)
+        {
+            UINT32 iIORequest = readyRequests.Remove();
+            IORequest *pIORequest = &p->pIORequests[iIORequest];
+            size_t iTarget = pIORequest->iTarget;
+            Target *pTarget = &p->vTargets[iTarget];
+            ThroughputMeter *pThroughputMeter = &vThroughputMeters[iTarget];
+            ArrivalScheduler *pArrivalScheduler = &vArrivalSchedulers[iTarget];
+
+            UINT64 ullDelay = pThroughputMeter->IsRunning() ? pThroughputMeter->GetDelay(PerfTimer::GetTime()) : 0;
+            if (ullDelay > 0)
+            {
+                ullMinDelay = min(ullMinDelay, ullDelay);
+                readyRequests.Add(iIORequest);
+                continue;
+            }
+
+            // the shared throttle is checked last: a token taken from it is spent on this IO
+            SharedThroughputMeter *pSharedThroughputMeter = &p->pSharedThroughputMeters[iTarget];
+            ullDelay = pSharedThroughputMeter->IsRunning() ? pSharedThroughputMeter->TryAcquire(PerfTimer::GetTime(), pTarget->GetBlockSizeInBytes()) : 0;
+            if (ullDelay > 0)
+            {
+                ullMinDelay = min(ullMinDelay, ullDelay);
+                readyRequests.Add(iIORequest);
+                continue;
+            }
+
+            // open loop: wait for the intended arrival time; if it has already passed (the request slot
+            // was busy), issue right away and still measure latency from the intended time
+            UINT64 ullIntendedTime = 0;
+            if (pArrivalScheduler->IsRunning())
+            {
+                UINT64 ullNow = PerfTimer::GetTime();
+                if (ullNow < pArrivalScheduler->GetNextArrivalTime())
+                {
+                    ullMinDelay = min(ullMinDelay, pArrivalScheduler->GetDelay(ullNow));
+                    readyRequests.Add(iIORequest);
+                    continue;
+                }
+
+                UINT64 ullBacklog;
+                ullIntendedTime = pArrivalScheduler->TakeArrival(ullNow, &ullBacklog);
+                if (isAccountingOn(p))
+                {
+                    p->pResults->vTargetResults[iTarget].AddArrival(ullIntendedTime, ullNow, ullBacklog);
+                }
+            }
+
+            if (DecideByPercentage(pTarget->GetFlushPercentage()) && !flushTarget(p, iTarget, fMeasureLatency))
+            {
+                fOk = false;
+                goto cleanup;
+            }
+
+            if (fRecordStartTime)
+            {
+                pIORequest->ullStartTime = (ullIntendedTime != 0) ? ullIntendedTime : PerfTimer::GetTime(); // record IO start time 
+            }
+
+            IOOperation readOrWrite;
+            readOrWrite = pIORequest->ioType = DecideByPercentage(pTarget->GetDiscardPercentage()) ? IOOperation::DiscardIO : DecideIo(pTarget->GetWriteRatio());
+            li.LowPart = pIORequest->overlapped.Offset;
+            li.HighPart = pIORequest->overlapped.OffsetHigh;
+            if (pTarget->GetVerify())
+            {
+                verifyBeforeIo(p, iTarget, readOrWrite, li.QuadPart, pIORequest->pWriteBuffer, &p->vullVerifySnapshots[iIORequest]);
+            }
+
+            if (readOrWrite == IOOperation::ReadIO)
+            {
+                rslt = ReadFile(p->vhTargets[iTarget], pIORequest->pReadBuffer, pTarget->GetBlockSizeInBytes(), nullptr, &pIORequest->overlapped);
+            }
+            else if (readOrWrite == IOOperation::WriteIO)
+            {
+                rslt = WriteFile(p->vhTargets[iTarget], pIORequest->pWriteBuffer, pTarget->GetBlockSizeInBytes(), nullptr, &pIORequest->overlapped);
+            }
+            else
+            {
+                rslt = issueDiscard(p, iTarget, li.QuadPart, pTarget->GetBlockSizeInBytes(), &pIORequest->overlapped);
+            }
+
+            if (!rslt && GetLastError() != ERROR_IO_PENDING)
+            {
+                PrintError("t[%u] error during %s error code: %u)\n", iIORequest, getIoName(readOrWrite), GetLastError());
+                fOk = false;
+                goto cleanup;
+            }
+
+            if (fMeasureLatencyDecomposition)
+            {
+                p->vIoSubmitEndTimes[iIORequest] = PerfTimer::GetTime();
+            }
+
+            if (pThroughputMeter->IsRunning())
+            {
+                pThroughputMeter->Adjust(pTarget->GetBlockSizeInBytes());
+                if (*p->pfAccountingOn && (pThroughputMeter->GetLastIssueInterval() != 0))
+                {
+                    p->pResults->vTargetResults[iTarget].AddIssueInterval(pThroughputMeter->GetLastIssueInterval());
+                }
+            }
+        }
+
+        // if no IOs are in flight, wait for the next scheduling time
+        if ((fUseThrougputMeter || fUseArrivalScheduler) && (readyRequests.GetCount() == cIORequests) && ullMinDelay != MAXUINT64)
+        {
+            sleeper.Wait(ullMinDelay);
+            ullMinDelay = 0;
+        }
+
+        // an IO which may be issued in less than a millisecond is polled for rather than waited on
+        dwWaitTimeout = (ullMinDelay < PerfTimer::MillisecondsToPerfTime(1)) ? 0 : 1;
+
+        // wait till one of the IO operations finishes
+        // with latency decomposition, poll the port first: a completion found by the poll may have been
+        // queued at any point since the port was last seen empty, while a completion that ends a wait
+        // was reaped as soon as it arrived
+        fWaited = true;
+        pCompletedOvrp = nullptr;
+        if (fMeasureLatencyDecomposition)
+        {
+            fDequeued = GetQueuedCompletionStatus(hCompletionPort, &dwBytesTransferred, &ulCompletionKey, &pCompletedOvrp, 0);
+            fWaited = (!fDequeued && (nullptr == pCompletedOvrp) && (GetLastError() == WAIT_TIMEOUT));
+            if (fWaited)
+            {
+                ullPortEmptyTime = PerfTimer::GetTime();
+            }
+        }
+        if (fWaited)
+        {
+            fDequeued = GetQueuedCompletionStatus(hCompletionPort, &dwBytesTransferred, &ulCompletionKey, &pCompletedOvrp, dwWaitTimeout);
+        }
+
+        if (fDequeued != 0)
+        {
+            //find which I/O operation it was (so we know to which buffer should we use)
+            IORequest *pIORequest = IORequest::FromOverlapped(pCompletedOvrp);
+            UINT32 iIORequest = p->GetIORequestIndex(pIORequest);
+            size_t iTarget = pIORequest->iTarget;
+
+            //check if I/O transferred all of the requested bytes (a discard transfers none)
+            Target *pTarget = &p->vTargets[iTarget];
+            if (pIORequest->ioType == IOOperation::DiscardIO)
+            {
+                dwBytesTransferred = pTarget->GetBlockSizeInBytes();
+            }
+            else if (dwBytesTransferred != pTarget->GetBlockSizeInBytes())
+            {
+                PrintError("Warning: thread %u transferred %u bytes instead of %u bytes\n",
+                    p->ulThreadNo,
+                    dwBytesTransferred,
+                    pTarget->GetBlockSizeInBytes());
+            }
+
+            li.HighPart = pCompletedOvrp->OffsetHigh;
+            li.LowPart = pCompletedOvrp->Offset;
+
+            if (pTarget->GetVerify())
+            {
+                verifyAfterIo(p, iTarget, pIORequest->ioType, li.QuadPart, pIORequest->pReadBuffer, p->vullVerifySnapshots[iIORequest]);
+            }
+
+            if (isAccountingOn(p))
+            {
+                if (pIORequest->ioType == IOOperation::DiscardIO)
+                {
+                    p->pResults->vTargetResults[iTarget].AddDiscard(pTarget->GetBlockSizeInBytes(),
+                        pIORequest->ullStartTime,
+                        *p->pullStartTime,
+                        false,
+                        fMeasureLatency,
+                        p->pTimeSpan->GetCalculateIopsStdDev());
+                }
+                else
+                {
+                    p->pResults->vTargetResults[iTarget].Add(dwBytesTransferred,
+                        pIORequest->ioType,
+                        &pIORequest->ullStartTime,
+                        p->pullStartTime,
+                        fMeasureLatency,
+                        p->pTimeSpan->GetCalculateIopsStdDev());
+                }
+
+                if (fMeasureLatencyDecomposition)
+                {
+                    ullReapTime = PerfTimer::GetTime();
+                    p->pResults->vTargetResults[iTarget].AddLatencyDecomposition(pIORequest->ullStartTime,
+                        p->vIoSubmitEndTimes[iIORequest],
+                        fWaited ? ullReapTime : ullPortEmptyTime,
+                        ullReapTime);
+                }
+
+                if (nullptr != p->pTrace)
+                {
+                    p->pTrace->Add(li.QuadPart,
+                        dwBytesTransferred,
+                        iTarget,
+                        static_cast<BYTE>(pIORequest->ioType),
+                        pIORequest->ullStartTime - *p->pullStartTime,
+                        PerfTimer::GetTime() - *p->pullStartTime);
+                }
+            }
+            else
+            {
+                countWarmupIo(p, pIORequest->ullStartTime, fMeasureLatency);
+            }
+
+            if ((pIORequest->ioType == IOOperation::WriteIO) &&
+                !completeWrite(p, iTarget, pIORequest->ullStartTime, fMeasureLatency))
+            {
+                fOk = false;
+                goto cleanup;
+            }
+
+            // TODO: move to a separate function
+            // check if we should print a progress dot
+            if (p->pProfile->GetProgress() != 0)
+            {
+                ++dwIOCnt;
+                if (dwIOCnt == p->pProfile->GetProgress())
+                {
+                    print(".");
+                    dwIOCnt = 0;
+                }
+            }
+
+            //restart the I/O operation that just completed
+            li.QuadPart = IORequestGenerator::GetNextFileOffset(*p, iTarget, li.QuadPart);
+
+            pCompletedOvrp->Offset = li.LowPart;
+            pCompletedOvrp->OffsetHigh = li.HighPart;
+
+            printfv(p->pProfile->GetVerbose(), "t[%u:%u] new I/O op at %I64u (starting in block: %I64u)\n",
+                p->ulThreadNo,
+                iTarget,
+                li.QuadPart,
+                li.QuadPart / pTarget->GetBlockSizeInBytes());
+
+            readyRequests.Add(iIORequest);
+        }
+        else
+        {
+            DWORD err = GetLastError();
+            if (err != WAIT_TIMEOUT)
+            {
+                PrintError("error during overlapped IO operation (error code: %u)\n", err);
+                fOk = false;
+                goto cleanup;
+            }
+        }
+    } // end work loop
+
+    // reap the IOs still in flight: a thread parked in the worker pool must not leave
+    // requests pending when it is re-armed with the next TimeSpan
+    for (UINT32 cInFlight = cIORequests - readyRequests.GetCount(); cInFlight > 0; cInFlight--)
+    {
+        pCompletedOvrp = nullptr;
+        fDequeued = GetQueuedCompletionStatus(hCompletionPort, &dwBytesTransferred, &ulCompletionKey, &pCompletedOvrp, INFINITE);
+        if (!fDequeued && (nullptr == pCompletedOvrp))
+        {
+            PrintError("error waiting for outstanding IO operations (error code: %u)\n", GetLastError());
+            fOk = false;
+            goto cleanup;
+        }
+    }
+
+cleanup:
+    return fOk;
+}
+
+/*****************************************************************************/
+// I/O completion routine. used by ReadFileEx and WriteFileEx
+//
+
+VOID CALLBACK fileIOCompletionRoutine(DWORD dwErrorCode, DWORD dwBytesTransferred, LPOVERLAPPED pOverlapped)
+{
+    assert(NULL != pOverlapped);
+
+    BOOL rslt = FALSE;
+    LARGE_INTEGER li;
+
+    ThreadParameters *p = (ThreadParameters *)pOverlapped->hEvent;
+    bool fMeasureLatency = p->pTimeSpan->GetMeasureLatency();
+
+    assert(NULL != p);
+    assert(p->cIORequestsInFlight > 0);
+    p->cIORequestsInFlight--;
+
+    //check error code
+    if (0 != dwErrorCode)
+    {
+        PrintError("Thread %u failed executing an I/O operation (error code: %u)\n", p->ulThreadNo, dwErrorCode);
+        goto cleanup;
+    }
+
+    IORequest *pIORequest = IORequest::FromOverlapped(pOverlapped);
+    size_t iTarget = pIORequest->iTarget;
+    Target *pTarget = &p->vTargets[iTarget];
+
+    //check if I/O operation transferred requested number of bytes
+    if (dwBytesTransferred != pTarget->GetBlockSizeInBytes())
+    {
+        PrintError("Warning: thread %u transferred %u bytes instead of %u bytes\n",
+            p->ulThreadNo,
+            dwBytesTransferred,
+            pTarget->GetBlockSizeInBytes());
+    }
+
+    // check if we should print a progress dot
+    // BUGBUG: does not work ... io counter must be global
+    DWORD cdwIO = 0;
+    if (p->pProfile->GetProgress() != 0)
+    {
+        ++cdwIO;
+        if (cdwIO == p->pProfile->GetProgress())
+        {
+            print(".");
+            cdwIO = 0;
+        }
+    }
+
+    //restart the I/O operation that just completed
+    li.HighPart = pOverlapped->OffsetHigh;
+    li.LowPart = pOverlapped->Offset;
+
+    if (pTarget->GetVerify())
+    {
+        verifyAfterIo(p, iTarget, pIORequest->ioType, li.QuadPart, pIORequest->pReadBuffer, p->vullVerifySnapshots[p->GetIORequestIndex(pIORequest)]);
+    }
+
+    if (isAccountingOn(p))
+    {
+        p->pResults->vTargetResults[iTarget].Add(dwBytesTransferred,
+            pIORequest->ioType,
+            &pIORequest->ullStartTime,
+            p->pullStartTime,
+            fMeasureLatency,
+            p->pTimeSpan->GetCalculateIopsStdDev());
+
+        if (nullptr != p->pTrace)
+        {
+            p->pTrace->Add(li.QuadPart,
+                dwBytesTransferred,
+                iTarget,
+                static_cast<BYTE>(pIORequest->ioType),
+                pIORequest->ullStartTime - *p->pullStartTime,
+                PerfTimer::GetTime() - *p->pullStartTime);
+        }
+    }
+    else
+    {
+        countWarmupIo(p, pIORequest->ullStartTime, fMeasureLatency);
+    }
+
+    if ((pIORequest->ioType == IOOperation::WriteIO) &&
+        !completeWrite(p, iTarget, pIORequest->ullStartTime, fMeasureLatency))
+    {
+        goto cleanup;
+    }
+
+    li.QuadPart = IORequestGenerator::GetNextFileOffset(*p, iTarget, li.QuadPart);
+
+    pOverlapped->Offset = li.LowPart;
+    pOverlapped->OffsetHigh = li.HighPart;
+
+    printfv(p->pProfile->GetVerbose(), "t[%u:%u] new I/O op at %I64u (starting in block: %I64u)\n",
+        p->ulThreadNo,
+        iTarget,
+        li.QuadPart,
+        li.QuadPart / pTarget->GetBlockSizeInBytes());
+
+    // start a new IO operation
+    if (g_bRun && !g_bThreadError)
+    {
+        if (DecideByPercentage(pTarget->GetFlushPercentage()) && !flushTarget(p, iTarget, fMeasureLatency))
+        {
+            goto cleanup;
+        }
+
+        if (fMeasureLatency || (nullptr != p->pTrace))
+        {
+            pIORequest->ullStartTime = PerfTimer::GetTime(); // record IO start time 
+        }
+
+        IOOperation readOrWrite;
+        readOrWrite = pIORequest->ioType = DecideIo(pTarget->GetWriteRatio());
+        if (pTarget->GetVerify())
+        {
+            verifyBeforeIo(p, iTarget, readOrWrite, li.QuadPart, pIORequest->pWriteBuffer, &p->vullVerifySnapshots[p->GetIORequestIndex(pIORequest)]);
+        }
+
+        if (readOrWrite == IOOperation::ReadIO)
+        {
+            rslt = ReadFileEx(p->vhTargets[iTarget], pIORequest->pReadBuffer, pTarget->GetBlockSizeInBytes(), pOverlapped, fileIOCompletionRoutine);
+        }
+        else
+        {
+            rslt = WriteFileEx(p->vhTargets[iTarget], pIORequest->pWriteBuffer, pTarget->GetBlockSizeInBytes(), pOverlapped, fileIOCompletionRoutine);
+        }
+
+        if (!rslt)
+        {
+            PrintError("t[%u:%u] error during %s error code: %u)\n", p->ulThreadNo, iTarget, (readOrWrite == IOOperation::ReadIO ? "read" : "write"), GetLastError());
+            goto cleanup;
+        }
+        p->cIORequestsInFlight++;
+    }
+
+cleanup:
+    return;
+}
+
+/*****************************************************************************/
+// function called from worker thread
+// performs asynch I/O using IO Completion Routines (ReadFileEx, WriteFileEx)
+//
+__inline static bool doWorkUsingCompletionRoutines(ThreadParameters *p)
+{
+    assert(NULL != p);
+    bool fOk = true;
+    BOOL rslt = FALSE;
+    
+    //start IO operations
+    bool fRecordStartTime = p->pTimeSpan->GetMeasureLatency() || (nullptr != p->pTrace);
+
+    for (UINT32 iIORequest = 0; iIORequest < p->cIORequests; iIORequest++)
+    {
+        IORequest *pIORequest = &p->pIORequests[iIORequest];
+        size_t iTarget = pIORequest->iTarget;
+        Target *pTarget = &p->vTargets[iTarget];
+
+        if (DecideByPercentage(pTarget->GetFlushPercentage()) && !flushTarget(p, iTarget, p->pTimeSpan->GetMeasureLatency()))
+        {
+            fOk = false;
+            goto cleanup;
+        }
+
+        if (fRecordStartTime)
+        {
+            pIORequest->ullStartTime = PerfTimer::GetTime(); // record IO start time 
+        }
+
+        IOOperation readOrWrite;
+        readOrWrite = pIORequest->ioType = DecideIo(pTarget->GetWriteRatio());
+        if (pTarget->GetVerify())
+        {
+            LARGE_INTEGER li;
+            li.LowPart = pIORequest->overlapped.Offset;
+            li.HighPart = pIORequest->overlapped.OffsetHigh;
+            verifyBeforeIo(p, iTarget, readOrWrite, li.QuadPart, pIORequest->pWriteBuffer, &p->vullVerifySnapshots[iIORequest]);
+        }
+
+        if (readOrWrite == IOOperation::ReadIO)
+        {
+            rslt = ReadFileEx(p->vhTargets[iTarget], pIORequest->pReadBuffer, pTarget->GetBlockSizeInBytes(), &pIORequest->overlapped, fileIOCompletionRoutine);
+        }
+        else
+        {
+            rslt = WriteFileEx(p->vhTargets[iTarget], pIORequest->pWriteBuffer, pTarget->GetBlockSizeInBytes(), &pIORequest->overlapped, fileIOCompletionRoutine);
+        }
+
+        if (!rslt)
+        {
+            PrintError("t[%u:%u] error during %s error code: %u)\n", p->ulThreadNo, iTarget, (readOrWrite == IOOperation::ReadIO ? "read" : "write"), GetLastError());
+            fOk = false;
+            goto cleanup;
+        }
+        p->cIORequestsInFlight++;
+    }
+
+    DWORD dwWaitResult = 0;
+    while( g_bRun && !g_bThreadError )
+    {
+        dwWaitResult = WaitForSingleObjectEx(p->hEndEvent, INFINITE, TRUE);
+
+        assert(WAIT_IO_COMPLETION == dwWaitResult || (WAIT_OBJECT_0 == dwWaitResult && (!g_bRun || g_bThreadError)));
+
+        //check WaitForSingleObjectEx status
+        if( WAIT_IO_COMPLETION != dwWaitResult && WAIT_OBJECT_0 != dwWaitResult )
+        {
+            PrintError("Error in thread %u during WaitForSingleObjectEx (in completion routines)\n", p->ulThreadNo);
+            fOk = false;
+            goto cleanup;
+        }
+    }
 
-            li.HighPart = pCompletedOvrp->OffsetHigh;
-            li.LowPart = pCompletedOvrp->Offset;
+    // let the completion routines of the IOs still in flight run (see doWorkUsingIOCompletionPorts)
+    while (p->cIORequestsInFlight > 0)
+    {
+        SleepEx(INFINITE, TRUE);
+    }
+cleanup:
+    return fOk;
+}
 
-            if (*p->pfAccountingOn)
-            {
-                p->pResults->vTargetResults[iTarget].Add(dwBytesTransferred,
-                    p->vdwIoType[iOverlapped],
-                    &p->vIoStartTimes[iOverlapped],
-                    p->pullStartTime,
-                    fMeasureLatency,
-                    p->pTimeSpan->GetCalculateIopsStdDev());
-            }
+/*****************************************************************************/
+// function called from worker thread
+// replays the streams of a trace (-Y) assigned to the thread using IO Completion Ports
+//
+__inline static bool doWorkUsingReplay(ThreadParameters *p, HANDLE hCompletionPort)
+{
+    assert(nullptr != p);
+    assert(nullptr != p->pReplay);
+    assert(nullptr != hCompletionPort);
 
-            // TODO: move to a separate function
-            // check if we should print a progress dot
-            if (p->pProfile->GetProgress() != 0)
+    bool fOk = true;
+    BOOL rslt = FALSE;
+    OVERLAPPED *pCompletedOvrp;
+    ULONG_PTR ulCompletionKey;
+    DWORD dwBytesTransferred;
+    BOOL fDequeued;
+    LARGE_INTEGER li;
+
+    IOReplay *pReplay = p->pReplay;
+    const bool fTimed = (pReplay->GetSpeed() > 0);
+    const bool fCalculateIopsStdDev = p->pTimeSpan->GetCalculateIopsStdDev();
+    const size_t cTargets = p->vTargets.size();
+    const UINT32 cIORequests = p->cIORequests;
+
+    vector<ReplayStream *> vStreams;
+    pReplay->GetThreadStreams(p->ulThreadNo, vStreams);
+    size_t cStreamsLeft = vStreams.size();
+
+    // stream and original latency of the I/O in flight on each request
+    vector<ReplayStream *> vRequestStreams(cIORequests);
+    vector<float> vRequestLatencies(cIORequests);
+    IORequestRing readyRequests(cIORequests);
+    for (UINT32 i = 0; i < cIORequests; i++)
+    {
+        readyRequests.Add(i);
+    }
+    PreciseSleeper sleeper;
+
+    // disks and partitions are only sized once opened; files were checked with the trace
+    for (size_t iTarget = 0; iTarget < cTargets; iTarget++)
+    {
+        if (p->vullFileSizes[iTarget] <= pReplay->GetMaxBytes())
+        {
+            PrintError("t[%u] target %s is not larger than the largest I/O of the replay trace (%u bytes)\n",
+                p->ulThreadNo,
+                p->vTargets[iTarget].GetPath().c_str(),
+                pReplay->GetMaxBytes());
+            return false;
+        }
+    }
+
+    // the replay starts with the measurement, so that all the threads share the time base
+    while (g_bRun && !g_bThreadError && !*p->pfAccountingOn)
+    {
+        Sleep(1);
+    }
+    const UINT64 ullBaseTime = *p->pullStartTime;
+
+    while (g_bRun && !g_bThreadError && ((cStreamsLeft > 0) || (readyRequests.GetCount() < cIORequests)))
+    {
+        UINT64 ullNow = PerfTimer::GetTime();
+        UINT64 ullNextTime = MAXUINT64;
+
+        for (auto pStream : vStreams)
+        {
+            vector<ReplayOp>& vOps = pStream->vOps;
+            while ((pStream->iNext < vOps.size()) && !readyRequests.IsEmpty())
             {
-                ++dwIOCnt;
-                if (dwIOCnt == p->pProfile->GetProgress())
+                const ReplayOp& op = vOps[pStream->iNext];
+                UINT64 ullIntendedTime = ullBaseTime + op.ullTime;
+                if (fTimed)
                 {
-                    print(".");
-                    dwIOCnt = 0;
+                    if (ullIntendedTime > ullNow)
+                    {
+                        ullNextTime = min(ullNextTime, ullIntendedTime);
+                        break;
+                    }
+                }
+                else if (pStream->cCompleted < op.ulDependency)
+                {
+                    break;
+                }
+
+                UINT32 iIORequest = readyRequests.Remove();
+                IORequest *pIORequest = &p->pIORequests[iIORequest];
+                size_t iTarget = op.bTarget % cTargets;
+                pIORequest->iTarget = static_cast<UINT32>(iTarget);
+                pIORequest->ioType = (2 == op.bType) ? IOOperation::WriteIO : IOOperation::ReadIO;
+                vRequestStreams[iIORequest] = pStream;
+                vRequestLatencies[iIORequest] = op.fLatency;
+
+                // an offset past the end of the target wraps around to one the I/O fits at, aligned
+                // like the target; the target is larger than the largest I/O of the trace
+                li.QuadPart = op.ullOffset;
+                if (li.QuadPart + op.ulBytes > p->vullFileSizes[iTarget])
+                {
+                    li.QuadPart %= p->vullFileSizes[iTarget] - op.ulBytes + 1;
+                    li.QuadPart -= li.QuadPart % p->vTargets[iTarget].GetBlockAlignmentInBytes();
+                }
+                pIORequest->overlapped.Offset = li.LowPart;
+                pIORequest->overlapped.OffsetHigh = li.HighPart;
+
+                if (fTimed && *p->pfAccountingOn)
+                {
+                    // the I/Os of the stream already due behind this one
+                    while ((pStream->iDue < vOps.size()) && (ullBaseTime + vOps[pStream->iDue].ullTime <= ullNow))
+                    {
+                        pStream->iDue++;
+                    }
+                    p->pResults->vTargetResults[iTarget].AddArrival(ullIntendedTime, ullNow, pStream->iDue - pStream->iNext - 1);
+                }
+
+                pIORequest->ullStartTime = PerfTimer::GetTime();
+                if (pIORequest->ioType == IOOperation::ReadIO)
+                {
+                    rslt = ReadFile(p->vhTargets[iTarget], pIORequest->pReadBuffer, op.ulBytes, nullptr, &pIORequest->overlapped);
+                }
+                else
+                {
+                    rslt = WriteFile(p->vhTargets[iTarget], pIORequest->pWriteBuffer, op.ulBytes, nullptr, &pIORequest->overlapped);
+                }
+
+                if (!rslt && GetLastError() != ERROR_IO_PENDING)
+                {
+                    PrintError("t[%u] error during %s error code: %u)\n", iIORequest, (pIORequest->ioType == IOOperation::ReadIO ? "read" : "write"), GetLastError());
+                    fOk = false;
+                    goto cleanup;
+                }
+
+                if (++pStream->iNext == vOps.size())
+                {
+                    cStreamsLeft--;
                 }
             }
+        }
 
-            //restart the I/O operation that just completed
-            li.QuadPart = IORequestGenerator::GetNextFileOffset(*p, iTarget, li.QuadPart);
+        // nothing in flight: sleep until the next I/O is due
+        DWORD dwWaitTimeout = 1;
+        if (readyRequests.GetCount() == cIORequests)
+        {
+            if (ullNextTime == MAXUINT64)
+            {
+                continue;
+            }
+            ullNow = PerfTimer::GetTime();
+            if (ullNextTime > ullNow)
+            {
+                sleeper.Wait(ullNextTime - ullNow);
+            }
+            continue;
+        }
+        else if ((ullNextTime != MAXUINT64) && (ullNextTime - ullNow < PerfTimer::MillisecondsToPerfTime(1)))
+        {
+            // an I/O due in less than a millisecond is polled for rather than waited on
+            dwWaitTimeout = 0;
+        }
 
-            pCompletedOvrp->Offset = li.LowPart;
-            pCompletedOvrp->OffsetHigh = li.HighPart;
+        pCompletedOvrp = nullptr;
+        fDequeued = GetQueuedCompletionStatus(hCompletionPort, &dwBytesTransferred, &ulCompletionKey, &pCompletedOvrp, dwWaitTimeout);
+        if (fDequeued != 0)
+        {
+            IORequest *pIORequest = IORequest::FromOverlapped(pCompletedOvrp);
+            UINT32 iIORequest = p->GetIORequestIndex(pIORequest);
+            size_t iTarget = pIORequest->iTarget;
+            vRequestStreams[iIORequest]->cCompleted++;
 
-            printfv(p->pProfile->GetVerbose(), "t[%u:%u] new I/O op at %I64u (starting in block: %I64u)\n",
-                p->ulThreadNo,
-                iTarget,
-                li.QuadPart,
-                li.QuadPart / pTarget->GetBlockSizeInBytes());
+            if (isAccountingOn(p))
+            {
+                TargetResults& targetResults = p->pResults->vTargetResults[iTarget];
+                targetResults.Add(dwBytesTransferred,
+                    pIORequest->ioType,
+                    &pIORequest->ullStartTime,
+                    p->pullStartTime,
+                    true,
+                    fCalculateIopsStdDev);
+
+                if (vRequestLatencies[iIORequest] >= 0)
+                {
+                    targetResults.originalLatencyHistogram.Add(vRequestLatencies[iIORequest]);
+                }
+
+                if (nullptr != p->pTrace)
+                {
+                    li.HighPart = pCompletedOvrp->OffsetHigh;
+                    li.LowPart = pCompletedOvrp->Offset;
+                    p->pTrace->Add(li.QuadPart,
+                        dwBytesTransferred,
+                        iTarget,
+                        static_cast<BYTE>(pIORequest->ioType),
+                        pIORequest->ullStartTime - *p->pullStartTime,
+                        PerfTimer::GetTime() - *p->pullStartTime);
+                }
+            }
 
-            overlappedQueue.Add(pCompletedOvrp);
+            readyRequests.Add(iIORequest);
         }
         else
         {
@@ -890,182 +2164,375 @@ __inline static bool doWorkUsingIOCompletionPorts(ThreadParameters *p, HANDLE hC
                 goto cleanup;
             }
         }
-    } // end work loop
+    }
+
+    // the thread has replayed all its streams: its measurement ends here
+    if ((cStreamsLeft == 0) && (p->pResults->ullAccountingStartTime != 0) && (p->pResults->ullAccountingEndTime == 0))
+    {
+        p->pResults->ullAccountingEndTime = PerfTimer::GetTime();
+        p->pResults->EndCpuWindow(GetCurrentThread());
+    }
+    pReplay->ThreadDone();
+
+    // reap the IOs still in flight if the run ended first
+    for (UINT32 cInFlight = cIORequests - static_cast<UINT32>(readyRequests.GetCount()); cInFlight > 0; cInFlight--)
+    {
+        pCompletedOvrp = nullptr;
+        fDequeued = GetQueuedCompletionStatus(hCompletionPort, &dwBytesTransferred, &ulCompletionKey, &pCompletedOvrp, INFINITE);
+        if (!fDequeued && (nullptr == pCompletedOvrp))
+        {
+            PrintError("error waiting for outstanding IO operations (error code: %u)\n", GetLastError());
+            fOk = false;
+            goto cleanup;
+        }
+    }
+
+    // stay until the run ends, like the threads that generate I/O
+    while (g_bRun && !g_bThreadError)
+    {
+        Sleep(10);
+    }
 
 cleanup:
     return fOk;
 }
 
 /*****************************************************************************/
-// I/O completion routine. used by ReadFileEx and WriteFileEx
+// function called from worker thread
+// group-commit log writer (-M): writes the commits of the clients waiting on the log
+// as one sequential write, makes it durable and releases the clients; the handle is
+// synchronous and the file pointer is at the starting offset
 //
-
-VOID CALLBACK fileIOCompletionRoutine(DWORD dwErrorCode, DWORD dwBytesTransferred, LPOVERLAPPED pOverlapped)
+__inline static bool doWorkUsingLogWriter(ThreadParameters *p, UINT64 ullOffset)
 {
-    assert(NULL != pOverlapped);
+    assert(nullptr != p);
+    assert(p->vTargets.size() == 1);
 
-    BOOL rslt = FALSE;
+    bool fOk = true;
     LARGE_INTEGER li;
+    DWORD dwBytesTransferred;
+    DWORD dwIOCnt = 0;
+    PreciseSleeper sleeper;
 
-    ThreadParameters *p = (ThreadParameters *)pOverlapped->hEvent;
+    Target *pTarget = &p->vTargets[0];
+    TargetResults& targetResults = p->pResults->vTargetResults[0];
     bool fMeasureLatency = p->pTimeSpan->GetMeasureLatency();
+    bool fCalculateIopsStdDev = p->pTimeSpan->GetCalculateIopsStdDev();
+    // write-through writes are durable when they complete and need no flush
+    bool fFlush = !pTarget->GetWriteThrough() && !pTarget->GetDisableAllCache();
+    DWORD cbRecord = static_cast<DWORD>(pTarget->GetBlockAlignmentInBytes());
+
+    GroupCommitLog log;
+    log.Start(pTarget->GetLogClients(),
+        static_cast<double>(pTarget->GetCommitRate()),
+        pTarget->GetPoissonCommits(),
+        pTarget->GetBlockSizeInBytes() / cbRecord,
+        p->ulRandSeed);
+
+    while (g_bRun && !g_bThreadError)
+    {
+        UINT64 ullStartTime = PerfTimer::GetTime();
+        UINT32 cCommits = log.FormBatch(ullStartTime);
+        if (cCommits == 0)
+        {
+            sleeper.Wait(log.GetDelay(ullStartTime));
+            continue;
+        }
 
-    assert(NULL != p);
+        if (!WriteFile(p->vhTargets[0], p->GetWriteBuffer(0, 0), cCommits * cbRecord, &dwBytesTransferred, nullptr))
+        {
+            PrintError("t[%u] error during log write error code: %u)\n", p->ulThreadNo, GetLastError());
+            fOk = false;
+            goto cleanup;
+        }
 
-    //check error code
-    if (0 != dwErrorCode)
-    {
-        PrintError("Thread %u failed executing an I/O operation (error code: %u)\n", p->ulThreadNo, dwErrorCode);
-        goto cleanup;
-    }
+        if (fFlush && !FlushFileBuffers(p->vhTargets[0]))
+        {
+            PrintError("t[%u] error during log flush error code: %u)\n", p->ulThreadNo, GetLastError());
+            fOk = false;
+            goto cleanup;
+        }
 
-    size_t iOverlapped = (pOverlapped - &p->vOverlapped[0]);
-    size_t iTarget = p->vOverlappedIdToTargetId[iOverlapped];
-    Target *pTarget = &p->vTargets[iTarget];
+        UINT64 ullDurableTime = PerfTimer::GetTime();
+        if (isAccountingOn(p))
+        {
+            targetResults.Add(dwBytesTransferred,
+                IOOperation::WriteIO,
+                &ullStartTime,
+                p->pullStartTime,
+                fMeasureLatency,
+                fCalculateIopsStdDev);
+
+            targetResults.AddLogBatch(cCommits, log.GetLateCommitCount());
+            for (UINT32 i = 0; i < cCommits; i++)
+            {
+                targetResults.commitLatencyHistogram.Add(static_cast<float>(PerfTimer::PerfTimeToMicroseconds(ullDurableTime - log.GetCommitTime(i))));
+            }
 
-    //check if I/O operation transferred requested number of bytes
-    if (dwBytesTransferred != pTarget->GetBlockSizeInBytes())
-    {
-        PrintError("Warning: thread %u transferred %u bytes instead of %u bytes\n",
-            p->ulThreadNo,
-            dwBytesTransferred,
-            pTarget->GetBlockSizeInBytes());
-    }
+            if (nullptr != p->pTrace)
+            {
+                p->pTrace->Add(ullOffset,
+                    dwBytesTransferred,
+                    0,
+                    static_cast<BYTE>(IOOperation::WriteIO),
+                    ullStartTime - *p->pullStartTime,
+                    ullDurableTime - *p->pullStartTime);
+            }
+        }
+        else
+        {
+            countWarmupIo(p, ullStartTime, fMeasureLatency);
+        }
+        log.CompleteBatch(ullDurableTime);
 
-    // check if we should print a progress dot
-    // BUGBUG: does not work ... io counter must be global
-    DWORD cdwIO = 0;
-    if (p->pProfile->GetProgress() != 0)
-    {
-        ++cdwIO;
-        if (cdwIO == p->pProfile->GetProgress())
+        // check if we should print a progress dot
+        if (p->pProfile->GetProgress() != 0)
         {
-            print(".");
-            cdwIO = 0;
+            ++dwIOCnt;
+            if (dwIOCnt == p->pProfile->GetProgress())
+            {
+                print(".");
+                dwIOCnt = 0;
+            }
+        }
+
+        // the log moves on by one stride per record written and wraps like any sequential pattern
+        for (UINT32 i = 0; i < cCommits; i++)
+        {
+            ullOffset = IORequestGenerator::GetNextFileOffset(*p, 0, ullOffset);
+        }
+
+        li.QuadPart = ullOffset;
+        if (!SetFilePointerEx(p->vhTargets[0], li, NULL, FILE_BEGIN))
+        {
+            PrintError("thread %u: Error setting file pointer\n", p->ulThreadNo);
+            fOk = false;
+            goto cleanup;
         }
     }
 
-    if (*p->pfAccountingOn)
+cleanup:
+    return fOk;
+}
+
+/*****************************************************************************/
+// path of a file of the small-file population (-m): <directory>\d<n>\f<file>, with
+// FilesPerDirectory files in each subdirectory
+//
+__inline static string getPopulationFilePath(const Target& target, DWORD iFile)
+{
+    string sPath(target.GetPath());
+    if (sPath.empty() || ('\\' != sPath[sPath.length() - 1]))
     {
-        p->pResults->vTargetResults[iTarget].Add(dwBytesTransferred,
-            p->vdwIoType[iOverlapped],
-            &p->vIoStartTimes[iOverlapped],
-            p->pullStartTime,
-            fMeasureLatency,
-            p->pTimeSpan->GetCalculateIopsStdDev());
+        sPath += '\\';
     }
 
-    //restart the I/O operation that just completed
-    li.HighPart = pOverlapped->OffsetHigh;
-    li.LowPart = pOverlapped->Offset;
+    char szName[32];
+    sprintf_s(szName, _countof(szName), "d%u\\f%u", iFile / target.GetFilesPerDirectory(), iFile);
+    return sPath + szName;
+}
 
-    li.QuadPart = IORequestGenerator::GetNextFileOffset(*p, iTarget, li.QuadPart);
+/*****************************************************************************/
+// size of a file of the small-file population (-m), log-uniform between the smallest
+// and the largest; a fixed hash of the index (the splitmix64 finalizer) stands in for
+// the random draw, so a file re-created by a thread gets the size it was populated with
+//
+__inline static UINT64 getPopulationFileSize(const Target& target, DWORD iFile)
+{
+    UINT64 ullMin = target.GetMinPopulationFileSize();
+    UINT64 ullMax = target.GetMaxPopulationFileSize();
+    if (ullMin >= ullMax)
+    {
+        return ullMin;
+    }
 
-    pOverlapped->Offset = li.LowPart;
-    pOverlapped->OffsetHigh = li.HighPart;
+    UINT64 x = (static_cast<UINT64>(iFile) + 1) * 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    x ^= x >> 31;
 
-    printfv(p->pProfile->GetVerbose(), "t[%u:%u] new I/O op at %I64u (starting in block: %I64u)\n",
-        p->ulThreadNo,
-        iTarget,
-        li.QuadPart,
-        li.QuadPart / pTarget->GetBlockSizeInBytes());
+    double fFraction = (x >> 11) / 9007199254740992.0;     // [0, 1) from the top 53 bits
+    UINT64 ullSize = static_cast<UINT64>(ullMin * pow(static_cast<double>(ullMax) / ullMin, fFraction));
+    return min(max(ullSize, ullMin), ullMax);
+}
 
-    // start a new IO operation
-    if (g_bRun && !g_bThreadError)
+/*****************************************************************************/
+// runs one operation of the small-file workload (-m) on a file of the population and
+// returns the bytes read or written; on failure GetLastError tells why
+//
+__inline static BOOL doFileOperation(ThreadParameters *p, FileOperation operation, const string& sFile, UINT64 cbFile, UINT64 *pcbTransferred)
+{
+    Target *pTarget = &p->vTargets[0];
+    DWORD cbBlock = pTarget->GetBlockSizeInBytes();
+    BOOL rslt = FALSE;
+    DWORD dwError = ERROR_SUCCESS;
+    DWORD cbTransferred;
+    HANDLE hFile;
+
+    *pcbTransferred = 0;
+    switch (operation)
     {
-        size_t iRequest = iOverlapped - p->vFirstOverlappedIdForTargetId[iTarget];
-        if (fMeasureLatency)
+    case FileOperation::OpenRead:
+        hFile = CreateFile(sFile.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+            nullptr);
+        if (INVALID_HANDLE_VALUE == hFile)
         {
-            p->vIoStartTimes[iOverlapped] = PerfTimer::GetTime(); // record IO start time 
+            return FALSE;
         }
 
-        IOOperation readOrWrite;
-        readOrWrite = p->vdwIoType[iOverlapped] = DecideIo(pTarget->GetWriteRatio());
-        if (readOrWrite == IOOperation::ReadIO)
+        do
+        {
+            rslt = ReadFile(hFile, p->GetReadBuffer(0, 0), cbBlock, &cbTransferred, nullptr);
+            *pcbTransferred += rslt ? cbTransferred : 0;
+        } while (rslt && (cbTransferred == cbBlock));
+
+        dwError = GetLastError();
+        CloseHandle(hFile);
+        break;
+
+    case FileOperation::Create:
+        hFile = CreateFile(sFile.c_str(),
+            GENERIC_WRITE,
+            0,
+            nullptr,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL | (pTarget->GetWriteThrough() ? FILE_FLAG_WRITE_THROUGH : 0),
+            nullptr);
+        if (INVALID_HANDLE_VALUE == hFile)
         {
-            rslt = ReadFileEx(p->vhTargets[iTarget], p->GetReadBuffer(iTarget, iRequest), pTarget->GetBlockSizeInBytes(), pOverlapped, fileIOCompletionRoutine);
+            return FALSE;
         }
-        else
+
+        rslt = TRUE;
+        while (rslt && (*pcbTransferred < cbFile))
         {
-            rslt = WriteFileEx(p->vhTargets[iTarget], p->GetWriteBuffer(iTarget, iRequest), pTarget->GetBlockSizeInBytes(), pOverlapped, fileIOCompletionRoutine);
+            DWORD cbWrite = static_cast<DWORD>(min(static_cast<UINT64>(cbBlock), cbFile - *pcbTransferred));
+            rslt = WriteFile(hFile, p->GetWriteBuffer(0, 0), cbWrite, &cbTransferred, nullptr);
+            *pcbTransferred += rslt ? cbTransferred : 0;
         }
 
-        if (!rslt)
+        // the file is durable, as after write and fsync, before it is closed
+        rslt = rslt && FlushFileBuffers(hFile);
+        dwError = GetLastError();
+        CloseHandle(hFile);
+        break;
+
+    case FileOperation::Stat:
         {
-            PrintError("t[%u:%u] error during %s error code: %u)\n", p->ulThreadNo, iTarget, (readOrWrite == IOOperation::ReadIO ? "read" : "write"), GetLastError());
-            goto cleanup;
+            WIN32_FILE_ATTRIBUTE_DATA attributes;
+            return GetFileAttributesEx(sFile.c_str(), GetFileExInfoStandard, &attributes);
         }
+
+    case FileOperation::Delete:
+        return DeleteFile(sFile.c_str());
     }
 
-cleanup:
-    return;
+    SetLastError(dwError);
+    return rslt;
 }
 
 /*****************************************************************************/
 // function called from worker thread
-// performs asynch I/O using IO Completion Routines (ReadFileEx, WriteFileEx)
+// small-file workload (-m): runs the mix of operations on the files of the population
+// the thread owns (every n-th file for n threads), one at a time. All of them exist at
+// the start; deleted files are re-created by later creates
 //
-__inline static bool doWorkUsingCompletionRoutines(ThreadParameters *p)
+__inline static bool doWorkUsingFileOperations(ThreadParameters *p)
 {
-    assert(NULL != p);
+    assert(nullptr != p);
+    assert(p->vTargets.size() == 1);
+
+    static const char *vszOperations[] = { "open/read", "create", "stat", "delete" };
     bool fOk = true;
-    BOOL rslt = FALSE;
-    
-    //start IO operations
-    size_t iOverlapped = 0;
+    DWORD dwIOCnt = 0;
 
+    Target *pTarget = &p->vTargets[0];
+    TargetResults& targetResults = p->pResults->vTargetResults[0];
     bool fMeasureLatency = p->pTimeSpan->GetMeasureLatency();
 
-    for (size_t iTarget = 0; iTarget < p->vTargets.size(); iTarget++)
+    vector<DWORD> vPresentFiles;
+    vector<DWORD> vDeletedFiles;
+    for (DWORD iFile = p->ulRelativeThreadNo; iFile < pTarget->GetFileCount(); iFile += getTargetThreadCount(p, pTarget))
+    {
+        vPresentFiles.push_back(iFile);
+    }
+
+    while (g_bRun && !g_bThreadError)
     {
-        Target *pTarget = &p->vTargets[iTarget];
-        for (size_t iRequest = 0; iRequest < pTarget->GetRequestCount(); ++iRequest)
+        FileOperation operation = FileOperation::Delete;
+        UINT32 ulChoice = static_cast<UINT32>(rand() % 100);
+        for (size_t i = 0; i < FILE_OPERATION_COUNT; i++)
         {
-            if (fMeasureLatency)
-            {
-                p->vIoStartTimes[iOverlapped] = PerfTimer::GetTime(); // record IO start time 
-            }
-
-            IOOperation readOrWrite;
-            readOrWrite = p->vdwIoType[iOverlapped] = DecideIo(pTarget->GetWriteRatio());
-            if (readOrWrite == IOOperation::ReadIO)
-            {
-                rslt = ReadFileEx(p->vhTargets[iTarget], p->GetReadBuffer(iTarget, iRequest), pTarget->GetBlockSizeInBytes(), &p->vOverlapped[iOverlapped], fileIOCompletionRoutine);
-            }
-            else
-            {
-                rslt = WriteFileEx(p->vhTargets[iTarget], p->GetWriteBuffer(iTarget, iRequest), pTarget->GetBlockSizeInBytes(), &p->vOverlapped[iOverlapped], fileIOCompletionRoutine);
-            }
-
-            if (!rslt)
+            UINT32 ulPercentage = pTarget->GetFileOperationPercentage(static_cast<FileOperation>(i));
+            if (ulChoice < ulPercentage)
             {
-                PrintError("t[%u:%u] error during %s error code: %u)\n", p->ulThreadNo, iTarget, (readOrWrite == IOOperation::ReadIO ? "read" : "write"), GetLastError());
-                fOk = false;
-                goto cleanup;
+                operation = static_cast<FileOperation>(i);
+                break;
             }
-            iOverlapped++;
+            ulChoice -= ulPercentage;
         }
-    }
 
-    DWORD dwWaitResult = 0;
-    while( g_bRun && !g_bThreadError )
-    {
-        dwWaitResult = WaitForSingleObjectEx(p->hEndEvent, INFINITE, TRUE);
+        // once every file of the thread is deleted, create one
+        if (vPresentFiles.size() == 0)
+        {
+            operation = FileOperation::Create;
+        }
 
-        assert(WAIT_IO_COMPLETION == dwWaitResult || (WAIT_OBJECT_0 == dwWaitResult && (!g_bRun || g_bThreadError)));
+        // creates bring deleted files back while there are any and overwrite files otherwise
+        vector<DWORD>& vFiles = ((operation == FileOperation::Create) && !vDeletedFiles.empty()) ? vDeletedFiles : vPresentFiles;
+        size_t iSlot = static_cast<size_t>(rand64() % vFiles.size());
+        DWORD iFile = vFiles[iSlot];
+        string sFile = getPopulationFilePath(*pTarget, iFile);
+        UINT64 cbTransferred;
 
-        //check WaitForSingleObjectEx status
-        if( WAIT_IO_COMPLETION != dwWaitResult && WAIT_OBJECT_0 != dwWaitResult )
+        UINT64 ullStartTime = PerfTimer::GetTime();
+        if (!doFileOperation(p, operation, sFile, getPopulationFileSize(*pTarget, iFile), &cbTransferred))
         {
-            PrintError("Error in thread %u during WaitForSingleObjectEx (in completion routines)\n", p->ulThreadNo);
+            PrintError("t[%u] error during %s of %s (error code: %u)\n", p->ulThreadNo, vszOperations[static_cast<size_t>(operation)], sFile.c_str(), GetLastError());
             fOk = false;
             goto cleanup;
         }
+
+        if (isAccountingOn(p))
+        {
+            targetResults.AddFileOperation(operation, cbTransferred, ullStartTime, fMeasureLatency);
+        }
+        else
+        {
+            countWarmupIo(p, ullStartTime, fMeasureLatency);
+        }
+
+        if ((operation == FileOperation::Delete) || (&vFiles == &vDeletedFiles))
+        {
+            vector<DWORD>& vTo = (operation == FileOperation::Delete) ? vDeletedFiles : vPresentFiles;
+            vTo.push_back(iFile);
+            vFiles[iSlot] = vFiles.back();
+            vFiles.pop_back();
+        }
+
+        // check if we should print a progress dot
+        if (p->pProfile->GetProgress() != 0)
+        {
+            ++dwIOCnt;
+            if (dwIOCnt == p->pProfile->GetProgress())
+            {
+                print(".");
+                dwIOCnt = 0;
+            }
+        }
     }
+
 cleanup:
     return fOk;
 }
 
+static bool doThreadPhase(ThreadParameters *p, HANDLE *phCompletionPort);
+
 /*****************************************************************************/
 // worker thread function
 //
@@ -1098,20 +2565,7 @@ DWORD WINAPI threadFunc(LPVOID cookie)
     bool fOk = true;
     ThreadParameters *p = reinterpret_cast<ThreadParameters *>(cookie);
     HANDLE hCompletionPort = nullptr;
-
-    bool fMeasureLatency = p->pTimeSpan->GetMeasureLatency();
-    bool fCalculateIopsStdDev = p->pTimeSpan->GetCalculateIopsStdDev();
-    UINT64 ioBucketDuration = 0;
-    UINT32 expectedNumberOfBuckets = 0;
-    if(fCalculateIopsStdDev)
-    {
-        UINT32 ioBucketDurationInMilliseconds = p->pTimeSpan->GetIoBucketDurationInMilliseconds();
-        ioBucketDuration = PerfTimer::MillisecondsToPerfTime(ioBucketDurationInMilliseconds);
-        expectedNumberOfBuckets = Util::QuotientCeiling(p->pTimeSpan->GetDuration() * 1000, ioBucketDurationInMilliseconds);
-    }
-
-    //set random seed (each thread has a different one)
-    srand(p->ulRandSeed);
+    bool fRunning = true;   // false while the thread is parked and not counted in g_lRunningThreadsCount
 
     //affinity
     ULONG ulGroupProcs = 0;
@@ -1254,6 +2708,36 @@ DWORD WINAPI threadFunc(LPVOID cookie)
             fname = sPath.c_str();
         }
 
+        //the small-file workload (-m) opens the files of the population as it goes; the
+        //handle on the directory only keeps it in place and the directory has no size
+        if (pTarget->GetFileCount() > 0)
+        {
+            HANDLE hDirectory = CreateFile(fname,
+                0,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_FLAG_BACKUP_SEMANTICS,
+                nullptr);
+            if (INVALID_HANDLE_VALUE == hDirectory)
+            {
+                PrintError("Error opening directory: %s [%u]\n", sPath.c_str(), GetLastError());
+                fOk = false;
+                goto cleanup;
+            }
+
+            p->vhTargets.push_back(hDirectory);
+            p->vullFileSizes.push_back(0);
+            if (!p->AllocateAndFillBufferForTarget(*pTarget))
+            {
+                PrintError("FATAL ERROR: Could not allocate a buffer bytes for target '%s'. Error code: 0x%x\n", pTarget->GetPath().c_str(), GetLastError());
+                fOk = false;
+                goto cleanup;
+            }
+            iTarget++;
+            continue;
+        }
+
         //set file flags
         DWORD dwFlags = FILE_ATTRIBUTE_NORMAL;
 
@@ -1282,8 +2766,13 @@ DWORD WINAPI threadFunc(LPVOID cookie)
             dwFlags |= (FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH);
         }
 
+        if (pTarget->GetWriteThrough())
+        {
+            dwFlags |= FILE_FLAG_WRITE_THROUGH;
+        }
+
         DWORD dwDesiredAccess = 0;
-        if (pTarget->GetWriteRatio() == 0)
+        if ((pTarget->GetWriteRatio() == 0) && !pTarget->GetUseDiscards())
         {
             dwDesiredAccess = GENERIC_READ;
         }
@@ -1383,38 +2872,6 @@ DWORD WINAPI threadFunc(LPVOID cookie)
                 // the whole file will be used
                 p->vullFileSizes.push_back(fsize);
             }
-
-            UINT64 startingFileOffset = IORequestGenerator::GetThreadBaseFileOffset(*p, iTarget);
-
-            // test whether the file is large enough for this thread to do work
-            if (startingFileOffset + pTarget->GetBlockSizeInBytes() >= p->vullFileSizes[iTarget])
-            {
-                PrintError("The file is too small. File: '%s' relative thread %u size: %I64u, base offset: %I64u block size: %u\n",
-                    pTarget->GetPath().c_str(),
-                    p->ulRelativeThreadNo,
-                    fsize,
-                    pTarget->GetBaseFileOffsetInBytes(),
-                    pTarget->GetBlockSizeInBytes());
-                fOk = false;
-                goto cleanup;
-            }
-
-            if (pTarget->GetUseRandomAccessPattern())
-            {
-                printfv(p->pProfile->GetVerbose(), "thread %u starting: file '%s' relative thread %u random pattern\n",
-                    p->ulThreadNo,
-                    pTarget->GetPath().c_str(),
-                    p->ulRelativeThreadNo);
-            }
-            else
-            {
-                printfv(p->pProfile->GetVerbose(), "thread %u starting: file '%s' relative thread %u file offset: %I64u (starting in block: %I64u)\n",
-                    p->ulThreadNo,
-                    pTarget->GetPath().c_str(),
-                    p->ulRelativeThreadNo,
-                    startingFileOffset,
-                    startingFileOffset / pTarget->GetBlockSizeInBytes());
-            }
         }
 
         // allocate memory for a data buffer
@@ -1427,6 +2884,137 @@ DWORD WINAPI threadFunc(LPVOID cookie)
         iTarget++;
     }
  
+    //
+    // run TimeSpans until the worker pool retires the thread; between them the thread parks
+    // with its targets open and buffers allocated
+    //
+    while (fOk)
+    {
+        fOk = doThreadPhase(p, &hCompletionPort);
+        if (fOk)
+        {
+            InterlockedDecrement(&g_lRunningThreadsCount);
+            fRunning = false;
+
+            printfv(p->pProfile->GetVerbose(), "thread %u: parked\n", p->ulThreadNo);
+            if ((WAIT_OBJECT_0 != WaitForSingleObject(p->hRearmEvent, INFINITE)) || p->fRetire)
+            {
+                break;
+            }
+
+            // the pool counted the thread as running again before re-arming it
+            fRunning = true;
+        }
+    }
+
+cleanup:
+    if (!fOk)
+    {
+        g_bThreadError = TRUE;
+    }
+
+    // free memory allocated with VirtualAlloc
+    for (auto i = p->vpDataBuffers.begin(); i != p->vpDataBuffers.end(); i++)
+    {
+        if (nullptr != *i)
+        {
+#pragma prefast(suppress:6001, "Prefast does not understand this vector will only contain validly allocated buffer pointers")
+            VirtualFree(*i, 0, MEM_RELEASE);
+        }
+    }
+    p->FreeIORequests();
+
+    // close files
+    for (auto i = p->vhTargets.begin(); i != p->vhTargets.end(); i++)
+    {
+        CloseHandle(*i);
+    }
+
+    // close completion ports
+    if (hCompletionPort != nullptr)
+    {
+        CloseHandle(hCompletionPort);
+    }
+
+    // notify master thread that we've finished (the worker pool owns and frees the parameters)
+    if (fRunning)
+    {
+        InterlockedDecrement(&g_lRunningThreadsCount);
+    }
+
+    return fOk ? 1 : 0;
+}
+
+/*****************************************************************************/
+// runs one TimeSpan on a worker thread whose targets are open and buffers allocated;
+// called again each time the worker pool re-arms the thread with a new TimeSpan
+//
+static bool doThreadPhase(ThreadParameters *p, HANDLE *phCompletionPort)
+{
+    bool fOk = true;
+    HANDLE hCompletionPort = *phCompletionPort;
+
+    bool fMeasureLatency = p->pTimeSpan->GetMeasureLatency();
+    bool fRecordStartTime = fMeasureLatency || (nullptr != p->pTrace);
+    bool fCalculateIopsStdDev = p->pTimeSpan->GetCalculateIopsStdDev();
+    UINT64 ioBucketDuration = 0;
+    UINT32 expectedNumberOfBuckets = 0;
+    if(fCalculateIopsStdDev)
+    {
+        UINT32 ioBucketDurationInMilliseconds = p->pTimeSpan->GetIoBucketDurationInMilliseconds();
+        ioBucketDuration = PerfTimer::MillisecondsToPerfTime(ioBucketDurationInMilliseconds);
+        expectedNumberOfBuckets = Util::QuotientCeiling(p->pTimeSpan->GetDuration() * 1000, ioBucketDurationInMilliseconds);
+    }
+
+    //set random seed (each thread has a different one)
+    srand(p->ulRandSeed);
+
+    // test whether the targets are large enough for this thread to do work
+    for (size_t iTarget = 0; iTarget < p->vTargets.size(); iTarget++)
+    {
+        Target *pTarget = &p->vTargets[iTarget];
+        UINT64 startingFileOffset = IORequestGenerator::GetThreadBaseFileOffset(*p, iTarget);
+
+        // the small-file workload (-m) has no offsets; its files are sized when the population is built
+        if (pTarget->GetFileCount() > 0)
+        {
+            printfv(p->pProfile->GetVerbose(), "thread %u starting: directory '%s' relative thread %u small-file operations\n",
+                p->ulThreadNo,
+                pTarget->GetPath().c_str(),
+                p->ulRelativeThreadNo);
+            continue;
+        }
+
+        if (startingFileOffset + pTarget->GetBlockSizeInBytes() >= p->vullFileSizes[iTarget])
+        {
+            PrintError("The file is too small. File: '%s' relative thread %u size: %I64u, base offset: %I64u block size: %u\n",
+                pTarget->GetPath().c_str(),
+                p->ulRelativeThreadNo,
+                p->vullFileSizes[iTarget],
+                pTarget->GetBaseFileOffsetInBytes(),
+                pTarget->GetBlockSizeInBytes());
+            fOk = false;
+            goto cleanup;
+        }
+
+        if (pTarget->GetUseRandomAccessPattern())
+        {
+            printfv(p->pProfile->GetVerbose(), "thread %u starting: file '%s' relative thread %u random pattern\n",
+                p->ulThreadNo,
+                pTarget->GetPath().c_str(),
+                p->ulRelativeThreadNo);
+        }
+        else
+        {
+            printfv(p->pProfile->GetVerbose(), "thread %u starting: file '%s' relative thread %u file offset: %I64u (starting in block: %I64u)\n",
+                p->ulThreadNo,
+                pTarget->GetPath().c_str(),
+                p->ulRelativeThreadNo,
+                startingFileOffset,
+                startingFileOffset / pTarget->GetBlockSizeInBytes());
+        }
+    }
+
     // TODO: copy parameters for better memory locality?    
     // TODO: tell the main thread we're ready
     // TODO: wait for a signal to start
@@ -1439,16 +3027,31 @@ DWORD WINAPI threadFunc(LPVOID cookie)
 
     p->vullPrivateSequentialOffsets.clear();
     p->vullPrivateSequentialOffsets.resize(p->vTargets.size());
+    p->vdwSequentialChunkRemaining.clear();
+    p->vdwSequentialChunkRemaining.resize(p->vTargets.size());
+    p->vdwWritesSinceFlush.clear();
+    p->vdwWritesSinceFlush.resize(p->vTargets.size());
+    p->vvullUnflushedWriteStartTimes.clear();
+    p->vvullUnflushedWriteStartTimes.resize(p->vTargets.size());
     p->pResults->vTargetResults.clear();
     p->pResults->vTargetResults.resize(p->vTargets.size());
     for (size_t i = 0; i < p->vullFileSizes.size(); i++)
     {
         p->pResults->vTargetResults[i].sPath = p->vTargets[i].GetPath();
         p->pResults->vTargetResults[i].ullFileSize = p->vullFileSizes[i];
+        p->pResults->vTargetResults[i].dwThroughputBytesPerMillisecond = p->vTargets[i].GetThroughputInBytesPerMillisecond();
+        p->pResults->vTargetResults[i].dwTotalThroughputBytesPerMillisecond = p->vTargets[i].GetTotalThroughputInBytesPerMillisecond();
         if(fCalculateIopsStdDev) 
         {
             p->pResults->vTargetResults[i].readBucketizer.Initialize(ioBucketDuration, expectedNumberOfBuckets);
             p->pResults->vTargetResults[i].writeBucketizer.Initialize(ioBucketDuration, expectedNumberOfBuckets);
+            p->pResults->vTargetResults[i].discardBucketizer.Initialize(ioBucketDuration, expectedNumberOfBuckets);
+        }
+        if (p->vTargets[i].GetVerify() && !p->pBlockVerifiers[i].Track(p->vullFileSizes[i]))
+        {
+            PrintError("FATAL ERROR: Could not allocate the block map to verify '%s'. Error code: 0x%x\n", p->vTargets[i].GetPath().c_str(), GetLastError());
+            fOk = false;
+            goto cleanup;
         }
     }
 
@@ -1469,7 +3072,7 @@ DWORD WINAPI threadFunc(LPVOID cookie)
             li.QuadPart,
             li.QuadPart / pTarget->GetBlockSizeInBytes());
         //FUTURE EXTENSION: file pointer should be set through OVERLAPPED stucture for consistency with other scenarios (unless this is suspected to be the common way in real scenarios)
-        if (!SetFilePointerEx(p->vhTargets[0], li, NULL, FILE_BEGIN))
+        if ((pTarget->GetFileCount() == 0) && !SetFilePointerEx(p->vhTargets[0], li, NULL, FILE_BEGIN))
         {
             PrintError("Error setting file pointer. Error code: %d.\n", GetLastError());
             fOk = false;
@@ -1482,6 +3085,7 @@ DWORD WINAPI threadFunc(LPVOID cookie)
 
         //wait for a signal to start
         printfv(p->pProfile->GetVerbose(), "thread %u: waiting for a signal to start\n", p->ulThreadNo);
+        InterlockedIncrement(&g_lReadyThreadsCount);
         if (WAIT_FAILED == WaitForSingleObject(p->hStartEvent, INFINITE))
         {
             PrintError("Waiting for a signal to start failed (error code: %u)\n", GetLastError());
@@ -1498,6 +3102,20 @@ DWORD WINAPI threadFunc(LPVOID cookie)
             goto cleanup;
         }
 
+        if (pTarget->GetLogClients() > 0)
+        {
+            // group-commit log writer (-M); the profile ensures a single synchronous target
+            fOk = doWorkUsingLogWriter(p, li.QuadPart);
+            goto cleanup;
+        }
+
+        if (pTarget->GetFileCount() > 0)
+        {
+            // small-file workload (-m); the handle is on the directory of the population
+            fOk = doWorkUsingFileOperations(p);
+            goto cleanup;
+        }
+
         //
         // perform work
         //
@@ -1506,7 +3124,8 @@ DWORD WINAPI threadFunc(LPVOID cookie)
         assert(pTarget->GetBlockSizeInBytes() > 0);
 
         ThroughputMeter throughputMeter;
-        DWORD dwSleepTime;
+        PreciseSleeper sleeper;
+        UINT64 ullDelay;
 
         DWORD dwBurstSize = pTarget->GetBurstSize();
         if (p->pTimeSpan->GetThreadCount() > 0)
@@ -1519,42 +3138,104 @@ DWORD WINAPI threadFunc(LPVOID cookie)
         }
         throughputMeter.Start(pTarget->GetThroughputInBytesPerMillisecond(), pTarget->GetBlockSizeInBytes(), pTarget->GetThinkTime(), dwBurstSize);
 
+        ArrivalScheduler arrivalScheduler;
+        if (pTarget->GetArrivalRate() > 0)
+        {
+            arrivalScheduler.Start(static_cast<double>(pTarget->GetArrivalRate()) / getTargetThreadCount(p, pTarget),
+                pTarget->GetPoissonArrivals(),
+                p->ulRandSeed);
+        }
+
+        vector<UINT64> vullNextBurstTimes;
+        startDiscardBursts(p, vullNextBurstTimes);
+
         while(g_bRun && !g_bThreadError)
         {
+            if (!doDiscardBursts(p, vullNextBurstTimes))
+            {
+                fOk = false;
+                goto cleanup;
+            }
+
             if (throughputMeter.IsRunning())
             {
-                dwSleepTime = throughputMeter.GetSleepTime();
-                if (0 != dwSleepTime)
+                ullDelay = throughputMeter.GetDelay(PerfTimer::GetTime());
+                if (0 != ullDelay)
+                {
+                    sleeper.Wait(ullDelay);
+                    continue;
+                }
+            }
+
+            if (p->pSharedThroughputMeters[0].IsRunning())
+            {
+                ullDelay = p->pSharedThroughputMeters[0].TryAcquire(PerfTimer::GetTime(), pTarget->GetBlockSizeInBytes());
+                if (0 != ullDelay)
+                {
+                    sleeper.Wait(ullDelay);
+                    continue;
+                }
+            }
+
+            UINT64 ullIntendedTime = 0;
+            if (arrivalScheduler.IsRunning())
+            {
+                UINT64 ullNow = PerfTimer::GetTime();
+                if (ullNow < arrivalScheduler.GetNextArrivalTime())
                 {
-                    Sleep(dwSleepTime);
+                    sleeper.Wait(arrivalScheduler.GetDelay(ullNow));
                     continue;
                 }
+
+                UINT64 ullBacklog;
+                ullIntendedTime = arrivalScheduler.TakeArrival(ullNow, &ullBacklog);
+                if (isAccountingOn(p))
+                {
+                    p->pResults->vTargetResults[0].AddArrival(ullIntendedTime, ullNow, ullBacklog);
+                }
             }
 
             //start read or write operation (depends of the type of test)
             //first access is always performed on base offset (even in case of random access)
 
+            if (DecideByPercentage(pTarget->GetFlushPercentage()) && !flushTarget(p, 0, fMeasureLatency))
+            {
+                fOk = false;
+                goto cleanup;
+            }
+
             UINT64 ullStartTime = 0;
 
-            if (fMeasureLatency)
+            if (fRecordStartTime)
             {
-                ullStartTime = PerfTimer::GetTime(); // record IO start time 
+                ullStartTime = (ullIntendedTime != 0) ? ullIntendedTime : PerfTimer::GetTime(); // record IO start time 
             }
 
             IOOperation readOrWrite;
-            readOrWrite = DecideIo(pTarget->GetWriteRatio());
+            readOrWrite = DecideByPercentage(pTarget->GetDiscardPercentage()) ? IOOperation::DiscardIO : DecideIo(pTarget->GetWriteRatio());
+            UINT64 ullVerifySnapshot = 0;
+            if (pTarget->GetVerify())
+            {
+                verifyBeforeIo(p, 0, readOrWrite, li.QuadPart, p->GetWriteBuffer(0, 0), &ullVerifySnapshot);
+            }
+
             if (readOrWrite == IOOperation::ReadIO) 
             {
                 rslt = ReadFile(p->vhTargets[0], p->GetReadBuffer(0, 0), pTarget->GetBlockSizeInBytes(), &dwBytesTransferred, nullptr);
             }
-            else
+            else if (readOrWrite == IOOperation::WriteIO)
             {
                 rslt = WriteFile(p->vhTargets[0], p->GetWriteBuffer(0, 0), pTarget->GetBlockSizeInBytes(), &dwBytesTransferred, nullptr);
             }
+            else
+            {
+                rslt = issueDiscard(p, 0, li.QuadPart, pTarget->GetBlockSizeInBytes(), nullptr);
+                dwBytesTransferred = pTarget->GetBlockSizeInBytes();
+            }
 
             if (!rslt)
             {
-                PrintError("t[%u:%u] error during %s error code: %u)\n", p->ulThreadNo, 0, (readOrWrite == IOOperation::ReadIO ? "read" : "write"), GetLastError()); 
+                PrintError("t[%u:%u] error during %s error code: %u)\n", p->ulThreadNo, 0, getIoName(readOrWrite), GetLastError()); 
                 fOk = false;
                 goto cleanup;
             }
@@ -1565,19 +3246,61 @@ DWORD WINAPI threadFunc(LPVOID cookie)
                 PrintError("Warning: thread %u transfered %u bytes instead of %u bytes\n", p->ulThreadNo, dwBytesTransferred, pTarget->GetBlockSizeInBytes());
             }
 
+            if (pTarget->GetVerify())
+            {
+                verifyAfterIo(p, 0, readOrWrite, li.QuadPart, p->GetReadBuffer(0, 0), ullVerifySnapshot);
+            }
+
             if (throughputMeter.IsRunning())
             {
                 throughputMeter.Adjust(pTarget->GetBlockSizeInBytes());
+                if (*p->pfAccountingOn && (throughputMeter.GetLastIssueInterval() != 0))
+                {
+                    p->pResults->vTargetResults[0].AddIssueInterval(throughputMeter.GetLastIssueInterval());
+                }
             }
 
-            if (*p->pfAccountingOn)
+            if (isAccountingOn(p))
             {
-                p->pResults->vTargetResults[0].Add(dwBytesTransferred,
-                    readOrWrite,
-                    &ullStartTime,
-                    p->pullStartTime,
-                    fMeasureLatency,
-                    fCalculateIopsStdDev);
+                if (readOrWrite == IOOperation::DiscardIO)
+                {
+                    p->pResults->vTargetResults[0].AddDiscard(dwBytesTransferred,
+                        ullStartTime,
+                        *p->pullStartTime,
+                        false,
+                        fMeasureLatency,
+                        fCalculateIopsStdDev);
+                }
+                else
+                {
+                    p->pResults->vTargetResults[0].Add(dwBytesTransferred,
+                        readOrWrite,
+                        &ullStartTime,
+                        p->pullStartTime,
+                        fMeasureLatency,
+                        fCalculateIopsStdDev);
+                }
+
+                if (nullptr != p->pTrace)
+                {
+                    p->pTrace->Add(li.QuadPart,
+                        dwBytesTransferred,
+                        0,
+                        static_cast<BYTE>(readOrWrite),
+                        ullStartTime - *p->pullStartTime,
+                        PerfTimer::GetTime() - *p->pullStartTime);
+                }
+            }
+            else
+            {
+                countWarmupIo(p, ullStartTime, fMeasureLatency);
+            }
+
+            if ((readOrWrite == IOOperation::WriteIO) &&
+                !completeWrite(p, 0, ullStartTime, fMeasureLatency))
+            {
+                fOk = false;
+                goto cleanup;
             }
 
             // check if we should print a progress dot
@@ -1614,9 +3337,9 @@ DWORD WINAPI threadFunc(LPVOID cookie)
     else
     {
         //
-        // create IO completion port
+        // create IO completion port (a re-armed thread keeps the one created for its first TimeSpan)
         //
-        for (unsigned int i = 0; i < p->vTargets.size(); i++)
+        for (unsigned int i = 0; (i < p->vTargets.size()) && (nullptr == *phCompletionPort); i++)
         {
             if (!p->pTimeSpan->GetCompletionRoutines())
             {
@@ -1631,29 +3354,29 @@ DWORD WINAPI threadFunc(LPVOID cookie)
         }
 
         //
-        // fill the OVERLAPPED structures
+        // fill the IO requests
         //
         
-        UINT32 cOverlapped = p->GetTotalRequestCount();
+        UINT32 cIORequests = p->GetTotalRequestCount();
         
-        p->vOverlapped.clear();
-        p->vOverlapped.resize(cOverlapped);
+        if ((nullptr == p->pIORequests) && !p->AllocateIORequests(cIORequests))
+        {
+            PrintError("FATAL ERROR: Could not allocate memory for %u IO requests. Error code: 0x%x\n", cIORequests, GetLastError());
+            fOk = false;
+            goto cleanup;
+        }
 
-        p->vdwIoType.clear();
-        p->vdwIoType.resize(cOverlapped);
-    
-        p->vIoStartTimes.clear();
-        p->vIoStartTimes.resize(cOverlapped);
+        p->vIoSubmitEndTimes.clear();
+        p->vIoSubmitEndTimes.resize(cIORequests);
+        p->vullVerifySnapshots.clear();
+        p->vullVerifySnapshots.resize(cIORequests);
 
-        p->vFirstOverlappedIdForTargetId.clear();
-        
-        UINT32 iOverlapped = 0;
+        UINT32 iIORequest = 0;
         for (unsigned int iFile = 0; iFile < p->vTargets.size(); iFile++)
         {
             Target *pTarget = &p->vTargets[iFile];
             
             li.QuadPart = IORequestGenerator::GetStartingFileOffset(*p, iFile);
-            p->vFirstOverlappedIdForTargetId.push_back(iOverlapped);
 
             for (DWORD iRequest = 0; iRequest < pTarget->GetRequestCount(); ++iRequest)
             {
@@ -1664,16 +3387,19 @@ DWORD WINAPI threadFunc(LPVOID cookie)
                     li.QuadPart = IORequestGenerator::GetNextFileOffset(*p, iFile, li.QuadPart);
                 }
 
-                p->vOverlappedIdToTargetId.push_back(iFile);
+                IORequest *pIORequest = &p->pIORequests[iIORequest];
+                pIORequest->iTarget = iFile;
+                pIORequest->pReadBuffer = p->GetReadBuffer(iFile, iRequest);
+                pIORequest->pWriteBuffer = p->GetWriteBuffer(iFile, iRequest);
                 if (!p->pTimeSpan->GetCompletionRoutines())
                 {
-                    p->vOverlapped[iOverlapped].hEvent = nullptr;    //we don't need event, because we use IO completion port
+                    pIORequest->overlapped.hEvent = nullptr;    //we don't need event, because we use IO completion port
                 }
                 else
                 {
                     //in case of completion routines hEvent field is not used,
                     //so we can use it to pass a pointer to the thread parameters
-                    p->vOverlapped[iOverlapped].hEvent = (HANDLE)p;
+                    pIORequest->overlapped.hEvent = (HANDLE)p;
                 }
 
                 printfv(p->pProfile->GetVerbose(), "t[%u:%u] initial I/O op at %I64u (starting in block: %I64u)\n",
@@ -1682,10 +3408,10 @@ DWORD WINAPI threadFunc(LPVOID cookie)
                     li.QuadPart,
                     li.QuadPart / pTarget->GetBlockSizeInBytes());
 
-                p->vOverlapped[iOverlapped].Offset = li.LowPart;
-                p->vOverlapped[iOverlapped].OffsetHigh = li.HighPart;
+                pIORequest->overlapped.Offset = li.LowPart;
+                pIORequest->overlapped.OffsetHigh = li.HighPart;
 
-                ++iOverlapped;
+                ++iIORequest;
             }
         }
 
@@ -1693,6 +3419,7 @@ DWORD WINAPI threadFunc(LPVOID cookie)
         // wait for a signal to start
         //
         printfv(p->pProfile->GetVerbose(), "thread %u: waiting for a signal to start\n", p->ulThreadNo);
+        InterlockedIncrement(&g_lReadyThreadsCount);
         if( WAIT_FAILED == WaitForSingleObject(p->hStartEvent, INFINITE) )
         {
             PrintError("Waiting for a signal to start failed (error code: %u)\n", GetLastError());
@@ -1709,7 +3436,16 @@ DWORD WINAPI threadFunc(LPVOID cookie)
         }
 
         //error handling and memory freeing is done in doWorkUsingIOCompletionPorts and doWorkUsingCompletionRoutines
-        if (!p->pTimeSpan->GetCompletionRoutines())
+        if (nullptr != p->pReplay)
+        {
+            // replay a trace (-Y); the profile ensures completion ports are in use
+            if (!doWorkUsingReplay(p, hCompletionPort))
+            {
+                fOk = false;
+                goto cleanup;
+            }
+        }
+        else if (!p->pTimeSpan->GetCompletionRoutines())
         {
             // use IO Completion Ports (it will also close the I/O completion port)
             if (!doWorkUsingIOCompletionPorts(p, hCompletionPort))
@@ -1731,42 +3467,9 @@ DWORD WINAPI threadFunc(LPVOID cookie)
         assert(!g_bError);  // at this point we shouldn't be seeing initialization error
     } // end of overlapped IO operations
 
-    // save results
-
 cleanup:
-    if (!fOk)
-    {
-        g_bThreadError = TRUE;
-    }
-
-    // free memory allocated with VirtualAlloc
-    for (auto i = p->vpDataBuffers.begin(); i != p->vpDataBuffers.end(); i++)
-    {
-        if (nullptr != *i)
-        {
-#pragma prefast(suppress:6001, "Prefast does not understand this vector will only contain validly allocated buffer pointers")
-            VirtualFree(*i, 0, MEM_RELEASE);
-        }
-    }
-
-    // close files
-    for (auto i = p->vhTargets.begin(); i != p->vhTargets.end(); i++)
-    {
-        CloseHandle(*i);
-    }
-
-    // close completion ports
-    if (hCompletionPort != nullptr)
-    {
-        CloseHandle(hCompletionPort);
-    }
-
-    delete p;
-
-    // notify master thread that we've finished
-    InterlockedDecrement(&g_lRunningThreadsCount);
-
-    return fOk ? 1 : 0;
+    *phCompletionPort = hCompletionPort;
+    return fOk;
 }
 
 /*****************************************************************************/
@@ -1833,6 +3536,92 @@ DWORD IORequestGenerator::_CreateDirectoryPath(const char *pszPath) const
     return ERROR_SUCCESS;
 }
 
+/*****************************************************************************/
+// create the files of the small-file population (-m) which do not exist yet, with
+// their directory and subdirectories
+//
+bool IORequestGenerator::_CreateFilePopulation(const Target& target, bool fVerbose) const
+{
+    printfv(fVerbose, "Populating '%s' with %u files of %I64u to %I64u bytes.\n",
+        target.GetPath().c_str(),
+        target.GetFileCount(),
+        target.GetMinPopulationFileSize(),
+        target.GetMaxPopulationFileSize());
+
+    // intermediate directories of absolute paths, then the directory itself
+    string sDirectory(target.GetPath());
+    DWORD dwError = _CreateDirectoryPath(getPopulationFilePath(target, 0).c_str());
+    if ((dwError != ERROR_SUCCESS) && (dwError != ERROR_NOT_SUPPORTED))
+    {
+        PrintError("Could not create the directory of the file population (error code: %u)\n", dwError);
+        return false;
+    }
+    if (!CreateDirectory(sDirectory.c_str(), nullptr) && (GetLastError() != ERROR_ALREADY_EXISTS))
+    {
+        PrintError("Could not create the directory %s (error code: %u)\n", sDirectory.c_str(), GetLastError());
+        return false;
+    }
+
+    vector<BYTE> vBuffer(static_cast<size_t>(min(target.GetMaxPopulationFileSize(), (UINT64)(1024 * 1024))));
+    for (size_t i = 0; i < vBuffer.size(); i++)
+    {
+        vBuffer[i] = target.GetZeroWriteBuffers() ? 0 : (BYTE)(i & 0xFF);
+    }
+
+    DWORD cCreated = 0;
+    for (DWORD iFile = 0; iFile < target.GetFileCount(); iFile++)
+    {
+        string sFile = getPopulationFilePath(target, iFile);
+        if (iFile % target.GetFilesPerDirectory() == 0)
+        {
+            string sSubdirectory = sFile.substr(0, sFile.rfind('\\'));
+            if (!CreateDirectory(sSubdirectory.c_str(), nullptr) && (GetLastError() != ERROR_ALREADY_EXISTS))
+            {
+                PrintError("Could not create the directory %s (error code: %u)\n", sSubdirectory.c_str(), GetLastError());
+                return false;
+            }
+        }
+
+        if (GetFileAttributes(sFile.c_str()) != INVALID_FILE_ATTRIBUTES)
+        {
+            continue;
+        }
+
+        HANDLE hFile = CreateFile(sFile.c_str(),
+                                  GENERIC_WRITE,
+                                  0,
+                                  nullptr,                  //security
+                                  CREATE_NEW,
+                                  FILE_ATTRIBUTE_NORMAL,    //flags
+                                  nullptr);                 //template file
+        if (INVALID_HANDLE_VALUE == hFile)
+        {
+            PrintError("Could not create the file %s (error code: %u)\n", sFile.c_str(), GetLastError());
+            return false;
+        }
+
+        UINT64 ullRemainSize = getPopulationFileSize(target, iFile);
+        while (ullRemainSize > 0)
+        {
+            DWORD cbWrite = static_cast<DWORD>(min(ullRemainSize, (UINT64)vBuffer.size()));
+            DWORD dwBytesWritten;
+            if (!WriteFile(hFile, &vBuffer[0], cbWrite, &dwBytesWritten, nullptr) || (dwBytesWritten != cbWrite))
+            {
+                PrintError("Error while writing the file %s (error code: %u)\n", sFile.c_str(), GetLastError());
+                CloseHandle(hFile);
+                return false;
+            }
+            ullRemainSize -= cbWrite;
+        }
+
+        CloseHandle(hFile);
+        cCreated++;
+    }
+
+    printfv(fVerbose, "%u files created, %u already in place.\n", cCreated, target.GetFileCount() - cCreated);
+    return true;
+}
+
 /*****************************************************************************/
 // create a file of the given size
 //
@@ -2014,118 +3803,491 @@ void IORequestGenerator::_AbortWorkerThreads(HANDLE hStartEvent, vector<HANDLE>&
         //FUTURE EXTENSION: maximal timeout may be added here (and below)
         while (g_lRunningThreadsCount > 0)
         {
-            Sleep(100);
+            Sleep(100);
+        }
+    }
+}
+
+/*****************************************************************************/
+// true if a thread set up for target a (opened with the same flags, with buffers of the
+// same size and content) can run target b without reopening or reallocating anything
+//
+static bool isSameTargetSetup(const Target& a, const Target& b)
+{
+    return (a.GetPath() == b.GetPath()) &&
+        (a.GetThreadsPerFile() == b.GetThreadsPerFile()) &&
+        (a.GetBlockSizeInBytes() == b.GetBlockSizeInBytes()) &&
+        (a.GetRequestCount() == b.GetRequestCount()) &&
+        (a.GetMaxFileSize() == b.GetMaxFileSize()) &&
+        ((a.GetWriteRatio() == 0) == (b.GetWriteRatio() == 0)) &&
+        ((a.GetWriteRatio() == 100) == (b.GetWriteRatio() == 100)) &&
+        (a.GetUseDiscards() == b.GetUseDiscards()) &&
+        (a.GetZeroWriteBuffers() == b.GetZeroWriteBuffers()) &&
+        (a.GetSequentialScanHint() == b.GetSequentialScanHint()) &&
+        (a.GetRandomAccessHint() == b.GetRandomAccessHint()) &&
+        (a.GetDisableOSCache() == b.GetDisableOSCache()) &&
+        (a.GetDisableAllCache() == b.GetDisableAllCache()) &&
+        (a.GetWriteThrough() == b.GetWriteThrough()) &&
+        (a.GetIOPriorityHint() == b.GetIOPriorityHint()) &&
+        (a.GetUseLargePages() == b.GetUseLargePages()) &&
+        (a.GetFileCount() == b.GetFileCount()) &&
+        (a.GetFilesPerDirectory() == b.GetFilesPerDirectory());
+}
+
+/*****************************************************************************/
+// checks if the threads parked after the previous TimeSpan can be re-armed with this one;
+// a repeated pass of the same TimeSpan keeps the targets it created in its first pass
+//
+bool IORequestGenerator::_CanReuseWorkers(const TimeSpan& timeSpan, bool fRepeatedPass) const
+{
+    if ((nullptr == _pWorkersTimeSpan) || _vhWorkers.empty())
+    {
+        return false;
+    }
+
+    const TimeSpan& prevTimeSpan = *_pWorkersTimeSpan;
+    if ((timeSpan.GetThreadCount() != prevTimeSpan.GetThreadCount()) ||
+        !timeSpan.GetReplayFile().empty() ||
+        !prevTimeSpan.GetReplayFile().empty() ||
+        (timeSpan.GetCompletionRoutines() != prevTimeSpan.GetCompletionRoutines()) ||
+        (timeSpan.GetDisableAffinity() != prevTimeSpan.GetDisableAffinity()) ||
+        (timeSpan.GetGroupAffinity() != prevTimeSpan.GetGroupAffinity()) ||
+        (timeSpan.GetAffinityAssignments() != prevTimeSpan.GetAffinityAssignments()))
+    {
+        return false;
+    }
+
+    vector<Target> vTargets(timeSpan.GetTargets());
+    vector<Target> vPrevTargets(prevTimeSpan.GetTargets());
+    if (vTargets.size() != vPrevTargets.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < vTargets.size(); i++)
+    {
+        // a target created by the TimeSpan itself cannot stay open across it
+        if (!isSameTargetSetup(vTargets[i], vPrevTargets[i]) ||
+            ((vTargets[i].GetFileSize() > 0) && !vTargets[i].GetPrecreated() && !fRepeatedPass))
+        {
+            return false;
+        }
+    }
+
+    // all the threads have to be parked rather than exited
+    for (const auto& hThread : _vhWorkers)
+    {
+        if ((nullptr == hThread) || (WAIT_TIMEOUT != WaitForSingleObject(hThread, 0)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*****************************************************************************/
+// retires the parked threads and frees their parameters
+//
+void IORequestGenerator::_ReleaseWorkers()
+{
+    g_bRun = FALSE;
+    for (auto pWorker : _vpWorkers)
+    {
+        pWorker->fRetire = true;
+        if (nullptr != pWorker->hEndEvent)
+        {
+            SetEvent(pWorker->hEndEvent);
+        }
+        if (nullptr != pWorker->hRearmEvent)
+        {
+            SetEvent(pWorker->hRearmEvent);
+        }
+    }
+
+    for (size_t i = 0; i < _vpWorkers.size(); i++)
+    {
+        if ((i < _vhWorkers.size()) && (nullptr != _vhWorkers[i]))
+        {
+            WaitForSingleObject(_vhWorkers[i], INFINITE);
+            CloseHandle(_vhWorkers[i]);
+        }
+        if (nullptr != _vpWorkers[i]->hRearmEvent)
+        {
+            CloseHandle(_vpWorkers[i]->hRearmEvent);
+        }
+        delete _vpWorkers[i];
+    }
+
+    _vpWorkers.clear();
+    _vhWorkers.clear();
+    _pWorkersTimeSpan = nullptr;
+}
+
+/*****************************************************************************/
+bool IORequestGenerator::_StopETW(bool fUseETW, TRACEHANDLE hTraceSession) const
+{
+    bool fOk = true;
+    if (fUseETW)
+    {
+        PEVENT_TRACE_PROPERTIES pETWSession = StopETWSession(hTraceSession);
+        if (nullptr == pETWSession)
+        {
+            PrintError("Error stopping ETW session\n");
+            fOk = false;
+        }
+        else
+        {
+            free(pETWSession);
+        }
+    }
+    return fOk;
+}
+
+/*****************************************************************************/
+// initializes all global parameters
+//
+void IORequestGenerator::_InitializeGlobalParameters()
+{
+//    g_vThreadResults.clear(); // TODO: remove
+    g_lRunningThreadsCount = 0;     //number of currently running worker threads
+    g_lReadyThreadsCount = 0;       //number of threads waiting for the start signal
+    g_ulProcCount = 0;              //number of CPUs present in the system
+    g_bRun = TRUE;                  //used for letting threads know that they should stop working
+
+    g_bThreadError = FALSE;         //true means that an error has occured in one of the threads
+    g_bTracing = FALSE;             //true means that ETW is turned on
+
+    _hNTDLL = nullptr;              //handle to ntdll.dll
+    g_bError = FALSE;               //true means there was fatal error during intialization and threads shouldn't perform their work
+
+    g_pActiveGroupsAndProcs = NULL; // structure with KGroup info
+}
+
+bool IORequestGenerator::_PrecreateFiles(Profile& profile) const
+{
+    bool fOk = true;
+    if (profile.GetPrecreateFiles() != PrecreateFiles::None)
+    {
+        vector<CreateFileParameters> vFilesToCreate = _GetFilesToPrecreate(profile);
+        vector<string> vCreatedFiles;
+        for (auto file : vFilesToCreate)
+        {
+            fOk = _CreateFile(file.ullFileSize, file.sPath.c_str(), file.fZeroWriteBuffers, profile.GetVerbose());
+            if (!fOk)
+            {
+                break;
+            }
+            vCreatedFiles.push_back(file.sPath);
+        }
+
+        if (fOk)
+        {
+            profile.MarkFilesAsPrecreated(vCreatedFiles);
+        }
+    }
+    return fOk;
+}
+
+bool IORequestGenerator::GenerateRequests(Profile& profile, IResultParser& resultParser, PRINTF pPrintOut, PRINTF pPrintError, PRINTF pPrintVerbose, struct Synchronization *pSynch, int *totalScore)
+{
+    g_pfnPrintOut = pPrintOut;
+    g_pfnPrintError = pPrintError;
+    g_pfnPrintVerbose = pPrintVerbose;
+
+    // measure the timer up front, before any worker thread competes for the CPU
+    SystemInformation system;
+    printfv(profile.GetVerbose(), "timer frequency: %I64u, call overhead: %.1fns, resolution: %.1fns\n",
+        system.ullTimerFrequency, system.fTimerOverheadNs, system.fTimerResolutionNs);
+
+    vector<Results> vResults;
+    bool fOk = GenerateRequests(profile, vResults, pPrintOut, pPrintError, pPrintVerbose, pSynch);
+
+    // no results at all means the files could not be precreated
+    if (vResults.size() > 0)
+    {
+        // TODO: show results only for timespans that succeeded
+        string sResults = resultParser.ParseResults(profile, system, vResults);
+        print("%s", sResults.c_str());
+		*totalScore = resultParser.GetTotalScore() * 10;
+    }
+
+    return fOk;
+}
+
+/*****************************************************************************/
+// same as above, but the results are streamed to the file by the writer rather than formatted
+// into a string first
+//
+bool IORequestGenerator::GenerateRequests(Profile& profile, IResultWriter& resultWriter, FILE *pFile, PRINTF pPrintOut, PRINTF pPrintError, PRINTF pPrintVerbose, struct Synchronization *pSynch, int *totalScore)
+{
+    g_pfnPrintOut = pPrintOut;
+    g_pfnPrintError = pPrintError;
+    g_pfnPrintVerbose = pPrintVerbose;
+
+    SystemInformation system;
+    printfv(profile.GetVerbose(), "timer frequency: %I64u, call overhead: %.1fns, resolution: %.1fns\n",
+        system.ullTimerFrequency, system.fTimerOverheadNs, system.fTimerResolutionNs);
+
+    vector<Results> vResults;
+    bool fOk = GenerateRequests(profile, vResults, pPrintOut, pPrintError, pPrintVerbose, pSynch);
+
+    if (vResults.size() > 0)
+    {
+        if (!resultWriter.WriteResults(profile, system, vResults, pFile))
+        {
+            PrintError("Error writing the results\n");
+            fOk = false;
+        }
+        *totalScore = resultWriter.GetTotalScore() * 10;
+    }
+
+    return fOk;
+}
+
+/*****************************************************************************/
+// runs all the TimeSpans of the profile and returns their results without formatting them;
+// used by front-ends which link the generator in rather than parse the output of diskspd
+//
+bool IORequestGenerator::GenerateRequests(Profile& profile, vector<Results>& vResults, PRINTF pPrintOut, PRINTF pPrintError, PRINTF pPrintVerbose, struct Synchronization *pSynch)
+{
+    g_pfnPrintOut = pPrintOut;
+    g_pfnPrintError = pPrintError;
+    g_pfnPrintVerbose = pPrintVerbose;
+
+    vResults.clear();
+
+    //check if I/O request generator is already running (it is released on every exit from here,
+    //so a front-end which keeps the generator loaded can run again after a failed TimeSpan)
+    LONG lGenState = InterlockedExchange(&g_lGeneratorRunning, 1);
+    if (1 == lGenState)
+    {
+        PrintError("FATAL ERROR: I/O Request Generator already running\n");
+        return false;
+    }
+
+    bool fOk = _PrecreateFiles(profile);
+    if (fOk)
+    {
+        const vector<TimeSpan>& vTimeSpans = profile.GetTimeSpans();
+        vResults.resize(vTimeSpans.size());
+        for (size_t i = 0; fOk && (i < vTimeSpans.size()); i++)
+        {
+            printfv(profile.GetVerbose(), "Generating requests for timespan %u.\n", i + 1);
+            fOk = _GenerateRequestsForTimeSpanPasses(profile, vTimeSpans[i], vResults[i], pSynch);
         }
+        _ReleaseWorkers();
     }
+
+    InterlockedExchange(&g_lGeneratorRunning, 0);
+    return fOk;
 }
 
 /*****************************************************************************/
-bool IORequestGenerator::_StopETW(bool fUseETW, TRACEHANDLE hTraceSession) const
+// waits out the warm up in rounds of the steady state interval until IOPS (and latency
+// with -L) settle or the warm up time runs out; returns WAIT_TIMEOUT to go on with the
+// measurement, WAIT_OBJECT_0 if hStopEvent was signaled and WAIT_FAILED on error
+//
+DWORD IORequestGenerator::_WaitForSteadyState(const Profile& profile, const TimeSpan& timeSpan, Results& results, HANDLE hStopEvent) const
 {
-    bool fOk = true;
-    if (fUseETW)
+    SteadyStateDetector iopsDetector(timeSpan.GetSteadyStateWindow(), timeSpan.GetSteadyStateRange(), timeSpan.GetSteadyStateSlope());
+    SteadyStateDetector latencyDetector(timeSpan.GetSteadyStateWindow(), timeSpan.GetSteadyStateRange(), timeSpan.GetSteadyStateSlope());
+    const bool fMeasureLatency = timeSpan.GetMeasureLatency();
+    const DWORD dwInterval = timeSpan.GetSteadyStateIntervalInMilliseconds();
+
+    UINT64 ullStart = PerfTimer::GetTime();
+    UINT64 ullEnd = ullStart + PerfTimer::SecondsToPerfTime(timeSpan.GetWarmup());
+    UINT64 ullPrevTime = ullStart;
+    LONG64 llPrevIOCount = 0;
+    LONG64 llPrevLatency = 0;
+    for (auto pWorker : _vpWorkers)
     {
-        PEVENT_TRACE_PROPERTIES pETWSession = StopETWSession(hTraceSession);
-        if (nullptr == pETWSession)
+        llPrevIOCount += InterlockedCompareExchange64(&pWorker->llWarmupIOCount, 0, 0);
+        llPrevLatency += InterlockedCompareExchange64(&pWorker->llWarmupLatency, 0, 0);
+    }
+
+    DWORD dwWaitStatus = WAIT_TIMEOUT;
+    UINT64 ullNow = ullStart;
+    while ((WAIT_TIMEOUT == dwWaitStatus) && (ullNow < ullEnd))
+    {
+        DWORD dwWait = static_cast<DWORD>(min(static_cast<double>(dwInterval), PerfTimer::PerfTimeToMilliseconds(ullEnd - ullNow)));
+        if (NULL != hStopEvent)
         {
-            PrintError("Error stopping ETW session\n");
-            fOk = false;
+            dwWaitStatus = WaitForSingleObject(hStopEvent, dwWait);
+            if (WAIT_TIMEOUT != dwWaitStatus)
+            {
+                break;
+            }
         }
         else
         {
-            free(pETWSession);
+            Sleep(dwWait);
+        }
+
+        // a round cut short by the end of the warm up is not one
+        ullNow = PerfTimer::GetTime();
+        if (dwWait < dwInterval)
+        {
+            break;
+        }
+
+        LONG64 llIOCount = 0;
+        LONG64 llLatency = 0;
+        for (auto pWorker : _vpWorkers)
+        {
+            llIOCount += InterlockedCompareExchange64(&pWorker->llWarmupIOCount, 0, 0);
+            llLatency += InterlockedCompareExchange64(&pWorker->llWarmupLatency, 0, 0);
+        }
+
+        double fIops = (llIOCount - llPrevIOCount) / PerfTimer::PerfTimeToSeconds(ullNow - ullPrevTime);
+        bool fSteady = iopsDetector.AddRound(fIops);
+        results.vWarmupIops.push_back(fIops);
+        if (fMeasureLatency)
+        {
+            double fLatency = (llIOCount > llPrevIOCount) ? PerfTimer::PerfTimeToMicroseconds(static_cast<UINT64>(llLatency - llPrevLatency)) / (llIOCount - llPrevIOCount) : 0;
+            fSteady = latencyDetector.AddRound(fLatency) && fSteady;
+            results.vWarmupLatency.push_back(fLatency);
+        }
+
+        printfv(profile.GetVerbose(), "warm up round %u: %.2f IOPS (range %.2f%%, slope %.2f%%)\n",
+            results.vWarmupIops.size(),
+            fIops,
+            iopsDetector.GetWindowRangePercent(),
+            iopsDetector.GetWindowSlopePercent());
+
+        ullPrevTime = ullNow;
+        llPrevIOCount = llIOCount;
+        llPrevLatency = llLatency;
+
+        if (fSteady)
+        {
+            results.fSteadyStateReached = true;
+            break;
         }
     }
-    return fOk;
+
+    results.ullWarmupTime = PerfTimer::GetTime() - ullStart;
+    printfv(profile.GetVerbose(), "warm up ended after %.2fs (%s)\n",
+        PerfTimer::PerfTimeToSeconds(results.ullWarmupTime),
+        results.fSteadyStateReached ? "steady state" : "not steady");
+
+    return dwWaitStatus;
 }
 
 /*****************************************************************************/
-// initializes all global parameters
+// runs the TimeSpan as many times as -N asks for; the passes after the first one re-arm the
+// parked threads on the same targets, and the run stops early once the 95% confidence interval
+// of the throughput is within the tolerance. The median pass (by throughput) is reported
 //
-void IORequestGenerator::_InitializeGlobalParameters()
+bool IORequestGenerator::_GenerateRequestsForTimeSpanPasses(const Profile& profile, const TimeSpan& timeSpan, Results& results, struct Synchronization *pSynch)
 {
-//    g_vThreadResults.clear(); // TODO: remove
-    g_lRunningThreadsCount = 0;     //number of currently running worker threads
-    g_ulProcCount = 0;              //number of CPUs present in the system
-    g_bRun = TRUE;                  //used for letting threads know that they should stop working
-
-    g_bThreadError = FALSE;         //true means that an error has occured in one of the threads
-    g_bTracing = FALSE;             //true means that ETW is turned on
+    const UINT32 ulPassCount = timeSpan.GetPassCount();
+    if (ulPassCount <= 1)
+    {
+        return _GenerateRequestsForTimeSpan(profile, timeSpan, results, pSynch, false);
+    }
 
-    _hNTDLL = nullptr;              //handle to ntdll.dll
-    g_bError = FALSE;               //true means there was fatal error during intialization and threads shouldn't perform their work
+    const UINT32 ulMinPassCount = min(timeSpan.GetMinPassCount(), ulPassCount);
+    const bool fSynchStop = STRUCT_SYNCHRONIZATION_SUPPORTS(pSynch, hStopEvent) && (NULL != pSynch->hStopEvent);
 
-    g_pActiveGroupsAndProcs = NULL; // structure with KGroup info
-}
+    vector<Results> vPassResults;
+    vector<double> vBytesPerSecond;
+    vector<double> vIops;
+    vPassResults.reserve(ulPassCount);
 
-bool IORequestGenerator::_PrecreateFiles(Profile& profile) const
-{
     bool fOk = true;
-    if (profile.GetPrecreateFiles() != PrecreateFiles::None)
+    for (UINT32 iPass = 0; iPass < ulPassCount; iPass++)
     {
-        vector<CreateFileParameters> vFilesToCreate = _GetFilesToPrecreate(profile);
-        vector<string> vCreatedFiles;
-        for (auto file : vFilesToCreate)
+        vPassResults.resize(iPass + 1);
+        Results& passResults = vPassResults[iPass];
+        fOk = _GenerateRequestsForTimeSpan(profile, timeSpan, passResults, pSynch, (iPass > 0));
+        if (!fOk)
         {
-            fOk = _CreateFile(file.ullFileSize, file.sPath.c_str(), file.fZeroWriteBuffers, profile.GetVerbose());
-            if (!fOk)
+            vPassResults.pop_back();
+            break;
+        }
+
+        // throughput of the pass, from the window each thread measured on its own
+        double fBytesPerSecond = 0;
+        double fIops = 0;
+        for (size_t iThread = 0; iThread < passResults.vThreadResults.size(); iThread++)
+        {
+            double fTime = passResults.GetThreadTimeInSeconds(iThread);
+            if (fTime <= 0)
             {
-                break;
+                continue;
+            }
+
+            for (const auto& targetResults : passResults.vThreadResults[iThread].vTargetResults)
+            {
+                fBytesPerSecond += targetResults.ullBytesCount / fTime;
+                fIops += targetResults.ullIOCount / fTime;
             }
-            vCreatedFiles.push_back(file.sPath);
         }
+        vBytesPerSecond.push_back(fBytesPerSecond);
+        vIops.push_back(fIops);
 
-        if (fOk)
+        PassStatistics stats(vBytesPerSecond);
+        printfv(profile.GetVerbose(), "pass %u: %.2f MiB/s, %.2f IOPS (95%% CI +/- %.2f%%)\n",
+            iPass + 1,
+            fBytesPerSecond / (1024 * 1024),
+            fIops,
+            stats.GetRelativeConfidenceInterval());
+
+        if (fSynchStop && (WAIT_OBJECT_0 == WaitForSingleObject(pSynch->hStopEvent, 0)))
         {
-            profile.MarkFilesAsPrecreated(vCreatedFiles);
+            break;
+        }
+
+        if ((iPass + 1 >= ulMinPassCount) &&
+            (timeSpan.GetPassTolerance() > 0) &&
+            (stats.GetRelativeConfidenceInterval() <= timeSpan.GetPassTolerance()))
+        {
+            printfv(profile.GetVerbose(), "confidence interval within %.2f%% after %u passes\n", timeSpan.GetPassTolerance(), iPass + 1);
+            break;
         }
     }
-    return fOk;
-}
 
-bool IORequestGenerator::GenerateRequests(Profile& profile, IResultParser& resultParser, PRINTF pPrintOut, PRINTF pPrintError, PRINTF pPrintVerbose, struct Synchronization *pSynch, int *totalScore)
-{
-    g_pfnPrintOut = pPrintOut;
-    g_pfnPrintError = pPrintError;
-    g_pfnPrintVerbose = pPrintVerbose;
+    if (vPassResults.empty())
+    {
+        return fOk;
+    }
 
-    bool fOk = _PrecreateFiles(profile);
-    if (fOk)
+    // report the pass with the median throughput (the lower one of the middle two for an even count)
+    vector<size_t> vOrder(vPassResults.size());
+    for (size_t i = 0; i < vOrder.size(); i++)
     {
-        const vector<TimeSpan>& vTimeSpans = profile.GetTimeSpans();
-        vector<Results> vResults(vTimeSpans.size());
-        for (size_t i = 0; fOk && (i < vTimeSpans.size()); i++)
-        {
-            printfv(profile.GetVerbose(), "Generating requests for timespan %u.\n", i + 1);
-            fOk = _GenerateRequestsForTimeSpan(profile, vTimeSpans[i], vResults[i], pSynch);
-        }
+        vOrder[i] = i;
+    }
+    sort(vOrder.begin(), vOrder.end(), [&vBytesPerSecond](size_t a, size_t b) { return vBytesPerSecond[a] < vBytesPerSecond[b]; });
+    size_t iMedian = vOrder[(vOrder.size() - 1) / 2];
 
-        // TODO: show results only for timespans that succeeded
-        SystemInformation system;
-        string sResults = resultParser.ParseResults(profile, system, vResults);
-        print("%s", sResults.c_str());
-		*totalScore = resultParser.GetTotalScore() * 10;
+    results = std::move(vPassResults[iMedian]);
+    if (results.fTrace && (iMedian != vPassResults.size() - 1))
+    {
+        // the trace file was rewritten by every pass and holds the last one
+        const Results& lastPass = vPassResults.back();
+        results.ullTraceRecords = lastPass.ullTraceRecords;
+        results.ullTraceOverwrittenRecords = lastPass.ullTraceOverwrittenRecords;
+        results.fTraceFlushMilliseconds = lastPass.fTraceFlushMilliseconds;
     }
+    results.vPassBytesPerSecond = vBytesPerSecond;
+    results.vPassIops = vIops;
+    results.iReportedPass = iMedian;
 
     return fOk;
 }
 
-bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, const TimeSpan& timeSpan, Results& results, struct Synchronization *pSynch)
+bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, const TimeSpan& timeSpan, Results& results, struct Synchronization *pSynch, bool fRepeatedPass)
 {
     //FUTURE EXTENSION: add new I/O capabilities presented in Longhorn
     //FUTURE EXTENSION: add a check if the folder is compressed (cache is always enabled in case of compressed folders)
 
-    //check if I/O request generator is already running
-    LONG lGenState = InterlockedExchange(&g_lGeneratorRunning, 1);
-    if (1 == lGenState)
-    {
-        PrintError("FATAL ERROR: I/O Request Generator already running\n");
-        return false;
-    }
-
     //initialize all global parameters (in case of second run, after the first one is finished)
     _InitializeGlobalParameters();
 
+    UINT64 ullSetupStartTime = PerfTimer::GetTime();
+
     HANDLE hStartEvent = nullptr;                       // start event (used to inform the worker threads that they should start the work)
     HANDLE hEndEvent = nullptr;                         // end event (used only in case of completin routines (not for IO Completion Ports))
 
@@ -2169,10 +4331,18 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
         }
     }
 
-    // check if user wanted to create a file
+    // re-arm the threads parked after the previous TimeSpan if they are set up for the same targets;
+    // otherwise retire them before the targets are created and opened again
+    bool fReuseWorkers = _CanReuseWorkers(timeSpan, fRepeatedPass);
+    if (!fReuseWorkers)
+    {
+        _ReleaseWorkers();
+    }
+
+    // check if user wanted to create a file (a repeated pass runs on the files of the first one)
     for (auto i = vTargets.begin(); i != vTargets.end(); i++)
     {
-        if ((i->GetFileSize() > 0) && (i->GetPrecreated() == false))
+        if ((i->GetFileSize() > 0) && (i->GetPrecreated() == false) && !fRepeatedPass)
         {
             string str = i->GetPath();
             const char *filename = str.c_str();
@@ -2196,6 +4366,16 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
         }
     }
 
+    // populate the directories of the small-file workload; this runs before every pass to
+    // bring back the files deleted by the previous one
+    for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+    {
+        if ((i->GetFileCount() > 0) && !_CreateFilePopulation(*i, profile.GetVerbose()))
+        {
+            return false;
+        }
+    }
+
     // get thread count
     UINT32 cThreads = timeSpan.GetThreadCount();
     if (cThreads < 1)
@@ -2206,8 +4386,13 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
         }
     }
 
-    // allocate memory for thread handles
-    vector<HANDLE> vhThreads(cThreads);
+    // allocate memory for thread handles (kept in the worker pool)
+    if (!fReuseWorkers)
+    {
+        _vhWorkers.assign(cThreads, nullptr);
+    }
+    vector<HANDLE>& vhThreads = _vhWorkers;
+    _pWorkersTimeSpan = &timeSpan;
 
     //
     // allocate memory for performance counters
@@ -2215,6 +4400,109 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
     vector<SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION> vPerfInit(g_ulProcCount);
     vector<SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION> vPerfDone(g_ulProcCount);
     vector<SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION> vPerfDiff(g_ulProcCount);
+    struct WorkerCounters workerCountersInit;
+    vector<UINT64> vullContextSwitchesInit;
+    vector<HANDLE> vhDevices;
+
+    //
+    // map the binary I/O trace; the n-th TimeSpan (n > 1) writes to <file>.<n>
+    //
+    IOTrace ioTrace;
+    results.fTrace = false;
+    if (!profile.GetTraceFile().empty())
+    {
+        UINT32 ulTimeSpan = static_cast<UINT32>(&timeSpan - &profile.GetTimeSpans()[0]) + 1;
+        string sTraceFile = profile.GetTraceFile();
+        if (ulTimeSpan > 1)
+        {
+            char szSuffix[16];
+            sprintf_s(szSuffix, _countof(szSuffix), ".%u", ulTimeSpan);
+            sTraceFile += szSuffix;
+        }
+
+        if (!ioTrace.Create(sTraceFile.c_str(), ulTimeSpan, cThreads, profile.GetTraceRecordsPerThread()))
+        {
+            PrintError("Error creating the trace file %s\n", sTraceFile.c_str());
+            return false;
+        }
+        results.fTrace = true;
+        results.sTraceFile = sTraceFile;
+        results.fTraceRecordNs = ioTrace.GetRecordNanoseconds();
+        printfv(profile.GetVerbose(), "tracing to %s (%u records per thread, %.1fns per record)\n",
+            sTraceFile.c_str(),
+            ioTrace.GetRecordsPerThread(),
+            results.fTraceRecordNs);
+    }
+
+    //
+    // load the trace to replay; every target must be able to take the largest I/O of the trace
+    // and each thread gets enough requests for the most I/Os the trace ever had in flight
+    //
+    IOReplay ioReplay;
+    results.fReplay = false;
+    if (!timeSpan.GetReplayFile().empty())
+    {
+        if (!ioReplay.Load(timeSpan.GetReplayFile().c_str(), timeSpan.GetReplaySpeed(), cThreads))
+        {
+            PrintError("Error reading the replay trace %s: %s\n", timeSpan.GetReplayFile().c_str(), ioReplay.GetError());
+            return false;
+        }
+
+        for (auto i = vTargets.begin(); i != vTargets.end(); i++)
+        {
+            if ((ioReplay.HasWrites() && (i->GetWriteRatio() == 0)) ||
+                (ioReplay.HasReads() && (i->GetWriteRatio() == 100)))
+            {
+                PrintError("The replay trace %s has %s; allow them on %s with -w\n",
+                    timeSpan.GetReplayFile().c_str(),
+                    (i->GetWriteRatio() == 0) ? "writes" : "reads",
+                    i->GetPath().c_str());
+                return false;
+            }
+
+            // offsets past the end wrap around, which needs room for the largest I/O
+            const string sPath(i->GetPath());
+            WIN32_FILE_ATTRIBUTE_DATA attributes;
+            bool fDevice = ('#' == sPath[0]) || ((sPath.length() == 2) && (':' == sPath[1]));
+            if (!fDevice && GetFileAttributesEx(sPath.c_str(), GetFileExInfoStandard, &attributes))
+            {
+                UINT64 ullSize = (static_cast<UINT64>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+                if (i->GetMaxFileSize() > 0)
+                {
+                    ullSize = min(ullSize, i->GetMaxFileSize());
+                }
+
+                if (ullSize <= ioReplay.GetMaxBytes())
+                {
+                    PrintError("The target %s is not larger than the largest I/O of the replay trace (%u bytes)\n",
+                        sPath.c_str(),
+                        ioReplay.GetMaxBytes());
+                    return false;
+                }
+            }
+
+            if ((i->GetRandomDataWriteBufferSize() > 0) && (i->GetRandomDataWriteBufferSize() < ioReplay.GetMaxBytes()))
+            {
+                PrintError("The write buffer of %s is smaller than the largest I/O of the replay trace (%u bytes)\n",
+                    i->GetPath().c_str(),
+                    ioReplay.GetMaxBytes());
+                return false;
+            }
+
+            i->SetBlockSizeInBytes(max(i->GetBlockSizeInBytes(), ioReplay.GetMaxBytes()));
+            i->SetRequestCount(max(max(i->GetRequestCount(), static_cast<DWORD>(ioReplay.GetMaxInFlight())), static_cast<DWORD>(2)));
+        }
+
+        results.fReplay = true;
+        results.sReplayFile = timeSpan.GetReplayFile();
+        results.fReplaySpeed = ioReplay.GetSpeed();
+        results.ullReplayOperations = ioReplay.GetOperationCount();
+        results.cReplayStreams = ioReplay.GetStreamCount();
+        printfv(profile.GetVerbose(), "replaying %llu I/Os in %u streams from %s\n",
+            ioReplay.GetOperationCount(),
+            static_cast<UINT32>(ioReplay.GetStreamCount()),
+            timeSpan.GetReplayFile().c_str());
+    }
 
     //
     //create start event
@@ -2252,18 +4540,47 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
     UINT64 ullStartTime;    //start time
     UINT64 ullTimeDiff;  //elapsed test time (in units returned by QueryPerformanceCounter)
     vector<UINT64> vullSharedSequentialOffsets(vTargets.size(), 0);
+    vector<SharedThroughputMeter> vSharedThroughputMeters(vTargets.size());
+    vector<BlockVerifier> vBlockVerifiers(vTargets.size());
+    for (size_t i = 0; i < vTargets.size(); i++)
+    {
+        vSharedThroughputMeters[i].Start(vTargets[i].GetTotalThroughputInBytesPerMillisecond(), vTargets[i].GetBlockSizeInBytes());
+        if (vTargets[i].GetVerify())
+        {
+            vBlockVerifiers[i].Start(static_cast<UINT32>(i), vTargets[i].GetBlockSizeInBytes());
+        }
+    }
 
     results.vThreadResults.clear();
     results.vThreadResults.resize(cThreads);
     for (UINT32 iThread = 0; iThread < cThreads; ++iThread)
     {
-        printfv(profile.GetVerbose(), "creating thread %u\n", iThread);
-        ThreadParameters *cookie = new ThreadParameters();  // threadFunc is going to free the memory
-        if (nullptr == cookie)
+        ThreadParameters *cookie = nullptr;
+        if (fReuseWorkers)
         {
-            PrintError("FATAL ERROR: could not allocate memory\n");
-            _AbortWorkerThreads(hStartEvent, vhThreads);
-            return false;
+            printfv(profile.GetVerbose(), "re-arming thread %u\n", iThread);
+            cookie = _vpWorkers[iThread];
+            cookie->vTargets.clear();
+        }
+        else
+        {
+            printfv(profile.GetVerbose(), "creating thread %u\n", iThread);
+            cookie = new ThreadParameters();  // the worker pool is going to free the memory
+            if (nullptr == cookie)
+            {
+                PrintError("FATAL ERROR: could not allocate memory\n");
+                _AbortWorkerThreads(hStartEvent, vhThreads);
+                return false;
+            }
+            _vpWorkers.push_back(cookie);
+
+            cookie->hRearmEvent = CreateEvent(NULL, FALSE, FALSE, nullptr);
+            if (NULL == cookie->hRearmEvent)
+            {
+                PrintError("Error creating the re-arm event\n");
+                _AbortWorkerThreads(hStartEvent, vhThreads);
+                return false;
+            }
         }
 
         UINT32 ulRelativeThreadNo = 0;
@@ -2275,6 +4592,8 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
             // relative thread number is the same as thread number.
             cookie->vTargets = vTargets;
             cookie->pullSharedSequentialOffsets = &vullSharedSequentialOffsets[0];
+            cookie->pSharedThroughputMeters = &vSharedThroughputMeters[0];
+            cookie->pBlockVerifiers = &vBlockVerifiers[0];
             ulRelativeThreadNo = iThread;
         }
         else
@@ -2282,9 +4601,11 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
             size_t cAssignedThreads = 0;
             size_t cBaseThread = 0;
             auto psi = vullSharedSequentialOffsets.begin();
+            auto pstm = vSharedThroughputMeters.begin();
+            auto pbv = vBlockVerifiers.begin();
             for (auto i = vTargets.begin();
                  i != vTargets.end();
-                 i++, psi++)
+                 i++, psi++, pstm++, pbv++)
             {
                 // per-file thread mode: groups of threads operate on individual files
                 // and receive the specific seq index for their file (note: singular).
@@ -2303,6 +4624,8 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
                 {
                     cookie->vTargets.push_back(*i);
                     cookie->pullSharedSequentialOffsets = &(*psi);
+                    cookie->pSharedThroughputMeters = &(*pstm);
+                    cookie->pBlockVerifiers = &(*pbv);
                     ulRelativeThreadNo = (iThread - cBaseThread) % i->GetThreadsPerFile();
 
                     printfv(profile.GetVerbose(), "thread %u is relative thread %u for %s\n", iThread, ulRelativeThreadNo, i->GetPath().c_str());
@@ -2320,6 +4643,10 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
         cookie->ulRelativeThreadNo = ulRelativeThreadNo;
         cookie->pfAccountingOn = &fAccountingOn;
         cookie->pullStartTime = &ullStartTime;
+        cookie->llWarmupIOCount = 0;
+        cookie->llWarmupLatency = 0;
+        cookie->pTrace = ioTrace.IsOpen() ? ioTrace.GetRing(iThread) : nullptr;
+        cookie->pReplay = ioReplay.IsLoaded() ? &ioReplay : nullptr;
         cookie->ulRandSeed = timeSpan.GetRandSeed() + iThread;  // each thread has a different random seed
 
         //Set thread group and proc affinity
@@ -2350,6 +4677,18 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
         cookie->pResults = &results.vThreadResults[iThread];
 
         InterlockedIncrement(&g_lRunningThreadsCount);
+        if (fReuseWorkers)
+        {
+            if (!SetEvent(cookie->hRearmEvent))
+            {
+                PrintError("Error signaling re-arm event\n");
+                InterlockedDecrement(&g_lRunningThreadsCount);
+                _AbortWorkerThreads(hStartEvent, vhThreads);
+                return false;
+            }
+            continue;
+        }
+
         DWORD dwThreadId;
         HANDLE hThread = CreateThread(NULL, 64 * 1024, threadFunc, cookie, 0, &dwThreadId);
         if (NULL == hThread)
@@ -2358,7 +4697,6 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
             PrintError("ERROR: unable to create thread (error code: %u)\n", GetLastError());
             InterlockedDecrement(&g_lRunningThreadsCount);
             _AbortWorkerThreads(hStartEvent, vhThreads);
-            delete cookie;
             return false;
         }
 
@@ -2375,6 +4713,33 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
     //FUTURE EXTENSION: lower priority so the worker threads will initialize (-2)
     //FUTURE EXTENSION: raise priority so this thread will run after the time end
 
+    //
+    // wait for all the threads to finish their initialization, so that the start event
+    // releases them together and none of them is still preparing while the others run
+    //
+    while ((g_lReadyThreadsCount < static_cast<LONG>(cThreads)) && !g_bThreadError)
+    {
+        Sleep(1);
+    }
+
+    if (g_bThreadError)
+    {
+        PrintError("Error during worker thread initialization\n");
+        _AbortWorkerThreads(hStartEvent, vhThreads);
+        return false;
+    }
+
+    results.ullSetupTime = PerfTimer::GetTime() - ullSetupStartTime;
+    results.fWorkersReused = fReuseWorkers;
+    results.iReportedPass = 0;
+    results.fSteadyStateReached = false;
+    results.ullWarmupTime = 0;
+    results.fWorkerCounters = false;
+    memset(&results.WorkerCounters, 0, sizeof(results.WorkerCounters));
+    printfv(profile.GetVerbose(), "setup took %.3fms (%s threads)\n",
+        PerfTimer::PerfTimeToMilliseconds(results.ullSetupTime),
+        fReuseWorkers ? "re-armed" : "new");
+
     if (STRUCT_SYNCHRONIZATION_SUPPORTS(pSynch, hStartEvent) && (NULL != pSynch->hStartEvent))
     {
         if (WAIT_OBJECT_0 != WaitForSingleObject(pSynch->hStartEvent, INFINITE))
@@ -2413,7 +4778,18 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
     //
     if (timeSpan.GetWarmup() > 0)
     {
-        if (bSynchStop)
+        if (timeSpan.GetSteadyStateWarmup())
+        {
+            dwWaitStatus = _WaitForSteadyState(profile, timeSpan, results, bSynchStop ? pSynch->hStopEvent : NULL);
+            if (WAIT_OBJECT_0 != dwWaitStatus && WAIT_TIMEOUT != dwWaitStatus)
+            {
+                PrintError("Error during WaitForSingleObject\n");
+                _TerminateWorkerThreads(vhThreads);
+                return false;
+            }
+            bBreak = (WAIT_TIMEOUT != dwWaitStatus);
+        }
+        else if (bSynchStop)
         {
             assert(NULL != pSynch->hStopEvent);
             dwWaitStatus = WaitForSingleObject(pSynch->hStopEvent, 1000 * timeSpan.GetWarmup());
@@ -2463,9 +4839,16 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
         //
         // read performance counters
         //
+        if (timeSpan.GetDeviceStatistics())
+        {
+            _OpenDevices(timeSpan, vhDevices, results.vDeviceResults, profile.GetVerbose());
+        }
+
+        results.fWorkerCounters = _GetWorkerCounters(&workerCountersInit, vullContextSwitchesInit);
         if (_GetSystemPerfInfo(&vPerfInit[0], g_ulProcCount) == FALSE)
         {
             PrintError("Error reading performance counters\n");
+            _CloseDevices(vhDevices);
             _StopETW(fUseETW, hTraceSession);
             _TerminateWorkerThreads(vhThreads);
             return false;
@@ -2483,6 +4866,7 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
             pSynch->pfnCallbackTestStarted();
         }
 
+        _SampleDevices(vhDevices, results.vDeviceResults);
         ullStartTime = PerfTimer::GetTime();
 
 #pragma warning( push )
@@ -2491,7 +4875,34 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
 #pragma warning( pop )
 
         assert(timeSpan.GetDuration() > 0);
-        if (bSynchStop)
+        if (!vhDevices.empty())
+        {
+            dwWaitStatus = _WaitAndSampleDevices(timeSpan, vhDevices, results.vDeviceResults, bSynchStop ? pSynch->hStopEvent : NULL);
+            if (WAIT_OBJECT_0 != dwWaitStatus && WAIT_TIMEOUT != dwWaitStatus)
+            {
+                PrintError("Error during WaitForSingleObject\n");
+                _CloseDevices(vhDevices);
+                _StopETW(fUseETW, hTraceSession);
+                _TerminateWorkerThreads(vhThreads);
+                return FALSE;
+            }
+            bBreak = (WAIT_TIMEOUT != dwWaitStatus);
+        }
+        else if (ioReplay.IsLoaded())
+        {
+            // the replay ends early once every thread has replayed its streams
+            HANDLE vhWait[2] = { ioReplay.GetDoneEvent(), bSynchStop ? pSynch->hStopEvent : NULL };
+            dwWaitStatus = WaitForMultipleObjects(bSynchStop ? 2 : 1, vhWait, FALSE, 1000 * timeSpan.GetDuration());
+            if (WAIT_OBJECT_0 != dwWaitStatus && WAIT_OBJECT_0 + 1 != dwWaitStatus && WAIT_TIMEOUT != dwWaitStatus)
+            {
+                PrintError("Error during WaitForMultipleObjects\n");
+                _StopETW(fUseETW, hTraceSession);
+                _TerminateWorkerThreads(vhThreads);
+                return FALSE;
+            }
+            bBreak = (WAIT_OBJECT_0 + 1 == dwWaitStatus);
+        }
+        else if (bSynchStop)
         {
             assert(NULL != pSynch->hStopEvent);
             dwWaitStatus = WaitForSingleObject(pSynch->hStopEvent, 1000 * timeSpan.GetDuration());
@@ -2514,6 +4925,9 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
         //get cycle count and perf counters
         ullTimeDiff = PerfTimer::GetTime() - ullStartTime;
 
+        _SampleDevices(vhDevices, results.vDeviceResults);
+        _CloseDevices(vhDevices);
+
         //
         // notify the front-end that the test has just finished;
         // do it after stopping timing in order not to perturb measurements
@@ -2531,6 +4945,25 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
             return false;
         }
 
+        struct WorkerCounters workerCountersDone;
+        vector<UINT64> vullContextSwitchesDone;
+        if (results.fWorkerCounters && _GetWorkerCounters(&workerCountersDone, vullContextSwitchesDone))
+        {
+            results.WorkerCounters.ullContextSwitches = workerCountersDone.ullContextSwitches - workerCountersInit.ullContextSwitches;
+            results.WorkerCounters.ullPageFaults = workerCountersDone.ullPageFaults - workerCountersInit.ullPageFaults;
+            results.WorkerCounters.ullReadOperations = workerCountersDone.ullReadOperations - workerCountersInit.ullReadOperations;
+            results.WorkerCounters.ullWriteOperations = workerCountersDone.ullWriteOperations - workerCountersInit.ullWriteOperations;
+            results.WorkerCounters.ullOtherOperations = workerCountersDone.ullOtherOperations - workerCountersInit.ullOtherOperations;
+            for (size_t iThread = 0; iThread < results.vThreadResults.size(); iThread++)
+            {
+                results.vThreadResults[iThread].ullContextSwitches = vullContextSwitchesDone[iThread] - vullContextSwitchesInit[iThread];
+            }
+        }
+        else
+        {
+            results.fWorkerCounters = false;
+        }
+
         //
         // stop etw session
         //
@@ -2609,6 +5042,18 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
         return false;
     }
 
+    if (ioTrace.IsOpen() &&
+        !ioTrace.Close(&results.ullTraceRecords, &results.ullTraceOverwrittenRecords, &results.fTraceFlushMilliseconds))
+    {
+        PrintError("Error flushing the trace file %s\n", results.sTraceFile.c_str());
+        return false;
+    }
+
+    if (ioReplay.IsLoaded())
+    {
+        results.ullReplayIssuedOperations = ioReplay.GetIssuedCount();
+    }
+
     //
     // close events' handles
     //
@@ -2620,6 +5065,13 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
         CloseHandle(hEndEvent);
         hEndEvent = NULL;
     }
+
+    // the parked threads must not keep the closed handles
+    for (auto pWorker : _vpWorkers)
+    {
+        pWorker->hStartEvent = nullptr;
+        pWorker->hEndEvent = nullptr;
+    }
     //FUTURE EXTENSION: hStartEvent and hEndEvent should be closed in case of error too
 
     //
@@ -2650,6 +5102,18 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
     results.vSystemProcessorPerfInfo = vPerfDiff;
     results.ullTimeCount = ullTimeDiff;
 
+    // threads which stopped before seeing accounting turned off end their window with the measurement;
+    // their CPU window ends now, which may include a little of the cool down
+    for (size_t iThread = 0; iThread < results.vThreadResults.size(); iThread++)
+    {
+        ThreadResults& threadResults = results.vThreadResults[iThread];
+        if ((threadResults.ullAccountingStartTime != 0) && (threadResults.ullAccountingEndTime == 0))
+        {
+            threadResults.ullAccountingEndTime = ullStartTime + ullTimeDiff;
+            threadResults.EndCpuWindow(vhThreads[iThread]);
+        }
+    }
+
     //
     // create structure containing etw results and properties
     //
@@ -2685,8 +5149,6 @@ bool IORequestGenerator::_GenerateRequestsForTimeSpan(const Profile& profile, co
         i->FreeRandomDataWriteBuffer();
     }
 
-    // TODO: this won't catch error cases, which exit early
-    InterlockedExchange(&g_lGeneratorRunning, 0);
     return true;
 }
 
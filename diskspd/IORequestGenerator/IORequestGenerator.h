@@ -44,12 +44,20 @@ class IORequestGenerator
 {
 public:
     IORequestGenerator() :
-        _hNTDLL(nullptr)
+        _hNTDLL(nullptr),
+        _pWorkersTimeSpan(nullptr)
     {
 
     }
 
+    ~IORequestGenerator()
+    {
+        _ReleaseWorkers();
+    }
+
     bool GenerateRequests(Profile& profile, IResultParser& resultParser, PRINTF pPrintOut, PRINTF pPrintError, PRINTF pPrintVerbose, struct Synchronization *pSynch, int *totalScore);
+    bool GenerateRequests(Profile& profile, IResultWriter& resultWriter, FILE *pFile, PRINTF pPrintOut, PRINTF pPrintError, PRINTF pPrintVerbose, struct Synchronization *pSynch, int *totalScore);
+    bool GenerateRequests(Profile& profile, vector<Results>& vResults, PRINTF pPrintOut, PRINTF pPrintError, PRINTF pPrintVerbose, struct Synchronization *pSynch);
     static UINT64 GetNextFileOffset(ThreadParameters& tp, size_t targetNum, UINT64 prevOffset);
     static UINT64 GetStartingFileOffset(ThreadParameters& tp, size_t targetNum);
     static UINT64 GetThreadBaseFileOffset(ThreadParameters& tp, size_t targetNum);
@@ -63,15 +71,25 @@ private:
         bool fZeroWriteBuffers;
     };
 
-    bool _GenerateRequestsForTimeSpan(const Profile& profile, const TimeSpan& timeSpan, Results& results, struct Synchronization *pSynch);
+    bool _GenerateRequestsForTimeSpan(const Profile& profile, const TimeSpan& timeSpan, Results& results, struct Synchronization *pSynch, bool fRepeatedPass);
+    bool _GenerateRequestsForTimeSpanPasses(const Profile& profile, const TimeSpan& timeSpan, Results& results, struct Synchronization *pSynch);
     void _AbortWorkerThreads(HANDLE hStartEvent, vector<HANDLE>& vhThreads) const;
+    bool _CanReuseWorkers(const TimeSpan& timeSpan, bool fRepeatedPass) const;
+    DWORD _WaitForSteadyState(const Profile& profile, const TimeSpan& timeSpan, Results& results, HANDLE hStopEvent) const;
+    void _ReleaseWorkers();
     void _CloseOpenFiles(vector<HANDLE>& vhFiles) const;
     DWORD _CreateDirectoryPath(const char *path) const;
     bool _CreateFile(UINT64 ullFileSize, const char *pszFilename, bool fZeroBuffers, bool fVerbose) const;
+    bool _CreateFilePopulation(const Target& target, bool fVerbose) const;
     void _DisplayFileSizeVerbose(bool fVerbose, UINT64 fsize) const;
     bool _GetActiveGroupsAndProcs() const;
     struct ETWSessionInfo _GetResultETWSession(const EVENT_TRACE_PROPERTIES *pTraceProperties) const;
     bool _GetSystemPerfInfo(SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION *pInfo, UINT32 uCpuCount) const;
+    bool _GetWorkerCounters(struct WorkerCounters *pCounters, vector<UINT64>& vullContextSwitches) const;
+    void _OpenDevices(const TimeSpan& timeSpan, vector<HANDLE>& vhDevices, vector<DeviceResults>& vDeviceResults, bool fVerbose) const;
+    void _SampleDevices(const vector<HANDLE>& vhDevices, vector<DeviceResults>& vDeviceResults) const;
+    DWORD _WaitAndSampleDevices(const TimeSpan& timeSpan, const vector<HANDLE>& vhDevices, vector<DeviceResults>& vDeviceResults, HANDLE hStopEvent) const;
+    void _CloseDevices(vector<HANDLE>& vhDevices) const;
     void _InitializeGlobalParameters();
     bool _LoadDLLs();
     bool _StopETW(bool fUseETW, TRACEHANDLE hTraceSession) const;
@@ -83,5 +101,10 @@ private:
 
     HINSTANCE volatile _hNTDLL;     //handle to ntdll.dll
 
+    // worker pool: threads parked between TimeSpans with their targets open and buffers allocated
+    vector<ThreadParameters *> _vpWorkers;
+    vector<HANDLE> _vhWorkers;
+    const TimeSpan *_pWorkersTimeSpan;  //TimeSpan the workers were last armed with
+
     friend class UnitTests::IORequestGeneratorUnitTests;
 };
@@ -27,53 +27,44 @@ SOFTWARE.
 
 */
 
-#include "OverlappedQueue.h"
+
+#include "IORequestRing.h"
 #include <assert.h>
 
-OverlappedQueue::OverlappedQueue(void) :
-    _pHead(nullptr),
-    _pTail(nullptr),
-    _cItems(0)
+IORequestRing::IORequestRing(UINT32 cCapacity) :
+    _ulHead(0),
+    _ulTail(0)
 {
+    UINT32 cSlots = 1;
+    while (cSlots < cCapacity)
+    {
+        cSlots <<= 1;
+    }
+    _vIndices.resize(cSlots);
+    _ulMask = cSlots - 1;
 }
 
-void OverlappedQueue::Add(OVERLAPPED *pOverlapped)
+void IORequestRing::Add(UINT32 iRequest)
 {
-    pOverlapped->Internal = NULL;
-    if (_pHead == nullptr)
-    {
-        assert(_pTail == nullptr);
-        _pHead = pOverlapped;
-    }
-    else
-    {
-        assert(_pTail != nullptr);
-        _pTail->Internal = (ULONG_PTR)pOverlapped;
-    }
-    _pTail = pOverlapped;
-    _cItems++;
+    assert(GetCount() < _vIndices.size());
+    _vIndices[_ulTail & _ulMask] = iRequest;
+    _ulTail++;
 }
 
-bool OverlappedQueue::IsEmpty(void) const
+bool IORequestRing::IsEmpty(void) const
 {
-    return (_pHead == nullptr);
+    return (_ulHead == _ulTail);
 }
 
-OVERLAPPED *OverlappedQueue::Remove(void)
+UINT32 IORequestRing::Remove(void)
 {
     assert(!IsEmpty());
-
-    OVERLAPPED *pOverlapped = _pHead;
-    _pHead = (OVERLAPPED *)pOverlapped->Internal;
-    if (_pHead == nullptr)
-    {
-        _pTail = nullptr;
-    }
-    _cItems--;
-    return pOverlapped;
+    UINT32 iRequest = _vIndices[_ulHead & _ulMask];
+    _ulHead++;
+    return iRequest;
 }
 
-size_t OverlappedQueue::GetCount() const
+size_t IORequestRing::GetCount() const
 {
-    return _cItems;
-}
\ No newline at end of file
+    return _ulTail - _ulHead;
+}
@@ -27,24 +27,30 @@ SOFTWARE.
 
 */
 
+
 #pragma once
 #include <Windows.h>
+#include <vector>
+
+using std::vector;
 
 //
-// OverlappedQueue is a simple class that implements a queue for OVERLAPPED elements
+// IORequestRing is a fixed-capacity queue of request indices, used to hold the
+// requests that are ready to be issued. The capacity is rounded up to a power of two.
 //
-class OverlappedQueue
+class IORequestRing
 {
 public:
-    OverlappedQueue(void);
+    IORequestRing(UINT32 cCapacity);
 
-    void Add(OVERLAPPED *pOverlapped);
+    void Add(UINT32 iRequest);
     bool IsEmpty(void) const;
-    OVERLAPPED * Remove(void);
+    UINT32 Remove(void);
     size_t GetCount() const;
 
 private:
-    OVERLAPPED *_pHead;
-    OVERLAPPED *_pTail;
-    size_t _cItems;
-};
\ No newline at end of file
+    vector<UINT32> _vIndices;
+    UINT32 _ulMask;
+    UINT32 _ulHead;     // total number of removed items; wraps around
+    UINT32 _ulTail;     // total number of added items; wraps around
+};
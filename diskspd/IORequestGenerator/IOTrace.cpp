@@ -0,0 +1,288 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "IOTrace.h"
+#include "Common.h"
+#include <new>
+#include <vector>
+
+IOTrace::IOTrace() :
+    _hFile(INVALID_HANDLE_VALUE),
+    _hMapping(nullptr),
+    _pView(nullptr),
+    _cbView(0),
+    _cRecordsPerThread(0),
+    _pRings(nullptr),
+    _cRings(0),
+    _fRecordNs(0)
+{
+}
+
+IOTrace::~IOTrace()
+{
+    _Release();
+}
+
+void IOTrace::_Release()
+{
+    if (nullptr != _pView)
+    {
+        UnmapViewOfFile(_pView);
+        _pView = nullptr;
+    }
+    if (nullptr != _hMapping)
+    {
+        CloseHandle(_hMapping);
+        _hMapping = nullptr;
+    }
+    if (INVALID_HANDLE_VALUE != _hFile)
+    {
+        CloseHandle(_hFile);
+        _hFile = INVALID_HANDLE_VALUE;
+    }
+    if (nullptr != _pRings)
+    {
+        VirtualFree(_pRings, 0, MEM_RELEASE);
+        _pRings = nullptr;
+    }
+    _cRings = 0;
+}
+
+/*****************************************************************************/
+// creates the trace file at its full size and maps it; every page is touched up front so
+// that the workers do not take page faults while tracing
+//
+bool IOTrace::Create(const char *pszPath, UINT32 ulTimeSpan, UINT32 cThreads, UINT32 cRecordsPerThread)
+{
+    _Release();
+
+    // the rings are indexed with a mask
+    UINT32 cRecords = 1;
+    while (cRecords < cRecordsPerThread && cRecords < 0x80000000)
+    {
+        cRecords <<= 1;
+    }
+    _cRecordsPerThread = cRecords;
+
+    const UINT64 cbSegment = sizeof(IOTraceSegmentHeader) + static_cast<UINT64>(cRecords) * sizeof(IOTraceRecord);
+    _cbView = sizeof(IOTraceFileHeader) + cbSegment * cThreads;
+
+    _hFile = CreateFileA(pszPath, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE == _hFile)
+    {
+        return false;
+    }
+
+    _hMapping = CreateFileMappingA(_hFile, NULL, PAGE_READWRITE, static_cast<DWORD>(_cbView >> 32), static_cast<DWORD>(_cbView), NULL);
+    if (nullptr == _hMapping)
+    {
+        _Release();
+        return false;
+    }
+
+    _pView = static_cast<BYTE *>(MapViewOfFile(_hMapping, FILE_MAP_WRITE, 0, 0, 0));
+    if (nullptr == _pView)
+    {
+        _Release();
+        return false;
+    }
+
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    for (UINT64 cb = 0; cb < _cbView; cb += systemInfo.dwPageSize)
+    {
+        _pView[cb] = 0;
+    }
+
+    IOTraceFileHeader *pHeader = reinterpret_cast<IOTraceFileHeader *>(_pView);
+    memset(pHeader, 0, sizeof(*pHeader));
+    pHeader->ulMagic = IO_TRACE_MAGIC;
+    pHeader->ulVersion = IO_TRACE_VERSION;
+    pHeader->cbHeader = sizeof(IOTraceFileHeader);
+    pHeader->cbRecord = sizeof(IOTraceRecord);
+    pHeader->cThreads = cThreads;
+    pHeader->cRecordsPerThread = cRecords;
+    pHeader->ullTimerFrequency = PerfTimer::GetFrequency();
+    pHeader->cbSegment = cbSegment;
+    pHeader->ulTimeSpan = ulTimeSpan;
+
+    // page aligned, hence cache line aligned
+    _pRings = static_cast<IOTraceRing *>(VirtualAlloc(nullptr, sizeof(IOTraceRing) * cThreads, MEM_COMMIT, PAGE_READWRITE));
+    if (nullptr == _pRings)
+    {
+        _Release();
+        return false;
+    }
+    _cRings = cThreads;
+
+    for (UINT32 iThread = 0; iThread < cThreads; iThread++)
+    {
+        IOTraceSegmentHeader *pSegment = reinterpret_cast<IOTraceSegmentHeader *>(_pView + sizeof(IOTraceFileHeader) + cbSegment * iThread);
+        IOTraceRing *pRing = new (&_pRings[iThread]) IOTraceRing();
+        pRing->Attach(pSegment, cRecords, iThread);
+    }
+
+    _MeasureOverhead();
+    return true;
+}
+
+struct TraceOverheadThread
+{
+    IOTraceRing *pRing;
+    HANDLE hStartEvent;
+    UINT32 cRecords;
+    UINT64 ullTicks;
+};
+
+/*****************************************************************************/
+// writes a burst of records to one ring once all the threads are ready
+//
+static DWORD WINAPI traceOverheadThreadFunc(LPVOID pvContext)
+{
+    TraceOverheadThread *pContext = static_cast<TraceOverheadThread *>(pvContext);
+    IOTraceRing *pRing = pContext->pRing;
+
+    if (nullptr != pContext->hStartEvent)
+    {
+        WaitForSingleObject(pContext->hStartEvent, INFINITE);
+    }
+
+    UINT64 ullStart = PerfTimer::GetTime();
+    for (UINT32 i = 0; i < pContext->cRecords; i++)
+    {
+        pRing->Add(static_cast<UINT64>(i) * 4096, 4096, 0, 1, ullStart, ullStart + i);
+    }
+    pContext->ullTicks = PerfTimer::GetTime() - ullStart;
+
+    return 0;
+}
+
+/*****************************************************************************/
+// times a burst of records written to every ring at once, one thread per ring as during
+// the run, so that contention between the rings shows in the result; then forgets them
+//
+void IOTrace::_MeasureOverhead()
+{
+    if (0 == _cRings)
+    {
+        return;
+    }
+
+    const UINT32 cRecords = min(_cRecordsPerThread, 65536U);
+    std::vector<TraceOverheadThread> vContexts(_cRings);
+    std::vector<HANDLE> vhThreads;
+
+    HANDLE hStartEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (nullptr != hStartEvent)
+    {
+        for (UINT32 iRing = 0; iRing < _cRings; iRing++)
+        {
+            vContexts[iRing].pRing = &_pRings[iRing];
+            vContexts[iRing].hStartEvent = hStartEvent;
+            vContexts[iRing].cRecords = cRecords;
+            vContexts[iRing].ullTicks = 0;
+
+            HANDLE hThread = CreateThread(nullptr, 64 * 1024, traceOverheadThreadFunc, &vContexts[iRing], 0, nullptr);
+            if (nullptr == hThread)
+            {
+                break;
+            }
+            vhThreads.push_back(hThread);
+        }
+
+        SetEvent(hStartEvent);
+        for (auto hThread : vhThreads)
+        {
+            WaitForSingleObject(hThread, INFINITE);
+            CloseHandle(hThread);
+        }
+        CloseHandle(hStartEvent);
+    }
+
+    // no thread could be started; time the first ring on this thread
+    if (vhThreads.empty())
+    {
+        vContexts[0].pRing = &_pRings[0];
+        vContexts[0].hStartEvent = nullptr;
+        vContexts[0].cRecords = cRecords;
+        vContexts[0].ullTicks = 0;
+        traceOverheadThreadFunc(&vContexts[0]);
+    }
+
+    const size_t cThreads = max(vhThreads.size(), static_cast<size_t>(1));
+    UINT64 ullTicks = 0;
+    for (size_t iThread = 0; iThread < cThreads; iThread++)
+    {
+        ullTicks += vContexts[iThread].ullTicks;
+    }
+    _fRecordNs = PerfTimer::PerfTimeToMicroseconds(ullTicks) * 1000 / (static_cast<double>(cRecords) * cThreads);
+
+    for (UINT32 iRing = 0; iRing < _cRings; iRing++)
+    {
+        _pRings[iRing].Reset();
+    }
+}
+
+/*****************************************************************************/
+// the workers must have stopped; writing the dirty pages back is left to the memory
+// manager while the run lasts, so only what it has not written yet is flushed here
+//
+bool IOTrace::Close(UINT64 *pullRecords, UINT64 *pullOverwrittenRecords, double *pfFlushMilliseconds)
+{
+    *pullRecords = 0;
+    *pullOverwrittenRecords = 0;
+    *pfFlushMilliseconds = 0;
+
+    if (nullptr == _pView)
+    {
+        return false;
+    }
+
+    for (UINT32 iRing = 0; iRing < _cRings; iRing++)
+    {
+        UINT64 ullCount = _pRings[iRing].GetRecordCount();
+        if (ullCount > _cRecordsPerThread)
+        {
+            *pullRecords += _cRecordsPerThread;
+            *pullOverwrittenRecords += ullCount - _cRecordsPerThread;
+        }
+        else
+        {
+            *pullRecords += ullCount;
+        }
+    }
+
+    UINT64 ullStart = PerfTimer::GetTime();
+    bool fOk = (FlushViewOfFile(_pView, 0) != FALSE);
+    _Release();
+    *pfFlushMilliseconds = PerfTimer::PerfTimeToMilliseconds(PerfTimer::GetTime() - ullStart);
+
+    return fOk;
+}
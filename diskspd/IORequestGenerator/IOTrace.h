@@ -0,0 +1,173 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+#include <Windows.h>
+
+//
+// Binary per-I/O trace (-vt). The trace file holds a header followed by one segment per
+// worker thread; each segment is a segment header and a ring of fixed-size records. The
+// file is mapped into memory and every thread writes only to its own segment, so the hot
+// path is a few stores with no locking and no system call. When a ring wraps, the oldest
+// records are overwritten. The layout is shared with the decoder (TraceDecoder).
+//
+#define IO_TRACE_MAGIC 0x54505344       // "DSPT"
+#define IO_TRACE_VERSION 1
+
+struct IOTraceFileHeader
+{
+    UINT32 ulMagic;
+    UINT32 ulVersion;
+    UINT32 cbHeader;                    // offset of the first segment
+    UINT32 cbRecord;
+    UINT32 cThreads;
+    UINT32 cRecordsPerThread;           // capacity of every ring; a power of two
+    UINT64 ullTimerFrequency;           // PerfTimer ticks per second
+    UINT64 cbSegment;                   // size of a segment, its header included
+    UINT32 ulTimeSpan;                  // 1-based
+    BYTE reserved[20];
+};
+
+struct IOTraceSegmentHeader
+{
+    volatile UINT64 ullRecordCount;     // records written by the thread; the ring holds the last cRecordsPerThread
+    UINT32 ulThread;
+    BYTE reserved[52];                  // one cache line per segment header
+};
+
+struct IOTraceRecord
+{
+    UINT64 ullOffset;                   // in bytes
+    UINT64 ullSubmitTime;               // PerfTimer ticks since the start of the measurement; an I/O issued during
+    UINT64 ullCompleteTime;             // the warm up and completed after the start has a negative (INT64) submit time
+    UINT32 ulBytes;
+    UINT16 usThread;
+    BYTE bTarget;                       // index of the target within the thread
+    BYTE bType;                         // 1 = read, 2 = write, 3 = discard (IOOperation)
+};
+
+static_assert(sizeof(IOTraceFileHeader) == 64, "the trace file header is part of the file format");
+static_assert(sizeof(IOTraceSegmentHeader) == 64, "the trace segment header is part of the file format");
+static_assert(sizeof(IOTraceRecord) == 32, "the trace record is part of the file format");
+
+// writer of one thread's segment; used by that thread only. The rings of all threads are
+// allocated together and each one fills a cache line of its own, so the count a thread
+// updates on every record does not share a line with another thread's ring.
+#define IO_TRACE_RING_ALIGNMENT 64
+
+class DECLSPEC_ALIGN(IO_TRACE_RING_ALIGNMENT) IOTraceRing
+{
+public:
+    IOTraceRing() :
+        _pHeader(nullptr),
+        _pRecords(nullptr),
+        _ulMask(0),
+        _ullCount(0),
+        _usThread(0)
+    {
+    }
+
+    void Attach(IOTraceSegmentHeader *pHeader, UINT32 cRecords, UINT32 ulThread)
+    {
+        _pHeader = pHeader;
+        _pRecords = reinterpret_cast<IOTraceRecord *>(pHeader + 1);
+        _ulMask = cRecords - 1;
+        _ullCount = 0;
+        _usThread = static_cast<UINT16>(ulThread);
+        _pHeader->ullRecordCount = 0;
+        _pHeader->ulThread = ulThread;
+    }
+
+    void Add(UINT64 ullOffset, UINT32 ulBytes, size_t iTarget, BYTE bType, UINT64 ullSubmitTime, UINT64 ullCompleteTime)
+    {
+        IOTraceRecord *pRecord = &_pRecords[_ullCount & _ulMask];
+        pRecord->ullOffset = ullOffset;
+        pRecord->ullSubmitTime = ullSubmitTime;
+        pRecord->ullCompleteTime = ullCompleteTime;
+        pRecord->ulBytes = ulBytes;
+        pRecord->usThread = _usThread;
+        pRecord->bTarget = static_cast<BYTE>(iTarget);
+        pRecord->bType = bType;
+
+        // publishing the count on every record keeps the file consistent even if the run is cut short
+        _pHeader->ullRecordCount = ++_ullCount;
+    }
+
+    UINT64 GetRecordCount() const { return _ullCount; }
+
+    // forgets the records written so far (used after measuring the overhead)
+    void Reset()
+    {
+        _ullCount = 0;
+        _pHeader->ullRecordCount = 0;
+    }
+
+private:
+    IOTraceSegmentHeader *_pHeader;
+    IOTraceRecord *_pRecords;
+    UINT64 _ulMask;
+    UINT64 _ullCount;
+    UINT16 _usThread;
+};
+
+static_assert(sizeof(IOTraceRing) == IO_TRACE_RING_ALIGNMENT, "a trace ring fills exactly one cache line");
+
+// the trace file of one TimeSpan
+class IOTrace
+{
+public:
+    IOTrace();
+    ~IOTrace();
+
+    bool Create(const char *pszPath, UINT32 ulTimeSpan, UINT32 cThreads, UINT32 cRecordsPerThread);
+    bool IsOpen() const { return nullptr != _pView; }
+    IOTraceRing *GetRing(UINT32 iThread) { return &_pRings[iThread]; }
+    UINT32 GetRecordsPerThread() const { return _cRecordsPerThread; }
+
+    // cost of writing one record, measured on the mapped file before the run with every
+    // thread writing to its own ring at the same time
+    double GetRecordNanoseconds() const { return _fRecordNs; }
+
+    // flushes the view to the file and closes it; returns the number of records kept in the file and lost to wrapping
+    bool Close(UINT64 *pullRecords, UINT64 *pullOverwrittenRecords, double *pfFlushMilliseconds);
+
+private:
+    void _Release();
+    void _MeasureOverhead();
+
+    HANDLE _hFile;
+    HANDLE _hMapping;
+    BYTE *_pView;
+    UINT64 _cbView;
+    UINT32 _cRecordsPerThread;
+    IOTraceRing *_pRings;               // VirtualAlloc'd so that the rings are cache line aligned
+    UINT32 _cRings;
+    double _fRecordNs;
+};
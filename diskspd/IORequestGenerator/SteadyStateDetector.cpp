@@ -0,0 +1,118 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include "SteadyStateDetector.h"
+#include <math.h>
+
+SteadyStateDetector::SteadyStateDetector(UINT32 ulWindow, double fMaxRangePercent, double fMaxSlopePercent) :
+    _ulWindow((ulWindow < 2) ? 2 : ulWindow),
+    _fMaxRangePercent(fMaxRangePercent),
+    _fMaxSlopePercent(fMaxSlopePercent)
+{
+}
+
+// returns true if the window ending with this round is steady
+bool SteadyStateDetector::AddRound(double fValue)
+{
+    _vValues.push_back(fValue);
+    return IsSteady();
+}
+
+bool SteadyStateDetector::IsSteady(void) const
+{
+    if (_vValues.size() < _ulWindow)
+    {
+        return false;
+    }
+
+    // nothing completed at all is not a steady state
+    if (GetWindowAverage() <= 0)
+    {
+        return false;
+    }
+
+    return (GetWindowRangePercent() <= _fMaxRangePercent) && (fabs(GetWindowSlopePercent()) <= _fMaxSlopePercent);
+}
+
+double SteadyStateDetector::GetWindowAverage(void) const
+{
+    if (_vValues.size() < _ulWindow)
+    {
+        return 0;
+    }
+
+    double fSum = 0;
+    for (size_t i = _vValues.size() - _ulWindow; i < _vValues.size(); i++)
+    {
+        fSum += _vValues[i];
+    }
+    return fSum / _ulWindow;
+}
+
+double SteadyStateDetector::GetWindowRangePercent(void) const
+{
+    double fAverage = GetWindowAverage();
+    if (fAverage <= 0)
+    {
+        return 0;
+    }
+
+    size_t iFirst = _vValues.size() - _ulWindow;
+    double fMin = _vValues[iFirst];
+    double fMax = _vValues[iFirst];
+    for (size_t i = iFirst + 1; i < _vValues.size(); i++)
+    {
+        fMin = min(fMin, _vValues[i]);
+        fMax = max(fMax, _vValues[i]);
+    }
+    return 100.0 * (fMax - fMin) / fAverage;
+}
+
+// change of the least-squares line over the window (slope * (window - 1)), signed
+double SteadyStateDetector::GetWindowSlopePercent(void) const
+{
+    double fAverage = GetWindowAverage();
+    if (fAverage <= 0)
+    {
+        return 0;
+    }
+
+    size_t iFirst = _vValues.size() - _ulWindow;
+    double fMeanX = (_ulWindow - 1) / 2.0;
+    double fSumXY = 0;
+    double fSumXX = 0;
+    for (UINT32 x = 0; x < _ulWindow; x++)
+    {
+        fSumXY += (x - fMeanX) * (_vValues[iFirst + x] - fAverage);
+        fSumXX += (x - fMeanX) * (x - fMeanX);
+    }
+    double fSlope = fSumXY / fSumXX;
+    return 100.0 * fSlope * (_ulWindow - 1) / fAverage;
+}
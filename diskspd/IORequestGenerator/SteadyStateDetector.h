@@ -0,0 +1,56 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#pragma once
+#include <Windows.h>
+#include <vector>
+
+// SteadyStateDetector follows one metric (IOPS or latency) over rounds of the
+// warm up and decides when it has settled, the way SNIA PTS does: over a window
+// of the last rounds, the range of the values (max - min) and the change of the
+// least-squares line fit across the window both have to stay within a percentage
+// of the window average.
+class SteadyStateDetector
+{
+public:
+    SteadyStateDetector(UINT32 ulWindow, double fMaxRangePercent, double fMaxSlopePercent);
+
+    bool AddRound(double fValue);
+    bool IsSteady(void) const;
+    double GetWindowAverage(void) const;
+    double GetWindowRangePercent(void) const;
+    double GetWindowSlopePercent(void) const;
+
+private:
+    UINT32 _ulWindow;               // number of rounds the criteria are checked over
+    double _fMaxRangePercent;       // allowed max - min, in percent of the window average
+    double _fMaxSlopePercent;       // allowed change of the line fit across the window, in percent of the window average
+    std::vector<double> _vValues;   // all rounds so far
+};
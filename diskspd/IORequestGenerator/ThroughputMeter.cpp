@@ -42,82 +42,191 @@ bool ThroughputMeter::IsRunning(void) const
 void ThroughputMeter::Start(DWORD cBytesPerMillisecond, DWORD dwBlockSize, DWORD dwThinkTime, DWORD dwBurstSize)
 {
     // Initialization
-    _cbCompleted = 0;
     _cIO = 0; // number of completed IOs in the current burst
-    _cbBlockSize = dwBlockSize;
 
     _fThrottle = false;
-    _cBytesPerMillisecond = 0;
+    _fTicksPerByte = 0;
+    _ullBucketDepth = 0;
     _fThink = false;
-    _ullDelayUntil = 0;
-    _thinkTime = 0;
+    _ullThinkTime = 0;
+    _ullThinkUntil = 0;
     _burstSize = 0;
     _fRunning = false;
+    _ullLastIssueTime = 0;
+    _ullLastIssueInterval = 0;
 
-	/// GetTickCount64 -> GetTickCount
-    _ullStartTimestamp = GetTickCount();
+    _ullNextIssueTime = PerfTimer::GetTime();
 
     if (0 != cBytesPerMillisecond)
     {
         _fThrottle = true;
-        _cBytesPerMillisecond = cBytesPerMillisecond;
+        _fTicksPerByte = static_cast<double>(PerfTimer::MillisecondsToPerfTime(1)) / cBytesPerMillisecond;
+        _ullBucketDepth = static_cast<UINT64>(_fTicksPerByte * dwBlockSize);
         _fRunning = true;
     }
     else if (0 != dwThinkTime)
     {
         _fThink = true;
-        _thinkTime = dwThinkTime;
+        _ullThinkTime = PerfTimer::MillisecondsToPerfTime(dwThinkTime);
         _burstSize = dwBurstSize;
         _fRunning = true;
     }
 }
 
-DWORD ThroughputMeter::GetSleepTime(void) const
+UINT64 ThroughputMeter::GetDelay(UINT64 ullNow) const
 {
+    UINT64 ullDelayUntil = 0;
+
     if (_fThink)
     {
-		/// GetTickCount64 -> GetTickCount
-        ULONGLONG ullTimestamp = GetTickCount();
-        if (ullTimestamp < _ullDelayUntil)
+        ullDelayUntil = _ullThinkUntil;
+    }
+
+    if (_fThrottle && (_ullNextIssueTime > ullDelayUntil))
+    {
+        ullDelayUntil = _ullNextIssueTime;
+    }
+
+    return (ullDelayUntil > ullNow) ? (ullDelayUntil - ullNow) : 0;
+}
+
+void ThroughputMeter::Adjust(size_t cb)
+{
+    UINT64 ullNow = PerfTimer::GetTime();
+
+    if (_fThrottle)
+    {
+        // credit at most one block worth of idle time
+        UINT64 ullEarliest = (ullNow > _ullBucketDepth) ? (ullNow - _ullBucketDepth) : 0;
+        if (_ullNextIssueTime < ullEarliest)
         {
-            return (DWORD)(_ullDelayUntil - ullTimestamp);
+            _ullNextIssueTime = ullEarliest;
         }
-        else
+        _ullNextIssueTime += static_cast<UINT64>(cb * _fTicksPerByte);
+
+        _ullLastIssueInterval = (_ullLastIssueTime != 0) ? (ullNow - _ullLastIssueTime) : 0;
+        _ullLastIssueTime = ullNow;
+    }
+
+    _cIO++;
+    if (_fThink)
+    {
+        if (_cIO >= _burstSize)
         {
-            return (_fThrottle) ? _GetThrottleTime() : 0;
+            _cIO = 0;
+            _ullThinkUntil = ullNow + _ullThinkTime;
         }
     }
-    else
+}
+
+UINT64 ThroughputMeter::GetLastIssueInterval(void) const
+{
+    return _ullLastIssueInterval;
+}
+
+UINT64 ThroughputMeter::GetTargetIssueInterval(void) const
+{
+    return _ullBucketDepth;
+}
+
+SharedThroughputMeter::SharedThroughputMeter(void) :
+    _fRunning(false),
+    _fTicksPerByte(0),
+    _ullBucketDepth(0),
+    _llNextIssueTime(0)
+{
+}
+
+bool SharedThroughputMeter::IsRunning(void) const
+{
+    return _fRunning;
+}
+
+void SharedThroughputMeter::Start(DWORD cBytesPerMillisecond, DWORD dwBlockSize)
+{
+    _fRunning = (0 != cBytesPerMillisecond);
+    if (_fRunning)
+    {
+        _fTicksPerByte = static_cast<double>(PerfTimer::MillisecondsToPerfTime(1)) / cBytesPerMillisecond;
+        _ullBucketDepth = static_cast<UINT64>(_fTicksPerByte * dwBlockSize);
+        _llNextIssueTime = static_cast<LONG64>(PerfTimer::GetTime());
+    }
+}
+
+// Takes the tokens for cb bytes and returns 0, or returns the time to wait
+// before the bucket has enough tokens (nothing is taken in that case)
+UINT64 SharedThroughputMeter::TryAcquire(UINT64 ullNow, size_t cb)
+{
+    UINT64 ullCost = static_cast<UINT64>(cb * _fTicksPerByte);
+    UINT64 ullEarliest = (ullNow > _ullBucketDepth) ? (ullNow - _ullBucketDepth) : 0;
+
+    for (;;)
     {
-        if (_fThrottle) // think time has not been specified only check for throttling
+        LONG64 llNextIssueTime = _llNextIssueTime;
+        UINT64 ullNextIssueTime = static_cast<UINT64>(llNextIssueTime);
+        if (ullNextIssueTime > ullNow)
         {
-            return _GetThrottleTime();
+            return ullNextIssueTime - ullNow;
         }
-        else
+
+        // credit at most one block worth of idle time
+        if (ullNextIssueTime < ullEarliest)
+        {
+            ullNextIssueTime = ullEarliest;
+        }
+
+        if (InterlockedCompareExchange64(&_llNextIssueTime, static_cast<LONG64>(ullNextIssueTime + ullCost), llNextIssueTime) == llNextIssueTime)
         {
             return 0;
         }
     }
 }
 
-DWORD ThroughputMeter::_GetThrottleTime(void) const
+PreciseSleeper::PreciseSleeper(void) :
+    _ullSpinMargin(PerfTimer::MillisecondsToPerfTime(2)),
+    _ullMinSpinMargin(PerfTimer::MillisecondsToPerfTime(2)),
+    _ullMaxSpinMargin(PerfTimer::MicrosecondsToPerfTime(2 * 15625))
 {
-	/// GetTickCount64 -> GetTickCount
-    ULONGLONG cbExpected = (GetTickCount() - _ullStartTimestamp) * _cBytesPerMillisecond;
-    return cbExpected >= (_cbCompleted + _cbBlockSize) ? 0 : 1;
+    // cap the margin at two clock ticks; the increment is in 100ns units
+    DWORD dwAdjustment;
+    DWORD dwIncrement;
+    BOOL fAdjustmentDisabled;
+    if (GetSystemTimeAdjustment(&dwAdjustment, &dwIncrement, &fAdjustmentDisabled) && (dwIncrement > 0))
+    {
+        _ullMaxSpinMargin = max(PerfTimer::MicrosecondsToPerfTime(2 * dwIncrement / 10), _ullMinSpinMargin);
+    }
 }
 
-void ThroughputMeter::Adjust(size_t cb)
+void PreciseSleeper::Wait(UINT64 ullDelay)
 {
-    _cbCompleted += cb;
-    _cIO++;
-    if (_fThink)
+    UINT64 ullStart = PerfTimer::GetTime();
+    UINT64 ullDeadline = ullStart + ullDelay;
+
+    if (ullDelay > _ullSpinMargin)
     {
-        if (_cIO >= _burstSize)
+        DWORD dwSleepTime = static_cast<DWORD>(PerfTimer::PerfTimeToMilliseconds(ullDelay - _ullSpinMargin));
+        if (dwSleepTime > 0)
         {
-            _cIO = 0;
-			/// GetTickCount64 -> GetTickCount
-            _ullDelayUntil = GetTickCount() + _thinkTime;
+            Sleep(dwSleepTime);
+
+            // learn the overshoot of Sleep so the next wait leaves enough time to spin
+            UINT64 ullSlept = PerfTimer::GetTime() - ullStart;
+            UINT64 ullRequested = PerfTimer::MillisecondsToPerfTime(dwSleepTime);
+            UINT64 ullOvershoot = (ullSlept > ullRequested) ? (ullSlept - ullRequested) : 0;
+            if (ullOvershoot > _ullSpinMargin)
+            {
+                _ullSpinMargin = min(ullOvershoot, _ullMaxSpinMargin);
+            }
+            else
+            {
+                // moving average toward the shorter overshoot, 1/8 of the way per wait
+                _ullSpinMargin -= (_ullSpinMargin - max(ullOvershoot, _ullMinSpinMargin)) / 8;
+            }
         }
     }
-}
\ No newline at end of file
+
+    while (PerfTimer::GetTime() < ullDeadline)
+    {
+        YieldProcessor();
+    }
+}
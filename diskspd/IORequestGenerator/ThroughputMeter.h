@@ -29,11 +29,17 @@ SOFTWARE.
 
 #pragma once
 #include <Windows.h>
+#include "Common.h"
 
 // ThroughputMeter class assists in metering out throughput over
 // time.  The meter is started by calling Start() with the throughput
-// to be simulated.  GetSleepTime() returns 0 when the next IO can be issued.
+// to be simulated.  GetDelay() returns 0 when the next IO can be issued.
 // Adjust() is called to notify the ThroughputMeter about how many bytes were read/written.
+//
+// Throttling is a token bucket kept in PerfTimer ticks: every issued byte
+// pushes the earliest time of the next IO forward by 1/rate, and at most
+// one block worth of idle time can be credited back, so a stall does not
+// turn into a burst afterwards.
 class ThroughputMeter
 {
 public:
@@ -41,21 +47,62 @@ public:
 
     bool IsRunning(void) const;
     void Start(DWORD cBytesPerMillisecond, DWORD dwBlockSize, DWORD dwThinkTime, DWORD dwBurstSize);
-    DWORD GetSleepTime(void) const;
+    UINT64 GetDelay(UINT64 ullNow) const;
     void Adjust(size_t cb);
+    UINT64 GetLastIssueInterval(void) const;
+    UINT64 GetTargetIssueInterval(void) const;
 
 private:
-    DWORD _GetThrottleTime(void) const;
-
     bool _fRunning;                 // true = throughput monitoring is on
     bool _fThrottle;                // true = throttling is on
     bool _fThink;                   // true = think time is enabled
-    ULONGLONG _cbCompleted;         // completed IO
-    DWORD _cbBlockSize;
-    DWORD _cBytesPerMillisecond;    // rate of throttling
-    ULONGLONG _ullStartTimestamp;
-    ULONGLONG _ullDelayUntil;       // timestamp at which the next IO can be executed
-    DWORD _thinkTime;               // time to sleep between burst of IOs
+    double _fTicksPerByte;          // bucket refill, in PerfTimer ticks per byte
+    UINT64 _ullBucketDepth;         // largest credit for idle time, in PerfTimer ticks (one block)
+    UINT64 _ullNextIssueTime;       // timestamp at which the bucket allows the next IO
+    UINT64 _ullThinkUntil;          // timestamp at which the current think time ends
+    UINT64 _ullThinkTime;           // time to sleep between burst of IOs, in PerfTimer ticks
     DWORD _burstSize;               // number of IOs in a burst. meaningless if think time is zero
     DWORD _cIO;                     // count of IOs in the current burst
-};
\ No newline at end of file
+    UINT64 _ullLastIssueTime;       // timestamp of the most recent throttled IO, 0 = none yet
+    UINT64 _ullLastIssueInterval;   // time between the two most recent IOs
+};
+
+// SharedThroughputMeter is a token bucket drawn from by all threads working
+// on a target, so that the total throughput does not depend on how the
+// threads get scheduled. It is lock-free: a thread takes a token by moving
+// the shared issue time forward with a compare-exchange.
+class SharedThroughputMeter
+{
+public:
+    SharedThroughputMeter(void);
+
+    bool IsRunning(void) const;
+    void Start(DWORD cBytesPerMillisecond, DWORD dwBlockSize);
+    UINT64 TryAcquire(UINT64 ullNow, size_t cb);
+
+private:
+    bool _fRunning;                 // true = throttling is on
+    double _fTicksPerByte;          // bucket refill, in PerfTimer ticks per byte
+    UINT64 _ullBucketDepth;         // largest credit for idle time, in PerfTimer ticks (one block)
+    volatile LONG64 _llNextIssueTime;   // timestamp at which the bucket allows the next IO
+};
+
+// PreciseSleeper waits for a number of PerfTimer ticks with sub-millisecond
+// precision: it sleeps for the bulk of the interval and spins for the rest.
+// The spin margin follows how much Sleep() has been observed to overshoot,
+// which depends on the system timer resolution (1ms to 15.6ms). It grows at
+// once to cover a longer overshoot, up to two clock ticks so that a single
+// preemption cannot turn every later wait into a spin, and decays slowly
+// back when the overshoots get shorter.
+class PreciseSleeper
+{
+public:
+    PreciseSleeper(void);
+
+    void Wait(UINT64 ullDelay);
+
+private:
+    UINT64 _ullSpinMargin;          // remaining time below which the sleeper spins instead of sleeping
+    UINT64 _ullMinSpinMargin;
+    UINT64 _ullMaxSpinMargin;
+};
@@ -0,0 +1,323 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// RequestBench.cpp : measures the per-I/O bookkeeping of the completion port work loop
+//
+// Every iteration completes an in-flight request picked at random, accounts it to its
+// target, puts it back on the ready queue, then takes the next ready request and prepares
+// it for issue (target, buffer, start time, type, offset). No I/O is issued and the timer
+// is not read, so what is timed is only the bookkeeping the loop does around each I/O.
+// Both variants take the read buffer whatever the type: the write buffer is the same one
+// unless the target has a random data write buffer, and the choice between the two is
+// the same branch in both designs.
+//
+// "before" is the bookkeeping of the OverlappedQueue design: a queue linked through
+// OVERLAPPED::Internal and the per-request state spread over parallel vectors.
+// "after" is the current one: IORequestRing and one cache-line IORequest per request.
+//
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "Common.h"
+#include "..\IORequestGenerator\IORequestRing.h"
+
+using namespace std;
+
+// the queue that IORequestRing replaced, kept here as the baseline
+class LegacyOverlappedQueue
+{
+public:
+    LegacyOverlappedQueue() :
+        _pHead(nullptr),
+        _pTail(nullptr),
+        _cItems(0)
+    {
+    }
+
+    void Add(OVERLAPPED *pOverlapped)
+    {
+        pOverlapped->Internal = NULL;
+        if (_pHead == nullptr)
+        {
+            _pHead = pOverlapped;
+        }
+        else
+        {
+            _pTail->Internal = (ULONG_PTR)pOverlapped;
+        }
+        _pTail = pOverlapped;
+        _cItems++;
+    }
+
+    OVERLAPPED *Remove()
+    {
+        OVERLAPPED *pOverlapped = _pHead;
+        _pHead = (OVERLAPPED *)pOverlapped->Internal;
+        if (_pHead == nullptr)
+        {
+            _pTail = nullptr;
+        }
+        _cItems--;
+        return pOverlapped;
+    }
+
+private:
+    OVERLAPPED *_pHead;
+    OVERLAPPED *_pTail;
+    size_t _cItems;
+};
+
+struct BenchSetup
+{
+    UINT32 cTargets;
+    UINT32 cRequestsPerTarget;
+};
+
+// the state shared by both variants: what the loop reads from the targets and the results
+struct BenchTargets
+{
+    vector<DWORD> vdwBlockSizes;
+    vector<BYTE *> vpDataBuffers;   // never dereferenced; only the buffer addresses are computed
+    vector<UINT64> vullBytes;
+    vector<UINT64> vullLatencyTicks;
+};
+
+static inline UINT32 NextRandom(UINT32& ulState)
+{
+    // xorshift32; the same sequence drives both variants
+    ulState ^= ulState << 13;
+    ulState ^= ulState >> 17;
+    ulState ^= ulState << 5;
+    return ulState;
+}
+
+static void InitTargets(const BenchSetup& setup, BenchTargets& targets)
+{
+    targets.vdwBlockSizes.assign(setup.cTargets, 4096);
+    targets.vpDataBuffers.resize(setup.cTargets);
+    for (UINT32 iTarget = 0; iTarget < setup.cTargets; iTarget++)
+    {
+        targets.vpDataBuffers[iTarget] = reinterpret_cast<BYTE *>(static_cast<ULONG_PTR>(iTarget + 1) * 0x100000);
+    }
+    targets.vullBytes.assign(setup.cTargets, 0);
+    targets.vullLatencyTicks.assign(setup.cTargets, 0);
+}
+
+/*****************************************************************************/
+// the bookkeeping before the change; returns the elapsed ticks
+//
+static UINT64 RunBefore(const BenchSetup& setup, UINT32 cIterations, UINT64 *pullChecksum)
+{
+    BenchTargets targets;
+    InitTargets(setup, targets);
+
+    UINT32 cOverlapped = setup.cTargets * setup.cRequestsPerTarget;
+    vector<OVERLAPPED> vOverlapped(cOverlapped);
+    vector<size_t> vOverlappedIdToTargetId;
+    vector<UINT32> vFirstOverlappedIdForTargetId;
+    vector<IOOperation> vdwIoType(cOverlapped, IOOperation::ReadIO);
+    vector<UINT64> vIoStartTimes(cOverlapped, 0);
+
+    for (UINT32 iTarget = 0; iTarget < setup.cTargets; iTarget++)
+    {
+        vFirstOverlappedIdForTargetId.push_back(static_cast<UINT32>(vOverlappedIdToTargetId.size()));
+        for (UINT32 iRequest = 0; iRequest < setup.cRequestsPerTarget; iRequest++)
+        {
+            vOverlappedIdToTargetId.push_back(iTarget);
+        }
+    }
+
+    LegacyOverlappedQueue overlappedQueue;
+    UINT32 ulRandom = 0x9E3779B9;
+    UINT64 ullChecksum = 0;
+
+    LARGE_INTEGER liStart;
+    LARGE_INTEGER liEnd;
+    QueryPerformanceCounter(&liStart);
+
+    for (UINT32 i = 0; i < cIterations; i++)
+    {
+        // complete
+        OVERLAPPED *pCompletedOvrp = &vOverlapped[NextRandom(ulRandom) % cOverlapped];
+        DWORD iOverlapped = (DWORD)(pCompletedOvrp - &vOverlapped[0]);
+        size_t iTarget = vOverlappedIdToTargetId[iOverlapped];
+        targets.vullBytes[iTarget] += (vdwIoType[iOverlapped] == IOOperation::ReadIO) ? targets.vdwBlockSizes[iTarget] : 0;
+        targets.vullLatencyTicks[iTarget] += i - vIoStartTimes[iOverlapped];
+        overlappedQueue.Add(pCompletedOvrp);
+
+        // issue
+        OVERLAPPED *pReadyOverlapped = overlappedQueue.Remove();
+        iOverlapped = (DWORD)(pReadyOverlapped - &vOverlapped[0]);
+        iTarget = vOverlappedIdToTargetId[iOverlapped];
+        size_t iRequest = iOverlapped - vFirstOverlappedIdForTargetId[iTarget];
+        vIoStartTimes[iOverlapped] = i;
+        IOOperation readOrWrite = vdwIoType[iOverlapped] = (NextRandom(ulRandom) & 1) ? IOOperation::ReadIO : IOOperation::WriteIO;
+        BYTE *pBuffer = targets.vpDataBuffers[iTarget] + (iRequest * targets.vdwBlockSizes[iTarget]);
+        pReadyOverlapped->Offset = static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(pBuffer)) + static_cast<DWORD>(readOrWrite);
+    }
+
+    QueryPerformanceCounter(&liEnd);
+
+    for (UINT32 iTarget = 0; iTarget < setup.cTargets; iTarget++)
+    {
+        ullChecksum += targets.vullBytes[iTarget] + targets.vullLatencyTicks[iTarget];
+    }
+    *pullChecksum = ullChecksum;
+    return liEnd.QuadPart - liStart.QuadPart;
+}
+
+/*****************************************************************************/
+// the bookkeeping after the change; returns the elapsed ticks
+//
+static UINT64 RunAfter(const BenchSetup& setup, UINT32 cIterations, UINT64 *pullChecksum)
+{
+    BenchTargets targets;
+    InitTargets(setup, targets);
+
+    UINT32 cIORequests = setup.cTargets * setup.cRequestsPerTarget;
+    IORequest *pIORequests = static_cast<IORequest *>(VirtualAlloc(nullptr, cIORequests * sizeof(IORequest), MEM_COMMIT, PAGE_READWRITE));
+    if (nullptr == pIORequests)
+    {
+        fprintf(stderr, "ERROR: could not allocate %u IO requests\n", cIORequests);
+        exit(1);
+    }
+
+    UINT32 iIORequest = 0;
+    for (UINT32 iTarget = 0; iTarget < setup.cTargets; iTarget++)
+    {
+        for (UINT32 iRequest = 0; iRequest < setup.cRequestsPerTarget; iRequest++)
+        {
+            IORequest *pIORequest = &pIORequests[iIORequest++];
+            pIORequest->iTarget = iTarget;
+            pIORequest->pReadBuffer = targets.vpDataBuffers[iTarget] + (iRequest * targets.vdwBlockSizes[iTarget]);
+            pIORequest->pWriteBuffer = pIORequest->pReadBuffer;
+            pIORequest->ioType = IOOperation::ReadIO;
+            pIORequest->ullStartTime = 0;
+        }
+    }
+
+    IORequestRing readyRequests(cIORequests);
+    UINT32 ulRandom = 0x9E3779B9;
+    UINT64 ullChecksum = 0;
+
+    LARGE_INTEGER liStart;
+    LARGE_INTEGER liEnd;
+    QueryPerformanceCounter(&liStart);
+
+    for (UINT32 i = 0; i < cIterations; i++)
+    {
+        // complete
+        OVERLAPPED *pCompletedOvrp = &pIORequests[NextRandom(ulRandom) % cIORequests].overlapped;
+        IORequest *pIORequest = IORequest::FromOverlapped(pCompletedOvrp);
+        size_t iTarget = pIORequest->iTarget;
+        targets.vullBytes[iTarget] += (pIORequest->ioType == IOOperation::ReadIO) ? targets.vdwBlockSizes[iTarget] : 0;
+        targets.vullLatencyTicks[iTarget] += i - pIORequest->ullStartTime;
+        readyRequests.Add(static_cast<UINT32>(pIORequest - pIORequests));
+
+        // issue
+        pIORequest = &pIORequests[readyRequests.Remove()];
+        pIORequest->ullStartTime = i;
+        IOOperation readOrWrite = pIORequest->ioType = (NextRandom(ulRandom) & 1) ? IOOperation::ReadIO : IOOperation::WriteIO;
+        BYTE *pBuffer = pIORequest->pReadBuffer;
+        pIORequest->overlapped.Offset = static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(pBuffer)) + static_cast<DWORD>(readOrWrite);
+    }
+
+    QueryPerformanceCounter(&liEnd);
+
+    for (UINT32 iTarget = 0; iTarget < setup.cTargets; iTarget++)
+    {
+        ullChecksum += targets.vullBytes[iTarget] + targets.vullLatencyTicks[iTarget];
+    }
+    *pullChecksum = ullChecksum;
+
+    VirtualFree(pIORequests, 0, MEM_RELEASE);
+    return liEnd.QuadPart - liStart.QuadPart;
+}
+
+int __cdecl main(int argc, const char* argv[])
+{
+    UINT32 cIterations = 20000000;
+    UINT32 cRuns = 5;
+    if (argc > 1)
+    {
+        cIterations = strtoul(argv[1], nullptr, 10);
+    }
+    if (argc > 2)
+    {
+        cRuns = strtoul(argv[2], nullptr, 10);
+    }
+    if ((argc > 3) || (cIterations == 0) || (cRuns == 0))
+    {
+        fprintf(stderr, "Usage: RequestBench [<iterations> [<runs>]]\n");
+        fprintf(stderr, "  prints the best of <runs> runs of the per-I/O bookkeeping before and after, in ns per I/O\n");
+        return 1;
+    }
+
+    LARGE_INTEGER liFrequency;
+    QueryPerformanceFrequency(&liFrequency);
+
+    const BenchSetup vSetups[] = {
+        { 1, 32 },
+        { 8, 32 },
+        { 64, 256 },
+    };
+
+    printf("targets,requests per target,before ns/IO,after ns/IO\n");
+    for (const auto& setup : vSetups)
+    {
+        UINT64 ullBestBefore = MAXUINT64;
+        UINT64 ullBestAfter = MAXUINT64;
+        UINT64 ullChecksumBefore = 0;
+        UINT64 ullChecksumAfter = 0;
+
+        // interleaved so that both variants see the same machine state
+        for (UINT32 iRun = 0; iRun < cRuns; iRun++)
+        {
+            ullBestBefore = min(ullBestBefore, RunBefore(setup, cIterations, &ullChecksumBefore));
+            ullBestAfter = min(ullBestAfter, RunAfter(setup, cIterations, &ullChecksumAfter));
+        }
+
+        if (ullChecksumBefore != ullChecksumAfter)
+        {
+            fprintf(stderr, "ERROR: the two variants did not do the same work\n");
+            return 1;
+        }
+
+        double fTicksPerNs = liFrequency.QuadPart / 1e9;
+        printf("%u,%u,%.2f,%.2f\n",
+            setup.cTargets,
+            setup.cRequestsPerTarget,
+            ullBestBefore / fTicksPerNs / cIterations,
+            ullBestAfter / fTicksPerNs / cIterations);
+    }
+
+    return 0;
+}
@@ -41,6 +41,7 @@ SOFTWARE.
 #include <Evntrace.h>
 
 #include <assert.h>
+#include <algorithm>
 
 // TODO: refactor to a single function shared with the XmlResultParser
 void ResultParser::_Print(const char *format, ...)
@@ -222,6 +223,16 @@ void ResultParser::_PrintTarget(const Target &target, bool fUseThreadsPerFile, b
     _Print("\tpath: '%s'\n", target.GetPath().c_str());
     _Print("\t\tthink time: %ums\n", target.GetThinkTime());
     _Print("\t\tburst size: %u\n", target.GetBurstSize());
+    if (target.GetVerify())
+    {
+        _Print("\t\tverifying written and read blocks (header and CRC32C)\n");
+    }
+    if (target.GetArrivalRate() > 0)
+    {
+        _Print("\t\topen-loop arrivals: %u I/Os per second (%s inter-arrival times)\n",
+            target.GetArrivalRate(),
+            target.GetPoissonArrivals() ? "poisson" : "constant");
+    }
     // TODO: completion routines/ports
 
     if (target.GetDisableAllCache())
@@ -238,6 +249,63 @@ void ResultParser::_PrintTarget(const Target &target, bool fUseThreadsPerFile, b
         _Print("\t\tusing software and hardware write cache\n");
     }
 
+    if (target.GetWriteThrough() && !target.GetDisableAllCache())
+    {
+        _Print("\t\twrite-through writes\n");
+    }
+
+    if (target.GetFlushInterval() > 0)
+    {
+        _Print("\t\tflushing after every %u writes of a thread\n", target.GetFlushInterval());
+    }
+
+    if (target.GetFlushPercentage() > 0)
+    {
+        _Print("\t\tflushing before %u%% of the I/Os\n", target.GetFlushPercentage());
+    }
+
+    if (target.GetDiscardPercentage() > 0)
+    {
+        _Print("\t\tdiscarding in place of %u%% of the I/Os\n", target.GetDiscardPercentage());
+    }
+
+    if (target.GetDiscardBurstInterval() > 0)
+    {
+        _Print("\t\tdiscarding %I64u bytes every %ums (bulk discard)\n", target.GetDiscardBurstSize(), target.GetDiscardBurstInterval());
+    }
+
+    if (target.GetFileCount() > 0)
+    {
+        _Print("\t\tsmall-file workload: %u files, %u per directory, %I64u to %I64u bytes\n",
+            target.GetFileCount(),
+            target.GetFilesPerDirectory(),
+            target.GetMinPopulationFileSize(),
+            target.GetMaxPopulationFileSize());
+        _Print("\t\t  %u%% open/read, %u%% create, %u%% stat, %u%% delete\n",
+            target.GetFileOperationPercentage(FileOperation::OpenRead),
+            target.GetFileOperationPercentage(FileOperation::Create),
+            target.GetFileOperationPercentage(FileOperation::Stat),
+            target.GetFileOperationPercentage(FileOperation::Delete));
+    }
+
+    if (target.GetLogClients() > 0)
+    {
+        if (target.GetCommitRate() > 0)
+        {
+            _Print("\t\tgroup-commit log: %u clients, %u commits per second (%s times between commits), %I64u byte records\n",
+                target.GetLogClients(),
+                target.GetCommitRate(),
+                target.GetPoissonCommits() ? "poisson" : "constant",
+                target.GetBlockAlignmentInBytes());
+        }
+        else
+        {
+            _Print("\t\tgroup-commit log: %u clients committing back to back, %I64u byte records\n",
+                target.GetLogClients(),
+                target.GetBlockAlignmentInBytes());
+        }
+    }
+
     if (target.GetZeroWriteBuffers())
     {
         _Print("\t\tzeroing write buffers\n");
@@ -287,6 +355,10 @@ void ResultParser::_PrintTarget(const Target &target, bool fUseThreadsPerFile, b
         }
     }
     _Print("%I64u)\n", target.GetBlockAlignmentInBytes());
+    if (!target.GetUseRandomAccessPattern() && target.GetUseInterlockedSequential() && (target.GetInterlockedSequentialChunk() > 1))
+    {
+        _Print("\t\tclaiming %u strides at a time from the shared offset\n", target.GetInterlockedSequentialChunk());
+    }
 
     _Print("\t\tnumber of outstanding I/O operations: %d\n", target.GetRequestCount());
     if (0 != target.GetBaseFileOffsetInBytes())
@@ -349,6 +421,14 @@ void ResultParser::_PrintTimeSpan(const TimeSpan& timeSpan)
 {
     _Print("\tduration: %us\n", timeSpan.GetDuration());
     _Print("\twarm up time: %us\n", timeSpan.GetWarmup());
+    if (timeSpan.GetSteadyStateWarmup())
+    {
+        _Print("\tending warm up at steady state: %u rounds of %ums, range <= %.2f%%, slope <= %.2f%%\n",
+            timeSpan.GetSteadyStateWindow(),
+            timeSpan.GetSteadyStateIntervalInMilliseconds(),
+            timeSpan.GetSteadyStateRange(),
+            timeSpan.GetSteadyStateSlope());
+    }
     _Print("\tcool down time: %us\n", timeSpan.GetCooldown());
     if (timeSpan.GetDisableAffinity())
     {
@@ -407,6 +487,15 @@ void ResultParser::_PrintProfile(const Profile& profile)
     }
 }
 
+void ResultParser::_PrintTimer(const SystemInformation& system)
+{
+    _Print("\ntimer: %s, %.3fMHz | call overhead: %.1fns | resolution: %.1fns\n",
+        (system.timerSource == PerfTimerSource::InvariantTsc) ? "invariant TSC" : "QueryPerformanceCounter",
+        static_cast<double>(system.ullTimerFrequency) / 1000000,
+        system.fTimerOverheadNs,
+        system.fTimerResolutionNs);
+}
+
 void ResultParser::_PrintCpuUtilization(const Results& results)
 {
     size_t ulProcCount = results.vSystemProcessorPerfInfo.size();
@@ -414,50 +503,118 @@ void ResultParser::_PrintCpuUtilization(const Results& results)
 
     char szFloatBuffer[1024];
 
-    _Print("\nCPU |  Usage |  User  |  Kernel |  Idle\n");
-    _Print("-------------------------------------------\n");
+    _Print("\nCPU |  Usage |  User  |  Kernel |  Idle  |   DPC  |  Intr\n");
+    _Print("-----------------------------------------------------------\n");
 
     double busyTime = 0;
     double totalIdleTime = 0;
     double totalUserTime = 0;
     double totalKrnlTime = 0;
+    double totalDpcTime = 0;
+    double totalIntrTime = 0;
 
     for (unsigned int x = 0; x<ulProcCount; ++x)
     {
         double idleTime;
         double userTime;
         double krnlTime;
+        double dpcTime;
+        double intrTime;
         double thisTime;
 
         idleTime = 100.0 * results.vSystemProcessorPerfInfo[x].IdleTime.QuadPart / 10000000 / fTime;
         krnlTime = 100.0 * results.vSystemProcessorPerfInfo[x].KernelTime.QuadPart / 10000000 / fTime;
         userTime = 100.0 * results.vSystemProcessorPerfInfo[x].UserTime.QuadPart / 10000000 / fTime;
+        // DPC and interrupt time (Reserved1[0] and [1]) are part of the kernel time
+        dpcTime = 100.0 * results.vSystemProcessorPerfInfo[x].Reserved1[0].QuadPart / 10000000 / fTime;
+        intrTime = 100.0 * results.vSystemProcessorPerfInfo[x].Reserved1[1].QuadPart / 10000000 / fTime;
 
         thisTime = (krnlTime + userTime) - idleTime;
 
-        sprintf_s(szFloatBuffer, sizeof(szFloatBuffer), "%4u| %6.2lf%%| %6.2lf%%|  %6.2lf%%| %6.2lf%%\n",
+        sprintf_s(szFloatBuffer, sizeof(szFloatBuffer), "%4u| %6.2lf%%| %6.2lf%%|  %6.2lf%%| %6.2lf%%| %6.2lf%%| %6.2lf%%\n",
             x,
             thisTime,
             userTime,
             krnlTime - idleTime,
-            idleTime);
+            idleTime,
+            dpcTime,
+            intrTime);
         _Print("%s", szFloatBuffer);
 
         busyTime += thisTime;
         totalIdleTime += idleTime;
         totalUserTime += userTime;
         totalKrnlTime += krnlTime;
+        totalDpcTime += dpcTime;
+        totalIntrTime += intrTime;
     }
-    _Print("-------------------------------------------\n");
+    _Print("-----------------------------------------------------------\n");
 
-    sprintf_s(szFloatBuffer, sizeof(szFloatBuffer), "avg.| %6.2lf%%| %6.2lf%%|  %6.2lf%%| %6.2lf%%\n",
+    sprintf_s(szFloatBuffer, sizeof(szFloatBuffer), "avg.| %6.2lf%%| %6.2lf%%|  %6.2lf%%| %6.2lf%%| %6.2lf%%| %6.2lf%%\n",
         busyTime / ulProcCount,
         totalUserTime / ulProcCount,
         (totalKrnlTime - totalIdleTime) / ulProcCount,
-        totalIdleTime / ulProcCount);
+        totalIdleTime / ulProcCount,
+        totalDpcTime / ulProcCount,
+        totalIntrTime / ulProcCount);
     _Print("%s", szFloatBuffer);
 }
 
+void ResultParser::_PrintCpuEfficiency(const Results& results)
+{
+    UINT64 ullTotalBytes = 0;
+    UINT64 ullTotalIOCount = 0;
+    UINT64 ullTotalCpuTime = 0;
+    UINT64 ullTotalCycleCount = 0;
+
+    _Print("thread |  User (ms) | Kernel (ms) |  CPU  | cycles per I/O | CPU us per I/O | CPU us per MiB\n");
+    _Print("------------------------------------------------------------------------------------------\n");
+
+    for (size_t iThread = 0; iThread < results.vThreadResults.size(); iThread++)
+    {
+        const ThreadResults& threadResults = results.vThreadResults[iThread];
+        UINT64 ullBytes = 0;
+        UINT64 ullIOCount = 0;
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            ullBytes += targetResults.ullBytesCount;
+            ullIOCount += targetResults.ullIOCount;
+        }
+
+        double fTime = results.GetThreadTimeInSeconds(iThread);
+        UINT64 ullCpuTime = threadResults.ullKernelTime + threadResults.ullUserTime;
+        _Print("%6u | %10.2f | %11.2f | %4.0f%% | %14.0f | %14.2f | %14.2f\n",
+            iThread,
+            threadResults.ullUserTime / 10000.0,
+            threadResults.ullKernelTime / 10000.0,
+            (fTime > 0) ? 100.0 * ullCpuTime / 10000000 / fTime : 0,
+            (ullIOCount > 0) ? (double)threadResults.ullCycleCount / ullIOCount : 0,
+            (ullIOCount > 0) ? ullCpuTime / 10.0 / ullIOCount : 0,
+            (ullBytes > 0) ? ullCpuTime / 10.0 / ((double)ullBytes / (1024 * 1024)) : 0);
+
+        ullTotalBytes += ullBytes;
+        ullTotalIOCount += ullIOCount;
+        ullTotalCpuTime += ullCpuTime;
+        ullTotalCycleCount += threadResults.ullCycleCount;
+    }
+
+    _Print("------------------------------------------------------------------------------------------\n");
+    _Print("total: |            |             |       | %14.0f | %14.2f | %14.2f\n",
+        (ullTotalIOCount > 0) ? (double)ullTotalCycleCount / ullTotalIOCount : 0,
+        (ullTotalIOCount > 0) ? ullTotalCpuTime / 10.0 / ullTotalIOCount : 0,
+        (ullTotalBytes > 0) ? ullTotalCpuTime / 10.0 / ((double)ullTotalBytes / (1024 * 1024)) : 0);
+
+    // all the CPU busy in the system, which includes the kernel work done for the I/Os outside the worker threads
+    double fBusyTime = 0;
+    for (const auto& info : results.vSystemProcessorPerfInfo)
+    {
+        fBusyTime += (double)(info.KernelTime.QuadPart + info.UserTime.QuadPart - info.IdleTime.QuadPart) / 10;
+    }
+    _Print("system:|            |             |       |                | %14.2f | %14.2f\n",
+        (ullTotalIOCount > 0) ? fBusyTime / ullTotalIOCount : 0,
+        (ullTotalBytes > 0) ? fBusyTime / ((double)ullTotalBytes / (1024 * 1024)) : 0);
+}
+
 void ResultParser::_PrintSectionFieldNames(const TimeSpan& timeSpan)
 {
     _Print("thread |       bytes     |     I/Os     |     MB/s   |  I/O per s %s%s%s|  file\n",
@@ -476,10 +633,11 @@ void ResultParser::_PrintSectionBorderLine(const TimeSpan& timeSpan)
 
 void ResultParser::_PrintSection(_SectionEnum section, const TimeSpan& timeSpan, const Results& results)
 {
-	double fTime = PerfTimer::PerfTimeToSeconds(results.ullTimeCount);
 	double fBucketTime = timeSpan.GetIoBucketDurationInMilliseconds() / 1000.0;
 	UINT64 ullTotalBytesCount = 0;
 	UINT64 ullTotalIOCount = 0;
+	double fTotalBytesPerSecond = 0;    // sum of the per-thread rates, each over the thread's own window
+	double fTotalIOPerSecond = 0;
 	Histogram<float> totalLatencyHistogram;
 	IoBucketizer totalIoBucketizer;
 
@@ -490,6 +648,7 @@ void ResultParser::_PrintSection(_SectionEnum section, const TimeSpan& timeSpan,
 	for (unsigned int iThread = 0; iThread < results.vThreadResults.size(); ++iThread)
 	{
 		const ThreadResults& threadResults = results.vThreadResults[iThread];
+		double fTime = results.GetThreadTimeInSeconds(iThread);
 		for (unsigned int iFile = 0; iFile < threadResults.vTargetResults.size(); iFile++)
 		{
 			const TargetResults& targetResults = threadResults.vTargetResults[iFile];
@@ -575,6 +734,8 @@ void ResultParser::_PrintSection(_SectionEnum section, const TimeSpan& timeSpan,
 
 			ullTotalBytesCount += ullBytesCount;
 			ullTotalIOCount += ullIOCount;
+			fTotalBytesPerSecond += (double) ullBytesCount / fTime;
+			fTotalIOPerSecond += (double) ullIOCount / fTime;
 		}
 	}
 
@@ -590,13 +751,13 @@ void ResultParser::_PrintSection(_SectionEnum section, const TimeSpan& timeSpan,
 	_Print("total:   %15llu | %12llu | %10.2f | %10.2f",
 		ullTotalBytesCount,
 		ullTotalIOCount,
-		(double) ullTotalBytesCount / 1024 / 1024 / fTime,
-		(double) ullTotalIOCount / fTime);
+		fTotalBytesPerSecond / 1024 / 1024,
+		fTotalIOPerSecond);
 
 
 	if (section == _SectionEnum::TOTAL)
 	{
-		_totalScore = (int)(ullTotalBytesCount / 1000 / fTime);
+		_totalScore = (int)(fTotalBytesPerSecond / 1000);
 	}
 
     if (timeSpan.GetMeasureLatency())
@@ -626,6 +787,853 @@ void ResultParser::_PrintSection(_SectionEnum section, const TimeSpan& timeSpan,
     _Print("\n");
 }
 
+void ResultParser::_PrintMeasurementWindow(const Results& results)
+{
+    UINT64 ullMinStart = MAXUINT64;
+    UINT64 ullMaxStart = 0;
+    UINT64 ullMinEnd = MAXUINT64;
+    UINT64 ullMaxEnd = 0;
+
+    _Print("thread | window (s) | start offset (ms) | end offset (ms)\n");
+    _Print("---------------------------------------------------------\n");
+
+    // offsets are relative to the earliest start among the threads
+    for (const auto& threadResults : results.vThreadResults)
+    {
+        if (threadResults.ullAccountingStartTime != 0)
+        {
+            ullMinStart = min(ullMinStart, threadResults.ullAccountingStartTime);
+            ullMaxStart = max(ullMaxStart, threadResults.ullAccountingStartTime);
+            ullMinEnd = min(ullMinEnd, threadResults.ullAccountingEndTime);
+            ullMaxEnd = max(ullMaxEnd, threadResults.ullAccountingEndTime);
+        }
+    }
+
+    for (unsigned int iThread = 0; iThread < results.vThreadResults.size(); ++iThread)
+    {
+        const ThreadResults& threadResults = results.vThreadResults[iThread];
+        if (threadResults.ullAccountingStartTime == 0)
+        {
+            _Print("%6u |        N/A |               N/A |             N/A\n", iThread);
+            continue;
+        }
+
+        _Print("%6u | %10.3f | %17.3f | %15.3f\n",
+            iThread,
+            results.GetThreadTimeInSeconds(iThread),
+            PerfTimer::PerfTimeToMilliseconds(threadResults.ullAccountingStartTime - ullMinStart),
+            PerfTimer::PerfTimeToMilliseconds(threadResults.ullAccountingEndTime - ullMinStart));
+    }
+
+    _Print("---------------------------------------------------------\n");
+    if (ullMaxStart != 0)
+    {
+        _Print("start skew: %.3fms | end skew: %.3fms\n",
+            PerfTimer::PerfTimeToMilliseconds(ullMaxStart - ullMinStart),
+            PerfTimer::PerfTimeToMilliseconds(ullMaxEnd - ullMinEnd));
+    }
+}
+
+void ResultParser::_PrintWorkerCounters(const Results& results)
+{
+    UINT64 ullIOCount = 0;
+    UINT64 ullCycleCount = 0;
+    for (const auto& threadResults : results.vThreadResults)
+    {
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            ullIOCount += targetResults.ullIOCount;
+        }
+        ullCycleCount += threadResults.ullCycleCount;
+    }
+
+    const struct WorkerCounters& counters = results.WorkerCounters;
+    double fIOCount = (ullIOCount > 0) ? (double)ullIOCount : 1;
+
+    _Print("counter                    |          total |        per I/O\n");
+    _Print("--------------------------------------------------------------\n");
+    _Print("cycles (workers)           | %14I64u | %14.2f\n", ullCycleCount, ullCycleCount / fIOCount);
+    _Print("context switches (workers) | %14I64u | %14.4f\n", counters.ullContextSwitches, counters.ullContextSwitches / fIOCount);
+    _Print("page faults (process)      | %14I64u | %14.4f\n", counters.ullPageFaults, counters.ullPageFaults / fIOCount);
+    _Print("read operations (process)  | %14I64u | %14.4f\n", counters.ullReadOperations, counters.ullReadOperations / fIOCount);
+    _Print("write operations (process) | %14I64u | %14.4f\n", counters.ullWriteOperations, counters.ullWriteOperations / fIOCount);
+    _Print("other operations (process) | %14I64u | %14.4f\n", counters.ullOtherOperations, counters.ullOtherOperations / fIOCount);
+
+    _Print("\nthread | context switches |   per I/O\n");
+    _Print("----------------------------------------\n");
+    for (size_t iThread = 0; iThread < results.vThreadResults.size(); iThread++)
+    {
+        const ThreadResults& threadResults = results.vThreadResults[iThread];
+        UINT64 ullThreadIOCount = 0;
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            ullThreadIOCount += targetResults.ullIOCount;
+        }
+        _Print("%6u | %16I64u | %9.4f\n",
+            iThread,
+            threadResults.ullContextSwitches,
+            (ullThreadIOCount > 0) ? (double)threadResults.ullContextSwitches / ullThreadIOCount : 0);
+    }
+}
+
+void ResultParser::_PrintTrace(const Results& results)
+{
+    _Print("trace file: %s\n", results.sTraceFile.c_str());
+    _Print("records: %I64u", results.ullTraceRecords);
+    if (results.ullTraceOverwrittenRecords > 0)
+    {
+        _Print(" (the ring wrapped, %I64u older records were overwritten)", results.ullTraceOverwrittenRecords);
+    }
+    _Print("\noverhead: %.1fns per I/O (measured before the run)\n", results.fTraceRecordNs);
+    _Print("final flush: %.3fms\n", results.fTraceFlushMilliseconds);
+}
+
+void ResultParser::_PrintVerify(const Results& results)
+{
+    static const char *vszChecks[] = { "verified", "unwritten", "raced", "stale", "misplaced", "corrupt" };
+    static_assert(_countof(vszChecks) == static_cast<size_t>(BlockCheck::Count), "every block check needs a name");
+
+    _Print("thread |   stamped |      read |  verified | unwritten |     raced |    errors | cost (us/IO) | file\n");
+    _Print("------------------------------------------------------------------------------------------------------\n");
+
+    UINT64 ullTotalWrites = 0;
+    UINT64 ullTotalReads = 0;
+    UINT64 vullTotalChecks[static_cast<size_t>(BlockCheck::Count)] = {};
+    UINT64 ullTotalErrors = 0;
+    UINT64 ullTotalTime = 0;
+    for (unsigned int iThread = 0; iThread < results.vThreadResults.size(); ++iThread)
+    {
+        const ThreadResults& threadResults = results.vThreadResults[iThread];
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            UINT64 ullIOCount = targetResults.ullVerifyWriteCount + targetResults.ullVerifyReadCount;
+            if (ullIOCount == 0)
+            {
+                continue;
+            }
+
+            _Print("%6u | %9I64u | %9I64u | %9I64u | %9I64u | %9I64u | %9I64u | %12.3f | %s\n",
+                iThread,
+                targetResults.ullVerifyWriteCount,
+                targetResults.ullVerifyReadCount,
+                targetResults.vullVerifyChecks[static_cast<size_t>(BlockCheck::Verified)],
+                targetResults.vullVerifyChecks[static_cast<size_t>(BlockCheck::Unwritten)],
+                targetResults.vullVerifyChecks[static_cast<size_t>(BlockCheck::Raced)],
+                targetResults.ullVerifyErrorCount,
+                PerfTimer::PerfTimeToMicroseconds(targetResults.ullVerifyTime) / ullIOCount,
+                targetResults.sPath.c_str());
+
+            ullTotalWrites += targetResults.ullVerifyWriteCount;
+            ullTotalReads += targetResults.ullVerifyReadCount;
+            for (size_t i = 0; i < static_cast<size_t>(BlockCheck::Count); i++)
+            {
+                vullTotalChecks[i] += targetResults.vullVerifyChecks[i];
+            }
+            ullTotalErrors += targetResults.ullVerifyErrorCount;
+            ullTotalTime += targetResults.ullVerifyTime;
+        }
+    }
+
+    _Print("------------------------------------------------------------------------------------------------------\n");
+    _Print("total: | %9I64u | %9I64u | %9I64u | %9I64u | %9I64u | %9I64u | %12.3f |\n",
+        ullTotalWrites,
+        ullTotalReads,
+        vullTotalChecks[static_cast<size_t>(BlockCheck::Verified)],
+        vullTotalChecks[static_cast<size_t>(BlockCheck::Unwritten)],
+        vullTotalChecks[static_cast<size_t>(BlockCheck::Raced)],
+        ullTotalErrors,
+        (ullTotalWrites + ullTotalReads > 0) ? PerfTimer::PerfTimeToMicroseconds(ullTotalTime) / (ullTotalWrites + ullTotalReads) : 0);
+    _Print("stale: %I64u  misplaced: %I64u  corrupt: %I64u  verification time: %.3fms (counted from the start, warm up included)\n",
+        vullTotalChecks[static_cast<size_t>(BlockCheck::Stale)],
+        vullTotalChecks[static_cast<size_t>(BlockCheck::Misplaced)],
+        vullTotalChecks[static_cast<size_t>(BlockCheck::Corrupt)],
+        PerfTimer::PerfTimeToMilliseconds(ullTotalTime));
+
+    if (ullTotalErrors == 0)
+    {
+        return;
+    }
+
+    _Print("\nthread |     check |           offset | found offset | target | generation | expected | written (s) |  read (s) | bad byte | file\n");
+    _Print("-----------------------------------------------------------------------------------------------------------------------------\n");
+    for (unsigned int iThread = 0; iThread < results.vThreadResults.size(); ++iThread)
+    {
+        const ThreadResults& threadResults = results.vThreadResults[iThread];
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            for (const auto& error : targetResults.vVerifyErrors)
+            {
+                _Print("%6u | %9s | %16I64u | %12I64u | %6u | %10I64u | %8I64u | %11.6f | %9.6f | %8u | %s\n",
+                    iThread,
+                    vszChecks[static_cast<size_t>(error.check)],
+                    error.ullOffset,
+                    error.ullFoundOffset,
+                    error.ulFoundTarget,
+                    error.ullFoundGeneration,
+                    error.ullExpectedGeneration,
+                    PerfTimer::PerfTimeToSeconds(error.ullWriteTime),
+                    PerfTimer::PerfTimeToSeconds(error.ullReadTime),
+                    error.ulFirstBadByte,
+                    targetResults.sPath.c_str());
+            }
+        }
+    }
+    _Print("(times from the start of the TimeSpan; the first %u errors of each thread and target are listed)\n", MAX_VERIFY_ERRORS_PER_TARGET);
+}
+
+void ResultParser::_PrintFlush(const Results& results)
+{
+    _Print("thread |   flushes |  AvgLat (us) |   50%% (us) |   99%% (us) |   max (us) | durable write AvgLat |  99%% (us) | file\n");
+    _Print("---------------------------------------------------------------------------------------------------------------\n");
+
+    UINT64 ullTotalFlushes = 0;
+    Histogram<float> totalFlush;
+    Histogram<float> totalDurableWrite;
+    auto printRow = [this](const char *pszThread, UINT64 ullFlushes, const Histogram<float>& flush, const Histogram<float>& durableWrite, const char *pszPath)
+    {
+        bool fFlush = (flush.GetSampleSize() > 0);
+        bool fDurableWrite = (durableWrite.GetSampleSize() > 0);
+        _Print("%6s | %9I64u | %12.3f | %10.3f | %10.3f | %10.3f | %20.3f | %10.3f | %s\n",
+            pszThread,
+            ullFlushes,
+            fFlush ? flush.GetAvg() : 0,
+            fFlush ? flush.GetPercentile(0.5) : 0,
+            fFlush ? flush.GetPercentile(0.99) : 0,
+            fFlush ? flush.GetMax() : 0,
+            fDurableWrite ? durableWrite.GetAvg() : 0,
+            fDurableWrite ? durableWrite.GetPercentile(0.99) : 0,
+            pszPath);
+    };
+
+    for (unsigned int iThread = 0; iThread < results.vThreadResults.size(); ++iThread)
+    {
+        const ThreadResults& threadResults = results.vThreadResults[iThread];
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            if (targetResults.ullFlushCount == 0)
+            {
+                continue;
+            }
+
+            char szThread[16];
+            sprintf_s(szThread, _countof(szThread), "%u", iThread);
+            printRow(szThread, targetResults.ullFlushCount, targetResults.flushLatencyHistogram, targetResults.durableWriteLatencyHistogram, targetResults.sPath.c_str());
+
+            ullTotalFlushes += targetResults.ullFlushCount;
+            totalFlush.Merge(targetResults.flushLatencyHistogram);
+            totalDurableWrite.Merge(targetResults.durableWriteLatencyHistogram);
+        }
+    }
+
+    _Print("---------------------------------------------------------------------------------------------------------------\n");
+    printRow("total:", ullTotalFlushes, totalFlush, totalDurableWrite, "");
+    if ((totalFlush.GetSampleSize() == 0) && (totalDurableWrite.GetSampleSize() == 0))
+    {
+        _Print("note: flush and durable write latencies are measured with -L\n");
+    }
+}
+
+void ResultParser::_PrintLogWriter(const Results& results)
+{
+    double fTime = PerfTimer::PerfTimeToSeconds(results.ullTimeCount);
+
+    _Print("thread |   commits |  commits/s |  batches | avg batch |  late | AvgLat (us) |   50%% (us) |   99%% (us) | 99.9%% (us) | file\n");
+    _Print("--------------------------------------------------------------------------------------------------------------------\n");
+
+    UINT64 ullTotalCommits = 0;
+    UINT64 ullTotalBatches = 0;
+    UINT64 ullTotalLate = 0;
+    vector<UINT64> vullTotalBatchSizes;
+    Histogram<float> totalLatency;
+    auto printRow = [this, fTime](const char *pszThread, UINT64 ullCommits, UINT64 ullBatches, UINT64 ullLate, const Histogram<float>& latency, const char *pszPath)
+    {
+        bool fLatency = (latency.GetSampleSize() > 0);
+        _Print("%6s | %9I64u | %10.2f | %8I64u | %9.2f | %5I64u | %11.3f | %10.3f | %10.3f | %10.3f | %s\n",
+            pszThread,
+            ullCommits,
+            (fTime > 0) ? ullCommits / fTime : 0,
+            ullBatches,
+            (ullBatches > 0) ? static_cast<double>(ullCommits) / ullBatches : 0,
+            ullLate,
+            fLatency ? latency.GetAvg() : 0,
+            fLatency ? latency.GetPercentile(0.5) : 0,
+            fLatency ? latency.GetPercentile(0.99) : 0,
+            fLatency ? latency.GetPercentile(0.999) : 0,
+            pszPath);
+    };
+
+    for (unsigned int iThread = 0; iThread < results.vThreadResults.size(); ++iThread)
+    {
+        const ThreadResults& threadResults = results.vThreadResults[iThread];
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            if (targetResults.ullLogBatchCount == 0)
+            {
+                continue;
+            }
+
+            char szThread[16];
+            sprintf_s(szThread, _countof(szThread), "%u", iThread);
+            printRow(szThread,
+                targetResults.ullCommitCount,
+                targetResults.ullLogBatchCount,
+                targetResults.ullLateCommitCount,
+                targetResults.commitLatencyHistogram,
+                targetResults.sPath.c_str());
+
+            ullTotalCommits += targetResults.ullCommitCount;
+            ullTotalBatches += targetResults.ullLogBatchCount;
+            ullTotalLate += targetResults.ullLateCommitCount;
+            totalLatency.Merge(targetResults.commitLatencyHistogram);
+            if (vullTotalBatchSizes.size() < targetResults.vullLogBatchSizes.size())
+            {
+                vullTotalBatchSizes.resize(targetResults.vullLogBatchSizes.size());
+            }
+            for (size_t i = 0; i < targetResults.vullLogBatchSizes.size(); i++)
+            {
+                vullTotalBatchSizes[i] += targetResults.vullLogBatchSizes[i];
+            }
+        }
+    }
+
+    _Print("--------------------------------------------------------------------------------------------------------------------\n");
+    printRow("total:", ullTotalCommits, ullTotalBatches, ullTotalLate, totalLatency, "");
+    _Print("(late: commits held back by the previous commit of their client)\n");
+
+    // batch sizes in power of two buckets: 1, 2, 3-4, 5-8, ...
+    _Print("\ncommits per batch |    batches |      %%\n");
+    _Print("---------------------------------------\n");
+    for (size_t ullLow = 1, ullHigh = 1; ullLow < vullTotalBatchSizes.size(); ullLow = ullHigh + 1, ullHigh *= 2)
+    {
+        UINT64 ullBatches = 0;
+        for (size_t i = ullLow; (i <= ullHigh) && (i < vullTotalBatchSizes.size()); i++)
+        {
+            ullBatches += vullTotalBatchSizes[i];
+        }
+
+        char szRange[32];
+        if (ullLow == ullHigh)
+        {
+            sprintf_s(szRange, _countof(szRange), "%u", static_cast<UINT32>(ullLow));
+        }
+        else
+        {
+            sprintf_s(szRange, _countof(szRange), "%u-%u", static_cast<UINT32>(ullLow), static_cast<UINT32>(ullHigh));
+        }
+        _Print("%17s | %10I64u | %6.2f\n", szRange, ullBatches, (ullTotalBatches > 0) ? 100.0 * ullBatches / ullTotalBatches : 0);
+    }
+}
+
+void ResultParser::_PrintDiscard(const TimeSpan& timeSpan, const Results& results)
+{
+    double fTime = PerfTimer::PerfTimeToSeconds(results.ullTimeCount);
+
+    _Print("thread |  discards |  discards/s |     MB/s | AvgLat (us) |   50%% (us) |   99%% (us) |   max (us) | bursts | burst AvgLat (us) | burst max (us) | file\n");
+    _Print("--------------------------------------------------------------------------------------------------------------------------------------------------\n");
+
+    UINT64 ullTotalDiscards = 0;
+    UINT64 cbTotalDiscarded = 0;
+    UINT64 ullTotalBursts = 0;
+    Histogram<float> totalLatency;
+    Histogram<float> totalBurstLatency;
+    auto printRow = [this, fTime](const char *pszThread, UINT64 ullDiscards, UINT64 cbDiscarded, UINT64 ullBursts, const Histogram<float>& latency, const Histogram<float>& burstLatency, const char *pszPath)
+    {
+        bool fLatency = (latency.GetSampleSize() > 0);
+        bool fBurstLatency = (burstLatency.GetSampleSize() > 0);
+        _Print("%6s | %9I64u | %11.2f | %8.2f | %11.3f | %10.3f | %10.3f | %10.3f | %6I64u | %17.3f | %14.3f | %s\n",
+            pszThread,
+            ullDiscards,
+            (fTime > 0) ? ullDiscards / fTime : 0,
+            (fTime > 0) ? cbDiscarded / fTime / (1024 * 1024) : 0,
+            fLatency ? latency.GetAvg() : 0,
+            fLatency ? latency.GetPercentile(0.5) : 0,
+            fLatency ? latency.GetPercentile(0.99) : 0,
+            fLatency ? latency.GetMax() : 0,
+            ullBursts,
+            fBurstLatency ? burstLatency.GetAvg() : 0,
+            fBurstLatency ? burstLatency.GetMax() : 0,
+            pszPath);
+    };
+
+    IoBucketizer totalReadBucketizer;
+    IoBucketizer totalWriteBucketizer;
+    vector<UINT64> vullBurstTimes;
+    for (unsigned int iThread = 0; iThread < results.vThreadResults.size(); ++iThread)
+    {
+        const ThreadResults& threadResults = results.vThreadResults[iThread];
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            totalReadBucketizer.Merge(targetResults.readBucketizer);
+            totalWriteBucketizer.Merge(targetResults.writeBucketizer);
+            if (targetResults.ullDiscardCount == 0)
+            {
+                continue;
+            }
+
+            char szThread[16];
+            sprintf_s(szThread, _countof(szThread), "%u", iThread);
+            printRow(szThread,
+                targetResults.ullDiscardCount,
+                targetResults.ullDiscardBytesCount,
+                targetResults.ullDiscardBurstCount,
+                targetResults.discardLatencyHistogram,
+                targetResults.discardBurstLatencyHistogram,
+                targetResults.sPath.c_str());
+
+            ullTotalDiscards += targetResults.ullDiscardCount;
+            cbTotalDiscarded += targetResults.ullDiscardBytesCount;
+            ullTotalBursts += targetResults.ullDiscardBurstCount;
+            totalLatency.Merge(targetResults.discardLatencyHistogram);
+            totalBurstLatency.Merge(targetResults.discardBurstLatencyHistogram);
+            vullBurstTimes.insert(vullBurstTimes.end(), targetResults.vullDiscardBurstTimes.begin(), targetResults.vullDiscardBurstTimes.end());
+        }
+    }
+
+    _Print("--------------------------------------------------------------------------------------------------------------------------------------------------\n");
+    printRow("total:", ullTotalDiscards, cbTotalDiscarded, ullTotalBursts, totalLatency, totalBurstLatency, "");
+    if ((totalLatency.GetSampleSize() == 0) && (totalBurstLatency.GetSampleSize() == 0))
+    {
+        _Print("note: discard latencies are measured with -L\n");
+    }
+
+    // read and write latency in the intervals of the time series (-D) which follow
+    // the bursts, to show how long the device takes to absorb a bulk discard
+    if (vullBurstTimes.empty() || (!totalReadBucketizer.HasLatency() && !totalWriteBucketizer.HasLatency()))
+    {
+        return;
+    }
+
+    const size_t cIntervals = 5;
+    UINT32 ulBucketDuration = timeSpan.GetIoBucketDurationInMilliseconds();
+    double fReadLatency[cIntervals] = {};
+    double fWriteLatency[cIntervals] = {};
+    UINT64 ullReads[cIntervals] = {};
+    UINT64 ullWrites[cIntervals] = {};
+    for (UINT64 ullBurstTime : vullBurstTimes)
+    {
+        size_t iBurstBucket = static_cast<size_t>(ullBurstTime / PerfTimer::MillisecondsToPerfTime(ulBucketDuration));
+        for (size_t i = 0; i < cIntervals; i++)
+        {
+            size_t iBucket = iBurstBucket + i;
+            if (iBucket < totalReadBucketizer.GetNumberOfValidBuckets())
+            {
+                ullReads[i] += totalReadBucketizer.GetIoBucket(iBucket);
+                fReadLatency[i] += totalReadBucketizer.GetLatencySum(iBucket);
+            }
+            if (iBucket < totalWriteBucketizer.GetNumberOfValidBuckets())
+            {
+                ullWrites[i] += totalWriteBucketizer.GetIoBucket(iBucket);
+                fWriteLatency[i] += totalWriteBucketizer.GetLatencySum(iBucket);
+            }
+        }
+    }
+
+    _Print("\nlatency after bursts, in %ums intervals of the time series\n", ulBucketDuration);
+    _Print("interval | read AvgLat (ms) | write AvgLat (ms)\n");
+    _Print("--------------------------------------------\n");
+    for (size_t i = 0; i < cIntervals; i++)
+    {
+        _Print("%8u | %16.3f | %17.3f\n",
+            static_cast<UINT32>(i),
+            (ullReads[i] > 0) ? fReadLatency[i] / ullReads[i] : 0,
+            (ullWrites[i] > 0) ? fWriteLatency[i] / ullWrites[i] : 0);
+    }
+    _Print("(interval 0 holds the burst)\n");
+}
+
+void ResultParser::_PrintFileOperations(const Results& results)
+{
+    static const char *vszOperations[] = { "open/read", "create", "stat", "delete" };
+    double fTime = PerfTimer::PerfTimeToSeconds(results.ullTimeCount);
+
+    UINT64 vullCounts[FILE_OPERATION_COUNT] = {};
+    Histogram<float> vLatencies[FILE_OPERATION_COUNT];
+    UINT64 cbRead = 0;
+    UINT64 cbWritten = 0;
+    for (const auto& threadResults : results.vThreadResults)
+    {
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            for (size_t i = 0; i < FILE_OPERATION_COUNT; i++)
+            {
+                vullCounts[i] += targetResults.vullFileOperationCounts[i];
+                vLatencies[i].Merge(targetResults.vFileOperationLatencyHistograms[i]);
+            }
+            cbRead += targetResults.ullFileReadBytesCount;
+            cbWritten += targetResults.ullFileWriteBytesCount;
+        }
+    }
+
+    _Print("operation |        ops |      ops/s |  AvgLat (us) |   50%% (us) |   99%% (us) | 99.9%% (us) |   max (us)\n");
+    _Print("-------------------------------------------------------------------------------------------------\n");
+
+    UINT64 ullTotal = 0;
+    for (size_t i = 0; i < FILE_OPERATION_COUNT; i++)
+    {
+        const Histogram<float>& latency = vLatencies[i];
+        bool fLatency = (latency.GetSampleSize() > 0);
+        _Print("%9s | %10I64u | %10.2f | %12.3f | %10.3f | %10.3f | %10.3f | %10.3f\n",
+            vszOperations[i],
+            vullCounts[i],
+            (fTime > 0) ? vullCounts[i] / fTime : 0,
+            fLatency ? latency.GetAvg() : 0,
+            fLatency ? latency.GetPercentile(0.5) : 0,
+            fLatency ? latency.GetPercentile(0.99) : 0,
+            fLatency ? latency.GetPercentile(0.999) : 0,
+            fLatency ? latency.GetMax() : 0);
+        ullTotal += vullCounts[i];
+    }
+
+    _Print("-------------------------------------------------------------------------------------------------\n");
+    _Print("total:    | %10I64u | %10.2f\n", ullTotal, (fTime > 0) ? ullTotal / fTime : 0);
+    _Print("read %.2f MB/s, written %.2f MB/s\n",
+        (fTime > 0) ? cbRead / fTime / (1024 * 1024) : 0,
+        (fTime > 0) ? cbWritten / fTime / (1024 * 1024) : 0);
+    if (vLatencies[0].GetSampleSize() + vLatencies[1].GetSampleSize() + vLatencies[2].GetSampleSize() + vLatencies[3].GetSampleSize() == 0)
+    {
+        _Print("note: operation latencies are measured with -L\n");
+    }
+}
+
+void ResultParser::_PrintReplay(const Results& results)
+{
+    _Print("trace: %s\n", results.sReplayFile.c_str());
+    if (results.fReplaySpeed > 0)
+    {
+        _Print("timing: original, speed %.3fx\n", results.fReplaySpeed);
+    }
+    else
+    {
+        _Print("timing: as fast as the dependencies allow\n");
+    }
+    _Print("streams: %u\n", static_cast<UINT32>(results.cReplayStreams));
+    _Print("I/Os issued: %I64u of %I64u\n\n", results.ullReplayIssuedOperations, results.ullReplayOperations);
+
+    _Print("thread |  AvgLat (us) | orig AvgLat |   50%% (us) | orig 50%% |   99%% (us) | orig 99%% | file\n");
+    _Print("------------------------------------------------------------------------------------------\n");
+
+    Histogram<float> totalReplay;
+    Histogram<float> totalOriginal;
+    auto printRow = [this](const char *pszThread, const Histogram<float>& replay, const Histogram<float>& original, const char *pszPath)
+    {
+        bool fReplay = (replay.GetSampleSize() > 0);
+        bool fOriginal = (original.GetSampleSize() > 0);
+        _Print("%6s | %12.3f | %11.3f | %10.3f | %9.3f | %10.3f | %9.3f | %s\n",
+            pszThread,
+            fReplay ? replay.GetAvg() : 0,
+            fOriginal ? original.GetAvg() : 0,
+            fReplay ? replay.GetPercentile(0.5) : 0,
+            fOriginal ? original.GetPercentile(0.5) : 0,
+            fReplay ? replay.GetPercentile(0.99) : 0,
+            fOriginal ? original.GetPercentile(0.99) : 0,
+            pszPath);
+    };
+
+    for (unsigned int iThread = 0; iThread < results.vThreadResults.size(); ++iThread)
+    {
+        const ThreadResults& threadResults = results.vThreadResults[iThread];
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            Histogram<float> replay;
+            replay.Merge(targetResults.readLatencyHistogram);
+            replay.Merge(targetResults.writeLatencyHistogram);
+
+            char szThread[16];
+            sprintf_s(szThread, _countof(szThread), "%u", iThread);
+            printRow(szThread, replay, targetResults.originalLatencyHistogram, targetResults.sPath.c_str());
+
+            totalReplay.Merge(replay);
+            totalOriginal.Merge(targetResults.originalLatencyHistogram);
+        }
+    }
+
+    _Print("------------------------------------------------------------------------------------------\n");
+    printRow("total:", totalReplay, totalOriginal, "");
+    if (totalOriginal.GetSampleSize() == 0)
+    {
+        _Print("note: the trace has no completion times to compare with\n");
+    }
+}
+
+void ResultParser::_PrintDeviceStatistics(const Results& results)
+{
+    double fTime = PerfTimer::PerfTimeToSeconds(results.ullTimeCount);
+
+    for (const auto& deviceResults : results.vDeviceResults)
+    {
+        if (deviceResults.vSamples.size() < 2)
+        {
+            continue;
+        }
+
+        _Print("\ndevice: %s\n", deviceResults.sDevice.c_str());
+        for (const auto& sPath : deviceResults.vTargetPaths)
+        {
+            _Print("  target: %s\n", sPath.c_str());
+        }
+
+        UINT64 ullReadBytes, ullWriteBytes, ullReadCount, ullWriteCount;
+        deviceResults.GetApplicationIo(results.vThreadResults, &ullReadBytes, &ullWriteBytes, &ullReadCount, &ullWriteCount);
+        DeviceSample total = deviceResults.GetTotal();
+        UINT64 ullDeviceCount = static_cast<UINT64>(total.dwReadCount) + total.dwWriteCount;
+
+        _Print("\n             |    application |         device\n");
+        _Print("-----------------------------------------------\n");
+        _Print("read I/Os    | %14I64u | %14u\n", ullReadCount, total.dwReadCount);
+        _Print("write I/Os   | %14I64u | %14u\n", ullWriteCount, total.dwWriteCount);
+        _Print("read bytes   | %14I64u | %14I64u\n", ullReadBytes, total.ullBytesRead);
+        _Print("write bytes  | %14I64u | %14I64u\n", ullWriteBytes, total.ullBytesWritten);
+        _Print("I/O per s    | %14.2f | %14.2f\n",
+            (fTime > 0) ? (ullReadCount + ullWriteCount) / fTime : 0,
+            deviceResults.GetIops(total));
+
+        _Print("\naverage queue depth: %.2f  average in flight: %.2f  utilization: %.2f%%  split I/Os: %u (%.4f per I/O)\n",
+            deviceResults.GetAverageQueueDepth(total),
+            deviceResults.GetAverageInFlight(),
+            deviceResults.GetUtilization(total),
+            total.dwSplitCount,
+            (ullDeviceCount > 0) ? static_cast<double>(total.dwSplitCount) / ullDeviceCount : 0);
+
+        const char *pszRead = DeviceResults::GetDiscrepancy(ullReadBytes, total.ullBytesRead, false);
+        const char *pszWrite = DeviceResults::GetDiscrepancy(ullWriteBytes, total.ullBytesWritten, true);
+        if (NULL != pszRead)
+        {
+            _Print("note: %s\n", pszRead);
+        }
+        if (NULL != pszWrite)
+        {
+            _Print("note: %s\n", pszWrite);
+        }
+
+        _Print("\ninterval |     I/O per s | queue depth | in flight | utilization\n");
+        _Print("----------------------------------------------------------------\n");
+        for (size_t iSample = 1; iSample < deviceResults.vSamples.size(); iSample++)
+        {
+            DeviceSample delta = deviceResults.GetDelta(iSample - 1, iSample);
+            _Print("%8u | %13.2f | %11.2f | %9u | %10.2f%%\n",
+                iSample,
+                deviceResults.GetIops(delta),
+                deviceResults.GetAverageQueueDepth(delta),
+                delta.dwQueueDepth,
+                deviceResults.GetUtilization(delta));
+        }
+    }
+}
+
+void ResultParser::_PrintPasses(const Results& results)
+{
+    _Print("pass |     MiB/s    |      I/O per s\n");
+    _Print("-------------------------------------\n");
+
+    for (size_t iPass = 0; iPass < results.vPassBytesPerSecond.size(); iPass++)
+    {
+        _Print("%4u | %12.2f | %14.2f%s\n",
+            iPass + 1,
+            results.vPassBytesPerSecond[iPass] / (1024 * 1024),
+            results.vPassIops[iPass],
+            (iPass == results.iReportedPass) ? "  <- reported" : "");
+    }
+
+    _Print("-------------------------------------\n");
+
+    PassStatistics bytesStats(results.vPassBytesPerSecond);
+    PassStatistics iopsStats(results.vPassIops);
+    _Print("MiB/s: median %.2f | mean %.2f | stddev %.2f | 95%% CI +/- %.2f (%.2f%%)\n",
+        bytesStats.fMedian / (1024 * 1024),
+        bytesStats.fMean / (1024 * 1024),
+        bytesStats.fStandardDeviation / (1024 * 1024),
+        bytesStats.fConfidenceInterval / (1024 * 1024),
+        bytesStats.GetRelativeConfidenceInterval());
+    _Print("IOPS:  median %.2f | mean %.2f | stddev %.2f | 95%% CI +/- %.2f (%.2f%%)\n",
+        iopsStats.fMedian,
+        iopsStats.fMean,
+        iopsStats.fStandardDeviation,
+        iopsStats.fConfidenceInterval,
+        iopsStats.GetRelativeConfidenceInterval());
+}
+
+void ResultParser::_PrintWarmup(const Results& results)
+{
+    bool fLatency = (results.vWarmupLatency.size() == results.vWarmupIops.size());
+
+    _Print("round |      I/O per s%s\n", fLatency ? " |  AvgLat (us)" : "");
+    _Print("-----------------------%s\n", fLatency ? "---------------" : "");
+
+    for (size_t iRound = 0; iRound < results.vWarmupIops.size(); iRound++)
+    {
+        if (fLatency)
+        {
+            _Print("%5u | %14.2f | %12.2f\n", iRound + 1, results.vWarmupIops[iRound], results.vWarmupLatency[iRound]);
+        }
+        else
+        {
+            _Print("%5u | %14.2f\n", iRound + 1, results.vWarmupIops[iRound]);
+        }
+    }
+}
+
+void ResultParser::_PrintArrivals(const Results& results)
+{
+    double fTime = PerfTimer::PerfTimeToSeconds(results.ullTimeCount);
+    UINT64 ullTotalIOCount = 0;
+    UINT64 ullTotalLateIOCount = 0;
+    UINT64 ullTotalMaxBacklog = 0;
+    UINT64 ullTotalIssueLag = 0;
+
+    _Print("thread |  achieved I/O per s |  late I/Os  | max backlog | avg issue lag (ms) | file\n");
+    _Print("------------------------------------------------------------------------------------\n");
+
+    for (unsigned int iThread = 0; iThread < results.vThreadResults.size(); ++iThread)
+    {
+        const ThreadResults& threadResults = results.vThreadResults[iThread];
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            _Print("%6u | %19.2f | %11llu | %11llu | %18.3f | %s\n",
+                iThread,
+                (double)targetResults.ullIOCount / fTime,
+                targetResults.ullLateIOCount,
+                targetResults.ullMaxBacklog,
+                (targetResults.ullIOCount > 0) ? PerfTimer::PerfTimeToMilliseconds(targetResults.ullIssueLag) / targetResults.ullIOCount : 0,
+                targetResults.sPath.c_str());
+
+            ullTotalIOCount += targetResults.ullIOCount;
+            ullTotalLateIOCount += targetResults.ullLateIOCount;
+            ullTotalMaxBacklog = max(ullTotalMaxBacklog, targetResults.ullMaxBacklog);
+            ullTotalIssueLag += targetResults.ullIssueLag;
+        }
+    }
+
+    _Print("------------------------------------------------------------------------------------\n");
+    _Print("total: | %19.2f | %11llu | %11llu | %18.3f |\n",
+        (double)ullTotalIOCount / fTime,
+        ullTotalLateIOCount,
+        ullTotalMaxBacklog,
+        (ullTotalIOCount > 0) ? PerfTimer::PerfTimeToMilliseconds(ullTotalIssueLag) / ullTotalIOCount : 0);
+}
+
+void ResultParser::_PrintThrottling(const Results& results)
+{
+    double fTime = PerfTimer::PerfTimeToSeconds(results.ullTimeCount);
+
+    _Print("thread | target MB/s | achieved MB/s | target interval (us) | avg interval (us) | jitter (us) | file\n");
+    _Print("---------------------------------------------------------------------------------------------------\n");
+
+    for (unsigned int iThread = 0; iThread < results.vThreadResults.size(); ++iThread)
+    {
+        const ThreadResults& threadResults = results.vThreadResults[iThread];
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            if (targetResults.dwThroughputBytesPerMillisecond == 0)
+            {
+                continue;
+            }
+
+            UINT64 ullBlockSize = (targetResults.ullIOCount > 0) ? targetResults.ullBytesCount / targetResults.ullIOCount : 0;
+            _Print("%6u | %11.2f | %13.2f | %20.2f | %17.2f | %11.2f | %s\n",
+                iThread,
+                (double)targetResults.dwThroughputBytesPerMillisecond * 1000 / (1024 * 1024),
+                (double)targetResults.ullBytesCount / (1024 * 1024) / fTime,
+                (double)ullBlockSize * 1000 / targetResults.dwThroughputBytesPerMillisecond,
+                targetResults.GetIssueIntervalAvg(),
+                targetResults.GetIssueIntervalJitter(),
+                targetResults.sPath.c_str());
+        }
+    }
+}
+
+void ResultParser::_PrintTotalThrottling(const Results& results)
+{
+    double fTime = PerfTimer::PerfTimeToSeconds(results.ullTimeCount);
+
+    // the threads sharing a throttle are the ones working on the same file
+    vector<string> vPaths;
+    for (const auto& threadResults : results.vThreadResults)
+    {
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            if ((targetResults.dwTotalThroughputBytesPerMillisecond > 0) &&
+                (find(vPaths.begin(), vPaths.end(), targetResults.sPath) == vPaths.end()))
+            {
+                vPaths.push_back(targetResults.sPath);
+            }
+        }
+    }
+
+    for (const auto& sPath : vPaths)
+    {
+        DWORD dwTotalThroughput = 0;
+        UINT64 ullTotalBytes = 0;
+        for (const auto& threadResults : results.vThreadResults)
+        {
+            for (const auto& targetResults : threadResults.vTargetResults)
+            {
+                if (targetResults.sPath == sPath)
+                {
+                    dwTotalThroughput = targetResults.dwTotalThroughputBytesPerMillisecond;
+                    ullTotalBytes += targetResults.ullBytesCount;
+                }
+            }
+        }
+
+        _Print("file: %s\n", sPath.c_str());
+        _Print("target: %.2f MB/s | achieved: %.2f MB/s\n",
+            (double)dwTotalThroughput * 1000 / (1024 * 1024),
+            (double)ullTotalBytes / (1024 * 1024) / fTime);
+        _Print("thread |     MB/s    | share\n");
+        _Print("-----------------------------\n");
+        for (unsigned int iThread = 0; iThread < results.vThreadResults.size(); ++iThread)
+        {
+            for (const auto& targetResults : results.vThreadResults[iThread].vTargetResults)
+            {
+                if (targetResults.sPath == sPath)
+                {
+                    _Print("%6u | %11.2f | %5.1f%%\n",
+                        iThread,
+                        (double)targetResults.ullBytesCount / (1024 * 1024) / fTime,
+                        (ullTotalBytes > 0) ? 100.0 * targetResults.ullBytesCount / ullTotalBytes : 0);
+                }
+            }
+        }
+    }
+}
+
+void ResultParser::_PrintSequentialClaims(const Results& results)
+{
+    double fTime = PerfTimer::PerfTimeToSeconds(results.ullTimeCount);
+    UINT64 ullTotalBytes = 0;
+    UINT64 ullTotalIOCount = 0;
+    UINT64 ullTotalClaimCount = 0;
+
+    _Print("thread |     MB/s    |   claims   |  claims per s  | I/Os per claim | file\n");
+    _Print("------------------------------------------------------------------------------\n");
+
+    for (unsigned int iThread = 0; iThread < results.vThreadResults.size(); ++iThread)
+    {
+        const ThreadResults& threadResults = results.vThreadResults[iThread];
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            _Print("%6u | %11.2f | %10llu | %14.2f | %14.2f | %s\n",
+                iThread,
+                (double)targetResults.ullBytesCount / (1024 * 1024) / fTime,
+                targetResults.ullSequentialClaimCount,
+                (double)targetResults.ullSequentialClaimCount / fTime,
+                (targetResults.ullSequentialClaimCount > 0) ? (double)targetResults.ullIOCount / targetResults.ullSequentialClaimCount : 0,
+                targetResults.sPath.c_str());
+
+            ullTotalBytes += targetResults.ullBytesCount;
+            ullTotalIOCount += targetResults.ullIOCount;
+            ullTotalClaimCount += targetResults.ullSequentialClaimCount;
+        }
+    }
+
+    _Print("------------------------------------------------------------------------------\n");
+    _Print("total: | %11.2f | %10llu | %14.2f | %14.2f |\n",
+        (double)ullTotalBytes / (1024 * 1024) / fTime,
+        ullTotalClaimCount,
+        (double)ullTotalClaimCount / fTime,
+        (ullTotalClaimCount > 0) ? (double)ullTotalIOCount / ullTotalClaimCount : 0);
+}
+
 void ResultParser::_PrintLatencyPercentiles(const Results& results)
 {
     Histogram<float> readLatencyHistogram;
@@ -708,19 +1716,70 @@ void ResultParser::_PrintLatencyPercentiles(const Results& results)
            totalLatencyHistogram.GetMax()/1000);
 }
 
+void ResultParser::_PrintLatencyDecomposition(const Results& results)
+{
+    Histogram<float> submitLatencyHistogram;
+    Histogram<float> inFlightLatencyHistogram;
+    Histogram<float> reapLatencyHistogram;
+
+    for (const auto& thread : results.vThreadResults)
+    {
+        for (const auto& target : thread.vTargetResults)
+        {
+            submitLatencyHistogram.Merge(target.submitLatencyHistogram);
+            inFlightLatencyHistogram.Merge(target.inFlightLatencyHistogram);
+            reapLatencyHistogram.Merge(target.reapLatencyHistogram);
+        }
+    }
+
+    if (submitLatencyHistogram.GetSampleSize() == 0)
+    {
+        return;
+    }
+
+    // the decomposition is reported in microseconds: submit and reap times are usually well below a millisecond
+    _Print("latency decomposition (reap delay is an upper bound):\n\n");
+    _Print("  %%-ile | Submit (us) | In-flight (us) |  Reap (us)\n");
+    _Print("--------------------------------------------------\n");
+    _Print("    min | %11.1lf | %14.1lf | %10.1lf\n",
+           submitLatencyHistogram.GetMin(), inFlightLatencyHistogram.GetMin(), reapLatencyHistogram.GetMin());
+
+    PercentileDescriptor percentiles[] =
+    {
+        {       0.50, "50th"    },
+        {       0.90, "90th"    },
+        {       0.99, "99th"    },
+        {      0.999, "3-nines" },
+        {     0.9999, "4-nines" },
+    };
+
+    for (auto p : percentiles)
+    {
+        _Print("%7s | %11.1lf | %14.1lf | %10.1lf\n",
+               p.Name.c_str(),
+               submitLatencyHistogram.GetPercentile(p.Percentile),
+               inFlightLatencyHistogram.GetPercentile(p.Percentile),
+               reapLatencyHistogram.GetPercentile(p.Percentile));
+    }
+
+    _Print("    max | %11.1lf | %14.1lf | %10.1lf\n",
+           submitLatencyHistogram.GetMax(), inFlightLatencyHistogram.GetMax(), reapLatencyHistogram.GetMax());
+    _Print("    avg | %11.1lf | %14.1lf | %10.1lf\n",
+           submitLatencyHistogram.GetAvg(), inFlightLatencyHistogram.GetAvg(), reapLatencyHistogram.GetAvg());
+}
+
 int ResultParser::GetTotalScore()
 {
 	return _totalScore;
 }
 
-string ResultParser::ParseResults(Profile& profile, const SystemInformation& system, vector<Results> vResults)
+string ResultParser::ParseResults(Profile& profile, const SystemInformation& system, const vector<Results>& vResults)
 {
-    // TODO: print text representation of system information (see xml parser)
-    UNREFERENCED_PARAMETER(system);
-
+    // TODO: print text representation of the rest of system information (see xml parser)
     _sResult.clear();
 
     _PrintProfile(profile);
+    _PrintTimer(system);
 
     for (size_t iResult = 0; iResult < vResults.size(); iResult++)
     {
@@ -751,10 +1810,42 @@ string ResultParser::ParseResults(Profile& profile, const SystemInformation& sys
             sprintf_s(szFloatBuffer, sizeof(szFloatBuffer), "actual test time:\t%.2lfs\n", fTime);
             _Print("%s", szFloatBuffer);
             _Print("thread count:\t\t%u\n", ulThreadCnt);
+            sprintf_s(szFloatBuffer, sizeof(szFloatBuffer), "setup time:\t\t%.2lfms%s\n",
+                PerfTimer::PerfTimeToMilliseconds(results.ullSetupTime),
+                results.fWorkersReused ? " (threads re-armed)" : "");
+            _Print("%s", szFloatBuffer);
+
+            if (results.vPassBytesPerSecond.size() > 1)
+            {
+                _Print("\nPasses (pass %u of %u reported)\n", results.iReportedPass + 1, results.vPassBytesPerSecond.size());
+                _PrintPasses(results);
+                _Print("\n");
+            }
+
+            if (timeSpan.GetSteadyStateWarmup())
+            {
+                sprintf_s(szFloatBuffer, sizeof(szFloatBuffer), "warm up time:\t\t%.2lfs (%s after %u rounds)\n",
+                    PerfTimer::PerfTimeToSeconds(results.ullWarmupTime),
+                    results.fSteadyStateReached ? "steady state" : "no steady state",
+                    results.vWarmupIops.size());
+                _Print("%s", szFloatBuffer);
+            }
 
             _Print("proc count:\t\t%u\n", ulProcCount);
             _PrintCpuUtilization(results);
 
+            if (timeSpan.GetSteadyStateWarmup() && (results.vWarmupIops.size() > 0))
+            {
+                _Print("\nWarm up convergence (%ums rounds)\n", timeSpan.GetSteadyStateIntervalInMilliseconds());
+                _PrintWarmup(results);
+            }
+
+            _Print("\nMeasurement window\n");
+            _PrintMeasurementWindow(results);
+
+            _Print("\nCPU per I/O\n");
+            _PrintCpuEfficiency(results);
+
             _Print("\nTotal IO\n");
             _PrintSection(_SectionEnum::TOTAL, timeSpan, results);
 
@@ -764,10 +1855,64 @@ string ResultParser::ParseResults(Profile& profile, const SystemInformation& sys
             _Print("\nWrite IO\n");
             _PrintSection(_SectionEnum::WRITE, timeSpan, results);
 
+            bool fOpenLoop = false;
+            for (const auto& target : timeSpan.GetTargets())
+            {
+                fOpenLoop = fOpenLoop || (target.GetArrivalRate() > 0);
+            }
+
+            if (fOpenLoop || (results.fReplay && (results.fReplaySpeed > 0)))
+            {
+                _Print("\nOpen-loop arrivals\n");
+                _PrintArrivals(results);
+            }
+
+            bool fInterlockedSequential = false;
+            for (const auto& target : timeSpan.GetTargets())
+            {
+                fInterlockedSequential = fInterlockedSequential || (!target.GetUseRandomAccessPattern() && target.GetUseInterlockedSequential());
+            }
+
+            if (fInterlockedSequential)
+            {
+                _Print("\nInterlocked sequential offset claims\n");
+                _PrintSequentialClaims(results);
+            }
+
+            bool fThrottled = false;
+            for (const auto& target : timeSpan.GetTargets())
+            {
+                fThrottled = fThrottled || (target.GetThroughputInBytesPerMillisecond() > 0);
+            }
+
+            if (fThrottled)
+            {
+                _Print("\nThrottling\n");
+                _PrintThrottling(results);
+            }
+
+            bool fTotalThrottled = false;
+            for (const auto& target : timeSpan.GetTargets())
+            {
+                fTotalThrottled = fTotalThrottled || (target.GetTotalThroughputInBytesPerMillisecond() > 0);
+            }
+
+            if (fTotalThrottled)
+            {
+                _Print("\nShared throttling\n");
+                _PrintTotalThrottling(results);
+            }
+
             if (timeSpan.GetMeasureLatency())
             {
                 _Print("\n\n");
                 _PrintLatencyPercentiles(results);
+
+                if (timeSpan.GetMeasureLatencyDecomposition())
+                {
+                    _Print("\n");
+                    _PrintLatencyDecomposition(results);
+                }
             }
 
             //etw
@@ -776,6 +1921,90 @@ string ResultParser::ParseResults(Profile& profile, const SystemInformation& sys
                 _DisplayETW(results.EtwMask, results.EtwEventCounters);
                 _DisplayETWSessionInfo(results.EtwSessionInfo);
             }
+
+            if (results.fWorkerCounters)
+            {
+                _Print("\n\nWorker counters\n");
+                _PrintWorkerCounters(results);
+            }
+
+            if (!results.vDeviceResults.empty())
+            {
+                _Print("\n\nDevice statistics\n");
+                _PrintDeviceStatistics(results);
+            }
+
+            if (results.fTrace)
+            {
+                _Print("\n\nI/O trace\n");
+                _PrintTrace(results);
+            }
+
+            bool fVerify = false;
+            for (const auto& target : timeSpan.GetTargets())
+            {
+                fVerify = fVerify || target.GetVerify();
+            }
+
+            if (fVerify)
+            {
+                _Print("\n\nData verification\n");
+                _PrintVerify(results);
+            }
+
+            bool fFlush = false;
+            for (const auto& target : timeSpan.GetTargets())
+            {
+                fFlush = fFlush || (target.GetFlushInterval() > 0) || (target.GetFlushPercentage() > 0) || target.GetWriteThrough();
+            }
+
+            if (fFlush)
+            {
+                _Print("\n\nFlushes\n");
+                _PrintFlush(results);
+            }
+
+            bool fLogWriter = false;
+            for (const auto& target : timeSpan.GetTargets())
+            {
+                fLogWriter = fLogWriter || (target.GetLogClients() > 0);
+            }
+
+            if (fLogWriter)
+            {
+                _Print("\n\nGroup-commit log\n");
+                _PrintLogWriter(results);
+            }
+
+            bool fDiscard = false;
+            for (const auto& target : timeSpan.GetTargets())
+            {
+                fDiscard = fDiscard || target.GetUseDiscards();
+            }
+
+            if (fDiscard)
+            {
+                _Print("\n\nDiscards\n");
+                _PrintDiscard(timeSpan, results);
+            }
+
+            bool fFileOperations = false;
+            for (const auto& target : timeSpan.GetTargets())
+            {
+                fFileOperations = fFileOperations || (target.GetFileCount() > 0);
+            }
+
+            if (fFileOperations)
+            {
+                _Print("\n\nSmall-file operations\n");
+                _PrintFileOperations(results);
+            }
+
+            if (results.fReplay)
+            {
+                _Print("\n\nTrace replay\n");
+                _PrintReplay(results);
+            }
         }
     }
 
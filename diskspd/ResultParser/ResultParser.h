@@ -38,7 +38,7 @@ namespace UnitTests
 class ResultParser : public IResultParser
 {
 public:
-    string ParseResults(Profile& profile, const SystemInformation& system, vector<Results> vResults);
+    string ParseResults(Profile& profile, const SystemInformation& system, const vector<Results>& vResults);
 	int GetTotalScore();
 
 private:
@@ -47,12 +47,31 @@ private:
     void _DisplayETW(struct ETWMask ETWMask, struct ETWEventCounters EtwEventCounters);
     void _Print(const char *format, ...);
     void _PrintProfile(const Profile& profile);
+    void _PrintTimer(const SystemInformation& system);
     void _PrintCpuUtilization(const Results&);
+    void _PrintCpuEfficiency(const Results&);
+    void _PrintWorkerCounters(const Results&);
+    void _PrintDeviceStatistics(const Results&);
+    void _PrintTrace(const Results&);
+    void _PrintReplay(const Results&);
+    void _PrintVerify(const Results&);
+    void _PrintFlush(const Results&);
+    void _PrintLogWriter(const Results&);
+    void _PrintDiscard(const TimeSpan&, const Results&);
+    void _PrintFileOperations(const Results&);
     enum class _SectionEnum {TOTAL, READ, WRITE};
     void _PrintSectionFieldNames(const TimeSpan& timeSpan);
     void _PrintSectionBorderLine(const TimeSpan& timeSpan);
     void _PrintSection(_SectionEnum, const TimeSpan&, const Results&);
     void _PrintLatencyPercentiles(const Results&);
+    void _PrintMeasurementWindow(const Results&);
+    void _PrintPasses(const Results&);
+    void _PrintWarmup(const Results&);
+    void _PrintArrivals(const Results&);
+    void _PrintThrottling(const Results&);
+    void _PrintSequentialClaims(const Results&);
+    void _PrintTotalThrottling(const Results&);
+    void _PrintLatencyDecomposition(const Results&);
     void _PrintTimeSpan(const TimeSpan &timeSpan);
     void _PrintTarget(const Target &target, bool fUseThreadsPerFile, bool fCompletionRoutines);
 
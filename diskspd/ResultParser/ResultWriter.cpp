@@ -0,0 +1,1080 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "ResultWriter.h"
+
+#include <stdarg.h>
+#include <assert.h>
+
+#define RESULT_WRITER_SCHEMA_VERSION 1
+
+const double ResultWriter::_percentiles[] = { 0, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 0.999, 0.9999, 0.99999, 0.999999, 0.9999999, 0.99999999, 1 };
+const size_t ResultWriter::_cPercentiles = _countof(ResultWriter::_percentiles);
+
+void ResultWriter::_Print(const char *format, ...)
+{
+    assert(nullptr != format);
+    assert(nullptr != _pFile);
+    va_list listArg;
+    va_start(listArg, format);
+    vfprintf(_pFile, format, listArg);
+    va_end(listArg);
+}
+
+// same score as the text parser: total bytes per second of the timespan, in thousands
+void ResultWriter::_SetTotalScore(const Results& results)
+{
+    double fTotalBytesPerSecond = 0;
+    for (size_t iThread = 0; iThread < results.vThreadResults.size(); iThread++)
+    {
+        double fTime = results.GetThreadTimeInSeconds(iThread);
+        if (fTime < 0.0000001)
+        {
+            continue;
+        }
+        for (const auto& targetResults : results.vThreadResults[iThread].vTargetResults)
+        {
+            fTotalBytesPerSecond += targetResults.ullBytesCount / fTime;
+        }
+    }
+    _totalScore = (int)(fTotalBytesPerSecond / 1000);
+}
+
+vector<float> ResultWriter::_GetLatencyBinLimits()
+{
+    vector<float> vLimits;
+    for (int i = 0; i <= 26; i++)
+    {
+        vLimits.push_back(static_cast<float>(1 << i));
+    }
+    return vLimits;
+}
+
+// IOPS of every bucket of the bucketizer, added to the series
+static void AddIops(vector<double>& vIops, const IoBucketizer& bucketizer, UINT32 ulBucketTimeInMs)
+{
+    size_t cBuckets = bucketizer.GetNumberOfValidBuckets();
+    if (vIops.size() < cBuckets)
+    {
+        vIops.resize(cBuckets, 0);
+    }
+    for (size_t i = 0; i < cBuckets; i++)
+    {
+        vIops[i] += bucketizer.GetIoBucket(i) / (ulBucketTimeInMs / 1000.0);
+    }
+}
+
+// discards and file operations of a target, added to the totals; the other fields of the totals are unused
+static void AddOperations(TargetResults& totalResults, const TargetResults& targetResults)
+{
+    totalResults.ullDiscardCount += targetResults.ullDiscardCount;
+    totalResults.ullDiscardBytesCount += targetResults.ullDiscardBytesCount;
+    totalResults.ullDiscardBurstCount += targetResults.ullDiscardBurstCount;
+    totalResults.discardLatencyHistogram.Merge(targetResults.discardLatencyHistogram);
+    totalResults.discardBurstLatencyHistogram.Merge(targetResults.discardBurstLatencyHistogram);
+    for (size_t i = 0; i < FILE_OPERATION_COUNT; i++)
+    {
+        totalResults.vullFileOperationCounts[i] += targetResults.vullFileOperationCounts[i];
+        totalResults.vFileOperationLatencyHistograms[i].Merge(targetResults.vFileOperationLatencyHistograms[i]);
+    }
+    totalResults.ullFileReadBytesCount += targetResults.ullFileReadBytesCount;
+    totalResults.ullFileWriteBytesCount += targetResults.ullFileWriteBytesCount;
+}
+
+/*****************************************************************************/
+// JSON
+//
+void JsonResultWriter::_Separator()
+{
+    if (!_vfFirst.empty())
+    {
+        if (!_vfFirst.back())
+        {
+            _Print(",");
+        }
+        _vfFirst.back() = false;
+    }
+}
+
+void JsonResultWriter::_Key(const char *pszName)
+{
+    _Separator();
+    if (nullptr != pszName)
+    {
+        _String(pszName);
+        _Print(":");
+    }
+}
+
+// the strings (paths, names) are in the ANSI code page; everything outside printable ASCII
+// is written as \uXXXX escapes of its UTF-16 code units, so the output is valid JSON in any code page
+void JsonResultWriter::_String(const char *pszValue)
+{
+    vector<wchar_t> vwchValue(1, L'\0');
+    int cwch = MultiByteToWideChar(CP_ACP, 0, pszValue, -1, nullptr, 0);
+    if (cwch > 0)
+    {
+        vwchValue.resize(cwch);
+        MultiByteToWideChar(CP_ACP, 0, pszValue, -1, &vwchValue[0], cwch);
+    }
+
+    fputc('"', _pFile);
+    for (const wchar_t *p = &vwchValue[0]; *p != L'\0'; p++)
+    {
+        unsigned int c = static_cast<unsigned int>(*p);
+        if ('"' == c || '\\' == c)
+        {
+            fputc('\\', _pFile);
+            fputc(static_cast<int>(c), _pFile);
+        }
+        else if ((c < 0x20) || (c >= 0x7f))
+        {
+            _Print("\\u%04x", c);
+        }
+        else
+        {
+            fputc(static_cast<int>(c), _pFile);
+        }
+    }
+    fputc('"', _pFile);
+}
+
+void JsonResultWriter::_BeginObject(const char *pszName)
+{
+    _Key(pszName);
+    _Print("{");
+    _vfFirst.push_back(true);
+}
+
+void JsonResultWriter::_EndObject()
+{
+    _vfFirst.pop_back();
+    _Print("}\n");
+}
+
+void JsonResultWriter::_BeginArray(const char *pszName)
+{
+    _Key(pszName);
+    _Print("[");
+    _vfFirst.push_back(true);
+}
+
+void JsonResultWriter::_EndArray()
+{
+    _vfFirst.pop_back();
+    _Print("]");
+}
+
+void JsonResultWriter::_Number(const char *pszName, const char *format, ...)
+{
+    _Key(pszName);
+    va_list listArg;
+    va_start(listArg, format);
+    vfprintf(_pFile, format, listArg);
+    va_end(listArg);
+}
+
+void JsonResultWriter::_StringField(const char *pszName, const char *pszValue)
+{
+    _Key(pszName);
+    _String(pszValue);
+}
+
+void JsonResultWriter::_WriteLatency(const char *pszName, const Histogram<float>& histogram, const vector<float>& vLimits)
+{
+    if (histogram.GetSampleSize() == 0)
+    {
+        return;
+    }
+
+    vector<float> vValues(_cPercentiles);
+    histogram.GetPercentiles(_percentiles, _cPercentiles, &vValues[0]);
+
+    _BeginObject(pszName);
+    _Number("samples", "%u", histogram.GetSampleSize());
+    _Number("meanMicroseconds", "%.3f", histogram.GetMean());
+    _Number("stdDevMicroseconds", "%.3f", histogram.GetStandardDeviation());
+
+    _BeginArray("percentiles");
+    for (size_t i = 0; i < _cPercentiles; i++)
+    {
+        _BeginObject(nullptr);
+        _Number("percentile", "%.6f", 100 * _percentiles[i]);
+        _Number("microseconds", "%.3f", vValues[i]);
+        _EndObject();
+    }
+    _EndArray();
+
+    vector<unsigned> vCounts = histogram.GetBinCounts(vLimits);
+    _BeginArray("histogramUpperMicroseconds");
+    for (auto limit : vLimits)
+    {
+        _Number(nullptr, "%.0f", limit);
+    }
+    _EndArray();
+    _BeginArray("histogramCounts");
+    for (auto count : vCounts)
+    {
+        _Number(nullptr, "%u", count);
+    }
+    _EndArray();
+    _EndObject();
+}
+
+void JsonResultWriter::_WriteIops(const char *pszName, const vector<double>& vRead, const vector<double>& vWrite, const vector<double>& vDiscard)
+{
+    _BeginObject(pszName);
+    _BeginArray("read");
+    for (auto iops : vRead)
+    {
+        _Number(nullptr, "%.0f", iops);
+    }
+    _EndArray();
+    _BeginArray("write");
+    for (auto iops : vWrite)
+    {
+        _Number(nullptr, "%.0f", iops);
+    }
+    _EndArray();
+    if (!vDiscard.empty())
+    {
+        _BeginArray("discard");
+        for (auto iops : vDiscard)
+        {
+            _Number(nullptr, "%.0f", iops);
+        }
+        _EndArray();
+    }
+    _EndObject();
+}
+
+// discards (-U, -Ub); a target's totals and the aggregate over all of them have the same shape
+void JsonResultWriter::_WriteDiscards(const TargetResults& targetResults, double fTime, const vector<float>& vLimits)
+{
+    _BeginObject("discards");
+    _Number("count", "%I64u", targetResults.ullDiscardCount);
+    _Number("bytes", "%I64u", targetResults.ullDiscardBytesCount);
+    _Number("perSecond", "%.2f", (fTime > 0) ? targetResults.ullDiscardCount / fTime : 0);
+    _WriteLatency("latency", targetResults.discardLatencyHistogram, vLimits);
+    _Number("bursts", "%I64u", targetResults.ullDiscardBurstCount);
+    _WriteLatency("burstLatency", targetResults.discardBurstLatencyHistogram, vLimits);
+    if (!targetResults.vullDiscardBurstTimes.empty())
+    {
+        _BeginArray("burstStartMilliseconds");
+        for (UINT64 ullBurstTime : targetResults.vullDiscardBurstTimes)
+        {
+            _Number(nullptr, "%.0f", PerfTimer::PerfTimeToMilliseconds(ullBurstTime));
+        }
+        _EndArray();
+    }
+    _EndObject();
+}
+
+// small-file operations (-mf); names follow the order of FileOperation
+void JsonResultWriter::_WriteFileOperations(const TargetResults& targetResults, double fTime, const vector<float>& vLimits)
+{
+    static const char *vszOperations[] = { "openRead", "create", "stat", "delete" };
+    static_assert(_countof(vszOperations) == FILE_OPERATION_COUNT, "every file operation needs a name");
+
+    _BeginObject("fileOperations");
+    _Number("readBytes", "%I64u", targetResults.ullFileReadBytesCount);
+    _Number("writeBytes", "%I64u", targetResults.ullFileWriteBytesCount);
+    for (size_t i = 0; i < FILE_OPERATION_COUNT; i++)
+    {
+        _BeginObject(vszOperations[i]);
+        _Number("count", "%I64u", targetResults.vullFileOperationCounts[i]);
+        _Number("perSecond", "%.2f", (fTime > 0) ? targetResults.vullFileOperationCounts[i] / fTime : 0);
+        _WriteLatency("latency", targetResults.vFileOperationLatencyHistograms[i], vLimits);
+        _EndObject();
+    }
+    _EndObject();
+}
+
+// repeated passes (-N); the rest of the timespan's results are those of the reported pass
+void JsonResultWriter::_WritePasses(const Results& results)
+{
+    PassStatistics bytesStats(results.vPassBytesPerSecond);
+    PassStatistics iopsStats(results.vPassIops);
+
+    _BeginObject("passes");
+    _Number("count", "%u", results.vPassBytesPerSecond.size());
+    _Number("reportedPass", "%u", results.iReportedPass + 1);
+    _BeginArray("bytesPerSecond");
+    for (auto fBytesPerSecond : results.vPassBytesPerSecond)
+    {
+        _Number(nullptr, "%.2f", fBytesPerSecond);
+    }
+    _EndArray();
+    _BeginArray("iosPerSecond");
+    for (auto fIops : results.vPassIops)
+    {
+        _Number(nullptr, "%.2f", fIops);
+    }
+    _EndArray();
+
+    const PassStatistics *pStats[] = { &bytesStats, &iopsStats };
+    const char *pszNames[] = { "bytesPerSecondStatistics", "iosPerSecondStatistics" };
+    for (size_t i = 0; i < _countof(pStats); i++)
+    {
+        _BeginObject(pszNames[i]);
+        _Number("median", "%.2f", pStats[i]->fMedian);
+        _Number("mean", "%.2f", pStats[i]->fMean);
+        _Number("stdDev", "%.2f", pStats[i]->fStandardDeviation);
+        _Number("confidenceInterval95", "%.2f", pStats[i]->fConfidenceInterval);
+        _EndObject();
+    }
+    _EndObject();
+}
+
+// steady-state warm up (-Ws): the IOPS and average latency of every round before the measurement
+void JsonResultWriter::_WriteWarmup(const Results& results)
+{
+    _BeginObject("warmup");
+    _Key("steadyStateReached");
+    _Print(results.fSteadyStateReached ? "true" : "false");
+    _Number("timeSeconds", "%.3f", PerfTimer::PerfTimeToSeconds(results.ullWarmupTime));
+    _BeginArray("roundIosPerSecond");
+    for (auto fIops : results.vWarmupIops)
+    {
+        _Number(nullptr, "%.2f", fIops);
+    }
+    _EndArray();
+    if (results.vWarmupLatency.size() == results.vWarmupIops.size())
+    {
+        _BeginArray("roundMeanLatencyMicroseconds");
+        for (auto fLatency : results.vWarmupLatency)
+        {
+            _Number(nullptr, "%.3f", fLatency);
+        }
+        _EndArray();
+    }
+    _EndObject();
+}
+
+// device counters (-Q) of every disk or volume behind the targets, next to what the application issued to it
+void JsonResultWriter::_WriteDevices(const Results& results)
+{
+    _BeginArray("devices");
+    for (const auto& deviceResults : results.vDeviceResults)
+    {
+        if (deviceResults.vSamples.size() < 2)
+        {
+            continue;
+        }
+
+        UINT64 ullReadBytes, ullWriteBytes, ullReadCount, ullWriteCount;
+        deviceResults.GetApplicationIo(results.vThreadResults, &ullReadBytes, &ullWriteBytes, &ullReadCount, &ullWriteCount);
+        DeviceSample total = deviceResults.GetTotal();
+        UINT64 ullDeviceCount = static_cast<UINT64>(total.dwReadCount) + total.dwWriteCount;
+
+        _BeginObject(nullptr);
+        _StringField("path", deviceResults.sDevice.c_str());
+        _BeginArray("targetPaths");
+        for (const auto& sPath : deviceResults.vTargetPaths)
+        {
+            _StringField(nullptr, sPath.c_str());
+        }
+        _EndArray();
+        _Number("applicationReadIos", "%I64u", ullReadCount);
+        _Number("applicationWriteIos", "%I64u", ullWriteCount);
+        _Number("applicationReadBytes", "%I64u", ullReadBytes);
+        _Number("applicationWriteBytes", "%I64u", ullWriteBytes);
+        _Number("readIos", "%u", total.dwReadCount);
+        _Number("writeIos", "%u", total.dwWriteCount);
+        _Number("readBytes", "%I64u", total.ullBytesRead);
+        _Number("writeBytes", "%I64u", total.ullBytesWritten);
+        _Number("iosPerSecond", "%.2f", deviceResults.GetIops(total));
+        _Number("averageQueueDepth", "%.2f", deviceResults.GetAverageQueueDepth(total));
+        _Number("averageInFlight", "%.2f", deviceResults.GetAverageInFlight());
+        _Number("utilizationPercent", "%.2f", deviceResults.GetUtilization(total));
+        _Number("splits", "%u", total.dwSplitCount);
+        _Number("splitsPerIo", "%.4f", (ullDeviceCount > 0) ? static_cast<double>(total.dwSplitCount) / ullDeviceCount : 0);
+
+        const char *pszRead = DeviceResults::GetDiscrepancy(ullReadBytes, total.ullBytesRead, false);
+        const char *pszWrite = DeviceResults::GetDiscrepancy(ullWriteBytes, total.ullBytesWritten, true);
+        if (NULL != pszRead)
+        {
+            _StringField("readDiscrepancy", pszRead);
+        }
+        if (NULL != pszWrite)
+        {
+            _StringField("writeDiscrepancy", pszWrite);
+        }
+
+        _BeginArray("intervals");
+        for (size_t iSample = 1; iSample < deviceResults.vSamples.size(); iSample++)
+        {
+            DeviceSample delta = deviceResults.GetDelta(iSample - 1, iSample);
+            _BeginObject(nullptr);
+            _Number("iosPerSecond", "%.2f", deviceResults.GetIops(delta));
+            _Number("queueDepth", "%.2f", deviceResults.GetAverageQueueDepth(delta));
+            _Number("inFlight", "%u", delta.dwQueueDepth);
+            _Number("utilizationPercent", "%.2f", deviceResults.GetUtilization(delta));
+            _Number("readIos", "%u", delta.dwReadCount);
+            _Number("writeIos", "%u", delta.dwWriteCount);
+            _Number("splits", "%u", delta.dwSplitCount);
+            _EndObject();
+        }
+        _EndArray();
+        _EndObject();
+    }
+    _EndArray();
+}
+
+void JsonResultWriter::_WriteCpus(const Results& results, double fTime)
+{
+    _BeginArray("cpus");
+    for (size_t iCpu = 0; iCpu < results.vSystemProcessorPerfInfo.size(); iCpu++)
+    {
+        const SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION& info = results.vSystemProcessorPerfInfo[iCpu];
+        double idleTime = 100.0 * info.IdleTime.QuadPart / 10000000 / fTime;
+        double krnlTime = 100.0 * info.KernelTime.QuadPart / 10000000 / fTime;
+        double userTime = 100.0 * info.UserTime.QuadPart / 10000000 / fTime;
+
+        _BeginObject(nullptr);
+        _Number("id", "%u", iCpu);
+        _Number("usagePercent", "%.2f", (krnlTime + userTime) - idleTime);
+        _Number("userPercent", "%.2f", userTime);
+        _Number("kernelPercent", "%.2f", krnlTime - idleTime);
+        _Number("idlePercent", "%.2f", idleTime);
+        _Number("dpcPercent", "%.2f", 100.0 * info.Reserved1[0].QuadPart / 10000000 / fTime);
+        _Number("interruptPercent", "%.2f", 100.0 * info.Reserved1[1].QuadPart / 10000000 / fTime);
+        _EndObject();
+    }
+    _EndArray();
+}
+
+void JsonResultWriter::_WriteTarget(const TargetResults& targetResults, double fTime, UINT32 ulBucketTimeInMs)
+{
+    _BeginObject(nullptr);
+    _StringField("path", targetResults.sPath.c_str());
+    _Number("fileSize", "%I64u", targetResults.ullFileSize);
+    _Number("bytes", "%I64u", targetResults.ullBytesCount);
+    _Number("ios", "%I64u", targetResults.ullIOCount);
+    _Number("readBytes", "%I64u", targetResults.ullReadBytesCount);
+    _Number("readIos", "%I64u", targetResults.ullReadIOCount);
+    _Number("writeBytes", "%I64u", targetResults.ullWriteBytesCount);
+    _Number("writeIos", "%I64u", targetResults.ullWriteIOCount);
+    _Number("bytesPerSecond", "%.2f", (fTime > 0) ? targetResults.ullBytesCount / fTime : 0);
+    _Number("iosPerSecond", "%.2f", (fTime > 0) ? targetResults.ullIOCount / fTime : 0);
+
+    vector<float> vLimits(_GetLatencyBinLimits());
+    _WriteLatency("readLatency", targetResults.readLatencyHistogram, vLimits);
+    _WriteLatency("writeLatency", targetResults.writeLatencyHistogram, vLimits);
+
+    if ((targetResults.ullFlushCount > 0) || (targetResults.durableWriteLatencyHistogram.GetSampleSize() > 0))
+    {
+        _Number("flushes", "%I64u", targetResults.ullFlushCount);
+        _WriteLatency("flushLatency", targetResults.flushLatencyHistogram, vLimits);
+        _WriteLatency("durableWriteLatency", targetResults.durableWriteLatencyHistogram, vLimits);
+    }
+
+    if (targetResults.ullDiscardCount > 0)
+    {
+        _WriteDiscards(targetResults, fTime, vLimits);
+    }
+
+    if (targetResults.GetFileOperationCount() > 0)
+    {
+        _WriteFileOperations(targetResults, fTime, vLimits);
+    }
+
+    vector<double> vRead, vWrite, vDiscard;
+    AddIops(vRead, targetResults.readBucketizer, ulBucketTimeInMs);
+    AddIops(vWrite, targetResults.writeBucketizer, ulBucketTimeInMs);
+    AddIops(vDiscard, targetResults.discardBucketizer, ulBucketTimeInMs);
+    if (!vRead.empty() || !vWrite.empty() || !vDiscard.empty())
+    {
+        _WriteIops("iopsSeries", vRead, vWrite, vDiscard);
+    }
+    _EndObject();
+}
+
+void JsonResultWriter::_WriteTimeSpan(size_t iTimeSpan, const TimeSpan& timeSpan, const Results& results)
+{
+    double fTime = PerfTimer::PerfTimeToSeconds(results.ullTimeCount);
+    const UINT32 ulBucketTimeInMs = timeSpan.GetIoBucketDurationInMilliseconds();
+
+    _BeginObject(nullptr);
+    _Number("timeSpan", "%u", iTimeSpan + 1);
+    _Number("testTimeSeconds", "%.3f", fTime);
+    _Number("setupMilliseconds", "%.3f", PerfTimer::PerfTimeToMilliseconds(results.ullSetupTime));
+    _Number("threadCount", "%u", results.vThreadResults.size());
+    _Number("ioBucketMilliseconds", "%u", ulBucketTimeInMs);
+
+    if (fTime < 0.0000001)
+    {
+        // interrupted before the measurements began
+        _EndObject();
+        return;
+    }
+
+    if (results.vPassBytesPerSecond.size() > 1)
+    {
+        _WritePasses(results);
+    }
+
+    if (timeSpan.GetSteadyStateWarmup())
+    {
+        _WriteWarmup(results);
+    }
+
+    _WriteCpus(results, fTime);
+
+    UINT64 ullBytesCount = 0;
+    UINT64 ullIOCount = 0;
+    UINT64 ullFlushCount = 0;
+    double fBytesPerSecond = 0;
+    double fIOPerSecond = 0;
+    Histogram<float> readLatencyHistogram;
+    Histogram<float> writeLatencyHistogram;
+    Histogram<float> flushLatencyHistogram;
+    Histogram<float> durableWriteLatencyHistogram;
+    TargetResults operationResults;         // discards and file operations only
+    vector<double> vReadIops, vWriteIops, vDiscardIops;
+
+    _BeginArray("threads");
+    for (size_t iThread = 0; iThread < results.vThreadResults.size(); iThread++)
+    {
+        const ThreadResults& threadResults = results.vThreadResults[iThread];
+        double fThreadTime = results.GetThreadTimeInSeconds(iThread);
+
+        _BeginObject(nullptr);
+        _Number("id", "%u", iThread);
+        _Number("accountedTimeSeconds", "%.6f", fThreadTime);
+        _Number("userMilliseconds", "%.3f", threadResults.ullUserTime / 10000.0);
+        _Number("kernelMilliseconds", "%.3f", threadResults.ullKernelTime / 10000.0);
+        _Number("cycles", "%I64u", threadResults.ullCycleCount);
+
+        _BeginArray("targets");
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            _WriteTarget(targetResults, fThreadTime, ulBucketTimeInMs);
+
+            ullBytesCount += targetResults.ullBytesCount;
+            ullIOCount += targetResults.ullIOCount;
+            if (fThreadTime > 0)
+            {
+                fBytesPerSecond += targetResults.ullBytesCount / fThreadTime;
+                fIOPerSecond += targetResults.ullIOCount / fThreadTime;
+            }
+            readLatencyHistogram.Merge(targetResults.readLatencyHistogram);
+            writeLatencyHistogram.Merge(targetResults.writeLatencyHistogram);
+            ullFlushCount += targetResults.ullFlushCount;
+            flushLatencyHistogram.Merge(targetResults.flushLatencyHistogram);
+            durableWriteLatencyHistogram.Merge(targetResults.durableWriteLatencyHistogram);
+            AddOperations(operationResults, targetResults);
+            AddIops(vReadIops, targetResults.readBucketizer, ulBucketTimeInMs);
+            AddIops(vWriteIops, targetResults.writeBucketizer, ulBucketTimeInMs);
+            AddIops(vDiscardIops, targetResults.discardBucketizer, ulBucketTimeInMs);
+        }
+        _EndArray();
+        _EndObject();
+    }
+    _EndArray();
+
+    _BeginObject("total");
+    _Number("bytes", "%I64u", ullBytesCount);
+    _Number("ios", "%I64u", ullIOCount);
+    _Number("bytesPerSecond", "%.2f", fBytesPerSecond);
+    _Number("iosPerSecond", "%.2f", fIOPerSecond);
+    vector<float> vLimits(_GetLatencyBinLimits());
+    _WriteLatency("readLatency", readLatencyHistogram, vLimits);
+    _WriteLatency("writeLatency", writeLatencyHistogram, vLimits);
+    if ((ullFlushCount > 0) || (durableWriteLatencyHistogram.GetSampleSize() > 0))
+    {
+        _Number("flushes", "%I64u", ullFlushCount);
+        _WriteLatency("flushLatency", flushLatencyHistogram, vLimits);
+        _WriteLatency("durableWriteLatency", durableWriteLatencyHistogram, vLimits);
+    }
+    if (operationResults.ullDiscardCount > 0)
+    {
+        _WriteDiscards(operationResults, fTime, vLimits);
+    }
+    if (operationResults.GetFileOperationCount() > 0)
+    {
+        _WriteFileOperations(operationResults, fTime, vLimits);
+    }
+    if (!vReadIops.empty() || !vWriteIops.empty() || !vDiscardIops.empty())
+    {
+        _WriteIops("iopsSeries", vReadIops, vWriteIops, vDiscardIops);
+    }
+    _EndObject();
+
+    if (!results.vDeviceResults.empty())
+    {
+        _WriteDevices(results);
+    }
+
+    _EndObject();
+}
+
+bool JsonResultWriter::WriteResults(const Profile& profile, const SystemInformation& system, const vector<Results>& vResults, FILE *pFile)
+{
+    _pFile = pFile;
+    _vfFirst.clear();
+
+    _BeginObject(nullptr);
+    _StringField("schema", "diskspd-results");
+    _Number("schemaVersion", "%u", RESULT_WRITER_SCHEMA_VERSION);
+    _StringField("version", DISKSPD_NUMERIC_VERSION_STRING);
+    _StringField("computerName", system.sComputerName.c_str());
+
+    _BeginObject("timer");
+    _Number("frequency", "%I64u", system.ullTimerFrequency);
+    _Number("overheadNanoseconds", "%.3f", system.fTimerOverheadNs);
+    _Number("resolutionNanoseconds", "%.3f", system.fTimerResolutionNs);
+    _EndObject();
+
+    _BeginArray("timeSpans");
+    for (size_t iResult = 0; iResult < vResults.size(); iResult++)
+    {
+        const Results& results = vResults[iResult];
+        _WriteTimeSpan(iResult, profile.GetTimeSpans()[iResult], results);
+        _SetTotalScore(results);
+    }
+    _EndArray();
+
+    _EndObject();
+
+    return (fflush(_pFile) == 0) && !ferror(_pFile);
+}
+
+/*****************************************************************************/
+// CSV
+//
+void CsvResultWriter::_WriteQuoted(const char *pszValue)
+{
+    fputc('"', _pFile);
+    for (const char *p = pszValue; *p != '\0'; p++)
+    {
+        if ('"' == *p)
+        {
+            fputc('"', _pFile);
+        }
+        fputc(*p, _pFile);
+    }
+    fputc('"', _pFile);
+}
+
+void CsvResultWriter::_Row(size_t iTimeSpan, const char *pszThread, const char *pszTarget, const char *pszMetric, const char *pszKey, const char *format, ...)
+{
+    _Print("%u,%s,%s,%s,%s,", iTimeSpan + 1, pszThread, pszTarget, pszMetric, pszKey);
+    va_list listArg;
+    va_start(listArg, format);
+    vfprintf(_pFile, format, listArg);
+    va_end(listArg);
+    _Print("\n");
+}
+
+void CsvResultWriter::_WriteLatency(size_t iTimeSpan, const char *pszThread, const char *pszTarget, const char *pszMetric, const Histogram<float>& histogram, const vector<float>& vLimits)
+{
+    if (histogram.GetSampleSize() == 0)
+    {
+        return;
+    }
+
+    char szMetric[64];
+    char szKey[32];
+
+    vector<float> vValues(_cPercentiles);
+    histogram.GetPercentiles(_percentiles, _cPercentiles, &vValues[0]);
+
+    sprintf_s(szMetric, _countof(szMetric), "%s_latency_mean_us", pszMetric);
+    _Row(iTimeSpan, pszThread, pszTarget, szMetric, "", "%.3f", histogram.GetMean());
+    sprintf_s(szMetric, _countof(szMetric), "%s_latency_stddev_us", pszMetric);
+    _Row(iTimeSpan, pszThread, pszTarget, szMetric, "", "%.3f", histogram.GetStandardDeviation());
+
+    sprintf_s(szMetric, _countof(szMetric), "%s_latency_percentile_us", pszMetric);
+    for (size_t i = 0; i < _cPercentiles; i++)
+    {
+        sprintf_s(szKey, _countof(szKey), "%.6f", 100 * _percentiles[i]);
+        _Row(iTimeSpan, pszThread, pszTarget, szMetric, szKey, "%.3f", vValues[i]);
+    }
+
+    // the key is the upper limit of the bin in microseconds; the last bin is open
+    vector<unsigned> vCounts = histogram.GetBinCounts(vLimits);
+    sprintf_s(szMetric, _countof(szMetric), "%s_latency_histogram", pszMetric);
+    for (size_t i = 0; i < vCounts.size(); i++)
+    {
+        if (i < vLimits.size())
+        {
+            sprintf_s(szKey, _countof(szKey), "%.0f", vLimits[i]);
+        }
+        else
+        {
+            strcpy_s(szKey, _countof(szKey), "inf");
+        }
+        _Row(iTimeSpan, pszThread, pszTarget, szMetric, szKey, "%u", vCounts[i]);
+    }
+}
+
+// the key is the end of the bucket in milliseconds since the start of the measurement
+void CsvResultWriter::_WriteIops(size_t iTimeSpan, const char *pszThread, const char *pszTarget, const vector<double>& vRead, const vector<double>& vWrite, const vector<double>& vDiscard, UINT32 ulBucketTimeInMs)
+{
+    char szKey[32];
+    for (size_t i = 0; i < vRead.size(); i++)
+    {
+        sprintf_s(szKey, _countof(szKey), "%u", ulBucketTimeInMs * (i + 1));
+        _Row(iTimeSpan, pszThread, pszTarget, "read_iops", szKey, "%.0f", vRead[i]);
+    }
+    for (size_t i = 0; i < vWrite.size(); i++)
+    {
+        sprintf_s(szKey, _countof(szKey), "%u", ulBucketTimeInMs * (i + 1));
+        _Row(iTimeSpan, pszThread, pszTarget, "write_iops", szKey, "%.0f", vWrite[i]);
+    }
+    for (size_t i = 0; i < vDiscard.size(); i++)
+    {
+        sprintf_s(szKey, _countof(szKey), "%u", ulBucketTimeInMs * (i + 1));
+        _Row(iTimeSpan, pszThread, pszTarget, "discard_iops", szKey, "%.0f", vDiscard[i]);
+    }
+}
+
+void CsvResultWriter::_WriteDiscards(size_t iTimeSpan, const char *pszThread, const char *pszTarget, const TargetResults& targetResults, double fTime, const vector<float>& vLimits)
+{
+    char szKey[32];
+
+    _Row(iTimeSpan, pszThread, pszTarget, "discards", "", "%I64u", targetResults.ullDiscardCount);
+    _Row(iTimeSpan, pszThread, pszTarget, "discard_bytes", "", "%I64u", targetResults.ullDiscardBytesCount);
+    _Row(iTimeSpan, pszThread, pszTarget, "discards_per_second", "", "%.2f", (fTime > 0) ? targetResults.ullDiscardCount / fTime : 0);
+    _WriteLatency(iTimeSpan, pszThread, pszTarget, "discard", targetResults.discardLatencyHistogram, vLimits);
+    _Row(iTimeSpan, pszThread, pszTarget, "discard_bursts", "", "%I64u", targetResults.ullDiscardBurstCount);
+    _WriteLatency(iTimeSpan, pszThread, pszTarget, "discard_burst", targetResults.discardBurstLatencyHistogram, vLimits);
+    for (size_t i = 0; i < targetResults.vullDiscardBurstTimes.size(); i++)
+    {
+        sprintf_s(szKey, _countof(szKey), "%u", i + 1);
+        _Row(iTimeSpan, pszThread, pszTarget, "discard_burst_start_ms", szKey, "%.0f", PerfTimer::PerfTimeToMilliseconds(targetResults.vullDiscardBurstTimes[i]));
+    }
+}
+
+// small-file operations (-mf); names follow the order of FileOperation
+void CsvResultWriter::_WriteFileOperations(size_t iTimeSpan, const char *pszThread, const char *pszTarget, const TargetResults& targetResults, double fTime, const vector<float>& vLimits)
+{
+    static const char *vszOperations[] = { "file_open_read", "file_create", "file_stat", "file_delete" };
+    static_assert(_countof(vszOperations) == FILE_OPERATION_COUNT, "every file operation needs a name");
+    char szMetric[64];
+
+    _Row(iTimeSpan, pszThread, pszTarget, "file_read_bytes", "", "%I64u", targetResults.ullFileReadBytesCount);
+    _Row(iTimeSpan, pszThread, pszTarget, "file_write_bytes", "", "%I64u", targetResults.ullFileWriteBytesCount);
+    for (size_t i = 0; i < FILE_OPERATION_COUNT; i++)
+    {
+        sprintf_s(szMetric, _countof(szMetric), "%s_count", vszOperations[i]);
+        _Row(iTimeSpan, pszThread, pszTarget, szMetric, "", "%I64u", targetResults.vullFileOperationCounts[i]);
+        sprintf_s(szMetric, _countof(szMetric), "%s_per_second", vszOperations[i]);
+        _Row(iTimeSpan, pszThread, pszTarget, szMetric, "", "%.2f", (fTime > 0) ? targetResults.vullFileOperationCounts[i] / fTime : 0);
+        _WriteLatency(iTimeSpan, pszThread, pszTarget, vszOperations[i], targetResults.vFileOperationLatencyHistograms[i], vLimits);
+    }
+}
+
+void CsvResultWriter::_WritePasses(size_t iTimeSpan, const Results& results)
+{
+    PassStatistics bytesStats(results.vPassBytesPerSecond);
+    PassStatistics iopsStats(results.vPassIops);
+    char szKey[32];
+
+    _Row(iTimeSpan, "total", "total", "pass_count", "", "%u", results.vPassBytesPerSecond.size());
+    _Row(iTimeSpan, "total", "total", "reported_pass", "", "%u", results.iReportedPass + 1);
+    for (size_t iPass = 0; iPass < results.vPassBytesPerSecond.size(); iPass++)
+    {
+        sprintf_s(szKey, _countof(szKey), "%u", iPass + 1);
+        _Row(iTimeSpan, "total", "total", "pass_bytes_per_second", szKey, "%.2f", results.vPassBytesPerSecond[iPass]);
+        _Row(iTimeSpan, "total", "total", "pass_ios_per_second", szKey, "%.2f", results.vPassIops[iPass]);
+    }
+
+    const PassStatistics *pStats[] = { &bytesStats, &iopsStats };
+    const char *pszNames[] = { "pass_bytes_per_second", "pass_ios_per_second" };
+    char szMetric[64];
+    for (size_t i = 0; i < _countof(pStats); i++)
+    {
+        sprintf_s(szMetric, _countof(szMetric), "%s_median", pszNames[i]);
+        _Row(iTimeSpan, "total", "total", szMetric, "", "%.2f", pStats[i]->fMedian);
+        sprintf_s(szMetric, _countof(szMetric), "%s_mean", pszNames[i]);
+        _Row(iTimeSpan, "total", "total", szMetric, "", "%.2f", pStats[i]->fMean);
+        sprintf_s(szMetric, _countof(szMetric), "%s_stddev", pszNames[i]);
+        _Row(iTimeSpan, "total", "total", szMetric, "", "%.2f", pStats[i]->fStandardDeviation);
+        sprintf_s(szMetric, _countof(szMetric), "%s_ci95", pszNames[i]);
+        _Row(iTimeSpan, "total", "total", szMetric, "", "%.2f", pStats[i]->fConfidenceInterval);
+    }
+}
+
+void CsvResultWriter::_WriteWarmup(size_t iTimeSpan, const Results& results)
+{
+    bool fLatency = (results.vWarmupLatency.size() == results.vWarmupIops.size());
+    char szKey[32];
+
+    _Row(iTimeSpan, "total", "total", "warmup_steady_state_reached", "", "%u", results.fSteadyStateReached ? 1 : 0);
+    _Row(iTimeSpan, "total", "total", "warmup_time_seconds", "", "%.3f", PerfTimer::PerfTimeToSeconds(results.ullWarmupTime));
+    for (size_t iRound = 0; iRound < results.vWarmupIops.size(); iRound++)
+    {
+        sprintf_s(szKey, _countof(szKey), "%u", iRound + 1);
+        _Row(iTimeSpan, "total", "total", "warmup_ios_per_second", szKey, "%.2f", results.vWarmupIops[iRound]);
+        if (fLatency)
+        {
+            _Row(iTimeSpan, "total", "total", "warmup_latency_mean_us", szKey, "%.3f", results.vWarmupLatency[iRound]);
+        }
+    }
+}
+
+void CsvResultWriter::_WriteDevices(size_t iTimeSpan, const Results& results)
+{
+    char szDevice[16];
+    char szKey[32];
+
+    for (size_t iDevice = 0; iDevice < results.vDeviceResults.size(); iDevice++)
+    {
+        const DeviceResults& deviceResults = results.vDeviceResults[iDevice];
+        if (deviceResults.vSamples.size() < 2)
+        {
+            continue;
+        }
+
+        UINT64 ullReadBytes, ullWriteBytes, ullReadCount, ullWriteCount;
+        deviceResults.GetApplicationIo(results.vThreadResults, &ullReadBytes, &ullWriteBytes, &ullReadCount, &ullWriteCount);
+        DeviceSample total = deviceResults.GetTotal();
+        UINT64 ullDeviceCount = static_cast<UINT64>(total.dwReadCount) + total.dwWriteCount;
+
+        sprintf_s(szDevice, _countof(szDevice), "%u", iDevice);
+        _Print("%u,device,%s,path,,", iTimeSpan + 1, szDevice);
+        _WriteQuoted(deviceResults.sDevice.c_str());
+        _Print("\n");
+        for (size_t iPath = 0; iPath < deviceResults.vTargetPaths.size(); iPath++)
+        {
+            _Print("%u,device,%s,target_path,%u,", iTimeSpan + 1, szDevice, iPath + 1);
+            _WriteQuoted(deviceResults.vTargetPaths[iPath].c_str());
+            _Print("\n");
+        }
+
+        _Row(iTimeSpan, "device", szDevice, "application_read_ios", "", "%I64u", ullReadCount);
+        _Row(iTimeSpan, "device", szDevice, "application_write_ios", "", "%I64u", ullWriteCount);
+        _Row(iTimeSpan, "device", szDevice, "application_read_bytes", "", "%I64u", ullReadBytes);
+        _Row(iTimeSpan, "device", szDevice, "application_write_bytes", "", "%I64u", ullWriteBytes);
+        _Row(iTimeSpan, "device", szDevice, "read_ios", "", "%u", total.dwReadCount);
+        _Row(iTimeSpan, "device", szDevice, "write_ios", "", "%u", total.dwWriteCount);
+        _Row(iTimeSpan, "device", szDevice, "read_bytes", "", "%I64u", total.ullBytesRead);
+        _Row(iTimeSpan, "device", szDevice, "write_bytes", "", "%I64u", total.ullBytesWritten);
+        _Row(iTimeSpan, "device", szDevice, "ios_per_second", "", "%.2f", deviceResults.GetIops(total));
+        _Row(iTimeSpan, "device", szDevice, "average_queue_depth", "", "%.2f", deviceResults.GetAverageQueueDepth(total));
+        _Row(iTimeSpan, "device", szDevice, "average_in_flight", "", "%.2f", deviceResults.GetAverageInFlight());
+        _Row(iTimeSpan, "device", szDevice, "utilization_percent", "", "%.2f", deviceResults.GetUtilization(total));
+        _Row(iTimeSpan, "device", szDevice, "splits", "", "%u", total.dwSplitCount);
+        _Row(iTimeSpan, "device", szDevice, "splits_per_io", "", "%.4f", (ullDeviceCount > 0) ? static_cast<double>(total.dwSplitCount) / ullDeviceCount : 0);
+
+        const char *pszRead = DeviceResults::GetDiscrepancy(ullReadBytes, total.ullBytesRead, false);
+        const char *pszWrite = DeviceResults::GetDiscrepancy(ullWriteBytes, total.ullBytesWritten, true);
+        if (NULL != pszRead)
+        {
+            _Print("%u,device,%s,read_discrepancy,,", iTimeSpan + 1, szDevice);
+            _WriteQuoted(pszRead);
+            _Print("\n");
+        }
+        if (NULL != pszWrite)
+        {
+            _Print("%u,device,%s,write_discrepancy,,", iTimeSpan + 1, szDevice);
+            _WriteQuoted(pszWrite);
+            _Print("\n");
+        }
+
+        for (size_t iSample = 1; iSample < deviceResults.vSamples.size(); iSample++)
+        {
+            DeviceSample delta = deviceResults.GetDelta(iSample - 1, iSample);
+            sprintf_s(szKey, _countof(szKey), "%u", iSample);
+            _Row(iTimeSpan, "device", szDevice, "interval_ios_per_second", szKey, "%.2f", deviceResults.GetIops(delta));
+            _Row(iTimeSpan, "device", szDevice, "interval_queue_depth", szKey, "%.2f", deviceResults.GetAverageQueueDepth(delta));
+            _Row(iTimeSpan, "device", szDevice, "interval_in_flight", szKey, "%u", delta.dwQueueDepth);
+            _Row(iTimeSpan, "device", szDevice, "interval_utilization_percent", szKey, "%.2f", deviceResults.GetUtilization(delta));
+            _Row(iTimeSpan, "device", szDevice, "interval_read_ios", szKey, "%u", delta.dwReadCount);
+            _Row(iTimeSpan, "device", szDevice, "interval_write_ios", szKey, "%u", delta.dwWriteCount);
+            _Row(iTimeSpan, "device", szDevice, "interval_splits", szKey, "%u", delta.dwSplitCount);
+        }
+    }
+}
+
+void CsvResultWriter::_WriteRows(size_t iTimeSpan, const char *pszThread, const char *pszTarget, const TargetResults& targetResults, double fTime, const vector<float>& vLimits)
+{
+    _Print("%u,%s,%s,path,,", iTimeSpan + 1, pszThread, pszTarget);
+    _WriteQuoted(targetResults.sPath.c_str());
+    _Print("\n");
+
+    _Row(iTimeSpan, pszThread, pszTarget, "file_size", "", "%I64u", targetResults.ullFileSize);
+    _Row(iTimeSpan, pszThread, pszTarget, "bytes", "", "%I64u", targetResults.ullBytesCount);
+    _Row(iTimeSpan, pszThread, pszTarget, "ios", "", "%I64u", targetResults.ullIOCount);
+    _Row(iTimeSpan, pszThread, pszTarget, "read_bytes", "", "%I64u", targetResults.ullReadBytesCount);
+    _Row(iTimeSpan, pszThread, pszTarget, "read_ios", "", "%I64u", targetResults.ullReadIOCount);
+    _Row(iTimeSpan, pszThread, pszTarget, "write_bytes", "", "%I64u", targetResults.ullWriteBytesCount);
+    _Row(iTimeSpan, pszThread, pszTarget, "write_ios", "", "%I64u", targetResults.ullWriteIOCount);
+    _Row(iTimeSpan, pszThread, pszTarget, "bytes_per_second", "", "%.2f", (fTime > 0) ? targetResults.ullBytesCount / fTime : 0);
+    _Row(iTimeSpan, pszThread, pszTarget, "ios_per_second", "", "%.2f", (fTime > 0) ? targetResults.ullIOCount / fTime : 0);
+
+    _WriteLatency(iTimeSpan, pszThread, pszTarget, "read", targetResults.readLatencyHistogram, vLimits);
+    _WriteLatency(iTimeSpan, pszThread, pszTarget, "write", targetResults.writeLatencyHistogram, vLimits);
+
+    if ((targetResults.ullFlushCount > 0) || (targetResults.durableWriteLatencyHistogram.GetSampleSize() > 0))
+    {
+        _Row(iTimeSpan, pszThread, pszTarget, "flushes", "", "%I64u", targetResults.ullFlushCount);
+        _WriteLatency(iTimeSpan, pszThread, pszTarget, "flush", targetResults.flushLatencyHistogram, vLimits);
+        _WriteLatency(iTimeSpan, pszThread, pszTarget, "durable_write", targetResults.durableWriteLatencyHistogram, vLimits);
+    }
+
+    if (targetResults.ullDiscardCount > 0)
+    {
+        _WriteDiscards(iTimeSpan, pszThread, pszTarget, targetResults, fTime, vLimits);
+    }
+
+    if (targetResults.GetFileOperationCount() > 0)
+    {
+        _WriteFileOperations(iTimeSpan, pszThread, pszTarget, targetResults, fTime, vLimits);
+    }
+}
+
+bool CsvResultWriter::WriteResults(const Profile& profile, const SystemInformation& system, const vector<Results>& vResults, FILE *pFile)
+{
+    UNREFERENCED_PARAMETER(system);
+
+    _pFile = pFile;
+    const vector<float> vLimits(_GetLatencyBinLimits());
+
+    _Print("timespan,thread,target,metric,key,value\n");
+
+    for (size_t iResult = 0; iResult < vResults.size(); iResult++)
+    {
+        const Results& results = vResults[iResult];
+        const TimeSpan& timeSpan = profile.GetTimeSpans()[iResult];
+        const UINT32 ulBucketTimeInMs = timeSpan.GetIoBucketDurationInMilliseconds();
+        double fTime = PerfTimer::PerfTimeToSeconds(results.ullTimeCount);
+
+        _Row(iResult, "total", "total", "test_time_seconds", "", "%.3f", fTime);
+        if (fTime < 0.0000001)
+        {
+            continue;
+        }
+
+        if (results.vPassBytesPerSecond.size() > 1)
+        {
+            _WritePasses(iResult, results);
+        }
+
+        if (timeSpan.GetSteadyStateWarmup())
+        {
+            _WriteWarmup(iResult, results);
+        }
+
+        char szKey[32];
+        for (size_t iCpu = 0; iCpu < results.vSystemProcessorPerfInfo.size(); iCpu++)
+        {
+            const SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION& info = results.vSystemProcessorPerfInfo[iCpu];
+            double idleTime = 100.0 * info.IdleTime.QuadPart / 10000000 / fTime;
+            double krnlTime = 100.0 * info.KernelTime.QuadPart / 10000000 / fTime;
+            double userTime = 100.0 * info.UserTime.QuadPart / 10000000 / fTime;
+
+            sprintf_s(szKey, _countof(szKey), "%u", iCpu);
+            _Row(iResult, "total", "total", "cpu_usage_percent", szKey, "%.2f", (krnlTime + userTime) - idleTime);
+            _Row(iResult, "total", "total", "cpu_user_percent", szKey, "%.2f", userTime);
+            _Row(iResult, "total", "total", "cpu_kernel_percent", szKey, "%.2f", krnlTime - idleTime);
+        }
+
+        UINT64 ullBytesCount = 0;
+        UINT64 ullIOCount = 0;
+        UINT64 ullFlushCount = 0;
+        Histogram<float> readLatencyHistogram;
+        Histogram<float> writeLatencyHistogram;
+        Histogram<float> flushLatencyHistogram;
+        Histogram<float> durableWriteLatencyHistogram;
+        TargetResults operationResults;     // discards and file operations only
+        vector<double> vReadIops, vWriteIops, vDiscardIops;
+
+        for (size_t iThread = 0; iThread < results.vThreadResults.size(); iThread++)
+        {
+            const ThreadResults& threadResults = results.vThreadResults[iThread];
+            double fThreadTime = results.GetThreadTimeInSeconds(iThread);
+            char szThread[16];
+            sprintf_s(szThread, _countof(szThread), "%u", iThread);
+
+            _Row(iResult, szThread, "total", "accounted_time_seconds", "", "%.6f", fThreadTime);
+            _Row(iResult, szThread, "total", "user_milliseconds", "", "%.3f", threadResults.ullUserTime / 10000.0);
+            _Row(iResult, szThread, "total", "kernel_milliseconds", "", "%.3f", threadResults.ullKernelTime / 10000.0);
+            _Row(iResult, szThread, "total", "cycles", "", "%I64u", threadResults.ullCycleCount);
+
+            for (size_t iTarget = 0; iTarget < threadResults.vTargetResults.size(); iTarget++)
+            {
+                const TargetResults& targetResults = threadResults.vTargetResults[iTarget];
+                char szTarget[16];
+                sprintf_s(szTarget, _countof(szTarget), "%u", iTarget);
+
+                _WriteRows(iResult, szThread, szTarget, targetResults, fThreadTime, vLimits);
+
+                vector<double> vRead, vWrite, vDiscard;
+                AddIops(vRead, targetResults.readBucketizer, ulBucketTimeInMs);
+                AddIops(vWrite, targetResults.writeBucketizer, ulBucketTimeInMs);
+                AddIops(vDiscard, targetResults.discardBucketizer, ulBucketTimeInMs);
+                _WriteIops(iResult, szThread, szTarget, vRead, vWrite, vDiscard, ulBucketTimeInMs);
+
+                ullBytesCount += targetResults.ullBytesCount;
+                ullIOCount += targetResults.ullIOCount;
+                readLatencyHistogram.Merge(targetResults.readLatencyHistogram);
+                writeLatencyHistogram.Merge(targetResults.writeLatencyHistogram);
+                ullFlushCount += targetResults.ullFlushCount;
+                flushLatencyHistogram.Merge(targetResults.flushLatencyHistogram);
+                durableWriteLatencyHistogram.Merge(targetResults.durableWriteLatencyHistogram);
+                AddOperations(operationResults, targetResults);
+                AddIops(vReadIops, targetResults.readBucketizer, ulBucketTimeInMs);
+                AddIops(vWriteIops, targetResults.writeBucketizer, ulBucketTimeInMs);
+                AddIops(vDiscardIops, targetResults.discardBucketizer, ulBucketTimeInMs);
+            }
+        }
+
+        _Row(iResult, "total", "total", "bytes", "", "%I64u", ullBytesCount);
+        _Row(iResult, "total", "total", "ios", "", "%I64u", ullIOCount);
+        _WriteLatency(iResult, "total", "total", "read", readLatencyHistogram, vLimits);
+        _WriteLatency(iResult, "total", "total", "write", writeLatencyHistogram, vLimits);
+        if ((ullFlushCount > 0) || (durableWriteLatencyHistogram.GetSampleSize() > 0))
+        {
+            _Row(iResult, "total", "total", "flushes", "", "%I64u", ullFlushCount);
+            _WriteLatency(iResult, "total", "total", "flush", flushLatencyHistogram, vLimits);
+            _WriteLatency(iResult, "total", "total", "durable_write", durableWriteLatencyHistogram, vLimits);
+        }
+        if (operationResults.ullDiscardCount > 0)
+        {
+            _WriteDiscards(iResult, "total", "total", operationResults, fTime, vLimits);
+        }
+        if (operationResults.GetFileOperationCount() > 0)
+        {
+            _WriteFileOperations(iResult, "total", "total", operationResults, fTime, vLimits);
+        }
+        _WriteIops(iResult, "total", "total", vReadIops, vWriteIops, vDiscardIops, ulBucketTimeInMs);
+
+        if (!results.vDeviceResults.empty())
+        {
+            _WriteDevices(iResult, results);
+        }
+
+        _SetTotalScore(results);
+    }
+
+    return (fflush(_pFile) == 0) && !ferror(_pFile);
+}
@@ -0,0 +1,113 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+#include "Common.h"
+#include <stdio.h>
+
+// base of the streaming writers: they emit the results to a file while walking them by
+// reference, so the size of the report does not matter and nothing is copied
+class ResultWriter : public IResultWriter
+{
+public:
+    ResultWriter() :
+        _pFile(nullptr),
+        _totalScore(0)
+    {
+    }
+
+    int GetTotalScore() { return _totalScore; }
+
+protected:
+    void _Print(const char *format, ...);
+    void _SetTotalScore(const Results& results);
+
+    // percentiles reported by both writers, as fractions; 0 and 1 are the minimum and maximum
+    static const double _percentiles[];
+    static const size_t _cPercentiles;
+
+    // upper limits of the latency histogram bins in microseconds: 1us doubling up to ~67s; a
+    // final open bin holds anything longer. Fixed so that runs can be compared bin by bin
+    static vector<float> _GetLatencyBinLimits();
+
+    FILE *_pFile;
+    int _totalScore;
+};
+
+class JsonResultWriter : public ResultWriter
+{
+public:
+    bool WriteResults(const Profile& profile, const SystemInformation& system, const vector<Results>& vResults, FILE *pFile);
+
+private:
+    void _Separator();
+    void _Key(const char *pszName);
+    void _String(const char *pszValue);
+    void _BeginObject(const char *pszName);
+    void _EndObject();
+    void _BeginArray(const char *pszName);
+    void _EndArray();
+    void _Number(const char *pszName, const char *format, ...);
+    void _StringField(const char *pszName, const char *pszValue);
+
+    void _WriteTimeSpan(size_t iTimeSpan, const TimeSpan& timeSpan, const Results& results);
+    void _WritePasses(const Results& results);
+    void _WriteWarmup(const Results& results);
+    void _WriteDevices(const Results& results);
+    void _WriteCpus(const Results& results, double fTime);
+    void _WriteTarget(const TargetResults& targetResults, double fTime, UINT32 ulBucketTimeInMs);
+    void _WriteLatency(const char *pszName, const Histogram<float>& histogram, const vector<float>& vLimits);
+    void _WriteIops(const char *pszName, const vector<double>& vRead, const vector<double>& vWrite, const vector<double>& vDiscard);
+    void _WriteDiscards(const TargetResults& targetResults, double fTime, const vector<float>& vLimits);
+    void _WriteFileOperations(const TargetResults& targetResults, double fTime, const vector<float>& vLimits);
+
+    vector<bool> _vfFirst;      //per nesting level: nothing written at the level yet
+};
+
+// one row per value: timespan,thread,target,metric,key,value. The thread and target columns
+// are "total" for the aggregates; the device counters (-Q) have "device" and the index of the
+// device instead. key is the percentile, the bin limit, the bucket time or the 1-based index
+// of a pass, a warm up round, a device sampling interval or a discard burst
+class CsvResultWriter : public ResultWriter
+{
+public:
+    bool WriteResults(const Profile& profile, const SystemInformation& system, const vector<Results>& vResults, FILE *pFile);
+
+private:
+    void _Row(size_t iTimeSpan, const char *pszThread, const char *pszTarget, const char *pszMetric, const char *pszKey, const char *format, ...);
+    void _WritePasses(size_t iTimeSpan, const Results& results);
+    void _WriteWarmup(size_t iTimeSpan, const Results& results);
+    void _WriteDevices(size_t iTimeSpan, const Results& results);
+    void _WriteRows(size_t iTimeSpan, const char *pszThread, const char *pszTarget, const TargetResults& targetResults, double fTime, const vector<float>& vLimits);
+    void _WriteLatency(size_t iTimeSpan, const char *pszThread, const char *pszTarget, const char *pszMetric, const Histogram<float>& histogram, const vector<float>& vLimits);
+    void _WriteIops(size_t iTimeSpan, const char *pszThread, const char *pszTarget, const vector<double>& vRead, const vector<double>& vWrite, const vector<double>& vDiscard, UINT32 ulBucketTimeInMs);
+    void _WriteDiscards(size_t iTimeSpan, const char *pszThread, const char *pszTarget, const TargetResults& targetResults, double fTime, const vector<float>& vLimits);
+    void _WriteFileOperations(size_t iTimeSpan, const char *pszThread, const char *pszTarget, const TargetResults& targetResults, double fTime, const vector<float>& vLimits);
+    void _WriteQuoted(const char *pszValue);
+};
@@ -0,0 +1,150 @@
+/*
+
+DISKSPD
+
+Copyright(c) Microsoft Corporation
+All rights reserved.
+
+MIT License
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// TraceDecoder.cpp : converts a binary I/O trace written by diskspd -vt to CSV
+//
+
+#include <windows.h>
+#include <stdio.h>
+#include <vector>
+#include "..\IORequestGenerator\IOTrace.h"
+
+using namespace std;
+
+static void Usage()
+{
+    fprintf(stderr, "Usage: TraceDecoder <trace file> [<csv file>]\n");
+    fprintf(stderr, "  writes one line per I/O, oldest first within each thread, to <csv file> or to the standard output\n");
+}
+
+/*****************************************************************************/
+// writes the records of one thread's ring; a ring that wrapped starts at the oldest record it still holds
+//
+static bool DecodeSegment(FILE *pInput, FILE *pOutput, const IOTraceFileHeader& header, UINT32 iThread)
+{
+    IOTraceSegmentHeader segment;
+    UINT64 ullSegmentOffset = header.cbHeader + header.cbSegment * iThread;
+    if ((_fseeki64(pInput, ullSegmentOffset, SEEK_SET) != 0) || (fread(&segment, sizeof(segment), 1, pInput) != 1))
+    {
+        fprintf(stderr, "ERROR: could not read the header of segment %u\n", iThread);
+        return false;
+    }
+
+    UINT64 cRecords = segment.ullRecordCount;
+    UINT64 iFirst = 0;
+    if (cRecords > header.cRecordsPerThread)
+    {
+        iFirst = cRecords % header.cRecordsPerThread;
+        cRecords = header.cRecordsPerThread;
+    }
+
+    double fTicksPerMicrosecond = header.ullTimerFrequency / 1000000.0;
+    vector<IOTraceRecord> vRecords(cRecords);
+    if (cRecords > 0)
+    {
+        if ((_fseeki64(pInput, ullSegmentOffset + sizeof(segment), SEEK_SET) != 0) ||
+            (fread(&vRecords[0], sizeof(IOTraceRecord), static_cast<size_t>(cRecords), pInput) != cRecords))
+        {
+            fprintf(stderr, "ERROR: could not read the records of segment %u\n", iThread);
+            return false;
+        }
+    }
+
+    for (UINT64 i = 0; i < cRecords; i++)
+    {
+        const IOTraceRecord& record = vRecords[static_cast<size_t>((iFirst + i) % header.cRecordsPerThread)];
+        // the times are relative to the start of the measurement and may be negative for the submit
+        INT64 llSubmitTime = static_cast<INT64>(record.ullSubmitTime);
+        INT64 llCompleteTime = static_cast<INT64>(record.ullCompleteTime);
+        fprintf(pOutput, "%u,%u,%s,%I64u,%u,%.3f,%.3f,%.3f\n",
+            record.usThread,
+            record.bTarget,
+            (record.bType == 1) ? "read" : ((record.bType == 2) ? "write" : "discard"),
+            record.ullOffset,
+            record.ulBytes,
+            llSubmitTime / fTicksPerMicrosecond,
+            llCompleteTime / fTicksPerMicrosecond,
+            (llCompleteTime - llSubmitTime) / fTicksPerMicrosecond);
+    }
+
+    return true;
+}
+
+int __cdecl main(int argc, const char* argv[])
+{
+    if ((argc < 2) || (argc > 3))
+    {
+        Usage();
+        return 1;
+    }
+
+    FILE *pInput = nullptr;
+    if ((fopen_s(&pInput, argv[1], "rb") != 0) || (nullptr == pInput))
+    {
+        fprintf(stderr, "ERROR: could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    IOTraceFileHeader header;
+    if ((fread(&header, sizeof(header), 1, pInput) != 1) ||
+        (header.ulMagic != IO_TRACE_MAGIC) ||
+        (header.ulVersion != IO_TRACE_VERSION) ||
+        (header.cbRecord != sizeof(IOTraceRecord)) ||
+        (header.cRecordsPerThread == 0) ||
+        (header.ullTimerFrequency == 0))
+    {
+        fprintf(stderr, "ERROR: %s is not a diskspd trace file of version %u\n", argv[1], IO_TRACE_VERSION);
+        fclose(pInput);
+        return 1;
+    }
+
+    FILE *pOutput = stdout;
+    if ((argc == 3) && ((fopen_s(&pOutput, argv[2], "w") != 0) || (nullptr == pOutput)))
+    {
+        fprintf(stderr, "ERROR: could not create %s\n", argv[2]);
+        fclose(pInput);
+        return 1;
+    }
+
+    fprintf(pOutput, "thread,target,type,offset,bytes,submit_us,complete_us,latency_us\n");
+
+    bool fOk = true;
+    for (UINT32 iThread = 0; fOk && (iThread < header.cThreads); iThread++)
+    {
+        fOk = DecodeSegment(pInput, pOutput, header, iThread);
+    }
+
+    fclose(pInput);
+    if (pOutput != stdout)
+    {
+        fclose(pOutput);
+    }
+
+    return fOk ? 0 : 1;
+}
@@ -71,6 +71,26 @@ bool XmlProfileParser::ParseFile(const char *pszPath, Profile *pProfile)
                         pProfile->SetVerbose(fVerbose);
                     }
 
+                    if (SUCCEEDED(hr))
+                    {
+                        string sTraceFile;
+                        hr = _GetString(spXmlDoc, "//Profile/Trace/Path", &sTraceFile);
+                        if (SUCCEEDED(hr) && (hr != S_FALSE))
+                        {
+                            pProfile->SetTraceFile(sTraceFile);
+                        }
+                    }
+
+                    if (SUCCEEDED(hr))
+                    {
+                        UINT32 ulTraceRecords;
+                        hr = _GetUINT32(spXmlDoc, "//Profile/Trace/RecordsPerThread", &ulTraceRecords);
+                        if (SUCCEEDED(hr) && (hr != S_FALSE))
+                        {
+                            pProfile->SetTraceRecordsPerThread(ulTraceRecords);
+                        }
+                    }
+
                     if (SUCCEEDED(hr))
                     {
                         DWORD dwProgress;
@@ -89,6 +109,14 @@ bool XmlProfileParser::ParseFile(const char *pszPath, Profile *pProfile)
                         {
                             pProfile->SetResultsFormat(ResultsFormat::Xml);
                         }
+                        else if (SUCCEEDED(hr) && (hr != S_FALSE) && sResultFormat == "json")
+                        {
+                            pProfile->SetResultsFormat(ResultsFormat::Json);
+                        }
+                        else if (SUCCEEDED(hr) && (hr != S_FALSE) && sResultFormat == "csv")
+                        {
+                            pProfile->SetResultsFormat(ResultsFormat::Csv);
+                        }
                     }
 
                     if (SUCCEEDED(hr))
@@ -390,6 +418,16 @@ HRESULT XmlProfileParser::_ParseTimeSpan(IXMLDOMNode &XmlNode, TimeSpan *pTimeSp
         }
     }
 
+    if (SUCCEEDED(hr))
+    {
+        bool fMeasureLatencyDecomposition;
+        hr = _GetBool(XmlNode, "MeasureLatencyDecomposition", &fMeasureLatencyDecomposition);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTimeSpan->SetMeasureLatencyDecomposition(fMeasureLatencyDecomposition);
+        }
+    }
+
     if (SUCCEEDED(hr))
     {
         bool fCalculateIopsStdDev;
@@ -400,6 +438,37 @@ HRESULT XmlProfileParser::_ParseTimeSpan(IXMLDOMNode &XmlNode, TimeSpan *pTimeSp
         }
     }
 
+    if (SUCCEEDED(hr))
+    {
+        bool fDeviceStatistics;
+        hr = _GetBool(XmlNode, "DeviceStatistics", &fDeviceStatistics);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTimeSpan->SetDeviceStatistics(fDeviceStatistics);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        string sReplayFile;
+        hr = _GetString(XmlNode, "Replay/Path", &sReplayFile);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTimeSpan->SetReplayFile(sReplayFile);
+            pTimeSpan->SetMeasureLatency(true);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        string sReplaySpeed;
+        hr = _GetString(XmlNode, "Replay/Speed", &sReplaySpeed);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTimeSpan->SetReplaySpeed(strtod(sReplaySpeed.c_str(), nullptr));
+        }
+    }
+
     if (SUCCEEDED(hr))
     {
         UINT32 ulIoBucketDuration;
@@ -410,6 +479,82 @@ HRESULT XmlProfileParser::_ParseTimeSpan(IXMLDOMNode &XmlNode, TimeSpan *pTimeSp
         }
     }
 
+    if (SUCCEEDED(hr))
+    {
+        UINT32 ulPassCount;
+        hr = _GetUINT32(XmlNode, "Passes/Count", &ulPassCount);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTimeSpan->SetPassCount(ulPassCount);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        UINT32 ulMinPassCount;
+        hr = _GetUINT32(XmlNode, "Passes/MinCount", &ulMinPassCount);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTimeSpan->SetMinPassCount(ulMinPassCount);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        string sTolerance;
+        hr = _GetString(XmlNode, "Passes/Tolerance", &sTolerance);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTimeSpan->SetPassTolerance(strtod(sTolerance.c_str(), nullptr));
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        IXMLDOMNodePtr spNode;
+        _variant_t query("SteadyState");
+        hr = XmlNode.selectSingleNode(query.bstrVal, &spNode);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTimeSpan->SetSteadyStateWarmup(true);
+
+            UINT32 ulValue;
+            hr = _GetUINT32(spNode, "Window", &ulValue);
+            if (SUCCEEDED(hr) && (hr != S_FALSE))
+            {
+                pTimeSpan->SetSteadyStateWindow(ulValue);
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                hr = _GetUINT32(spNode, "Interval", &ulValue);
+                if (SUCCEEDED(hr) && (hr != S_FALSE))
+                {
+                    pTimeSpan->SetSteadyStateIntervalInMilliseconds(ulValue);
+                }
+            }
+
+            string sValue;
+            if (SUCCEEDED(hr))
+            {
+                hr = _GetString(spNode, "Range", &sValue);
+                if (SUCCEEDED(hr) && (hr != S_FALSE))
+                {
+                    pTimeSpan->SetSteadyStateRange(strtod(sValue.c_str(), nullptr));
+                }
+            }
+
+            if (SUCCEEDED(hr))
+            {
+                hr = _GetString(spNode, "Slope", &sValue);
+                if (SUCCEEDED(hr) && (hr != S_FALSE))
+                {
+                    pTimeSpan->SetSteadyStateSlope(strtod(sValue.c_str(), nullptr));
+                }
+            }
+        }
+    }
+
     if (SUCCEEDED(hr))
     {
         hr = _ParseAffinityAssignment(XmlNode, pTimeSpan);
@@ -564,6 +709,16 @@ HRESULT XmlProfileParser::_ParseTarget(IXMLDOMNode &XmlNode, Target *pTarget)
         }
     }
 
+    if (SUCCEEDED(hr))
+    {
+        DWORD dwInterlockedSequentialChunk;
+        hr = _GetDWORD(XmlNode, "InterlockedSequentialChunk", &dwInterlockedSequentialChunk);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetInterlockedSequentialChunk(dwInterlockedSequentialChunk);
+        }
+    }
+
     if (SUCCEEDED(hr))
     {
         UINT64 ullBaseFileOffset;
@@ -645,6 +800,36 @@ HRESULT XmlProfileParser::_ParseTarget(IXMLDOMNode &XmlNode, Target *pTarget)
         }
     }
 
+    if (SUCCEEDED(hr))
+    {
+        bool fWriteThrough;
+        hr = _GetBool(XmlNode, "WriteThrough", &fWriteThrough);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetWriteThrough(fWriteThrough);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        DWORD dwFlushInterval;
+        hr = _GetDWORD(XmlNode, "FlushInterval", &dwFlushInterval);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetFlushInterval(dwFlushInterval);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        UINT32 ulFlushPercentage;
+        hr = _GetUINT32(XmlNode, "FlushPercentage", &ulFlushPercentage);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetFlushPercentage(ulFlushPercentage);
+        }
+    }
+
     if (SUCCEEDED(hr))
     {
         hr = _ParseWriteBufferContent(XmlNode, pTarget);
@@ -682,6 +867,186 @@ HRESULT XmlProfileParser::_ParseTarget(IXMLDOMNode &XmlNode, Target *pTarget)
         }
     }
 
+    if (SUCCEEDED(hr))
+    {
+        DWORD dwTotalThroughput;
+        hr = _GetDWORD(XmlNode, "TotalThroughput", &dwTotalThroughput);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetTotalThroughput(dwTotalThroughput);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        DWORD dwArrivalRate;
+        hr = _GetDWORD(XmlNode, "ArrivalRate", &dwArrivalRate);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetArrivalRate(dwArrivalRate);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        bool fPoissonArrivals;
+        hr = _GetBool(XmlNode, "PoissonArrivals", &fPoissonArrivals);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetPoissonArrivals(fPoissonArrivals);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        bool fVerify;
+        hr = _GetBool(XmlNode, "Verify", &fVerify);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetVerify(fVerify);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        DWORD dwLogClients;
+        hr = _GetDWORD(XmlNode, "LogClients", &dwLogClients);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetLogClients(dwLogClients);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        DWORD dwCommitRate;
+        hr = _GetDWORD(XmlNode, "CommitRate", &dwCommitRate);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetCommitRate(dwCommitRate);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        bool fPoissonCommits;
+        hr = _GetBool(XmlNode, "PoissonCommits", &fPoissonCommits);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetPoissonCommits(fPoissonCommits);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        UINT32 ulDiscardPercentage;
+        hr = _GetUINT32(XmlNode, "DiscardPercentage", &ulDiscardPercentage);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetDiscardPercentage(ulDiscardPercentage);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        UINT64 ullDiscardBurstSize;
+        hr = _GetUINT64(XmlNode, "DiscardBurstSize", &ullDiscardBurstSize);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetDiscardBurstSize(ullDiscardBurstSize);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        DWORD dwDiscardBurstInterval;
+        hr = _GetDWORD(XmlNode, "DiscardBurstInterval", &dwDiscardBurstInterval);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetDiscardBurstInterval(dwDiscardBurstInterval);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        DWORD dwFileCount;
+        hr = _GetDWORD(XmlNode, "FileCount", &dwFileCount);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetFileCount(dwFileCount);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        DWORD dwFilesPerDirectory;
+        hr = _GetDWORD(XmlNode, "FilesPerDirectory", &dwFilesPerDirectory);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetFilesPerDirectory(dwFilesPerDirectory);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        UINT64 ullMinPopulationFileSize;
+        hr = _GetUINT64(XmlNode, "MinPopulationFileSize", &ullMinPopulationFileSize);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetMinPopulationFileSize(ullMinPopulationFileSize);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        UINT64 ullMaxPopulationFileSize;
+        hr = _GetUINT64(XmlNode, "MaxPopulationFileSize", &ullMaxPopulationFileSize);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetMaxPopulationFileSize(ullMaxPopulationFileSize);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        UINT32 ulOpenReadPercentage;
+        hr = _GetUINT32(XmlNode, "OpenReadPercentage", &ulOpenReadPercentage);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetFileOperationPercentage(FileOperation::OpenRead, ulOpenReadPercentage);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        UINT32 ulCreatePercentage;
+        hr = _GetUINT32(XmlNode, "CreatePercentage", &ulCreatePercentage);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetFileOperationPercentage(FileOperation::Create, ulCreatePercentage);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        UINT32 ulStatPercentage;
+        hr = _GetUINT32(XmlNode, "StatPercentage", &ulStatPercentage);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetFileOperationPercentage(FileOperation::Stat, ulStatPercentage);
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        UINT32 ulDeletePercentage;
+        hr = _GetUINT32(XmlNode, "DeletePercentage", &ulDeletePercentage);
+        if (SUCCEEDED(hr) && (hr != S_FALSE))
+        {
+            pTarget->SetFileOperationPercentage(FileOperation::Delete, ulDeletePercentage);
+        }
+    }
+
     if (SUCCEEDED(hr))
     {
         DWORD dwThreadsPerFile;
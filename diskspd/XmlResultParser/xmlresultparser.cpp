@@ -28,6 +28,7 @@ SOFTWARE.
 */
 
 #include "xmlresultparser.h"
+#include <algorithm>
 
 // TODO: refactor to a single function shared with the ResultParser
 void XmlResultParser::_Print(const char *format, ...)
@@ -55,6 +56,237 @@ void XmlResultParser::_PrintTargetResults(const TargetResults& results)
     _Print("<ReadCount>%I64u</ReadCount>\n", results.ullReadIOCount);
     _Print("<WriteBytes>%I64u</WriteBytes>\n", results.ullWriteBytesCount);
     _Print("<WriteCount>%I64u</WriteCount>\n", results.ullWriteIOCount);
+    if (results.ullSequentialClaimCount > 0)
+    {
+        _Print("<SequentialClaimCount>%I64u</SequentialClaimCount>\n", results.ullSequentialClaimCount);
+    }
+}
+
+void XmlResultParser::_PrintTargetArrivals(const TargetResults& results)
+{
+    _Print("<Arrivals>\n");
+    _Print("<LateIOCount>%I64u</LateIOCount>\n", results.ullLateIOCount);
+    _Print("<MaxBacklog>%I64u</MaxBacklog>\n", results.ullMaxBacklog);
+    _Print("<AverageIssueLagMilliseconds>%.3f</AverageIssueLagMilliseconds>\n",
+        (results.ullIOCount > 0) ? PerfTimer::PerfTimeToMilliseconds(results.ullIssueLag) / results.ullIOCount : 0);
+    _Print("</Arrivals>\n");
+}
+
+void XmlResultParser::_PrintTargetVerify(const TargetResults& results)
+{
+    static const char *vszChecks[] = { "Verified", "Unwritten", "Raced", "Stale", "Misplaced", "Corrupt" };
+    static_assert(_countof(vszChecks) == static_cast<size_t>(BlockCheck::Count), "every block check needs a name");
+    UINT64 ullIOCount = results.ullVerifyWriteCount + results.ullVerifyReadCount;
+
+    _Print("<Verify>\n");
+    _Print("<StampedBlocks>%I64u</StampedBlocks>\n", results.ullVerifyWriteCount);
+    _Print("<ReadBlocks>%I64u</ReadBlocks>\n", results.ullVerifyReadCount);
+    for (size_t i = 0; i < static_cast<size_t>(BlockCheck::Count); i++)
+    {
+        _Print("<%sBlocks>%I64u</%sBlocks>\n", vszChecks[i], results.vullVerifyChecks[i], vszChecks[i]);
+    }
+    _Print("<Milliseconds>%.3f</Milliseconds>\n", PerfTimer::PerfTimeToMilliseconds(results.ullVerifyTime));
+    _Print("<MicrosecondsPerIO>%.3f</MicrosecondsPerIO>\n", (ullIOCount > 0) ? PerfTimer::PerfTimeToMicroseconds(results.ullVerifyTime) / ullIOCount : 0);
+    for (const auto& error : results.vVerifyErrors)
+    {
+        _Print("<Error>\n");
+        _Print("<Check>%s</Check>\n", vszChecks[static_cast<size_t>(error.check)]);
+        _Print("<Offset>%I64u</Offset>\n", error.ullOffset);
+        _Print("<FoundOffset>%I64u</FoundOffset>\n", error.ullFoundOffset);
+        _Print("<FoundTarget>%u</FoundTarget>\n", error.ulFoundTarget);
+        _Print("<FoundGeneration>%I64u</FoundGeneration>\n", error.ullFoundGeneration);
+        _Print("<ExpectedGeneration>%I64u</ExpectedGeneration>\n", error.ullExpectedGeneration);
+        _Print("<WriteSeconds>%.6f</WriteSeconds>\n", PerfTimer::PerfTimeToSeconds(error.ullWriteTime));
+        _Print("<ReadSeconds>%.6f</ReadSeconds>\n", PerfTimer::PerfTimeToSeconds(error.ullReadTime));
+        _Print("<FirstBadByte>%u</FirstBadByte>\n", error.ulFirstBadByte);
+        _Print("</Error>\n");
+    }
+    _Print("</Verify>\n");
+}
+
+void XmlResultParser::_PrintTargetFlush(const TargetResults& results)
+{
+    _Print("<Flush>\n");
+    _Print("<FlushCount>%I64u</FlushCount>\n", results.ullFlushCount);
+    if (results.flushLatencyHistogram.GetSampleSize() > 0)
+    {
+        _Print("<AverageMilliseconds>%.3f</AverageMilliseconds>\n", results.flushLatencyHistogram.GetAvg() / 1000);
+        _Print("<MedianMilliseconds>%.3f</MedianMilliseconds>\n", results.flushLatencyHistogram.GetPercentile(0.5) / 1000);
+        _Print("<P99Milliseconds>%.3f</P99Milliseconds>\n", results.flushLatencyHistogram.GetPercentile(0.99) / 1000);
+        _Print("<MaxMilliseconds>%.3f</MaxMilliseconds>\n", results.flushLatencyHistogram.GetMax() / 1000);
+    }
+    if (results.durableWriteLatencyHistogram.GetSampleSize() > 0)
+    {
+        _Print("<DurableWriteAverageMilliseconds>%.3f</DurableWriteAverageMilliseconds>\n", results.durableWriteLatencyHistogram.GetAvg() / 1000);
+        _Print("<DurableWriteMedianMilliseconds>%.3f</DurableWriteMedianMilliseconds>\n", results.durableWriteLatencyHistogram.GetPercentile(0.5) / 1000);
+        _Print("<DurableWriteP99Milliseconds>%.3f</DurableWriteP99Milliseconds>\n", results.durableWriteLatencyHistogram.GetPercentile(0.99) / 1000);
+    }
+    _Print("</Flush>\n");
+}
+
+void XmlResultParser::_PrintTargetLogWriter(const TargetResults& results, double fTime)
+{
+    _Print("<LogWriter>\n");
+    _Print("<CommitCount>%I64u</CommitCount>\n", results.ullCommitCount);
+    _Print("<CommitsPerSecond>%.2f</CommitsPerSecond>\n", (fTime > 0) ? results.ullCommitCount / fTime : 0);
+    _Print("<LateCommitCount>%I64u</LateCommitCount>\n", results.ullLateCommitCount);
+    _Print("<BatchCount>%I64u</BatchCount>\n", results.ullLogBatchCount);
+    if (results.commitLatencyHistogram.GetSampleSize() > 0)
+    {
+        _Print("<AverageMilliseconds>%.3f</AverageMilliseconds>\n", results.commitLatencyHistogram.GetAvg() / 1000);
+        _Print("<MedianMilliseconds>%.3f</MedianMilliseconds>\n", results.commitLatencyHistogram.GetPercentile(0.5) / 1000);
+        _Print("<P99Milliseconds>%.3f</P99Milliseconds>\n", results.commitLatencyHistogram.GetPercentile(0.99) / 1000);
+        _Print("<P999Milliseconds>%.3f</P999Milliseconds>\n", results.commitLatencyHistogram.GetPercentile(0.999) / 1000);
+    }
+    for (size_t i = 1; i < results.vullLogBatchSizes.size(); i++)
+    {
+        if (results.vullLogBatchSizes[i] > 0)
+        {
+            _Print("<Batch Commits=\"%u\" Count=\"%I64u\"/>\n", static_cast<UINT32>(i), results.vullLogBatchSizes[i]);
+        }
+    }
+    _Print("</LogWriter>\n");
+}
+
+void XmlResultParser::_PrintTargetDiscard(const TargetResults& results, double fTime)
+{
+    _Print("<Discard>\n");
+    _Print("<DiscardCount>%I64u</DiscardCount>\n", results.ullDiscardCount);
+    _Print("<DiscardBytes>%I64u</DiscardBytes>\n", results.ullDiscardBytesCount);
+    _Print("<DiscardsPerSecond>%.2f</DiscardsPerSecond>\n", (fTime > 0) ? results.ullDiscardCount / fTime : 0);
+    if (results.discardLatencyHistogram.GetSampleSize() > 0)
+    {
+        _Print("<AverageMilliseconds>%.3f</AverageMilliseconds>\n", results.discardLatencyHistogram.GetAvg() / 1000);
+        _Print("<MedianMilliseconds>%.3f</MedianMilliseconds>\n", results.discardLatencyHistogram.GetPercentile(0.5) / 1000);
+        _Print("<P99Milliseconds>%.3f</P99Milliseconds>\n", results.discardLatencyHistogram.GetPercentile(0.99) / 1000);
+        _Print("<MaxMilliseconds>%.3f</MaxMilliseconds>\n", results.discardLatencyHistogram.GetMax() / 1000);
+    }
+    _Print("<BurstCount>%I64u</BurstCount>\n", results.ullDiscardBurstCount);
+    if (results.discardBurstLatencyHistogram.GetSampleSize() > 0)
+    {
+        _Print("<BurstAverageMilliseconds>%.3f</BurstAverageMilliseconds>\n", results.discardBurstLatencyHistogram.GetAvg() / 1000);
+        _Print("<BurstMaxMilliseconds>%.3f</BurstMaxMilliseconds>\n", results.discardBurstLatencyHistogram.GetMax() / 1000);
+    }
+    for (UINT64 ullBurstTime : results.vullDiscardBurstTimes)
+    {
+        _Print("<Burst StartMillisecond=\"%.0f\"/>\n", PerfTimer::PerfTimeToMilliseconds(ullBurstTime));
+    }
+    _Print("</Discard>\n");
+}
+
+void XmlResultParser::_PrintTargetFileOperations(const TargetResults& results, double fTime)
+{
+    static const char *vszOperations[] = { "OpenRead", "Create", "Stat", "Delete" };
+
+    _Print("<FileOperations>\n");
+    _Print("<ReadBytes>%I64u</ReadBytes>\n", results.ullFileReadBytesCount);
+    _Print("<WriteBytes>%I64u</WriteBytes>\n", results.ullFileWriteBytesCount);
+    for (size_t i = 0; i < FILE_OPERATION_COUNT; i++)
+    {
+        const Histogram<float>& latency = results.vFileOperationLatencyHistograms[i];
+        _Print("<%s>\n", vszOperations[i]);
+        _Print("<Count>%I64u</Count>\n", results.vullFileOperationCounts[i]);
+        _Print("<OperationsPerSecond>%.2f</OperationsPerSecond>\n", (fTime > 0) ? results.vullFileOperationCounts[i] / fTime : 0);
+        if (latency.GetSampleSize() > 0)
+        {
+            _Print("<AverageMilliseconds>%.3f</AverageMilliseconds>\n", latency.GetAvg() / 1000);
+            _Print("<MedianMilliseconds>%.3f</MedianMilliseconds>\n", latency.GetPercentile(0.5) / 1000);
+            _Print("<P99Milliseconds>%.3f</P99Milliseconds>\n", latency.GetPercentile(0.99) / 1000);
+            _Print("<P999Milliseconds>%.3f</P999Milliseconds>\n", latency.GetPercentile(0.999) / 1000);
+            _Print("<MaxMilliseconds>%.3f</MaxMilliseconds>\n", latency.GetMax() / 1000);
+        }
+        _Print("</%s>\n", vszOperations[i]);
+    }
+    _Print("</FileOperations>\n");
+}
+
+void XmlResultParser::_PrintTargetReplay(const TargetResults& results)
+{
+    Histogram<float> replay;
+    replay.Merge(results.readLatencyHistogram);
+    replay.Merge(results.writeLatencyHistogram);
+
+    _Print("<Replay>\n");
+    if (replay.GetSampleSize() > 0)
+    {
+        _Print("<AverageMilliseconds>%.3f</AverageMilliseconds>\n", replay.GetAvg() / 1000);
+        _Print("<MedianMilliseconds>%.3f</MedianMilliseconds>\n", replay.GetPercentile(0.5) / 1000);
+        _Print("<P99Milliseconds>%.3f</P99Milliseconds>\n", replay.GetPercentile(0.99) / 1000);
+    }
+    if (results.originalLatencyHistogram.GetSampleSize() > 0)
+    {
+        _Print("<OriginalAverageMilliseconds>%.3f</OriginalAverageMilliseconds>\n", results.originalLatencyHistogram.GetAvg() / 1000);
+        _Print("<OriginalMedianMilliseconds>%.3f</OriginalMedianMilliseconds>\n", results.originalLatencyHistogram.GetPercentile(0.5) / 1000);
+        _Print("<OriginalP99Milliseconds>%.3f</OriginalP99Milliseconds>\n", results.originalLatencyHistogram.GetPercentile(0.99) / 1000);
+    }
+    _Print("</Replay>\n");
+}
+
+void XmlResultParser::_PrintTargetThrottling(const TargetResults& results, double fTime)
+{
+    UINT64 ullBlockSize = (results.ullIOCount > 0) ? results.ullBytesCount / results.ullIOCount : 0;
+    _Print("<Throttling>\n");
+    _Print("<TargetBytesPerMillisecond>%u</TargetBytesPerMillisecond>\n", results.dwThroughputBytesPerMillisecond);
+    _Print("<AchievedBytesPerMillisecond>%.2f</AchievedBytesPerMillisecond>\n", (fTime > 0) ? (double)results.ullBytesCount / (fTime * 1000) : 0);
+    _Print("<TargetIntervalMicroseconds>%.2f</TargetIntervalMicroseconds>\n", (double)ullBlockSize * 1000 / results.dwThroughputBytesPerMillisecond);
+    _Print("<AverageIntervalMicroseconds>%.2f</AverageIntervalMicroseconds>\n", results.GetIssueIntervalAvg());
+    _Print("<IntervalJitterMicroseconds>%.2f</IntervalJitterMicroseconds>\n", results.GetIssueIntervalJitter());
+    _Print("</Throttling>\n");
+}
+
+void XmlResultParser::_PrintSharedThrottling(const Results& results, double fTime)
+{
+    // the threads sharing a throttle are the ones working on the same file
+    vector<string> vPaths;
+    for (const auto& threadResults : results.vThreadResults)
+    {
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            if ((targetResults.dwTotalThroughputBytesPerMillisecond > 0) &&
+                (find(vPaths.begin(), vPaths.end(), targetResults.sPath) == vPaths.end()))
+            {
+                vPaths.push_back(targetResults.sPath);
+            }
+        }
+    }
+
+    _Print("<SharedThrottling>\n");
+    for (const auto& sPath : vPaths)
+    {
+        DWORD dwTotalThroughput = 0;
+        UINT64 ullTotalBytes = 0;
+        for (const auto& threadResults : results.vThreadResults)
+        {
+            for (const auto& targetResults : threadResults.vTargetResults)
+            {
+                if (targetResults.sPath == sPath)
+                {
+                    dwTotalThroughput = targetResults.dwTotalThroughputBytesPerMillisecond;
+                    ullTotalBytes += targetResults.ullBytesCount;
+                }
+            }
+        }
+
+        _Print("<Target>\n");
+        _Print("<Path>%s</Path>\n", sPath.c_str());
+        _Print("<TargetBytesPerMillisecond>%u</TargetBytesPerMillisecond>\n", dwTotalThroughput);
+        _Print("<AchievedBytesPerMillisecond>%.2f</AchievedBytesPerMillisecond>\n", (fTime > 0) ? (double)ullTotalBytes / (fTime * 1000) : 0);
+        for (size_t iThread = 0; iThread < results.vThreadResults.size(); iThread++)
+        {
+            for (const auto& targetResults : results.vThreadResults[iThread].vTargetResults)
+            {
+                if (targetResults.sPath == sPath)
+                {
+                    _Print("<Thread>\n");
+                    _Print("<Id>%u</Id>\n", iThread);
+                    _Print("<SharePercent>%.2f</SharePercent>\n", (ullTotalBytes > 0) ? 100.0 * targetResults.ullBytesCount / ullTotalBytes : 0);
+                    _Print("</Thread>\n");
+                }
+            }
+        }
+        _Print("</Target>\n");
+    }
+    _Print("</SharedThrottling>\n");
 }
 
 void XmlResultParser::_PrintTargetLatency(const TargetResults& results)
@@ -79,7 +311,7 @@ void XmlResultParser::_PrintTargetLatency(const TargetResults& results)
     }
 }
 
-void XmlResultParser::_PrintTargetIops(const IoBucketizer& readBucketizer, const IoBucketizer& writeBucketizer, UINT32 bucketTimeInMs)
+void XmlResultParser::_PrintTargetIops(const IoBucketizer& readBucketizer, const IoBucketizer& writeBucketizer, const IoBucketizer& discardBucketizer, UINT32 bucketTimeInMs)
 {
     _Print("<Iops>\n");
 
@@ -99,7 +331,7 @@ void XmlResultParser::_PrintTargetIops(const IoBucketizer& readBucketizer, const
     {
         _Print("<IopsStdDev>%.3f</IopsStdDev>\n", totalIoBucketizer.GetStandardDeviation() / (bucketTimeInMs / 1000.0));
     }
-    _PrintIops(readBucketizer, writeBucketizer, bucketTimeInMs);
+    _PrintIops(readBucketizer, writeBucketizer, discardBucketizer, bucketTimeInMs);
     _Print("</Iops>\n");
 }
 
@@ -198,6 +430,33 @@ void XmlResultParser::_PrintETW(struct ETWMask ETWMask, struct ETWEventCounters
     _Print("</ETW>\n");
 }
 
+void XmlResultParser::_PrintMeasurementWindow(const Results& results)
+{
+    UINT64 ullMinStart = MAXUINT64;
+    UINT64 ullMaxStart = 0;
+    UINT64 ullMinEnd = MAXUINT64;
+    UINT64 ullMaxEnd = 0;
+
+    for (const auto& threadResults : results.vThreadResults)
+    {
+        if (threadResults.ullAccountingStartTime != 0)
+        {
+            ullMinStart = min(ullMinStart, threadResults.ullAccountingStartTime);
+            ullMaxStart = max(ullMaxStart, threadResults.ullAccountingStartTime);
+            ullMinEnd = min(ullMinEnd, threadResults.ullAccountingEndTime);
+            ullMaxEnd = max(ullMaxEnd, threadResults.ullAccountingEndTime);
+        }
+    }
+
+    if (ullMaxStart != 0)
+    {
+        _Print("<MeasurementWindow>\n");
+        _Print("<StartSkewMilliseconds>%.3f</StartSkewMilliseconds>\n", PerfTimer::PerfTimeToMilliseconds(ullMaxStart - ullMinStart));
+        _Print("<EndSkewMilliseconds>%.3f</EndSkewMilliseconds>\n", PerfTimer::PerfTimeToMilliseconds(ullMaxEnd - ullMinEnd));
+        _Print("</MeasurementWindow>\n");
+    }
+}
+
 void XmlResultParser::_PrintCpuUtilization(const Results& results)
 {
     size_t ulProcCount = results.vSystemProcessorPerfInfo.size();
@@ -209,17 +468,23 @@ void XmlResultParser::_PrintCpuUtilization(const Results& results)
     double totalIdleTime = 0;
     double totalUserTime = 0;
     double totalKrnlTime = 0;
+    double totalDpcTime = 0;
+    double totalIntrTime = 0;
 
     for (unsigned int x = 0; x<ulProcCount; ++x)
     {
         double idleTime;
         double userTime;
         double krnlTime;
+        double dpcTime;
+        double intrTime;
         double thisTime;
 
         idleTime = 100.0 * results.vSystemProcessorPerfInfo[x].IdleTime.QuadPart / 10000000 / fTime;
         krnlTime = 100.0 * results.vSystemProcessorPerfInfo[x].KernelTime.QuadPart / 10000000 / fTime;
         userTime = 100.0 * results.vSystemProcessorPerfInfo[x].UserTime.QuadPart / 10000000 / fTime;
+        dpcTime = 100.0 * results.vSystemProcessorPerfInfo[x].Reserved1[0].QuadPart / 10000000 / fTime;
+        intrTime = 100.0 * results.vSystemProcessorPerfInfo[x].Reserved1[1].QuadPart / 10000000 / fTime;
 
         thisTime = (krnlTime + userTime) - idleTime;
 
@@ -229,25 +494,66 @@ void XmlResultParser::_PrintCpuUtilization(const Results& results)
         _Print("<UserPercent>%.2f</UserPercent>\n", userTime);
         _Print("<KernelPercent>%.2f</KernelPercent>\n", krnlTime - idleTime);
         _Print("<IdlePercent>%.2f</IdlePercent>\n", idleTime);
+        _Print("<DpcPercent>%.2f</DpcPercent>\n", dpcTime);
+        _Print("<InterruptPercent>%.2f</InterruptPercent>\n", intrTime);
         _Print("</CPU>\n");
 
         busyTime += thisTime;
         totalIdleTime += idleTime;
         totalUserTime += userTime;
         totalKrnlTime += krnlTime;
+        totalDpcTime += dpcTime;
+        totalIntrTime += intrTime;
     }
     _Print("<Average>\n");
     _Print("<UsagePercent>%.2f</UsagePercent>\n", busyTime / ulProcCount);
     _Print("<UserPercent>%.2f</UserPercent>\n", totalUserTime / ulProcCount);
     _Print("<KernelPercent>%.2f</KernelPercent>\n", (totalKrnlTime - totalIdleTime) / ulProcCount);
     _Print("<IdlePercent>%.2f</IdlePercent>\n", totalIdleTime / ulProcCount);
+    _Print("<DpcPercent>%.2f</DpcPercent>\n", totalDpcTime / ulProcCount);
+    _Print("<InterruptPercent>%.2f</InterruptPercent>\n", totalIntrTime / ulProcCount);
     _Print("</Average>\n");
 
     _Print("</CpuUtilization>\n");
 }
 
+void XmlResultParser::_PrintCpuEfficiency(const Results& results)
+{
+    UINT64 ullTotalBytes = 0;
+    UINT64 ullTotalIOCount = 0;
+    UINT64 ullTotalCpuTime = 0;
+    UINT64 ullTotalCycleCount = 0;
+
+    for (const auto& threadResults : results.vThreadResults)
+    {
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            ullTotalBytes += targetResults.ullBytesCount;
+            ullTotalIOCount += targetResults.ullIOCount;
+        }
+        ullTotalCpuTime += threadResults.ullKernelTime + threadResults.ullUserTime;
+        ullTotalCycleCount += threadResults.ullCycleCount;
+    }
+
+    double fBusyTime = 0;
+    for (const auto& info : results.vSystemProcessorPerfInfo)
+    {
+        fBusyTime += (double)(info.KernelTime.QuadPart + info.UserTime.QuadPart - info.IdleTime.QuadPart) / 10;
+    }
+
+    double fMiB = (double)ullTotalBytes / (1024 * 1024);
+    _Print("<CpuEfficiency>\n");
+    _Print("<ThreadCyclesPerIO>%.0f</ThreadCyclesPerIO>\n", (ullTotalIOCount > 0) ? (double)ullTotalCycleCount / ullTotalIOCount : 0);
+    _Print("<ThreadCpuMicrosecondsPerIO>%.3f</ThreadCpuMicrosecondsPerIO>\n", (ullTotalIOCount > 0) ? ullTotalCpuTime / 10.0 / ullTotalIOCount : 0);
+    _Print("<ThreadCpuMicrosecondsPerMiB>%.3f</ThreadCpuMicrosecondsPerMiB>\n", (fMiB > 0) ? ullTotalCpuTime / 10.0 / fMiB : 0);
+    _Print("<SystemCpuMicrosecondsPerIO>%.3f</SystemCpuMicrosecondsPerIO>\n", (ullTotalIOCount > 0) ? fBusyTime / ullTotalIOCount : 0);
+    _Print("<SystemCpuMicrosecondsPerMiB>%.3f</SystemCpuMicrosecondsPerMiB>\n", (fMiB > 0) ? fBusyTime / fMiB : 0);
+    _Print("</CpuEfficiency>\n");
+}
+
 // emit the iops time series (this obviates needing perfmon counters, in common cases, and provides file level data)
-void XmlResultParser::_PrintIops(const IoBucketizer& readBucketizer, const IoBucketizer& writeBucketizer, UINT32 bucketTimeInMs)
+// with -L each bucket also carries the average read and write latency of its interval
+void XmlResultParser::_PrintIops(const IoBucketizer& readBucketizer, const IoBucketizer& writeBucketizer, const IoBucketizer& discardBucketizer, UINT32 bucketTimeInMs)
 {
     bool done = false;
     for (size_t i = 0; !done; i++)
@@ -269,7 +575,21 @@ void XmlResultParser::_PrintIops(const IoBucketizer& readBucketizer, const IoBuc
         }
         if (!done)
         {
-            _Print("<Bucket SampleMillisecond=\"%lu\" Read=\"%.0f\" Write=\"%.0f\" Total=\"%.0f\"/>\n", bucketTimeInMs*(i + 1), r, w, r + w);
+            _Print("<Bucket SampleMillisecond=\"%lu\" Read=\"%.0f\" Write=\"%.0f\" Total=\"%.0f\"", bucketTimeInMs*(i + 1), r, w, r + w);
+            if (discardBucketizer.GetNumberOfValidBuckets() > 0)
+            {
+                double d = (discardBucketizer.GetNumberOfValidBuckets() > i) ? discardBucketizer.GetIoBucket(i) / (bucketTimeInMs / 1000.0) : 0;
+                _Print(" Discard=\"%.0f\"", d);
+            }
+            if (readBucketizer.HasLatency() && (readBucketizer.GetNumberOfValidBuckets() > i) && (readBucketizer.GetIoBucket(i) > 0))
+            {
+                _Print(" ReadMilliseconds=\"%.3f\"", readBucketizer.GetLatencySum(i) / readBucketizer.GetIoBucket(i));
+            }
+            if (writeBucketizer.HasLatency() && (writeBucketizer.GetNumberOfValidBuckets() > i) && (writeBucketizer.GetIoBucket(i) > 0))
+            {
+                _Print(" WriteMilliseconds=\"%.3f\"", writeBucketizer.GetLatencySum(i) / writeBucketizer.GetIoBucket(i));
+            }
+            _Print("/>\n");
         }
     }
 }
@@ -278,6 +598,7 @@ void XmlResultParser::_PrintOverallIops(const Results& results, UINT32 bucketTim
 {
     IoBucketizer readBucketizer;
     IoBucketizer writeBucketizer;
+    IoBucketizer discardBucketizer;
 
     for (const auto& thread : results.vThreadResults)
     {
@@ -285,10 +606,11 @@ void XmlResultParser::_PrintOverallIops(const Results& results, UINT32 bucketTim
         {
             readBucketizer.Merge(target.readBucketizer);
             writeBucketizer.Merge(target.writeBucketizer);
+            discardBucketizer.Merge(target.discardBucketizer);
         }
     }
 
-    _PrintTargetIops(readBucketizer, writeBucketizer, bucketTimeInMs);
+    _PrintTargetIops(readBucketizer, writeBucketizer, discardBucketizer, bucketTimeInMs);
 }
 
 void XmlResultParser::_PrintLatencyPercentiles(const Results& results)
@@ -359,21 +681,44 @@ void XmlResultParser::_PrintLatencyPercentiles(const Results& results)
     vPercentiles.push_back(make_pair(5, 99.99999));
     vPercentiles.push_back(make_pair(6, 99.999999));
 
+    // sort each histogram once for all the percentiles
+    vector<double> vFractions;
     for (auto p : vPercentiles)
+    {
+        vFractions.push_back(p.second / 100);
+    }
+
+    vector<float> vReadValues(vFractions.size());
+    vector<float> vWriteValues(vFractions.size());
+    vector<float> vTotalValues(vFractions.size());
+    if (readLatencyHistogram.GetSampleSize() > 0)
+    {
+        readLatencyHistogram.GetPercentiles(&vFractions[0], vFractions.size(), &vReadValues[0]);
+    }
+    if (writeLatencyHistogram.GetSampleSize() > 0)
+    {
+        writeLatencyHistogram.GetPercentiles(&vFractions[0], vFractions.size(), &vWriteValues[0]);
+    }
+    if (totalLatencyHistogram.GetSampleSize() > 0)
+    {
+        totalLatencyHistogram.GetPercentiles(&vFractions[0], vFractions.size(), &vTotalValues[0]);
+    }
+
+    for (size_t i = 0; i < vPercentiles.size(); i++)
     {
         _Print("<Bucket>\n");
-        _Print("<Percentile>%.*f</Percentile>\n", p.first, p.second);
+        _Print("<Percentile>%.*f</Percentile>\n", vPercentiles[i].first, vPercentiles[i].second);
         if (readLatencyHistogram.GetSampleSize() > 0)
         {
-            _Print("<ReadMilliseconds>%.3f</ReadMilliseconds>\n", readLatencyHistogram.GetPercentile(p.second / 100) / 1000);
+            _Print("<ReadMilliseconds>%.3f</ReadMilliseconds>\n", vReadValues[i] / 1000);
         }
         if (writeLatencyHistogram.GetSampleSize() > 0)
         {
-            _Print("<WriteMilliseconds>%.3f</WriteMilliseconds>\n", writeLatencyHistogram.GetPercentile(p.second / 100) / 1000);
+            _Print("<WriteMilliseconds>%.3f</WriteMilliseconds>\n", vWriteValues[i] / 1000);
         }
         if (totalLatencyHistogram.GetSampleSize() > 0)
         {
-            _Print("<TotalMilliseconds>%.3f</TotalMilliseconds>\n", totalLatencyHistogram.GetPercentile(p.second / 100) / 1000);
+            _Print("<TotalMilliseconds>%.3f</TotalMilliseconds>\n", vTotalValues[i] / 1000);
         }
         _Print("</Bucket>\n");
     }
@@ -396,12 +741,220 @@ void XmlResultParser::_PrintLatencyPercentiles(const Results& results)
     _Print("</Latency>\n");
 }
 
+void XmlResultParser::_PrintLatencyDecomposition(const Results& results)
+{
+    Histogram<float> submitLatencyHistogram;
+    Histogram<float> inFlightLatencyHistogram;
+    Histogram<float> reapLatencyHistogram;
+
+    for (const auto& thread : results.vThreadResults)
+    {
+        for (const auto& target : thread.vTargetResults)
+        {
+            submitLatencyHistogram.Merge(target.submitLatencyHistogram);
+            inFlightLatencyHistogram.Merge(target.inFlightLatencyHistogram);
+            reapLatencyHistogram.Merge(target.reapLatencyHistogram);
+        }
+    }
+
+    if (submitLatencyHistogram.GetSampleSize() == 0)
+    {
+        return;
+    }
+
+    _Print("<LatencyDecomposition>\n");
+    _Print("<AverageSubmitMicroseconds>%.3f</AverageSubmitMicroseconds>\n", submitLatencyHistogram.GetAvg());
+    _Print("<AverageInFlightMicroseconds>%.3f</AverageInFlightMicroseconds>\n", inFlightLatencyHistogram.GetAvg());
+    _Print("<AverageReapMicroseconds>%.3f</AverageReapMicroseconds>\n", reapLatencyHistogram.GetAvg());
+
+    double percentiles[] = { 0, 50, 90, 99, 99.9, 99.99, 100 };
+    for (auto p : percentiles)
+    {
+        _Print("<Bucket>\n");
+        _Print("<Percentile>%g</Percentile>\n", p);
+        _Print("<SubmitMicroseconds>%.3f</SubmitMicroseconds>\n", submitLatencyHistogram.GetPercentile(p / 100));
+        _Print("<InFlightMicroseconds>%.3f</InFlightMicroseconds>\n", inFlightLatencyHistogram.GetPercentile(p / 100));
+        _Print("<ReapMicroseconds>%.3f</ReapMicroseconds>\n", reapLatencyHistogram.GetPercentile(p / 100));
+        _Print("</Bucket>\n");
+    }
+    _Print("</LatencyDecomposition>\n");
+}
+
 int XmlResultParser::GetTotalScore()
 {
 	return 0;
 }
 
-string XmlResultParser::ParseResults(Profile& profile, const SystemInformation& system, vector<Results> vResults)
+void XmlResultParser::_PrintPasses(const Results& results)
+{
+    PassStatistics bytesStats(results.vPassBytesPerSecond);
+    PassStatistics iopsStats(results.vPassIops);
+
+    _Print("<Passes>\n");
+    _Print("<Count>%u</Count>\n", results.vPassBytesPerSecond.size());
+    _Print("<ReportedPass>%u</ReportedPass>\n", results.iReportedPass + 1);
+    for (size_t iPass = 0; iPass < results.vPassBytesPerSecond.size(); iPass++)
+    {
+        _Print("<Pass>\n");
+        _Print("<Index>%u</Index>\n", iPass + 1);
+        _Print("<BytesPerSecond>%.2f</BytesPerSecond>\n", results.vPassBytesPerSecond[iPass]);
+        _Print("<IOPS>%.2f</IOPS>\n", results.vPassIops[iPass]);
+        _Print("</Pass>\n");
+    }
+    _Print("<BytesPerSecond>\n");
+    _Print("<Median>%.2f</Median>\n", bytesStats.fMedian);
+    _Print("<Mean>%.2f</Mean>\n", bytesStats.fMean);
+    _Print("<StandardDeviation>%.2f</StandardDeviation>\n", bytesStats.fStandardDeviation);
+    _Print("<ConfidenceInterval95>%.2f</ConfidenceInterval95>\n", bytesStats.fConfidenceInterval);
+    _Print("</BytesPerSecond>\n");
+    _Print("<IOPS>\n");
+    _Print("<Median>%.2f</Median>\n", iopsStats.fMedian);
+    _Print("<Mean>%.2f</Mean>\n", iopsStats.fMean);
+    _Print("<StandardDeviation>%.2f</StandardDeviation>\n", iopsStats.fStandardDeviation);
+    _Print("<ConfidenceInterval95>%.2f</ConfidenceInterval95>\n", iopsStats.fConfidenceInterval);
+    _Print("</IOPS>\n");
+    _Print("</Passes>\n");
+}
+
+void XmlResultParser::_PrintWorkerCounters(const Results& results)
+{
+    UINT64 ullIOCount = 0;
+    UINT64 ullCycleCount = 0;
+    for (const auto& threadResults : results.vThreadResults)
+    {
+        for (const auto& targetResults : threadResults.vTargetResults)
+        {
+            ullIOCount += targetResults.ullIOCount;
+        }
+        ullCycleCount += threadResults.ullCycleCount;
+    }
+
+    const struct WorkerCounters& counters = results.WorkerCounters;
+    double fIOCount = (ullIOCount > 0) ? (double)ullIOCount : 1;
+
+    _Print("<WorkerCounters>\n");
+    _Print("<Cycles>%I64u</Cycles>\n", ullCycleCount);
+    _Print("<CyclesPerIO>%.2f</CyclesPerIO>\n", ullCycleCount / fIOCount);
+    _Print("<ContextSwitches>%I64u</ContextSwitches>\n", counters.ullContextSwitches);
+    _Print("<ContextSwitchesPerIO>%.4f</ContextSwitchesPerIO>\n", counters.ullContextSwitches / fIOCount);
+    _Print("<ProcessPageFaults>%I64u</ProcessPageFaults>\n", counters.ullPageFaults);
+    _Print("<ProcessPageFaultsPerIO>%.4f</ProcessPageFaultsPerIO>\n", counters.ullPageFaults / fIOCount);
+    _Print("<ProcessReadOperations>%I64u</ProcessReadOperations>\n", counters.ullReadOperations);
+    _Print("<ProcessWriteOperations>%I64u</ProcessWriteOperations>\n", counters.ullWriteOperations);
+    _Print("<ProcessOtherOperations>%I64u</ProcessOtherOperations>\n", counters.ullOtherOperations);
+    _Print("</WorkerCounters>\n");
+}
+
+void XmlResultParser::_PrintTrace(const Results& results)
+{
+    _Print("<Trace>\n");
+    _Print("<Path>%s</Path>\n", results.sTraceFile.c_str());
+    _Print("<Records>%I64u</Records>\n", results.ullTraceRecords);
+    _Print("<OverwrittenRecords>%I64u</OverwrittenRecords>\n", results.ullTraceOverwrittenRecords);
+    _Print("<NanosecondsPerIO>%.1f</NanosecondsPerIO>\n", results.fTraceRecordNs);
+    _Print("<FlushMilliseconds>%.3f</FlushMilliseconds>\n", results.fTraceFlushMilliseconds);
+    _Print("</Trace>\n");
+}
+
+void XmlResultParser::_PrintReplay(const Results& results)
+{
+    _Print("<Replay>\n");
+    _Print("<Path>%s</Path>\n", results.sReplayFile.c_str());
+    _Print("<Speed>%.3f</Speed>\n", results.fReplaySpeed);
+    _Print("<Streams>%u</Streams>\n", static_cast<UINT32>(results.cReplayStreams));
+    _Print("<Operations>%I64u</Operations>\n", results.ullReplayOperations);
+    _Print("<IssuedOperations>%I64u</IssuedOperations>\n", results.ullReplayIssuedOperations);
+    _Print("</Replay>\n");
+}
+
+void XmlResultParser::_PrintDeviceStatistics(const Results& results)
+{
+    _Print("<DeviceStatistics>\n");
+    for (const auto& deviceResults : results.vDeviceResults)
+    {
+        if (deviceResults.vSamples.size() < 2)
+        {
+            continue;
+        }
+
+        UINT64 ullReadBytes, ullWriteBytes, ullReadCount, ullWriteCount;
+        deviceResults.GetApplicationIo(results.vThreadResults, &ullReadBytes, &ullWriteBytes, &ullReadCount, &ullWriteCount);
+        DeviceSample total = deviceResults.GetTotal();
+        UINT64 ullDeviceCount = static_cast<UINT64>(total.dwReadCount) + total.dwWriteCount;
+
+        _Print("<Device>\n");
+        _Print("<Path>%s</Path>\n", deviceResults.sDevice.c_str());
+        for (const auto& sPath : deviceResults.vTargetPaths)
+        {
+            _Print("<TargetPath>%s</TargetPath>\n", sPath.c_str());
+        }
+        _Print("<ApplicationReadCount>%I64u</ApplicationReadCount>\n", ullReadCount);
+        _Print("<ApplicationWriteCount>%I64u</ApplicationWriteCount>\n", ullWriteCount);
+        _Print("<ApplicationReadBytes>%I64u</ApplicationReadBytes>\n", ullReadBytes);
+        _Print("<ApplicationWriteBytes>%I64u</ApplicationWriteBytes>\n", ullWriteBytes);
+        _Print("<ReadCount>%u</ReadCount>\n", total.dwReadCount);
+        _Print("<WriteCount>%u</WriteCount>\n", total.dwWriteCount);
+        _Print("<ReadBytes>%I64u</ReadBytes>\n", total.ullBytesRead);
+        _Print("<WriteBytes>%I64u</WriteBytes>\n", total.ullBytesWritten);
+        _Print("<IOPS>%.2f</IOPS>\n", deviceResults.GetIops(total));
+        _Print("<AverageQueueDepth>%.2f</AverageQueueDepth>\n", deviceResults.GetAverageQueueDepth(total));
+        _Print("<AverageInFlight>%.2f</AverageInFlight>\n", deviceResults.GetAverageInFlight());
+        _Print("<Utilization>%.2f</Utilization>\n", deviceResults.GetUtilization(total));
+        _Print("<SplitCount>%u</SplitCount>\n", total.dwSplitCount);
+        _Print("<SplitsPerIO>%.4f</SplitsPerIO>\n", (ullDeviceCount > 0) ? static_cast<double>(total.dwSplitCount) / ullDeviceCount : 0);
+
+        const char *pszRead = DeviceResults::GetDiscrepancy(ullReadBytes, total.ullBytesRead, false);
+        const char *pszWrite = DeviceResults::GetDiscrepancy(ullWriteBytes, total.ullBytesWritten, true);
+        if (NULL != pszRead)
+        {
+            _Print("<ReadDiscrepancy>%s</ReadDiscrepancy>\n", pszRead);
+        }
+        if (NULL != pszWrite)
+        {
+            _Print("<WriteDiscrepancy>%s</WriteDiscrepancy>\n", pszWrite);
+        }
+
+        _Print("<Intervals>\n");
+        for (size_t iSample = 1; iSample < deviceResults.vSamples.size(); iSample++)
+        {
+            DeviceSample delta = deviceResults.GetDelta(iSample - 1, iSample);
+            _Print("<Interval IOPS=\"%.2f\" QueueDepth=\"%.2f\" InFlight=\"%u\" Utilization=\"%.2f\" ReadCount=\"%u\" WriteCount=\"%u\" SplitCount=\"%u\"/>\n",
+                deviceResults.GetIops(delta),
+                deviceResults.GetAverageQueueDepth(delta),
+                delta.dwQueueDepth,
+                deviceResults.GetUtilization(delta),
+                delta.dwReadCount,
+                delta.dwWriteCount,
+                delta.dwSplitCount);
+        }
+        _Print("</Intervals>\n");
+        _Print("</Device>\n");
+    }
+    _Print("</DeviceStatistics>\n");
+}
+
+void XmlResultParser::_PrintWarmup(const Results& results)
+{
+    bool fLatency = (results.vWarmupLatency.size() == results.vWarmupIops.size());
+
+    _Print("<Warmup>\n");
+    _Print(results.fSteadyStateReached ? "<SteadyStateReached>true</SteadyStateReached>\n" : "<SteadyStateReached>false</SteadyStateReached>\n");
+    _Print("<TimeSeconds>%.2f</TimeSeconds>\n", PerfTimer::PerfTimeToSeconds(results.ullWarmupTime));
+    for (size_t iRound = 0; iRound < results.vWarmupIops.size(); iRound++)
+    {
+        _Print("<Round>\n");
+        _Print("<Index>%u</Index>\n", iRound + 1);
+        _Print("<IOPS>%.2f</IOPS>\n", results.vWarmupIops[iRound]);
+        if (fLatency)
+        {
+            _Print("<AverageLatencyMilliseconds>%.3f</AverageLatencyMilliseconds>\n", results.vWarmupLatency[iRound] / 1000);
+        }
+        _Print("</Round>\n");
+    }
+    _Print("</Warmup>\n");
+}
+
+string XmlResultParser::ParseResults(Profile& profile, const SystemInformation& system, const vector<Results>& vResults)
 {
     _sResult.clear();
 
@@ -425,41 +978,137 @@ string XmlResultParser::ParseResults(Profile& profile, const SystemInformation&
             _Print("<TestTimeSeconds>%.2f</TestTimeSeconds>\n", fTime);
             _Print("<ThreadCount>%u</ThreadCount>\n", ulThreadCnt);
             _Print("<ProcCount>%u</ProcCount>\n", ulProcCount);
+            _Print("<SetupTimeMilliseconds>%.3f</SetupTimeMilliseconds>\n", PerfTimer::PerfTimeToMilliseconds(results.ullSetupTime));
+            _Print(results.fWorkersReused ? "<WorkersReused>true</WorkersReused>\n" : "<WorkersReused>false</WorkersReused>\n");
+
+            if (results.vPassBytesPerSecond.size() > 1)
+            {
+                _PrintPasses(results);
+            }
+
+            if (timeSpan.GetSteadyStateWarmup())
+            {
+                _PrintWarmup(results);
+            }
 
             _PrintCpuUtilization(results);
+            _PrintCpuEfficiency(results);
+            _PrintMeasurementWindow(results);
+
+            bool fOpenLoop = false;
+            for (const auto& target : timeSpan.GetTargets())
+            {
+                fOpenLoop = fOpenLoop || (target.GetArrivalRate() > 0);
+            }
 
             if (timeSpan.GetMeasureLatency())
             {
                 _PrintLatencyPercentiles(results);
             }
 
+            if (timeSpan.GetMeasureLatencyDecomposition())
+            {
+                _PrintLatencyDecomposition(results);
+            }
+
             if (timeSpan.GetCalculateIopsStdDev())
             {
                 _PrintOverallIops(results, timeSpan.GetIoBucketDurationInMilliseconds());
             }
 
+            bool fTotalThrottled = false;
+            for (const auto& target : timeSpan.GetTargets())
+            {
+                fTotalThrottled = fTotalThrottled || (target.GetTotalThroughputInBytesPerMillisecond() > 0);
+            }
+
+            if (fTotalThrottled)
+            {
+                _PrintSharedThrottling(results, fTime);
+            }
+
             if (results.fUseETW)
             {
                 _PrintETW(results.EtwMask, results.EtwEventCounters);
                 _PrintETWSessionInfo(results.EtwSessionInfo);
             }
 
+            if (results.fWorkerCounters)
+            {
+                _PrintWorkerCounters(results);
+            }
+
+            if (!results.vDeviceResults.empty())
+            {
+                _PrintDeviceStatistics(results);
+            }
+
+            if (results.fTrace)
+            {
+                _PrintTrace(results);
+            }
+
+            if (results.fReplay)
+            {
+                _PrintReplay(results);
+            }
+
             for (size_t iThread = 0; iThread < results.vThreadResults.size(); iThread++)
             {
                 const ThreadResults& threadResults = results.vThreadResults[iThread];
                 _Print("<Thread>\n");
                 _Print("<Id>%u</Id>\n", iThread);
+                _Print("<AccountedTimeSeconds>%.6f</AccountedTimeSeconds>\n", results.GetThreadTimeInSeconds(iThread));
+                _Print("<UserMilliseconds>%.3f</UserMilliseconds>\n", threadResults.ullUserTime / 10000.0);
+                _Print("<KernelMilliseconds>%.3f</KernelMilliseconds>\n", threadResults.ullKernelTime / 10000.0);
+                _Print("<CycleCount>%I64u</CycleCount>\n", threadResults.ullCycleCount);
+                if (results.fWorkerCounters)
+                {
+                    _Print("<ContextSwitches>%I64u</ContextSwitches>\n", threadResults.ullContextSwitches);
+                }
                 for (const auto& targetResults : threadResults.vTargetResults)
                 {
                     _Print("<Target>\n");
                     _PrintTargetResults(targetResults);
+                    if (fOpenLoop || (results.fReplay && (results.fReplaySpeed > 0)))
+                    {
+                        _PrintTargetArrivals(targetResults);
+                    }
+                    if (results.fReplay)
+                    {
+                        _PrintTargetReplay(targetResults);
+                    }
+                    if (targetResults.ullVerifyWriteCount + targetResults.ullVerifyReadCount > 0)
+                    {
+                        _PrintTargetVerify(targetResults);
+                    }
+                    if ((targetResults.ullFlushCount > 0) || (targetResults.durableWriteLatencyHistogram.GetSampleSize() > 0))
+                    {
+                        _PrintTargetFlush(targetResults);
+                    }
+                    if (targetResults.ullLogBatchCount > 0)
+                    {
+                        _PrintTargetLogWriter(targetResults, fTime);
+                    }
+                    if (targetResults.ullDiscardCount > 0)
+                    {
+                        _PrintTargetDiscard(targetResults, fTime);
+                    }
+                    if (targetResults.GetFileOperationCount() > 0)
+                    {
+                        _PrintTargetFileOperations(targetResults, fTime);
+                    }
+                    if (targetResults.dwThroughputBytesPerMillisecond > 0)
+                    {
+                        _PrintTargetThrottling(targetResults, fTime);
+                    }
                     if (timeSpan.GetMeasureLatency())
                     {
                         _PrintTargetLatency(targetResults);
                     }
                     if (timeSpan.GetCalculateIopsStdDev())
                     {
-                        _PrintTargetIops(targetResults.readBucketizer, targetResults.writeBucketizer, timeSpan.GetIoBucketDurationInMilliseconds());
+                        _PrintTargetIops(targetResults.readBucketizer, targetResults.writeBucketizer, targetResults.discardBucketizer, timeSpan.GetIoBucketDurationInMilliseconds());
                     }
                     _Print("</Target>\n");
                 }
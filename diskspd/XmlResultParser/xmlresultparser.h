@@ -33,19 +33,37 @@ SOFTWARE.
 class XmlResultParser: public IResultParser
 {
 public:
-    string ParseResults(Profile& profile, const SystemInformation& system, vector<Results> vResults);
+    string ParseResults(Profile& profile, const SystemInformation& system, const vector<Results>& vResults);
 	int GetTotalScore();
 
 private:
     void _PrintCpuUtilization(const Results& results);
+    void _PrintCpuEfficiency(const Results& results);
+    void _PrintWorkerCounters(const Results& results);
+    void _PrintDeviceStatistics(const Results& results);
+    void _PrintTrace(const Results& results);
+    void _PrintReplay(const Results& results);
+    void _PrintMeasurementWindow(const Results& results);
+    void _PrintPasses(const Results& results);
+    void _PrintWarmup(const Results& results);
     void _PrintETW(struct ETWMask ETWMask, struct ETWEventCounters EtwEventCounters);
     void _PrintETWSessionInfo(struct ETWSessionInfo sessionInfo);
     void _PrintLatencyPercentiles(const Results& results);
+    void _PrintLatencyDecomposition(const Results& results);
     void _PrintTargetResults(const TargetResults& results);
     void _PrintTargetLatency(const TargetResults& results);
-    void _PrintTargetIops(const IoBucketizer& readBucketizer, const IoBucketizer& writeBucketizer, UINT32 bucketTimeInMs);
+    void _PrintTargetArrivals(const TargetResults& results);
+    void _PrintTargetReplay(const TargetResults& results);
+    void _PrintTargetVerify(const TargetResults& results);
+    void _PrintTargetFlush(const TargetResults& results);
+    void _PrintTargetLogWriter(const TargetResults& results, double fTime);
+    void _PrintTargetDiscard(const TargetResults& results, double fTime);
+    void _PrintTargetFileOperations(const TargetResults& results, double fTime);
+    void _PrintTargetThrottling(const TargetResults& results, double fTime);
+    void _PrintSharedThrottling(const Results& results, double fTime);
+    void _PrintTargetIops(const IoBucketizer& readBucketizer, const IoBucketizer& writeBucketizer, const IoBucketizer& discardBucketizer, UINT32 bucketTimeInMs);
     void _PrintOverallIops(const Results& results, UINT32 bucketTimeInMs);
-    void _PrintIops(const IoBucketizer& readBucketizer, const IoBucketizer& writeBucketizer, UINT32 bucketTimeInMs);
+    void _PrintIops(const IoBucketizer& readBucketizer, const IoBucketizer& writeBucketizer, const IoBucketizer& discardBucketizer, UINT32 bucketTimeInMs);
     void _Print(const char *format, ...);
 
     string _sResult;